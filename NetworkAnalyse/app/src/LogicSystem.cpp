@@ -2,6 +2,7 @@
 #include "../include/HttpConnection.h"
 #include <spdlog/spdlog.h>
 #include <AppInfoFetcher.h>
+#include <ColumnStore.h>
 #include "../include/const.h"
 
 
@@ -186,6 +187,34 @@ reg_post("/start_capture", [this](std::shared_ptr<HttpConnection> connection) {
     auto name = src_root["app_name"].get<std::string>();
     auto uid = src_root["app_uid"].get<int>();
     spdlog::info("start_capture: app_name: {}, app_uid: {}", name, uid);
+    // 可选：按名称启用/关闭协议解析器，如 {"dissectors": {"mdns": true, "icmp": false}}
+    CaptureOptions options;
+    if (src_root.contains("dissectors") && src_root["dissectors"].is_object()) {
+        for (auto& item : src_root["dissectors"].items()) {
+            if (item.value().is_boolean()) options.dissectors[item.key()] = item.value().get<bool>();
+        }
+    }
+    // 可选：本次采集的地址映射，如 {"address_map": {"192.168.31.172": "192.168.31.200"}}
+    if (src_root.contains("address_map") && src_root["address_map"].is_object()) {
+        for (auto& item : src_root["address_map"].items()) {
+            if (item.value().is_string()) options.address_map.emplace_back(item.key(), item.value().get<std::string>());
+        }
+    }
+    // 可选：提取逐流分类特征，如 {"features": true}
+    if (src_root.contains("features") && src_root["features"].is_boolean())
+        options.features = src_root["features"].get<bool>();
+    // 可选：按 NSS key log 被动解密 TLS 中的 HTTP，如 {"tls_keylog": "/data/sslkeylog.txt"}
+    if (src_root.contains("tls_keylog") && src_root["tls_keylog"].is_string())
+        options.tls_keylog = src_root["tls_keylog"].get<std::string>();
+    // 可选：回放 pcap 文件代替实时抓包，如 {"pcap_file": "/data/capture.pcap"}
+    if (src_root.contains("pcap_file") && src_root["pcap_file"].is_string())
+        options.pcap_file = src_root["pcap_file"].get<std::string>();
+    // 可选：经 adb exec-out tcpdump 直接在设备上抓包，如 {"adb_serial": "emulator-5554"}
+    if (src_root.contains("adb_serial") && src_root["adb_serial"].is_string())
+        options.adb_serial = src_root["adb_serial"].get<std::string>();
+    // 可选：报文记录改用 LOAD DATA LOCAL INFILE 批量导入，如 {"bulk_load": true}
+    if (src_root.contains("bulk_load") && src_root["bulk_load"].is_boolean())
+        options.bulk_load = src_root["bulk_load"].get<bool>();
 
     // 执行脚本
     runClearScript();
@@ -194,7 +223,7 @@ reg_post("/start_capture", [this](std::shared_ptr<HttpConnection> connection) {
     connection->m_response.set(http::field::content_type, "application/json");
     //int uid=10051;
     //开始捕获
-    m_traffic_capture->start_capture(uid);
+    m_traffic_capture->start_capture(uid, options);
     m_zmq_subscriber->start(uid);
 
     json root;
@@ -209,6 +238,48 @@ reg_post("/start_capture", [this](std::shared_ptr<HttpConnection> connection) {
 
 });
 
+reg_post("/address_map", [this](std::shared_ptr<HttpConnection> connection) {
+    // 获取请求体
+    auto body_str = boost::beast::buffers_to_string(connection->m_request.body().data());
+    spdlog::info("address_map: Received body: {}", body_str);
+    // 请求格式：{"entries": {"源地址": "映射地址"}, "scope": "session" | "base"}，采集中即时生效
+    json src_root = json::parse(body_str, nullptr, false);
+    AddressMap::Entries entries;
+    bool session = true;
+    if (!src_root.is_discarded()) {
+        if (src_root.contains("entries") && src_root["entries"].is_object()) {
+            for (auto& item : src_root["entries"].items()) {
+                if (item.value().is_string()) entries.emplace_back(item.key(), item.value().get<std::string>());
+            }
+        }
+        if (src_root.contains("scope") && src_root["scope"].is_string())
+            session = src_root["scope"].get<std::string>() != "base";
+    }
+
+    // 设置响应头
+    connection->m_response.set(http::field::content_type, "application/json");
+
+    json root;
+    std::string error;
+    if (src_root.is_discarded()) {
+        root["error"] = 1;
+        root["msg"] = "请求格式错误";
+    } else if (!m_traffic_capture->set_address_map(entries, session, error)) {
+        root["error"] = 1;
+        root["msg"] = "地址映射无效: " + error;
+    } else {
+        root["error"] = 0;
+        root["msg"] = "地址映射已更新";
+    }
+    // 发送响应
+    std::string jsonstr = root.dump();
+    beast::ostream(connection->m_response.body()) << jsonstr;
+    spdlog::info("address_map: response: {}", jsonstr);
+
+    return true;
+
+});
+
 reg_post("/stop_capture", [this](std::shared_ptr<HttpConnection> connection) {
     // 获取请求体
     auto body_str = boost::beast::buffers_to_string(connection->m_request.body().data());
@@ -255,6 +326,97 @@ reg_post("/get_app_info", [this](std::shared_ptr<HttpConnection> connection) {
 
 });
 
+reg_post("/db_status", [this](std::shared_ptr<HttpConnection> connection) {
+    // 设置响应头
+    connection->m_response.set(http::field::content_type, "application/json");
+
+    // 共享连接池的就绪状态（connecting/ready/failed）与借用统计，以及本地暂存区的积压与回放情况
+    json root;
+    root["error"] = 0;
+    root["pool"] = m_mysql.pool_status();
+    root["spool"] = m_mysql.spool_status();
+    if (ColumnStore* store = m_mysql.column_store()) root["column_store"] = store->status();
+    json partitions = m_mysql.partition_status();
+    if (!partitions.is_null()) root["partitions"] = std::move(partitions);
+    root["body_compression"] = m_mysql.body_compression_status();
+    std::string jsonstr = root.dump();
+    beast::ostream(connection->m_response.body()) << jsonstr;
+
+    return true;
+
+});
+
+reg_post("/http_packets", [this](std::shared_ptr<HttpConnection> connection) {
+    auto body_str = boost::beast::buffers_to_string(connection->m_request.body().data());
+    spdlog::info("http_packets: Received body: {}", body_str);
+    // {"flow_id": "...", "body": true}：body 为 false 时只返回元数据，不解压报文体
+    json src_root = json::parse(body_str, nullptr, false);
+
+    // 设置响应头
+    connection->m_response.set(http::field::content_type, "application/json");
+
+    json root;
+    if (src_root.is_discarded() || !src_root.contains("flow_id") || !src_root["flow_id"].is_string()) {
+        root["error"] = 1;
+        root["message"] = "flow_id is required";
+    } else {
+        bool with_body = src_root.value("body", true);
+        json packets = json::array();
+        for (const auto& record : m_mysql.get_http_packets(src_root["flow_id"].get<std::string>())) {
+            const HttpPacket& packet = record.packet;
+            json item;
+            item["direction"] = packet.type;
+            item["protocol"] = packet.top_protocol;
+            item["timestamp"] = format_datetime_us(packet.timestamp_us);
+            item["headers"] = packet.headers;
+            item["content_type"] = packet.content_type;
+            item["length"] = packet.length;
+            item["stored_bytes"] = record.body.stored_bytes();
+            if (with_body) {
+                item["body"] = record.body.text();
+                if (!record.body.error().empty()) item["body_error"] = record.body.error();
+            }
+            packets.push_back(std::move(item));
+        }
+        root["error"] = 0;
+        root["packets"] = std::move(packets);
+    }
+    std::string jsonstr = root.dump(-1, ' ', false, json::error_handler_t::replace);
+    beast::ostream(connection->m_response.body()) << jsonstr;
+
+    return true;
+
+});
+
+reg_post("/column_query", [this](std::shared_ptr<HttpConnection> connection) {
+    // 获取请求体
+    auto body_str = boost::beast::buffers_to_string(connection->m_request.body().data());
+    spdlog::info("column_query: Received body: {}", body_str);
+    // 请求格式见 ColumnQuery::from_json，例如按目的地址统计 DNS 报文：
+    // {"table": "dns_packets", "from": "2025-05-25 00:00:00", "group_by": ["des_ip"], "aggregates": [{"op": "count"}]}
+    json src_root = json::parse(body_str, nullptr, false);
+
+    // 设置响应头
+    connection->m_response.set(http::field::content_type, "application/json");
+
+    json root;
+    ColumnStore* store = m_mysql.column_store();
+    if (!store) {
+        root["error"] = 1;
+        root["message"] = "column store is not enabled (set NETWORK_ANALYSE_COLUMN_STORE)";
+    } else if (src_root.is_discarded()) {
+        root["error"] = 1;
+        root["message"] = "invalid JSON";
+    } else {
+        root = store->query(src_root);
+    }
+    std::string jsonstr = root.dump(-1, ' ', false, json::error_handler_t::replace);
+    beast::ostream(connection->m_response.body()) << jsonstr;
+
+    return true;
+
+});
+
 reg_post("/user_mgr", [this](std::shared_ptr<HttpConnection> connection) {
     // 获取请求体
     auto body_str = boost::beast::buffers_to_string(connection->m_request.body().data());
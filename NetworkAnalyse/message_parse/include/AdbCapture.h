@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <sys/types.h>
+
+/**
+ * @brief 经 adb exec-out 在设备上运行 tcpdump，从管道读取 pcap 流
+ *
+ * 流量在模拟器/真机内部抓取，不再依赖宿主机的转发与子接口配置。
+ * adb 程序路径取环境变量 ADB（默认 "adb"），测试时可指向向标准输出写 pcap 的替身脚本。
+ */
+class AdbCapture
+{
+public:
+    // link_type 为 pcap 文件头中的 LINKTYPE_*（-i any 时一般为 LINUX_SLL）
+    using PacketCallback = std::function<void(const timeval& ts, const uint8_t* data, size_t len, int link_type)>;
+
+    static const size_t READ_BUFFER_SIZE = 1024 * 1024;    // 单次从管道读取的字节数
+
+    /**
+     * @param serial    设备序列号（adb -s），如 "emulator-5554"
+     * @param filter    设备端 tcpdump 的 BPF 过滤表达式，可为空
+     */
+    AdbCapture(const std::string& serial, const std::string& filter);
+    ~AdbCapture();
+
+    /**
+     * @brief 启动 adb 并持续读取，直到管道结束或调用 stop()
+     * @return false 表示启动失败或 pcap 流格式错误，error 给出原因
+     */
+    bool                run(const PacketCallback& on_packet, std::string& error);
+    void                stop();                     // 结束设备端抓包，可在其他线程调用
+
+    const std::string&  serial() const { return m_serial; }
+
+private:
+    std::vector<std::string> build_command() const;
+    bool                spawn(std::string& error);
+    void                reap();                     // 等待并回收子进程，只由 run() 调用
+
+    const std::string   m_serial;
+    const std::string   m_filter;
+    std::mutex          m_pid_mutex;                // 保护 m_pid：stop() 发信号与 reap() 回收互斥
+    pid_t               m_pid = -1;                 // 未回收的子进程，回收后为 -1
+    int                 m_fd = -1;                  // 子进程标准输出的读端
+    std::atomic<bool>   m_stopping{false};
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 地址映射表（代理出口 -> 设备地址、子接口别名等）
+ *
+ * 条目分两层：常驻条目与本次采集的会话条目，会话条目优先。修改时重新生成只读快照并递增版本号，
+ * 解析线程通过 Reader 缓存快照，每个报文只比较一次版本号，查找以网络字节序的 32 位地址为键。
+ * 修改可在任意线程进行，无需停止采集。
+ */
+class AddressMap
+{
+public:
+    using Entries = std::vector<std::pair<std::string, std::string>>;   // 原地址 -> 映射后地址（点分十进制）
+
+    struct Snapshot
+    {
+        std::unordered_map<uint32_t, std::string>   map;    // 原地址（网络字节序）-> 映射后地址文本
+    };
+
+    /**
+     * @brief 解析线程持有的只读视图
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(const AddressMap& owner) : m_owner(owner), m_snapshot(owner.snapshot()) {}
+
+        void                refresh()       // 每个报文调用一次，表被修改后才重新取快照
+        {
+            uint64_t version = m_owner.version();
+            if (version != m_version)
+            {
+                m_snapshot = m_owner.snapshot();
+                m_version = version;
+            }
+        }
+
+        const std::string*  lookup(uint32_t addr) const     // 未命中返回 nullptr
+        {
+            if (m_snapshot->map.empty()) return nullptr;
+            auto it = m_snapshot->map.find(addr);
+            return it == m_snapshot->map.end() ? nullptr : &it->second;
+        }
+
+    private:
+        const AddressMap&                   m_owner;
+        std::shared_ptr<const Snapshot>     m_snapshot;
+        uint64_t                            m_version = 0;
+    };
+
+    AddressMap();
+
+    bool                set_base(const Entries& entries, std::string& error);      // 替换常驻条目
+    bool                set_session(const Entries& entries, std::string& error);   // 替换会话条目
+    Entries             entries() const;                                            // 合并后的全部条目
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+    uint64_t            version() const { return m_version.load(std::memory_order_acquire); }
+
+private:
+    using Layer = std::unordered_map<uint32_t, std::string>;
+
+    static bool         parse(const Entries& entries, Layer& layer, std::string& error);
+    void                rebuild();      // 调用方持有 m_mutex
+
+    mutable std::mutex                  m_mutex;
+    Layer                               m_base;
+    Layer                               m_session;
+    std::shared_ptr<const Snapshot>     m_snapshot;
+    std::atomic<uint64_t>               m_version{1};
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 被动解密所需的最小密码学工具集（基于 OpenSSL libcrypto）
+ *
+ * 只暴露 QUIC Initial 与 TLS 记录层解密需要的 HKDF / AEAD / AES-ECB 原语，
+ * 头文件不引入 OpenSSL，避免上层模块依赖其头文件路径。
+ */
+namespace crypto_util
+{
+    using Bytes = std::vector<uint8_t>;
+
+    enum class Hash { SHA256, SHA384 };
+    enum class Aead { AES_128_GCM, AES_256_GCM, CHACHA20_POLY1305 };
+
+    size_t      hash_length(Hash hash);
+    size_t      aead_key_length(Aead aead);
+
+    // RFC 5869 HKDF-Extract / HKDF-Expand
+    Bytes       hkdf_extract(Hash hash, const Bytes& salt, const Bytes& ikm);
+    Bytes       hkdf_expand(Hash hash, const Bytes& prk, const Bytes& info, size_t length);
+
+    // RFC 8446 7.1 HKDF-Expand-Label，label 不含 "tls13 " 前缀
+    Bytes       hkdf_expand_label(Hash hash, const Bytes& secret, const std::string& label,
+                                  const Bytes& context, size_t length);
+
+    // RFC 5246 5 TLS 1.2 PRF（P_hash），label 为 ASCII 标签，如 "key expansion"
+    Bytes       tls12_prf(Hash hash, const Bytes& secret, const std::string& label,
+                          const Bytes& seed, size_t length);
+
+    // 单个 16 字节分组的 AES-ECB 加密（QUIC 头部保护掩码）
+    bool        aes_ecb_encrypt_block(const Bytes& key, const uint8_t* in, uint8_t* out);
+
+    // AEAD 解密并校验 16 字节尾部 tag，成功时 out 为明文
+    bool        aead_decrypt(Aead aead, const Bytes& key, const uint8_t* nonce, size_t nonce_len,
+                             const uint8_t* aad, size_t aad_len,
+                             const uint8_t* in, size_t in_len, Bytes& out);
+
+    Bytes       from_hex(const std::string& hex);
+    std::string to_hex(const uint8_t* data, size_t len);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/time.h>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief 传给协议解析器的报文视图
+ *
+ * 指针指向原始报文或分片重组缓冲区，只在本次 dissect 调用期间有效。
+ */
+struct PacketView
+{
+    timeval         ts{};
+    uint16_t        l3 = 0;                 // 以太网类型（0x0800 IPv4）
+    uint8_t         l4 = 0;                 // IP 协议号
+    std::string     src_ip;
+    std::string     dst_ip;
+    const uint8_t*  ip_header = nullptr;
+    size_t          ip_header_len = 0;
+    const uint8_t*  l4_data = nullptr;      // 传输层头 + 负载
+    size_t          l4_len = 0;
+    int             src_port = 0;           // 无端口的协议为 0
+    int             dst_port = 0;
+    const uint8_t*  payload = nullptr;      // 传输层负载（UDP 负载；其余协议同 l4_data）
+    size_t          payload_len = 0;
+    uint32_t        sample_rate = 1;        // 该报文代表的采样率，1 表示未采样
+};
+
+/**
+ * @brief 协议解析器接口
+ *
+ * dissect 返回待入库的 JSON（带 protocol 字段，由存储线程分发），无需入库时返回空对象。
+ * detect 仅对注册为启发式识别的解析器调用。
+ */
+class Dissector
+{
+public:
+    virtual ~Dissector() = default;
+
+    virtual const std::string&  name() const = 0;
+    virtual nlohmann::json      dissect(const PacketView& packet) = 0;
+    virtual bool                detect(const PacketView& packet) const { (void)packet; return false; }
+};
+
+/**
+ * @brief 以函数对象实现的解析器，用于包装现有的解析函数
+ */
+class FunctionDissector : public Dissector
+{
+public:
+    using DissectFn = std::function<nlohmann::json(const PacketView&)>;
+    using DetectFn = std::function<bool(const PacketView&)>;
+
+    FunctionDissector(std::string name, DissectFn dissect, DetectFn detect = nullptr)
+        : m_name(std::move(name)), m_dissect(std::move(dissect)), m_detect(std::move(detect)) {}
+
+    const std::string&  name() const override { return m_name; }
+    nlohmann::json      dissect(const PacketView& packet) override { return m_dissect(packet); }
+    bool                detect(const PacketView& packet) const override { return m_detect && m_detect(packet); }
+
+private:
+    std::string     m_name;
+    DissectFn       m_dissect;
+    DetectFn        m_detect;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Dissector.h"
+
+/**
+ * @brief 协议解析器注册表
+ *
+ * 注册阶段按（L3 协议, L4 协议, 端口）、（L3, L4）整协议或启发式识别登记解析器，
+ * build() 时只把启用的解析器展开成平铺分发表：每个 (L3, L4) 一张 65536 项的端口表，
+ * 报文路径上是两次数组下标访问，未启用的解析器不出现在表中，没有任何开销。
+ * 匹配顺序：端口（先较小端口）-> 启发式 -> 整协议。
+ * 注册与 build 在解析线程启动前完成，之后只读。
+ */
+class DissectorRegistry
+{
+public:
+    enum L3Proto { L3_IPV4 = 0, L3_COUNT };
+
+    static int          l3_index(uint16_t ether_type);      // 以太网类型 -> L3 下标，不支持时返回 -1
+
+    void                add(std::shared_ptr<Dissector> dissector, bool enabled = true);
+    void                bind_port(const std::string& name, uint16_t ether_type, uint8_t l4, uint16_t port);
+    void                bind_protocol(const std::string& name, uint16_t ether_type, uint8_t l4);
+    void                bind_heuristic(const std::string& name, uint16_t ether_type, uint8_t l4);
+
+    bool                set_enabled(const std::string& name, bool enabled);     // 未注册的名称返回 false
+    bool                is_enabled(const std::string& name) const;
+    void                reset_enabled();                                        // 恢复注册时的默认值
+    std::vector<std::string> enabled_names() const;
+
+    void                build();                                                // 生成分发表
+
+    /**
+     * @brief 查找报文对应的解析器（build 之后调用）
+     * @return 未匹配时返回 nullptr
+     */
+    Dissector*          lookup(int l3, const PacketView& packet) const
+    {
+        const Table* table = m_tables[l3][packet.l4].get();
+        if (!table) return nullptr;
+        if (!table->ports.empty())
+        {
+            int low = packet.src_port < packet.dst_port ? packet.src_port : packet.dst_port;
+            int high = packet.src_port < packet.dst_port ? packet.dst_port : packet.src_port;
+            uint8_t index = table->ports[low];
+            if (!index) index = table->ports[high];
+            if (index) return table->dissectors[index];
+        }
+        for (Dissector* heuristic : table->heuristics)
+            if (heuristic->detect(packet)) return heuristic;
+        return table->fallback;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Dissector>  dissector;
+        bool                        default_enabled = true;
+        bool                        enabled = true;
+    };
+    struct Binding
+    {
+        enum Kind { PORT, PROTOCOL, HEURISTIC } kind;
+        std::string     name;
+        int             l3;
+        uint8_t         l4;
+        uint16_t        port;
+    };
+    struct Table
+    {
+        std::vector<uint8_t>        ports;          // 端口 -> dissectors 下标，0 表示未绑定；无端口绑定时为空
+        std::vector<Dissector*>     dissectors{nullptr};
+        std::vector<Dissector*>     heuristics;
+        Dissector*                  fallback = nullptr;
+    };
+
+    void                bind(Binding::Kind kind, const std::string& name, uint16_t ether_type,
+                             uint8_t l4, uint16_t port);
+
+    std::map<std::string, Entry>                            m_entries;
+    std::vector<Binding>                                    m_bindings;
+    std::array<std::array<std::unique_ptr<Table>, 256>, L3_COUNT>   m_tables;
+};
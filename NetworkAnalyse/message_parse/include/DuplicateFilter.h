@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include "Dissector.h"
+
+/**
+ * @brief 重复报文判定参数
+ */
+struct DuplicateFilterConfig
+{
+    int64_t         window_us = 50000;          // 时间桶宽度，重复副本需在 1~2 个桶内出现
+    size_t          max_entries = 65536;        // 单个时间桶的指纹上限，超出后不再登记
+    size_t          payload_prefix = 32;        // 参与指纹的负载前缀字节
+};
+
+/**
+ * @brief 短窗口重复报文检测
+ *
+ * 镜像口、子接口转发会让同一报文在抓包接口上出现两次（入方向一次、转发后一次）。
+ * 指纹取 IP 标识、映射后的五元组、TCP 序号/确认号/标志、负载长度与负载前缀，不含 TTL 与校验和，
+ * 因此转发副本与原报文得到同一指纹；正常重传的 IP 标识不同，不会被误判。
+ * 指纹保存在当前/上一两个时间桶中，按报文时间戳轮换。仅由解析线程调用。
+ */
+class DuplicateFilter
+{
+public:
+    explicit DuplicateFilter(const DuplicateFilterConfig& config = DuplicateFilterConfig());
+
+    bool                is_duplicate(const PacketView& packet);     // true 表示窗口内已见过该报文
+
+    uint64_t            duplicates() const { return m_duplicates.load(std::memory_order_relaxed); }  // 可在其他线程读取
+
+private:
+    uint64_t            fingerprint(const PacketView& packet) const;
+    void                rotate(int64_t now_us);
+
+    DuplicateFilterConfig           m_config;
+    std::unordered_set<uint64_t>    m_current;          // 当前时间桶
+    std::unordered_set<uint64_t>    m_previous;         // 上一个时间桶
+    int64_t                         m_bucket_start_us = 0;
+    std::atomic<uint64_t>           m_duplicates{0};
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 加密流量分类用的逐流特征，随会话表条目内联存放
+ *
+ * 记录前 MAX_PACKETS 个携带负载的报文的长度、方向与到达间隔，以及整条流的突发（burst）统计。
+ * 固定长度数组，报文路径上不做任何内存分配；纯 ACK 等空负载报文不计入。
+ * 前 MAX_PACKETS 个报文收齐时随增量记录输出一次，会话结束时随终结记录再输出完整的突发统计。
+ * 方向：0 表示发起方->响应方，1 表示反向。
+ */
+struct FlowFeatures
+{
+    static const size_t MAX_PACKETS = 20;
+
+    uint32_t        sizes[MAX_PACKETS];         // 负载字节
+    uint32_t        iat_us[MAX_PACKETS];        // 与上一个负载报文的间隔，首个为 0
+    uint32_t        directions = 0;             // 第 i 位为第 i 个报文的方向
+    uint8_t         count = 0;                  // 已记录的报文数
+    bool            exported = false;           // 已随增量记录输出（终结记录总会再输出）
+
+    int64_t         last_us = 0;                // 上一个负载报文时间
+    uint64_t        bursts = 0;                 // 突发数（连续同方向报文为一个突发）
+    uint64_t        burst_packets = 0;          // 当前突发
+    uint64_t        burst_bytes = 0;
+    uint64_t        max_burst_packets = 0;
+    uint64_t        max_burst_bytes = 0;
+    uint64_t        total_bytes = 0;            // 全部负载字节，用于平均突发长度
+    int8_t          burst_direction = -1;
+
+    bool            full() const { return count == MAX_PACKETS; }
+    void            update(int direction, size_t payload_len, int64_t ts_us);
+    std::string     to_json() const;            // 输出时才分配
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief HPACK（RFC 7541）头部块解码器
+ *
+ * 每个 HTTP/2 连接的每个方向各持有一个实例，动态表状态在该方向的
+ * 所有头部块之间共享，因此必须按帧顺序逐个解码，不能跳过任何头部块。
+ */
+class HpackDecoder
+{
+public:
+    using Header = std::pair<std::string, std::string>;
+
+    explicit HpackDecoder(size_t max_table_size = 4096);
+
+    bool                decode(const uint8_t* data, size_t len, std::vector<Header>& headers); // 解码完整头部块
+    void                set_max_table_size(size_t size);     // 对端 SETTINGS_HEADER_TABLE_SIZE 更新
+    size_t              table_size() const { return m_table_size; }
+
+private:
+    bool                decode_integer(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& value);
+    bool                decode_string(const uint8_t*& p, const uint8_t* end, std::string& out);
+    bool                decode_huffman(const uint8_t* p, size_t len, std::string& out);
+    bool                lookup(uint64_t index, Header& header) const;
+    void                insert(const Header& header);
+    void                evict(size_t target_size);
+
+    std::deque<Header>  m_dynamic_table;        // 动态表，front 为最新条目
+    size_t              m_table_size;           // 当前动态表大小（按 RFC 计算，每项 +32）
+    size_t              m_max_table_size;       // 编码端通过动态表大小更新指令设置的上限
+    size_t              m_settings_max_size;    // SETTINGS 协商的上限
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <sys/time.h>
+#include "Http2Parser.h"
+
+/**
+ * @brief HTTP/1.x 报文解析器，一个实例对应一条 TCP 连接
+ *
+ * 与 Http2Connection 相同，调用方按 TCP 序号顺序投递两个方向的字节流（TLS 解密后的数据），
+ * 解析器完成请求/响应分帧（Content-Length、chunked、读到连接关闭），按顺序配对流水线请求，
+ * 每个交换完成时以 Http2Stream 形式回调，沿用 HTTP/2 的入库路径（stream_id 为连接内序号）。
+ */
+class Http1Connection
+{
+public:
+    enum Direction { CLIENT_TO_SERVER = 0, SERVER_TO_CLIENT = 1 };
+    using StreamCallback = Http2Connection::StreamCallback;
+
+    static const size_t MAX_BODY_CAPTURE = Http2Connection::MAX_BODY_CAPTURE;  // 每个方向最多保留的 body 字节
+    static const size_t MAX_HEAD_BYTES = 64 * 1024;                            // 起始行 + 头部的上限
+
+    /**
+     * @param base      连接级公共字段（app_uid、五元组、flow_id 前缀等），复制到每个交换
+     * @param on_done   交换结束回调
+     * @param tls       是否为 TLS 解密得到的数据（决定 URL scheme 与 top_protocol）
+     */
+    Http1Connection(const HttpFlowInfo& base, StreamCallback on_done, bool tls);
+
+    static bool         is_request(const uint8_t* data, size_t len);   // 是否以 HTTP/1.x 请求行开头
+
+    bool                feed(Direction dir, const uint8_t* data, size_t len, const timeval& ts); // false 表示协议错误
+    void                close(const timeval& ts);                                   // 连接关闭，输出未完成的交换
+
+private:
+    enum class Phase : uint8_t
+    {
+        HEAD,           // 等待起始行与头部
+        LENGTH,         // Content-Length 定长 body
+        CHUNK_SIZE,     // chunked：等待块长度行
+        CHUNK_DATA,     // chunked：块数据（含结尾 CRLF）
+        CHUNK_TRAILER,  // chunked：末块之后的 trailer
+        UNTIL_CLOSE,    // 无长度的响应，读到连接关闭
+        STOPPED,        // 协议切换（101）后不再解析
+    };
+
+    struct DirectionState
+    {
+        std::string     buffer;                 // 未处理的字节
+        Phase           phase = Phase::HEAD;
+        uint64_t        remaining = 0;          // LENGTH / CHUNK_DATA 阶段剩余字节
+        Http2Stream*    current = nullptr;      // 正在接收 body 的交换
+    };
+
+    bool                parse_head(Direction dir, const timeval& ts);
+    bool                parse_body(Direction dir, const timeval& ts);
+    void                append_body(Direction dir, const char* data, size_t len);
+    void                end_message(Direction dir, const timeval& ts);
+    Http2Stream&        new_exchange(const timeval& ts);
+    Http2Stream*        awaiting_response();                    // 最早的尚未收到最终响应的交换
+    void                finish_completed();                     // 按顺序输出已完成的交换
+
+    HttpFlowInfo                m_base;         // 连接级公共字段
+    StreamCallback              m_on_done;
+    bool                        m_tls;
+    DirectionState              m_dir[2];
+    std::deque<Http2Stream>     m_exchanges;    // 进行中的交换，按请求顺序
+    uint32_t                    m_count = 0;    // 已建立的交换数
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <sys/time.h>
+#include <MySQLDAO.h>
+#include "HpackDecoder.h"
+
+/**
+ * @brief HTTP/2 单个流（一次请求/响应）的解析结果
+ *
+ * flow/request/response 直接对应 http_flow_info 与 http_packets 表的记录，
+ * 时间字段保留原始 timeval，由调用方在入库前统一格式化。
+ */
+struct Http2Stream
+{
+    uint32_t        stream_id = 0;
+    HttpFlowInfo    flow{};                     // 对应 http_flow_info 记录
+    HttpPacket      request{};                  // 请求头 + 请求体（截断至 MAX_BODY_CAPTURE）
+    HttpPacket      response{};                 // 响应头 + 响应体（截断至 MAX_BODY_CAPTURE）
+
+    uint64_t        request_header_bytes = 0;   // 请求 HEADERS/CONTINUATION 负载字节
+    uint64_t        request_body_bytes = 0;     // 请求 DATA 负载字节（不含填充）
+    uint64_t        response_header_bytes = 0;
+    uint64_t        response_body_bytes = 0;
+
+    timeval         request_start{};            // 首个请求 HEADERS 帧时间
+    timeval         request_end{};              // 请求 END_STREAM 时间
+    timeval         response_start{};           // 首个最终响应 HEADERS 帧时间（首字节时延）
+    timeval         response_end{};             // 响应 END_STREAM 时间
+
+    bool            request_done = false;
+    bool            response_done = false;
+    bool            reset = false;              // 收到 RST_STREAM
+    bool            pushed = false;             // 服务端推送流（PUSH_PROMISE）
+};
+
+/**
+ * @brief HTTP/2 帧级解析器，一个实例对应一条 TCP 连接
+ *
+ * 调用方负责按 TCP 序号顺序投递两个方向的字节流（h2c 明文或 TLS 解密后的数据），
+ * 解析器完成分帧、HPACK 解码，并在每个流结束（双向 END_STREAM 或 RST_STREAM）时回调。
+ * 帧长度按接收端声明的 SETTINGS_MAX_FRAME_SIZE 检查；进行中的流数不超过 MAX_STREAMS
+ * 与两端声明的 SETTINGS_MAX_CONCURRENT_STREAMS 之和，缺失 END_STREAM 的流不会无限积累。
+ */
+class Http2Connection
+{
+public:
+    enum Direction { CLIENT_TO_SERVER = 0, SERVER_TO_CLIENT = 1 };
+    using StreamCallback = std::function<void(Http2Stream&)>;
+
+    static const size_t MAX_BODY_CAPTURE = 64 * 1024;    // 每个方向最多保留的 body 字节
+    static const size_t DEFAULT_MAX_FRAME_SIZE = 16384;  // SETTINGS_MAX_FRAME_SIZE 初始值（RFC 7540 6.5.2）
+    static const size_t MAX_STREAMS = 256;               // 同时跟踪的流上限，超出时最早开始的流提前输出
+
+    /**
+     * @param base      连接级公共字段（app_uid、五元组、flow_id 前缀等），复制到每个流
+     * @param on_done   流结束回调
+     * @param upgrade   是否为 HTTP/1.1 Upgrade: h2c 方式建立的连接
+     */
+    Http2Connection(const HttpFlowInfo& base, StreamCallback on_done, bool upgrade = false);
+
+    static bool         is_client_preface(const uint8_t* data, size_t len);   // 是否以 h2 连接前言开头
+    static bool         is_h2c_upgrade(const uint8_t* data, size_t len);      // 是否为 Upgrade: h2c 请求
+
+    bool                feed(Direction dir, const uint8_t* data, size_t len, const timeval& ts); // false 表示协议错误
+    void                close(const timeval& ts);                             // 连接关闭，输出未完成的流
+    size_t              active_streams() const { return m_streams.size(); }
+
+private:
+    struct DirectionState
+    {
+        std::string     buffer;                 // 未组成完整帧的字节
+        int             handshake_steps = 0;    // 剩余待越过的握手阶段（HTTP/1.1 升级报文、连接前言）
+        HpackDecoder    hpack;                  // 该方向头部块的 HPACK 解码器
+        std::string     header_block;           // 等待 CONTINUATION 的头部块片段
+        uint32_t        header_stream = 0;      // 当前头部块所属流，0 表示无
+        uint32_t        promised_stream = 0;    // PUSH_PROMISE 承诺的流
+        bool            header_end_stream = false;
+        size_t          header_frame_bytes = 0;
+        size_t          max_frame_size = DEFAULT_MAX_FRAME_SIZE;    // 该方向帧长度上限（由接收端声明）
+        size_t          max_concurrent = MAX_STREAMS;   // 该方向发送端声明的 SETTINGS_MAX_CONCURRENT_STREAMS
+    };
+
+    bool                consume_handshake(Direction dir, const timeval& ts);
+    bool                handle_frame(Direction dir, uint8_t type, uint8_t flags, uint32_t stream_id,
+                                     const uint8_t* payload, size_t len, const timeval& ts);
+    bool                handle_header_block(Direction dir, const timeval& ts);
+    Http2Stream&        get_stream(uint32_t stream_id, const timeval& ts);
+    void                end_stream(Direction dir, uint32_t stream_id, const timeval& ts);
+    void                finish_stream(uint32_t stream_id);
+    void                evict_oldest_stream();
+
+    HttpFlowInfo                        m_base;         // 连接级公共字段
+    StreamCallback                      m_on_done;      // 流结束回调
+    DirectionState                      m_dir[2];       // 两个方向的解析状态
+    std::map<uint32_t, Http2Stream>     m_streams;      // 进行中的流
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <sys/time.h>
+
+/**
+ * @brief 分片重组参数
+ */
+struct ReassemblyConfig
+{
+    size_t          max_bytes = 4 * 1024 * 1024;    // 所有未完成数据报占用的内存上限
+    std::time_t     timeout = 30;                   // 单个数据报从首个分片起的最长等待时间（秒）
+    size_t          max_datagrams = 1024;           // 同时重组的数据报上限
+};
+
+/**
+ * @brief 分片重组计数器
+ */
+struct ReassemblyStats
+{
+    uint64_t        fragments = 0;
+    uint64_t        reassembled = 0;
+    uint64_t        timed_out = 0;
+    uint64_t        evicted = 0;        // 超出内存/数量上限被丢弃
+    uint64_t        overlaps = 0;       // 重叠内容不一致被丢弃
+    uint64_t        malformed = 0;      // 偏移/长度不合法
+};
+
+/**
+ * @brief IPv4 分片重组
+ *
+ * 以（源地址, 目的地址, 标识, 协议）区分数据报，分片按偏移放入缓冲区并记录已收区间。
+ * 重复分片忽略，重叠部分内容不一致时整个数据报丢弃（避免按不同重叠策略得到不同结果）。
+ * 超时按首个分片时间判断，内存或数量超限时淘汰最早的数据报。
+ * 非分片报文只检查一次 flag_offset，不产生额外开销。仅由解析线程调用，内部不加锁。
+ */
+class Ipv4Reassembler
+{
+public:
+    enum class Result { NOT_FRAGMENT, PENDING, COMPLETE, DROPPED };
+
+    explicit Ipv4Reassembler(const ReassemblyConfig& config = ReassemblyConfig());
+
+    static bool         is_fragment(const uint8_t* ip);     // MF 置位或偏移非零
+
+    /**
+     * @brief 处理一个 IPv4 报文
+     * @param ip   IP 头起始
+     * @param len  IP 报文长度（已按 total_length 截去链路层填充）
+     * @param out  COMPLETE 时输出完整数据报（IP 头 + 负载，头部长度与校验和已修正）
+     */
+    Result              process(const uint8_t* ip, size_t len, const timeval& ts, std::vector<uint8_t>& out);
+
+    size_t              pending() const { return m_datagrams.size(); }
+    size_t              memory() const { return m_bytes; }
+    const ReassemblyStats& stats() const { return m_stats; }
+
+private:
+    struct Key
+    {
+        uint32_t    src;
+        uint32_t    dst;
+        uint16_t    id;
+        uint8_t     protocol;
+        bool operator==(const Key& other) const
+        {
+            return src == other.src && dst == other.dst && id == other.id && protocol == other.protocol;
+        }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            uint64_t v = (static_cast<uint64_t>(key.src) << 32) ^ key.dst;
+            v ^= (static_cast<uint64_t>(key.id) << 16) ^ key.protocol;
+            return std::hash<uint64_t>()(v * 0x9E3779B97F4A7C15ULL);
+        }
+    };
+    struct Datagram
+    {
+        std::vector<uint8_t>            header;         // 偏移 0 分片的 IP 头
+        std::vector<uint8_t>            payload;        // 按偏移存放的负载
+        std::map<uint32_t, uint32_t>    ranges;         // 已收区间 [起, 止)，相邻区间合并
+        uint32_t                        total = 0;      // 负载总长，收到末片后确定
+        bool                            have_last = false;
+        std::time_t                     first_seen = 0;
+        size_t                          charged = 0;    // 计入 m_bytes 的字节数
+        std::list<Key>::iterator        order;          // 在 m_order 中的位置
+    };
+
+    bool                add_fragment(Datagram& dg, uint32_t offset, const uint8_t* data, size_t len);
+    bool                complete(const Datagram& dg) const;
+    void                build(const Datagram& dg, std::vector<uint8_t>& out) const;
+    void                remove(const Key& key);
+    void                expire(std::time_t now);
+    void                charge(Datagram& dg);
+
+    ReassemblyConfig                                m_config;
+    std::unordered_map<Key, Datagram, KeyHash>      m_datagrams;
+    std::list<Key>                                  m_order;        // 按首个分片时间排序，最早的在前
+    size_t                                          m_bytes = 0;
+    ReassemblyStats                                 m_stats;
+};
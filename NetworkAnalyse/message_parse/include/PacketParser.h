@@ -7,15 +7,41 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 #include <MySQLDAO.h>
 #include "format.h"
+#include "AddressMap.h"
+#include "DissectorRegistry.h"
+#include "DuplicateFilter.h"
+#include "Http1Parser.h"
+#include "Http2Parser.h"
+#include "Ipv4Reassembler.h"
+#include "QuicParser.h"
+#include "Sampler.h"
+#include "SessionTable.h"
+#include "TlsDecryptor.h"
+#include "TlsKeyLog.h"
 
 //extern   std::map<std::string, std::queue<nlohmann::json>>    g_parsed_packets_map; // 存储解析后的 JSON 数据
 
 struct Packet {
     timeval timestamp; // 时间戳
     std::vector<uint8_t> data; // 数据
+    int link_type = 1; // 链路层类型（LINKTYPE_*），实时抓包为以太网，设备端 tcpdump -i any 为 LINUX_SLL
+    std::string device; // 来源设备序列号（adb 抓包时），本机网卡为空
+};
+
+// 单次采集的配置
+struct CaptureOptions {
+    std::map<std::string, bool> dissectors;     // 按名称启用/关闭解析器，未列出的保持默认
+    AddressMap::Entries         address_map;    // 本次采集的地址映射条目，优先于常驻条目
+    bool                        features = false;   // 是否提取逐流分类特征（报文长度/间隔序列等）
+    std::string                 tls_keylog;         // NSS key log 文件路径，非空时被动解密 TLS 连接中的 HTTP
+    std::string                 pcap_file;          // 非空时回放该 pcap 文件而不是实时抓包
+    std::string                 adb_serial;         // 非空时经 adb exec-out tcpdump 在该设备上抓包
+    bool                        bulk_load = false;  // 报文记录积压较多时改用 LOAD DATA LOCAL INFILE 批量导入
 };
 
 class PacketParser {
@@ -24,7 +50,9 @@ public:
     ~PacketParser();
 
     void                push_raw_packet(const Packet& packet); // 添加原始数据包
-    void                start(int uid=10001);
+    void                start(int uid=10001, const CaptureOptions& options = CaptureOptions());
+    // 替换地址映射条目（session 为 true 时替换本次采集的条目），采集中即时生效
+    bool                set_address_map(const AddressMap::Entries& entries, bool session, std::string& error);
     void                stop();
     //bool                get_parsed_packet(const std::string& protocol, nlohmann::json& result); // 获取解析结果队列
 
@@ -32,21 +60,47 @@ private:
     void                parse_loop();  // 解析线程主循环
     void                parse_packet(const Packet& packet);   // 解析数据包
     void                start_storage();
+    void                register_dissectors();  // 登记协议解析器
 
     // 协议解析器
     nlohmann::json      parse_tcp(const uint8_t* data, size_t len, const timeval& ts,
                              const std::string& src_ip, const std::string& des_ip,
-                             const uint8_t* ip_header_ptr, size_t ip_header_lenp); // 解析 TCP 数据包
+                             const uint8_t* ip_header_ptr, size_t ip_header_lenp,
+                             uint32_t sample_rate = 1); // 解析 TCP 数据包
     nlohmann::json      parse_udp(const uint8_t* data, size_t len, const timeval& ts,
                               const std::string& src_ip, const std::string& des_ip,
                             const uint8_t* ip_header_ptr, size_t ip_header_len);
+    bool                parse_quic(const uint8_t* data, size_t len, const timeval& ts,
+                            const std::string& src_ip, int src_port,
+                            const std::string& des_ip, int des_port,
+                            uint32_t sample_rate = 1);   // QUIC 连接跟踪与 SNI 提取，不属于 QUIC 时返回 false
+    void                track_udp(const uint8_t* payload, size_t len, const timeval& ts,
+                            const std::string& src_ip, int src_port,
+                            const std::string& des_ip, int des_port,
+                            uint32_t sample_rate = 1);   // 非 DNS/QUIC 的 UDP 按流计数
+    nlohmann::json      parse_icmp(const uint8_t* data, size_t len, const timeval& ts,
+                            const std::string& src_ip, const std::string& des_ip,
+                            const uint8_t* ip_header_ptr, size_t ip_header_len);
     nlohmann::json      parse_dns(const uint8_t* data, size_t len, const timeval& ts,
                             const std::string& src_ip, const std::string& des_ip,
                             const uint8_t* ip_header_ptr, size_t ip_header_len);
 
     std::string         parse_tcp_flags(uint8_t flags);     // 解析 TCP 标志
 
-    std::string         format_timeval(const timeval& tv);          //转换时间戳格式
+    void                format_address(uint32_t addr, std::string& out) const; // 地址映射 + 转文本
+
+    // HTTP 连接跟踪：h2c 明文直接交给 Http2Connection；配置了 key log 时 TLS 连接先解密，
+    // 再按 ALPN / 明文内容交给 HTTP/2 或 HTTP/1 解析器。两个方向的负载按 TCP 序号顺序投递
+    void                track_http(const std::string& src_ip, int src_port,
+                                   const std::string& dst_ip, int dst_port,
+                                   const TCP_HEADER* tcp, const uint8_t* payload, size_t payload_len,
+                                   const timeval& ts);
+    struct HttpTracker;
+    bool                feed_http(HttpTracker& tracker, int dir, const uint8_t* data, size_t len,
+                                  const timeval& ts);               // 投递到 TLS 解密器或 HTTP 解析器
+    void                close_http(HttpTracker& tracker, const timeval& ts);
+    void                sweep_http(const timeval& ts);              // 清理空闲连接
+    void                flush_pending_http();                       // 已完成的流写入数据库
 
     //会话
     void                session_management_loop();
@@ -84,14 +138,46 @@ private:
     // const size_t                                        MAX_SESSIONS_PER_FLUSH = 100;   
     
     // 新增存储控制参数
-    const size_t MIN_SESSIONS_BEFORE_FLUSH = 20;  // 最小存储会话数
+    const size_t MIN_SESSIONS_BEFORE_FLUSH = 20;  // 待存储的已结束会话数达到该值时提前刷新
+    static const size_t UDP_FINGERPRINT_BYTES = 16;   // UDP 流首个负载保留的前缀字节
+    static const size_t SESSION_BULK_MIN_ROWS = 2000; // 批量导入时一次刷新的会话记录达到该数走 LOAD DATA
     const int FLUSH_TIMEOUT_SECONDS = 5;         // 存储超时时间(秒)
     
-    std::map<std::string, SessionInfo>           m_activeSessions; // 活跃会话集
+    SessionTable                                 m_sessions;       // 活跃会话表（有界，时间轮超时）
     std::mutex                                   m_sessionsMutex;
     std::time_t                                  m_lastFlushTime;  // 上次存储时间
     std::atomic<bool>                            m_flushInProgress; // 存储进行中标志
 
-    std::string             m_src_ip="192.168.31.200";
+    struct HttpTracker
+    {
+        HttpFlowInfo                        base{};             // 连接级公共字段
+        std::unique_ptr<TlsDecryptor>       tls;                // TLS 连接的解密器，h2c 为空
+        std::unique_ptr<Http2Connection>    h2;                 // 二者至多其一，TLS 连接在首段明文后确定
+        std::unique_ptr<Http1Connection>    h1;
+        std::string                         client;             // 客户端 "ip:port"
+        uint32_t                            next_seq[2] = {0, 0};   // 各方向期望的下一个序号
+        bool                                seq_valid[2] = {false, false};
+        bool                                fin[2] = {false, false};
+        std::time_t                         last_seen = 0;
+    };
+    std::unordered_map<std::string, HttpTracker>    m_http_conns;       // 仅解析线程访问
+    std::time_t                                     m_last_http_sweep = 0;
+    std::vector<Http2Stream>                        m_pending_http;     // 待入库的已完成交换（HTTP/1 与 HTTP/2）
+    std::mutex                                      m_http_mutex;
+    TlsKeyLog                                       m_keylog;           // TLS 被动解密的密钥来源，仅解析线程访问
+
+    QuicTracker                                     m_quic;             // 仅解析线程访问
+    bool                                            m_udp_flows = true; // "udp" 解析器是否启用（QUIC 归属失败时回落）
+    bool                                            m_features = false; // 是否提取逐流分类特征
+    bool                                            m_bulk_load = false; // 存储线程是否启用 LOAD DATA 批量导入
+    std::string                                     m_device;           // 本次采集的来源设备（adb 序列号），写入会话与 HTTP 记录
+    std::unique_ptr<BulkLoader>                     m_session_bulk;     // 批量导入时会话记录的导入连接，仅会话刷新使用
+    Ipv4Reassembler                                 m_reassembler;      // IPv4 分片重组，仅解析线程访问
+    DissectorRegistry                               m_dissectors;       // 协议解析器分发表，start() 时生成
+    Sampler                                         m_sampler;          // 过载采样，仅解析线程访问
+    DuplicateFilter                                 m_duplicates;       // 转发/镜像副本检测，仅解析线程访问
+    AddressMap                                      m_address_map;      // 地址映射表，任意线程可修改
+    AddressMap::Reader                              m_address_reader;   // 解析线程缓存的映射快照
+
     int                     app_uid=10001;
 };
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/time.h>
+
+/**
+ * @brief pcap 字节流的增量解析（如 tcpdump -w - 的管道输出）
+ *
+ * 数据可按任意大小分块投递，不完整的记录保留到下次。支持微秒/纳秒两种魔数及两种字节序，
+ * pcapng 不支持（tcpdump -w 默认输出 pcap）。
+ */
+class PcapStreamReader
+{
+public:
+    using PacketCallback = std::function<void(const timeval& ts, const uint8_t* data, size_t len)>;
+
+    static const uint32_t MAX_SNAPLEN = 256 * 1024;     // 单条记录长度上限，超过视为流损坏
+
+    /**
+     * @brief 投递一段字节流，对其中完整的记录逐条回调
+     * @return false 表示格式错误（魔数不识别或记录长度异常），流无法继续解析
+     */
+    bool                feed(const uint8_t* data, size_t len, const PacketCallback& on_packet);
+
+    bool                has_header() const { return m_have_header; }
+    int                 link_type() const { return m_link_type; }    // 文件头中的 LINKTYPE_*，读到文件头前为 -1
+    const std::string&  error() const { return m_error; }
+
+private:
+    bool                parse_header(const uint8_t* p);
+    uint32_t            read_u32(const uint8_t* p) const;
+
+    std::string         m_buffer;               // 跨块的不完整文件头/记录
+    bool                m_have_header = false;
+    bool                m_swapped = false;      // 写入端字节序与本机不同
+    bool                m_nanosecond = false;   // 时间戳小数部分为纳秒
+    int                 m_link_type = -1;
+    std::string         m_error;
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/time.h>
+
+/**
+ * @brief 一条 QUIC 连接的跟踪记录
+ *
+ * 以客户端首个 Initial 的目的连接 ID（original DCID）作为稳定标识，
+ * 端口迁移 / NAT 重绑定后仍归属同一记录。
+ */
+struct QuicConnection
+{
+    std::string     id;                         // 稳定标识（original DCID 十六进制）
+    std::string     original_dcid;              // original DCID 原始字节，用于推导 Initial 密钥
+    uint32_t        version = 0;
+    std::string     server_name;                // ClientHello SNI
+    std::string     alpn;                       // ClientHello ALPN 首选协议
+
+    std::string     client_ip;                  // 当前客户端地址（迁移后更新）
+    int             client_port = 0;
+    std::string     server_ip;
+    int             server_port = 0;
+
+    uint64_t        packets[2] = {0, 0};        // [0] 客户端->服务端，[1] 服务端->客户端
+    uint64_t        bytes[2] = {0, 0};          // UDP 负载字节
+    uint32_t        migrations = 0;             // 客户端地址变化次数
+    timeval         first_seen{};
+    timeval         last_seen{};
+
+    // 以下为解析器内部状态
+    std::map<uint64_t, std::string> crypto_fragments;   // Initial 级 CRYPTO 帧（偏移 -> 数据）
+    size_t          crypto_bytes = 0;
+    bool            hello_done = false;         // ClientHello 已解析或放弃
+    std::vector<std::string> cids;              // 已登记的连接 ID
+    std::vector<std::string> tuples;            // 已登记的四元组
+};
+
+/**
+ * @brief 客户端 Initial 包保护密钥（RFC 9001 5.2），由 original DCID 推导
+ */
+struct QuicInitialKeys
+{
+    std::vector<uint8_t>    key;                // AEAD 密钥（AES-128-GCM）
+    std::vector<uint8_t>    iv;
+    std::vector<uint8_t>    hp;                 // 头部保护密钥
+};
+
+/**
+ * @brief QUIC 长包头识别、Initial 解密与连接 ID 跟踪
+ *
+ * 客户端 Initial 的密钥完全由 DCID 推导（RFC 9001 5.2），无需任何会话密钥即可
+ * 解出 ClientHello 取得 SNI/ALPN。之后的 Handshake/1-RTT 包只做连接归属与计数。
+ * 仅由解析线程调用，内部不加锁。
+ */
+class QuicTracker
+{
+public:
+    QuicTracker() = default;
+
+    /**
+     * @brief 处理一个 UDP 负载
+     * @param direction 输出：0 表示客户端->服务端，1 表示反向
+     * @return 所属连接；不是 QUIC 或无法归属时返回 nullptr
+     */
+    QuicConnection*     process(const std::string& src_ip, int src_port,
+                                const std::string& dst_ip, int dst_port,
+                                const uint8_t* payload, size_t len, const timeval& ts, int& direction);
+
+    static bool         is_long_header(const uint8_t* data, size_t len);   // 带固定位的长包头
+    // 推导客户端 Initial 密钥，版本不支持时返回 false
+    static bool         client_initial_keys(uint32_t version, const std::string& dcid, QuicInitialKeys& keys);
+
+    // 是否可能属于 QUIC：长包头，或四元组/短包头连接 ID 已被跟踪（只读，不建连接）
+    bool                recognizes(const std::string& src_ip, int src_port,
+                                   const std::string& dst_ip, int dst_port,
+                                   const uint8_t* payload, size_t len) const;
+    void                expire(const timeval& ts);                          // 清理空闲连接
+    size_t              size() const { return m_connections.size(); }
+
+private:
+    using ConnPtr = std::shared_ptr<QuicConnection>;
+
+    ConnPtr             find_by_cid(const std::string& cid) const;
+    ConnPtr             find_short_header(const uint8_t* data, size_t len) const;
+    ConnPtr             find_by_tuple(const std::string& tuple) const;
+    ConnPtr             create(const std::string& client_ip, int client_port,
+                               const std::string& server_ip, int server_port,
+                               const std::string& dcid, uint32_t version, const timeval& ts);
+    void                register_cid(const ConnPtr& conn, const std::string& cid);
+    void                register_tuple(const ConnPtr& conn, const std::string& tuple);
+    void                remove(const ConnPtr& conn);
+
+    bool                decrypt_client_initial(QuicConnection& conn, const uint8_t* packet, size_t pn_offset,
+                                               size_t packet_len);
+    void                handle_crypto_frames(QuicConnection& conn, const uint8_t* data, size_t len);
+    void                parse_client_hello(QuicConnection& conn);
+
+    std::unordered_map<std::string, ConnPtr>    m_by_cid;       // 连接 ID -> 连接
+    std::unordered_map<std::string, ConnPtr>    m_by_tuple;     // 规范化四元组 -> 连接
+    std::unordered_map<std::string, ConnPtr>    m_connections;  // 稳定标识 -> 连接
+    std::vector<size_t>                         m_cid_lengths;  // 出现过的非零 CID 长度（短包头匹配）
+    std::time_t                                 m_last_expire = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Dissector.h"
+
+/**
+ * @brief 过载采样参数
+ */
+struct SamplerConfig
+{
+    enum class Mode
+    {
+        FLOW,       // 按流哈希整流采样：保留哈希落在 1/N 内的流
+        ELEPHANT    // 只对大流做流内 1/N 报文采样，其余流完整解析
+    };
+
+    Mode            mode = Mode::ELEPHANT;
+    size_t          high_watermark = 20000;         // 队列深度超过该值视为过载
+    size_t          low_watermark = 2000;           // 队列深度低于该值视为恢复
+    int64_t         max_queue_delay_us = 500000;    // 队列深度 x 平均解析耗时超过该值也视为过载
+    uint32_t        max_rate = 64;                  // 采样率上限（2 的幂）
+    uint64_t        elephant_bytes = 1024 * 1024;   // ELEPHANT 模式下的大流阈值（传输层字节）
+    int64_t         adjust_interval_us = 100000;    // 过载判断周期
+    int64_t         recover_after_us = 2000000;     // 持续不过载多久后采样率减半
+};
+
+/**
+ * @brief 依据解析队列深度与解析耗时自适应的采样器
+ *
+ * 采样率 N 为 2 的幂，过载时翻倍、持续恢复后减半，N = 1 时直通。
+ * 两种模式下 DNS、非 TCP/UDP 报文与 TCP 控制报文（SYN/FIN/RST）都始终保留，按采样率 1 计；
+ * FLOW 模式下落选流只留下控制报文。
+ * 保留的报文带出其代表的采样率，调用方记入会话的 sample_rate，计数本身不放大。
+ * 采样判定只依赖流哈希和流内计数，同一输入得到同一结果；N 翻倍时保留的流是原集合的子集。
+ * admit/observe 由解析线程调用，rate() 可在其他线程读取。
+ */
+class Sampler
+{
+public:
+    explicit Sampler(const SamplerConfig& config = SamplerConfig());
+
+    /**
+     * @brief 判断报文是否进入解析
+     * @param rate 输出：该报文代表的采样率（未被采样的报文为 1）
+     */
+    bool                admit(const PacketView& packet, uint32_t& rate);
+
+    // 每解析一个报文调用一次：出队后的队列深度、本次解析耗时、当前单调时钟（微秒）
+    void                observe(size_t queue_depth, int64_t parse_us, int64_t now_us);
+
+    uint32_t            rate() const { return m_rate.load(std::memory_order_relaxed); }
+    uint64_t            skipped() const { return m_skipped; }
+
+private:
+    struct Slot
+    {
+        uint64_t    tag = 0;            // 流哈希，冲突时整槽重置
+        uint64_t    bytes = 0;
+        uint32_t    packets = 0;
+    };
+
+    static uint64_t     flow_hash(const PacketView& packet);    // 方向无关的五元组哈希
+
+    SamplerConfig           m_config;
+    std::atomic<uint32_t>   m_rate{1};
+    std::vector<Slot>       m_slots;            // 固定大小的流计数表（大流识别）
+    int64_t                 m_latency_us = 0;   // 解析耗时的指数滑动平均
+    int64_t                 m_last_adjust_us = 0;
+    int64_t                 m_calm_since_us = 0;
+    uint64_t                m_skipped = 0;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <MySQLDAO.h>
+#include "FlowFeatures.h"
+#include "TcpMetrics.h"
+#include "TimerWheel.h"
+
+/**
+ * @brief 会话表参数（超时单位：秒）
+ */
+struct SessionTableConfig
+{
+    size_t          max_entries = 65536;        // 会话数上限，超出时淘汰最久未活跃的会话
+    std::time_t     tcp_syn_timeout = 30;       // 握手未完成的 TCP 会话
+    std::time_t     tcp_idle_timeout = 300;     // 已建立的 TCP 会话
+    std::time_t     tcp_half_closed_timeout = 60;   // 单方向 FIN 后
+    std::time_t     tcp_closing_timeout = 10;   // 双方向 FIN 后等待剩余报文
+    std::time_t     idle_timeout = 60;          // 非 TCP 会话
+    std::time_t     max_clock_skew = 86400;     // 报文时间超前墙钟超过该值时不推进会话时钟
+};
+
+/**
+ * @brief 会话表计数器
+ */
+struct SessionTableStats
+{
+    uint64_t        created = 0;
+    uint64_t        closed_fin = 0;             // FIN 后超时结束
+    uint64_t        closed_rst = 0;             // 收到 RST 立即结束
+    uint64_t        expired_idle = 0;           // 空闲超时
+    uint64_t        evicted = 0;                // 超出上限被淘汰
+    uint64_t        clamped_time = 0;           // 报文时间超前墙钟被钳位
+    size_t          peak_entries = 0;
+};
+
+/**
+ * @brief 会话表条目中对调用方可见的部分：入库记录与 TCP 分析状态
+ *
+ * 会话以规范化（端点排序后）的五元组为键，两个方向归入同一条记录；
+ * info.src_* 为发起方，client_side 记录发起方在规范顺序中的位置。
+ */
+struct SessionFlow
+{
+    SessionInfo     info{};
+    TcpConnState    tcp{};
+    FlowFeatures    features{};                 // 可选的分类特征，未启用时保持为空
+    uint8_t         client_side = 0;            // 0：发起方为排序在前的端点
+};
+
+/**
+ * @brief 有界会话表：状态跟踪、时间轮超时与 LRU 淘汰
+ *
+ * 活跃会话周期性输出增量记录（size 为自上次输出以来的报文数），会话结束
+ * （FIN/RST/空闲超时/淘汰）时输出一条带 close_reason 的终结记录后移除；
+ * 已 RST 或双向 FIN 的 TCP 会话收到新的 SYN（端口复用）时先结束旧会话再新建。
+ * 超时按报文时间计算（pcap 回放与实时抓包一致），报文停止后按墙钟继续推进。
+ * 输出的记录写库后须调用 confirm：成功时才视为已入库，失败时增量退回、下次重新输出。
+ * 条目存放在预分配的槽位数组中，LRU 链表与时间轮都以槽位下标引用，
+ * 报文路径只做一次哈希查找和 O(1) 的链表调整。
+ * 非线程安全，由调用方加锁。
+ */
+class SessionTable
+{
+public:
+    explicit SessionTable(const SessionTableConfig& config = SessionTableConfig());
+
+    /**
+     * @brief 查找或创建会话并刷新活跃时间
+     * @param tcp_flags TCP 标志位（非 TCP 传 0）
+     * @param side      报文发送端在规范顺序中的位置（0/1），用于区分两个方向的 FIN
+     * @param now       报文时间（秒），超前墙钟 max_clock_skew 以上时按当前会话时钟处理
+     * @param created   输出：是否为新建会话，新建时由调用方填写五元组等字段
+     * @return 会话条目，调用方在返回后累加 size 等统计；引用在下一次 touch 之前有效
+     */
+    SessionFlow&        touch(const std::string& session_id, const std::string& protocol,
+                              uint8_t tcp_flags, int side, std::time_t now, bool& created);
+
+    void                expire(std::time_t now);                        // 按报文时间推进时间轮，结束超时会话
+    // 以最近报文时间加上此后经过的墙钟时间推进（报文停止后会话照常超时），wall_now 为当前墙钟时间
+    void                tick(std::time_t wall_now);
+    void                collect(std::vector<SessionInfo>& out);         // 取出增量记录与终结记录
+    // 上一次 collect 的记录写库结果：stored 为 true 时仍活跃的会话标记为已入库，否则退回增量
+    void                confirm(bool stored);
+    void                close_all(const char* reason);                  // 结束全部会话（停止采集时）
+
+    size_t              size() const { return m_index.size(); }
+    size_t              pending_closed() const { return m_closed.size(); }
+    const SessionTableStats& stats() const { return m_stats; }
+
+private:
+    enum class State : uint8_t { ACTIVE, SYN, ESTABLISHED, HALF_CLOSED, CLOSING, RESET };
+
+    static const uint32_t NIL = 0xFFFFFFFF;
+
+    // 已输出的计数类字段，用于计算增量
+    struct Counters
+    {
+        int             size = 0;
+        uint64_t        packets_up = 0;
+        uint64_t        packets_down = 0;
+        uint64_t        bytes_up = 0;
+        uint64_t        bytes_down = 0;
+        uint32_t        retransmissions = 0;
+        uint32_t        out_of_order = 0;
+        uint32_t        zero_window = 0;
+    };
+
+    struct Entry
+    {
+        SessionFlow     flow{};
+        Counters        flushed{};
+        std::time_t     last_seen = 0;          // 最近报文时间
+        uint64_t        serial = 0;             // 会话序号，槽位复用后不同
+        uint32_t        timer_seq = 0;          // 定时器序号，重新登记或槽位释放时递增，旧定时器随之失效
+        uint32_t        prev = NIL;             // LRU 链表（头部最新）
+        uint32_t        next = NIL;
+        State           state = State::ACTIVE;
+        bool            fin[2] = {false, false};    // 按规范顺序记录两端的 FIN
+        bool            in_use = false;
+        bool            tcp = false;
+        bool            dirty = false;          // 已在待输出列表中
+        bool            persisted = false;      // 数据库中已有该会话行（写库确认后才置位）
+    };
+
+    // 已输出、等待写库结果的增量
+    struct Unconfirmed
+    {
+        uint32_t        index;
+        uint64_t        serial;
+        Counters        before;                 // 输出前的 flushed，写库失败时恢复
+        bool            features_exported;      // 本次输出了分类特征
+    };
+
+    void                mark_dirty(uint32_t index);
+    uint32_t            allocate();                                     // 取空闲槽位，满时先淘汰 LRU 尾部
+    void                finish(uint32_t index, const char* reason);
+    bool                update_state(Entry& entry, uint8_t tcp_flags, int side);   // 返回超时是否缩短
+    bool                reused(const Entry& entry, uint8_t tcp_flags) const;       // 已结束的 TCP 会话收到新 SYN
+    std::time_t         timeout_of(const Entry& entry) const;
+    void                schedule(uint32_t index);
+    void                lru_unlink(uint32_t index);
+    void                lru_push_front(uint32_t index);
+    SessionInfo         take_delta(Entry& entry, bool final, bool* features_exported = nullptr);
+
+    SessionTableConfig                          m_config;
+    std::vector<Entry>                          m_entries;      // 槽位数组，最多 max_entries 个
+    std::vector<uint32_t>                       m_free;         // 空闲槽位
+    std::unordered_map<std::string, uint32_t>   m_index;        // session_id -> 槽位
+    uint32_t                                    m_lru_head = NIL;
+    uint32_t                                    m_lru_tail = NIL;
+    std::vector<uint32_t>                       m_dirty;        // 有新报文、待输出增量的槽位
+    std::vector<SessionInfo>                    m_closed;       // 待输出的终结记录
+    std::vector<Unconfirmed>                    m_unconfirmed;
+    uint64_t                                    m_serial = 0;
+    std::time_t                                 m_clock = 0;        // 已见的最大报文时间
+    std::time_t                                 m_clock_wall = 0;   // m_clock 更新时的墙钟时间
+    TimerWheel                                  m_wheel;
+    std::vector<TimerWheel::TimerId>            m_expired;      // 时间轮输出缓冲
+    SessionTableStats                           m_stats;
+};
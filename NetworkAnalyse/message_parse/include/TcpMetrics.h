@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <sys/time.h>
+#include <MySQLDAO.h>
+#include "format.h"
+
+/**
+ * @brief 单方向 TCP 分析状态（不入库）
+ */
+struct TcpFlowState
+{
+    uint32_t        next_seq = 0;       // 已见最大序号 + 1
+    bool            seq_valid = false;
+    int64_t         last_us = 0;        // 上一个携带序号空间的报文时间
+    int64_t         syn_us = 0;         // 本方向发出 SYN 的时间
+    int64_t         synack_us = 0;      // 对端回复 SYN-ACK 的时间
+};
+
+/**
+ * @brief 一条 TCP 连接的分析状态，随会话表条目存放
+ */
+struct TcpConnState
+{
+    TcpFlowState    dir[2];             // [0] 发起方->响应方，[1] 反向
+    int64_t         first_us = 0;       // 首包时间（微秒）
+};
+
+/**
+ * @brief TCP 会话指标的逐包增量计算，每个报文 O(1)
+ *
+ * direction 为报文方向：0 表示发起方->响应方，1 表示反向。
+ * 重传与乱序按 Wireshark 的判定：序号回退的报文若距上一报文不足一个 RTT（未知时取 3ms）
+ * 视为乱序，否则视为重传。
+ */
+namespace tcp_metrics
+{
+void update(SessionInfo& info, TcpConnState& state, int direction,
+            const TCP_HEADER* tcp, size_t payload_len, const timeval& ts);
+}
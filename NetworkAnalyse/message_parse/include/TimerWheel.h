@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 分层时间轮（4 层 x 64 槽，1 tick = 1 秒）
+ *
+ * 定时器只登记，不支持主动取消：调用方在到期回收时自行校验（如代数号、
+ * 最后活跃时间），过期的定时器直接丢弃，未到期的重新登记。这样每个报文
+ * 只需更新最后活跃时间，不触碰时间轮，单包开销为 O(1)。
+ * 推进时逐 tick 处理；轮为空或间隔远大于定时器数量时直接跳转，报文时间
+ * 的大幅跳变不会退化为按秒空转。
+ */
+class TimerWheel
+{
+public:
+    using TimerId = uint64_t;
+
+    void                start(uint64_t tick) { m_current = tick; }                 // 设置起始 tick
+    bool                started() const { return m_current != 0; }
+    void                schedule(TimerId id, uint64_t expire_tick);                 // 登记定时器
+    void                advance(uint64_t now_tick, std::vector<TimerId>& expired);  // 推进到 now_tick，输出到期定时器
+    size_t              size() const { return m_count; }
+
+private:
+    static const int    LEVELS = 4;
+    static const int    SLOT_BITS = 6;
+    static const int    SLOTS = 1 << SLOT_BITS;
+
+    struct Timer
+    {
+        TimerId     id;
+        uint64_t    expire;
+    };
+
+    void                insert(const Timer& timer, uint64_t earliest);
+    void                jump(uint64_t now_tick, std::vector<TimerId>& expired);    // 取出全部定时器，直接跳到 now_tick 后重新登记
+
+    std::vector<Timer>  m_slots[LEVELS][SLOTS];
+    uint64_t            m_current = 0;      // 当前 tick，0 表示尚未开始
+    size_t              m_count = 0;
+};
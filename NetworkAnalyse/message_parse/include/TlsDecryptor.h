@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <sys/time.h>
+#include "CryptoUtil.h"
+#include "TlsKeyLog.h"
+
+/**
+ * @brief 基于 key log 的 TLS 1.2 / 1.3 被动解密，一个实例对应一条 TCP 连接
+ *
+ * 调用方按 TCP 序号顺序投递两个方向的字节流，解密器完成记录分帧、握手跟踪
+ * （ClientHello/ServerHello 取随机数、套件与版本，TLS 1.3 的 EncryptedExtensions 取 ALPN）
+ * 与记录解密，输出各方向的应用数据明文。
+ * 支持 AES-128/256-GCM 与 ChaCha20-Poly1305 套件（TLS 1.2 的 ECDHE/DHE/RSA 密钥交换均可，
+ * 密钥由 key log 直接给出）。密钥尚未出现在 key log 中时暂存加密记录，key log 追加后继续解密。
+ */
+class TlsDecryptor
+{
+public:
+    enum Direction { CLIENT_TO_SERVER = 0, SERVER_TO_CLIENT = 1 };
+
+    static const size_t MAX_PENDING_BYTES = 1024 * 1024;   // 每个方向等待密钥时最多暂存的字节
+
+    explicit TlsDecryptor(TlsKeyLog& keylog);
+
+    static bool         is_client_hello(const uint8_t* data, size_t len);   // 是否以 ClientHello 记录开头
+
+    /**
+     * @brief 投递一个方向的 TCP 负载
+     * @param plaintext 追加该方向解出的应用数据
+     * @return false 表示无法继续（不支持的套件、解密失败、暂存超限），调用方应放弃该连接
+     */
+    bool                feed(Direction dir, const uint8_t* data, size_t len, std::string& plaintext);
+
+    const std::string&  alpn() const { return m_alpn; }
+    const std::string&  server_name() const { return m_server_name; }
+    uint16_t            version() const { return m_version; }
+    uint16_t            cipher_suite() const { return m_suite; }
+
+private:
+    enum class Epoch : uint8_t { PLAINTEXT, HANDSHAKE, APPLICATION };
+
+    struct DirectionState
+    {
+        std::string         buffer;             // 未组成完整记录的字节
+        std::string         handshake;          // 未组成完整消息的握手字节
+        Epoch               epoch = Epoch::PLAINTEXT;
+        bool                keyed = false;      // 当前 epoch 的密钥已就绪
+        crypto_util::Bytes  key;
+        crypto_util::Bytes  iv;
+        crypto_util::Bytes  secret;             // TLS 1.3 当前流量密钥（KeyUpdate 时派生下一代）
+        uint64_t            seq = 0;
+        std::deque<std::string> pending;        // 等待密钥的完整记录
+        size_t              pending_bytes = 0;
+    };
+
+    bool                handle_record(Direction dir, std::string record, std::string& plaintext);
+    bool                handle_encrypted(Direction dir, const std::string& record, std::string& plaintext);
+    bool                decrypt_record(Direction dir, const std::string& record, uint8_t& type,
+                                       crypto_util::Bytes& out);
+    bool                handle_handshake(Direction dir, const uint8_t* data, size_t len);
+    void                handle_handshake_message(Direction dir, uint8_t type, const uint8_t* body, size_t len);
+    void                parse_client_hello(const uint8_t* body, size_t len);
+    void                parse_server_hello(const uint8_t* body, size_t len);
+    void                parse_extensions(const uint8_t* p, const uint8_t* end, bool client);
+    bool                install_keys(Direction dir);                    // 当前 epoch 的密钥，key log 中没有时返回 false
+    void                set_traffic_secret(Direction dir, const crypto_util::Bytes& secret);
+    bool                drain_pending(Direction dir, std::string& plaintext);
+
+    TlsKeyLog&          m_keylog;
+    DirectionState      m_dir[2];
+    uint8_t             m_client_random[32] = {0};
+    uint8_t             m_server_random[32] = {0};
+    bool                m_have_client_random = false;
+    bool                m_have_server_hello = false;
+    uint16_t            m_version = 0;              // 协商版本（0x0303 / 0x0304）
+    uint16_t            m_suite = 0;
+    crypto_util::Aead   m_aead = crypto_util::Aead::AES_128_GCM;
+    crypto_util::Hash   m_hash = crypto_util::Hash::SHA256;
+    std::string         m_alpn;
+    std::string         m_server_name;
+    bool                m_unsupported = false;      // 版本或套件不支持
+};
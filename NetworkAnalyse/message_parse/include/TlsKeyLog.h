@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include "CryptoUtil.h"
+
+/**
+ * @brief 一条 TLS 连接在 key log 中的密钥（按 ClientHello.random 归属）
+ */
+struct TlsSecrets
+{
+    crypto_util::Bytes  master_secret;              // TLS 1.2：CLIENT_RANDOM
+    crypto_util::Bytes  client_handshake;           // TLS 1.3：CLIENT_HANDSHAKE_TRAFFIC_SECRET
+    crypto_util::Bytes  server_handshake;           // TLS 1.3：SERVER_HANDSHAKE_TRAFFIC_SECRET
+    crypto_util::Bytes  client_traffic;             // TLS 1.3：CLIENT_TRAFFIC_SECRET_0
+    crypto_util::Bytes  server_traffic;             // TLS 1.3：SERVER_TRAFFIC_SECRET_0
+};
+
+/**
+ * @brief NSS key log（SSLKEYLOGFILE）读取
+ *
+ * 文件可在采集过程中持续追加（如定期从模拟器 adb pull），refresh 只读取新增部分；
+ * 文件被整体替换（变短）时从头重读。仅由解析线程访问。
+ */
+class TlsKeyLog
+{
+public:
+    bool                open(const std::string& path, std::string& error);  // 读入现有内容
+    void                close();
+    bool                is_open() const { return !m_path.empty(); }
+
+    size_t              refresh();                          // 读取追加的行，返回新增密钥条目数
+    size_t              refresh_if_stale();                 // 同一秒内已读取过则跳过（按墙上时钟）
+    const TlsSecrets*   find(const uint8_t* client_random) const;   // client_random 为 32 字节
+    size_t              size() const { return m_secrets.size(); }
+
+private:
+    size_t              parse_line(const std::string& line);
+
+    std::string                                 m_path;
+    uint64_t                                    m_offset = 0;       // 已读取的字节数
+    std::string                                 m_partial;          // 末尾未以换行结束的行
+    std::time_t                                 m_last_refresh = 0;
+    std::unordered_map<std::string, TlsSecrets> m_secrets;          // client_random（原始字节）-> 密钥
+};
@@ -5,8 +5,10 @@
 #include <spdlog/spdlog.h>
 #include <atomic>
 #include <mutex>
+#include <memory>
 #include <queue>
 #include <vector>
+#include "AdbCapture.h"
 #include "PacketParser.h"
 
 /**
@@ -22,13 +24,15 @@ public:
     TrafficCapture(const std::string& app_id, const std::string& ip);
     ~TrafficCapture();
 
-    bool                start_capture(int uid);                     //开始抓包
+    bool                start_capture(int uid, const CaptureOptions& options = CaptureOptions()); //开始抓包
+    bool                set_address_map(const AddressMap::Entries& entries, bool session, std::string& error); //更新地址映射，无需重启抓包
     void                stop_capture();                      //停止抓包
-    void                process_packet(const timeval&, const u_char*, size_t); //实际处理函数
+    void                process_packet(const timeval&, const u_char*, size_t, int link_type = 1); //实际处理函数
     bool                set_filter(const std::string& ip);   //设置 BPF 过滤器
 
 private:
     void                thread_capture();                    // 工作线程入口
+    void                thread_adb_capture();                // adb 设备端抓包的工作线程入口
     static void         pcap_callback(u_char*, const struct pcap_pkthdr*, const u_char*); // libpcap回调
     void                get_net_devices();                    // 打印设备列表（调试用）
 
@@ -41,5 +45,9 @@ private:
 
     std::mutex                      m_queue_mutex;      // 互斥锁
     PacketParser*                   m_packet_parser;     // 数据包解析器
+    std::string                     m_pcap_file;        // 回放的 pcap 文件，空表示实时抓包
+    std::unique_ptr<AdbCapture>     m_adb;              // adb 设备端抓包，未使用时为空
+    std::string                     m_device;           // 报文来源设备序列号
+    int                             m_link_type = 1;    // 当前 pcap 句柄的链路层类型
     int                             app_uid=10001;
 };
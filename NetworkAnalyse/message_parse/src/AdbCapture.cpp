@@ -0,0 +1,158 @@
+#include "AdbCapture.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+#include "PcapStreamReader.h"
+
+AdbCapture::AdbCapture(const std::string& serial, const std::string& filter)
+    : m_serial(serial)
+    , m_filter(filter)
+{
+}
+
+AdbCapture::~AdbCapture()
+{
+    stop();
+}
+
+std::vector<std::string> AdbCapture::build_command() const
+{
+    const char* adb = std::getenv("ADB");
+    std::vector<std::string> args = {adb && *adb ? adb : "adb"};
+    if (!m_serial.empty())
+    {
+        args.push_back("-s");
+        args.push_back(m_serial);
+    }
+    // exec-out 不经过 pty，二进制输出不会被改写；-U 每个报文立即刷出，-s 0 不截断
+    for (const char* arg : {"exec-out", "tcpdump", "-i", "any", "-U", "-s", "0", "-w", "-"})
+        args.push_back(arg);
+    if (!m_filter.empty()) args.push_back(m_filter);
+    return args;
+}
+
+bool AdbCapture::spawn(std::string& error)
+{
+    std::vector<std::string> args = build_command();
+    // argv 在 fork 前备好：子进程在 exec 前只做 async-signal-safe 的调用，不分配内存
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    // 两端都带 O_CLOEXEC，不会泄漏给其他线程同时 fork 出的子进程；dup2 出的标准输出不继承该标志
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+    {
+        error = std::string("pipe failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        error = std::string("fork failed: ") + std::strerror(errno);
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0)
+    {
+        // 子进程：标准输出接到管道，stderr 保留以便看到 adb/tcpdump 的报错
+        dup2(fds[1], STDOUT_FILENO);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(fds[1]);
+    m_fd = fds[0];
+    {
+        std::lock_guard<std::mutex> lock(m_pid_mutex);
+        m_pid = pid;
+    }
+
+    std::string command;
+    for (const auto& arg : args) command += (command.empty() ? "" : " ") + arg;
+    spdlog::info("adb capture started (pid {}): {}", pid, command);
+    return true;
+}
+
+bool AdbCapture::run(const PacketCallback& on_packet, std::string& error)
+{
+    m_stopping = false;
+    if (!spawn(error)) return false;
+
+    PcapStreamReader reader;
+    std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+    bool ok = true;
+    uint64_t packets = 0;
+    auto deliver = [&](const timeval& ts, const uint8_t* data, size_t len) {
+        ++packets;
+        on_packet(ts, data, len, reader.link_type());
+    };
+
+    while (true)
+    {
+        ssize_t n = read(m_fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0)
+        {
+            if (n < 0 && !m_stopping) error = std::string("read failed: ") + std::strerror(errno);
+            break;
+        }
+        if (!reader.feed(buffer.data(), static_cast<size_t>(n), deliver))
+        {
+            error = reader.error();
+            ok = false;
+            break;
+        }
+    }
+
+    close(m_fd);
+    m_fd = -1;
+    bool stopped = m_stopping;
+    stop();
+    reap();     // 子进程只在这里回收
+    if (!reader.has_header() && !stopped)
+    {
+        if (error.empty()) error = "adb exited before sending a pcap header (device offline or tcpdump missing?)";
+        ok = false;
+    }
+    spdlog::info("adb capture on {} finished: {} packets", m_serial.empty() ? "default device" : m_serial, packets);
+    return ok && error.empty();
+}
+
+void AdbCapture::stop()
+{
+    m_stopping = true;
+    // 结束本地 adb 进程即可，adb server 会随之关闭设备端的 exec 会话。
+    // 持锁发信号：回收前 m_pid 一直有效，回收后置 -1，不会误杀复用了该 pid 的其他进程
+    std::lock_guard<std::mutex> lock(m_pid_mutex);
+    if (m_pid > 0) kill(m_pid, SIGTERM);
+}
+
+void AdbCapture::reap()
+{
+    pid_t pid;
+    {
+        std::lock_guard<std::mutex> lock(m_pid_mutex);
+        pid = m_pid;
+    }
+    if (pid <= 0) return;
+
+    // 先不回收地等待退出（僵尸进程的 pid 不会被复用，此时 stop() 仍可安全发信号），再持锁回收并清除 pid
+    siginfo_t info{};
+    while (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT) < 0 && errno == EINTR) {}
+    int status = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_pid_mutex);
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        m_pid = -1;
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+        spdlog::warn("adb exited with status {}", WEXITSTATUS(status));
+}
@@ -0,0 +1,79 @@
+#include "AddressMap.h"
+#include <arpa/inet.h>
+#include <spdlog/spdlog.h>
+
+AddressMap::AddressMap()
+    : m_snapshot(std::make_shared<Snapshot>())
+{
+}
+
+bool AddressMap::parse(const Entries& entries, Layer& layer, std::string& error)
+{
+    for (const auto& entry : entries)
+    {
+        in_addr from{}, to{};
+        if (inet_pton(AF_INET, entry.first.c_str(), &from) != 1 ||
+            inet_pton(AF_INET, entry.second.c_str(), &to) != 1)
+        {
+            error = "invalid IPv4 address: " + entry.first + " -> " + entry.second;
+            return false;
+        }
+        // 统一为规范文本，避免前导零等写法进入数据库
+        char text[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &to, text, INET_ADDRSTRLEN);
+        layer[from.s_addr] = text;
+    }
+    return true;
+}
+
+bool AddressMap::set_base(const Entries& entries, std::string& error)
+{
+    Layer layer;
+    if (!parse(entries, layer, error)) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_base.swap(layer);
+    rebuild();
+    return true;
+}
+
+bool AddressMap::set_session(const Entries& entries, std::string& error)
+{
+    Layer layer;
+    if (!parse(entries, layer, error)) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_session.swap(layer);
+    rebuild();
+    return true;
+}
+
+void AddressMap::rebuild()
+{
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->map = m_base;
+    for (const auto& pair : m_session)
+        snapshot->map[pair.first] = pair.second;
+    m_snapshot = std::move(snapshot);
+    m_version.fetch_add(1, std::memory_order_acq_rel);
+    spdlog::info("Address map updated: {} entries", m_snapshot->map.size());
+}
+
+std::shared_ptr<const AddressMap::Snapshot> AddressMap::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_snapshot;
+}
+
+AddressMap::Entries AddressMap::entries() const
+{
+    auto current = snapshot();
+    Entries result;
+    for (const auto& pair : current->map)
+    {
+        in_addr from{};
+        from.s_addr = pair.first;
+        char text[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &from, text, INET_ADDRSTRLEN);
+        result.emplace_back(text, pair.second);
+    }
+    return result;
+}
@@ -0,0 +1,181 @@
+#include "CryptoUtil.h"
+#include <memory>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace crypto_util
+{
+
+namespace {
+
+const EVP_MD* to_md(Hash hash)
+{
+    return hash == Hash::SHA384 ? EVP_sha384() : EVP_sha256();
+}
+
+const EVP_CIPHER* to_cipher(Aead aead)
+{
+    switch (aead)
+    {
+        case Aead::AES_128_GCM:         return EVP_aes_128_gcm();
+        case Aead::AES_256_GCM:         return EVP_aes_256_gcm();
+        case Aead::CHACHA20_POLY1305:   return EVP_chacha20_poly1305();
+    }
+    return nullptr;
+}
+
+Bytes hmac(Hash hash, const Bytes& key, const uint8_t* data, size_t len)
+{
+    Bytes out(EVP_MAX_MD_SIZE);
+    unsigned int out_len = 0;
+    HMAC(to_md(hash), key.data(), static_cast<int>(key.size()), data, len, out.data(), &out_len);
+    out.resize(out_len);
+    return out;
+}
+
+using CipherCtx = std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>;
+
+} // namespace
+
+size_t hash_length(Hash hash)
+{
+    return hash == Hash::SHA384 ? 48 : 32;
+}
+
+size_t aead_key_length(Aead aead)
+{
+    return aead == Aead::AES_128_GCM ? 16 : 32;
+}
+
+Bytes hkdf_extract(Hash hash, const Bytes& salt, const Bytes& ikm)
+{
+    Bytes key = salt.empty() ? Bytes(hash_length(hash), 0) : salt;
+    return hmac(hash, key, ikm.data(), ikm.size());
+}
+
+Bytes hkdf_expand(Hash hash, const Bytes& prk, const Bytes& info, size_t length)
+{
+    Bytes out;
+    Bytes t;
+    for (uint8_t counter = 1; out.size() < length; ++counter)
+    {
+        Bytes input = t;
+        input.insert(input.end(), info.begin(), info.end());
+        input.push_back(counter);
+        t = hmac(hash, prk, input.data(), input.size());
+        out.insert(out.end(), t.begin(), t.end());
+    }
+    out.resize(length);
+    return out;
+}
+
+Bytes hkdf_expand_label(Hash hash, const Bytes& secret, const std::string& label,
+                        const Bytes& context, size_t length)
+{
+    // struct { uint16 length; opaque label<7..255>; opaque context<0..255>; } HkdfLabel
+    std::string full_label = "tls13 " + label;
+    Bytes info;
+    info.push_back(static_cast<uint8_t>(length >> 8));
+    info.push_back(static_cast<uint8_t>(length));
+    info.push_back(static_cast<uint8_t>(full_label.size()));
+    info.insert(info.end(), full_label.begin(), full_label.end());
+    info.push_back(static_cast<uint8_t>(context.size()));
+    info.insert(info.end(), context.begin(), context.end());
+    return hkdf_expand(hash, secret, info, length);
+}
+
+Bytes tls12_prf(Hash hash, const Bytes& secret, const std::string& label,
+                const Bytes& seed, size_t length)
+{
+    // P_hash(secret, label + seed)：A(0) = label + seed，A(i) = HMAC(secret, A(i-1))，
+    // 输出 HMAC(secret, A(i) + label + seed) 的串接
+    Bytes label_seed(label.begin(), label.end());
+    label_seed.insert(label_seed.end(), seed.begin(), seed.end());
+
+    Bytes out;
+    Bytes a = hmac(hash, secret, label_seed.data(), label_seed.size());
+    while (out.size() < length)
+    {
+        Bytes input = a;
+        input.insert(input.end(), label_seed.begin(), label_seed.end());
+        Bytes block = hmac(hash, secret, input.data(), input.size());
+        out.insert(out.end(), block.begin(), block.end());
+        a = hmac(hash, secret, a.data(), a.size());
+    }
+    out.resize(length);
+    return out;
+}
+
+bool aes_ecb_encrypt_block(const Bytes& key, const uint8_t* in, uint8_t* out)
+{
+    const EVP_CIPHER* cipher = key.size() == 32 ? EVP_aes_256_ecb() : EVP_aes_128_ecb();
+    CipherCtx ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    int len = 0;
+    return ctx
+        && EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, key.data(), nullptr) == 1
+        && EVP_CIPHER_CTX_set_padding(ctx.get(), 0) == 1
+        && EVP_EncryptUpdate(ctx.get(), out, &len, in, 16) == 1
+        && len == 16;
+}
+
+bool aead_decrypt(Aead aead, const Bytes& key, const uint8_t* nonce, size_t nonce_len,
+                  const uint8_t* aad, size_t aad_len,
+                  const uint8_t* in, size_t in_len, Bytes& out)
+{
+    const size_t TAG_LEN = 16;
+    if (in_len < TAG_LEN) return false;
+    size_t ct_len = in_len - TAG_LEN;
+
+    CipherCtx ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if (!ctx) return false;
+    if (EVP_DecryptInit_ex(ctx.get(), to_cipher(aead), nullptr, nullptr, nullptr) != 1) return false;
+    if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(nonce_len), nullptr) != 1) return false;
+    if (EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, key.data(), nonce) != 1) return false;
+
+    int len = 0;
+    if (aad_len > 0 && EVP_DecryptUpdate(ctx.get(), nullptr, &len, aad, static_cast<int>(aad_len)) != 1)
+        return false;
+
+    out.resize(ct_len);
+    if (ct_len > 0 && EVP_DecryptUpdate(ctx.get(), out.data(), &len, in, static_cast<int>(ct_len)) != 1)
+        return false;
+    if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, TAG_LEN,
+                            const_cast<uint8_t*>(in + ct_len)) != 1)
+        return false;
+    return EVP_DecryptFinal_ex(ctx.get(), out.data() + ct_len, &len) == 1;
+}
+
+Bytes from_hex(const std::string& hex)
+{
+    Bytes out;
+    out.reserve(hex.size() / 2);
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    {
+        int hi = nibble(hex[i]);
+        int lo = nibble(hex[i + 1]);
+        if (hi < 0 || lo < 0) return {};
+        out.push_back(static_cast<uint8_t>((hi << 4) | lo));
+    }
+    return out;
+}
+
+std::string to_hex(const uint8_t* data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+    for (size_t i = 0; i < len; ++i)
+    {
+        out.push_back(digits[data[i] >> 4]);
+        out.push_back(digits[data[i] & 0x0F]);
+    }
+    return out;
+}
+
+} // namespace crypto_util
@@ -0,0 +1,120 @@
+#include "DissectorRegistry.h"
+#include <spdlog/spdlog.h>
+
+int DissectorRegistry::l3_index(uint16_t ether_type)
+{
+    switch (ether_type)
+    {
+    case 0x0800: return L3_IPV4;
+    default:     return -1;
+    }
+}
+
+void DissectorRegistry::add(std::shared_ptr<Dissector> dissector, bool enabled)
+{
+    Entry entry;
+    entry.dissector = std::move(dissector);
+    entry.default_enabled = enabled;
+    entry.enabled = enabled;
+    m_entries[entry.dissector->name()] = std::move(entry);
+}
+
+void DissectorRegistry::bind(Binding::Kind kind, const std::string& name, uint16_t ether_type,
+                             uint8_t l4, uint16_t port)
+{
+    int l3 = l3_index(ether_type);
+    if (l3 < 0 || m_entries.find(name) == m_entries.end())
+    {
+        spdlog::warn("Dissector binding ignored: name={}, ether_type={:#06x}", name, ether_type);
+        return;
+    }
+    m_bindings.push_back({kind, name, l3, l4, port});
+}
+
+void DissectorRegistry::bind_port(const std::string& name, uint16_t ether_type, uint8_t l4, uint16_t port)
+{
+    bind(Binding::PORT, name, ether_type, l4, port);
+}
+
+void DissectorRegistry::bind_protocol(const std::string& name, uint16_t ether_type, uint8_t l4)
+{
+    bind(Binding::PROTOCOL, name, ether_type, l4, 0);
+}
+
+void DissectorRegistry::bind_heuristic(const std::string& name, uint16_t ether_type, uint8_t l4)
+{
+    bind(Binding::HEURISTIC, name, ether_type, l4, 0);
+}
+
+bool DissectorRegistry::set_enabled(const std::string& name, bool enabled)
+{
+    auto it = m_entries.find(name);
+    if (it == m_entries.end()) return false;
+    it->second.enabled = enabled;
+    return true;
+}
+
+bool DissectorRegistry::is_enabled(const std::string& name) const
+{
+    auto it = m_entries.find(name);
+    return it != m_entries.end() && it->second.enabled;
+}
+
+void DissectorRegistry::reset_enabled()
+{
+    for (auto& pair : m_entries)
+        pair.second.enabled = pair.second.default_enabled;
+}
+
+std::vector<std::string> DissectorRegistry::enabled_names() const
+{
+    std::vector<std::string> names;
+    for (const auto& pair : m_entries)
+        if (pair.second.enabled) names.push_back(pair.first);
+    return names;
+}
+
+void DissectorRegistry::build()
+{
+    for (auto& l3_tables : m_tables)
+        for (auto& table : l3_tables) table.reset();
+
+    for (const auto& binding : m_bindings)
+    {
+        const Entry& entry = m_entries.at(binding.name);
+        if (!entry.enabled) continue;
+
+        auto& table = m_tables[binding.l3][binding.l4];
+        if (!table) table.reset(new Table());
+        Dissector* dissector = entry.dissector.get();
+
+        switch (binding.kind)
+        {
+        case Binding::PORT:
+        {
+            if (table->ports.empty()) table->ports.assign(65536, 0);
+            uint8_t index = 0;
+            for (size_t i = 1; i < table->dissectors.size(); ++i)
+                if (table->dissectors[i] == dissector) index = static_cast<uint8_t>(i);
+            if (!index)
+            {
+                if (table->dissectors.size() >= 256)
+                {
+                    spdlog::warn("Too many port dissectors for L4 protocol {}", binding.l4);
+                    break;
+                }
+                index = static_cast<uint8_t>(table->dissectors.size());
+                table->dissectors.push_back(dissector);
+            }
+            table->ports[binding.port] = index;
+            break;
+        }
+        case Binding::HEURISTIC:
+            table->heuristics.push_back(dissector);
+            break;
+        case Binding::PROTOCOL:
+            table->fallback = dissector;
+            break;
+        }
+    }
+}
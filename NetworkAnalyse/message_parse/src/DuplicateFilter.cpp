@@ -0,0 +1,92 @@
+#include "DuplicateFilter.h"
+#include <algorithm>
+
+namespace {
+const uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+inline uint64_t fnv(uint64_t hash, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv(uint64_t hash, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+}
+
+DuplicateFilter::DuplicateFilter(const DuplicateFilterConfig& config)
+    : m_config(config)
+{
+    m_current.reserve(1024);
+    m_previous.reserve(1024);
+}
+
+uint64_t DuplicateFilter::fingerprint(const PacketView& packet) const
+{
+    uint64_t hash = FNV_OFFSET;
+    // 地址使用映射后的文本，NAT 转发前后的副本换算到同一设备地址
+    hash = fnv(hash, reinterpret_cast<const uint8_t*>(packet.src_ip.data()), packet.src_ip.size());
+    hash = fnv(hash, reinterpret_cast<const uint8_t*>(packet.dst_ip.data()), packet.dst_ip.size());
+    uint64_t ports = (static_cast<uint64_t>(static_cast<uint16_t>(packet.src_port)) << 24) |
+                     (static_cast<uint64_t>(static_cast<uint16_t>(packet.dst_port)) << 8) | packet.l4;
+    // IP 标识（偏移 4，2 字节），转发只改 TTL/校验和，不改标识
+    uint64_t ip_id = (static_cast<uint64_t>(packet.ip_header[4]) << 8) | packet.ip_header[5];
+    hash = fnv(hash, ports ^ (ip_id << 48));
+    hash = fnv(hash, packet.payload_len);
+    // TCP 序号、确认号、首部长度与标志（偏移 4~13）：同一序号的纯 ACK、窗口探测与 FIN/RST 彼此区分
+    if (packet.l4 == 6 && packet.l4_len >= 14)
+        hash = fnv(hash, packet.l4_data + 4, 10);
+    return fnv(hash, packet.payload, std::min(packet.payload_len, m_config.payload_prefix));
+}
+
+void DuplicateFilter::rotate(int64_t now_us)
+{
+    if (m_bucket_start_us == 0)
+    {
+        m_bucket_start_us = now_us;
+        return;
+    }
+    // 时间戳回退或同一桶内：不轮换
+    if (now_us - m_bucket_start_us < m_config.window_us) return;
+
+    if (now_us - m_bucket_start_us >= 2 * m_config.window_us)
+    {
+        // 空闲超过两个桶，旧指纹全部过期
+        m_previous.clear();
+        m_current.clear();
+    }
+    else
+    {
+        m_previous.swap(m_current);
+        m_current.clear();
+    }
+    m_bucket_start_us = now_us;
+}
+
+bool DuplicateFilter::is_duplicate(const PacketView& packet)
+{
+    if (!packet.ip_header || packet.ip_header_len < 20) return false;
+
+    rotate(static_cast<int64_t>(packet.ts.tv_sec) * 1000000 + packet.ts.tv_usec);
+
+    uint64_t key = fingerprint(packet);
+    if (m_current.count(key) || m_previous.count(key))
+    {
+        m_duplicates.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (m_current.size() < m_config.max_entries) m_current.insert(key);
+    return false;
+}
@@ -0,0 +1,53 @@
+#include "FlowFeatures.h"
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+void FlowFeatures::update(int direction, size_t payload_len, int64_t ts_us)
+{
+    if (payload_len == 0) return;
+    direction &= 1;
+
+    if (count < MAX_PACKETS)
+    {
+        sizes[count] = static_cast<uint32_t>(payload_len);
+        int64_t gap = (count == 0 || ts_us < last_us) ? 0 : ts_us - last_us;
+        iat_us[count] = static_cast<uint32_t>(std::min<int64_t>(gap, UINT32_MAX));
+        if (direction) directions |= 1u << count;
+        ++count;
+    }
+    last_us = ts_us;
+
+    if (direction != burst_direction)
+    {
+        ++bursts;
+        burst_direction = static_cast<int8_t>(direction);
+        burst_packets = 0;
+        burst_bytes = 0;
+    }
+    ++burst_packets;
+    burst_bytes += payload_len;
+    total_bytes += payload_len;
+    max_burst_packets = std::max(max_burst_packets, burst_packets);
+    max_burst_bytes = std::max(max_burst_bytes, burst_bytes);
+}
+
+std::string FlowFeatures::to_json() const
+{
+    nlohmann::json j;
+    nlohmann::json sizes_json = nlohmann::json::array();
+    nlohmann::json iat_json = nlohmann::json::array();
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        // 带符号长度：正数为发起方发出，负数为响应方发出
+        int64_t size = sizes[i];
+        sizes_json.push_back((directions >> i) & 1 ? -size : size);
+        iat_json.push_back(iat_us[i]);
+    }
+    j["sizes"] = sizes_json;
+    j["iat_us"] = iat_json;
+    j["bursts"] = bursts;
+    j["max_burst_packets"] = max_burst_packets;
+    j["max_burst_bytes"] = max_burst_bytes;
+    j["mean_burst_bytes"] = bursts ? total_bytes / bursts : 0;
+    return j.dump();
+}
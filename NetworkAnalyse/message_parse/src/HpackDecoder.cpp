@@ -0,0 +1,330 @@
+#include "HpackDecoder.h"
+
+namespace {
+
+// RFC 7541 附录 A 静态表（索引从 1 开始）
+const HpackDecoder::Header kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""}
+};
+const size_t kStaticTableSize = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// RFC 7541 附录 B Huffman 编码表：{码字, 位数}，下标即符号，256 为 EOS
+struct HuffmanCode { uint32_t code; uint8_t bits; };
+const HuffmanCode kHuffmanCodes[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28},
+    {0xfffffe6, 28}, {0xfffffe7, 28}, {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28}, {0xfffffed, 28}, {0xfffffee, 28},
+    {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28},
+    {0xffffffa, 28}, {0xffffffb, 28}, {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10},
+    {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6},
+    {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10}, {0x1ffa, 13}, {0x21, 6},
+    {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7},
+    {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7},
+    {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5},
+    {0x25, 6}, {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7},
+    {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14},
+    {0x1ffd, 13}, {0xffffffc, 28}, {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22}, {0x7fffda, 23},
+    {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23},
+    {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22}, {0x1fffdd, 21},
+    {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22},
+    {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20}, {0x3fffe2, 22},
+    {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23},
+    {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19}, {0x1fffe3, 21},
+    {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27},
+    {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22}, {0x3fffeb, 22},
+    {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27},
+    {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}, {0x3fffffff, 30}
+};
+
+// 由编码表构建的二叉解码树，进程内只构建一次
+struct HuffmanTree
+{
+    struct Node { int16_t child[2]; int16_t symbol; };
+    std::vector<Node> nodes;
+
+    HuffmanTree()
+    {
+        nodes.push_back({{-1, -1}, -1});
+        for (int sym = 0; sym < 257; ++sym)
+        {
+            size_t cur = 0;
+            for (int i = kHuffmanCodes[sym].bits - 1; i >= 0; --i)
+            {
+                int bit = (kHuffmanCodes[sym].code >> i) & 1;
+                if (nodes[cur].child[bit] < 0)
+                {
+                    nodes[cur].child[bit] = static_cast<int16_t>(nodes.size());
+                    nodes.push_back({{-1, -1}, -1});
+                }
+                cur = nodes[cur].child[bit];
+            }
+            nodes[cur].symbol = static_cast<int16_t>(sym);
+        }
+    }
+};
+
+const HuffmanTree& huffman_tree()
+{
+    static const HuffmanTree tree;
+    return tree;
+}
+
+} // namespace
+
+HpackDecoder::HpackDecoder(size_t max_table_size)
+    : m_table_size(0)
+    , m_max_table_size(max_table_size)
+    , m_settings_max_size(max_table_size)
+{
+}
+
+void HpackDecoder::set_max_table_size(size_t size)
+{
+    m_settings_max_size = size;
+    if (m_max_table_size > size)
+    {
+        m_max_table_size = size;
+        evict(m_max_table_size);
+    }
+}
+
+bool HpackDecoder::decode(const uint8_t* data, size_t len, std::vector<Header>& headers)
+{
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+
+    while (p < end)
+    {
+        uint8_t b = *p;
+        if (b & 0x80)
+        {
+            // 6.1 索引头部字段
+            uint64_t index = 0;
+            if (!decode_integer(p, end, 7, index) || index == 0) return false;
+            Header h;
+            if (!lookup(index, h)) return false;
+            headers.push_back(std::move(h));
+        }
+        else if ((b & 0xE0) == 0x20)
+        {
+            // 6.3 动态表大小更新
+            uint64_t size = 0;
+            if (!decode_integer(p, end, 5, size) || size > m_settings_max_size) return false;
+            m_max_table_size = static_cast<size_t>(size);
+            evict(m_max_table_size);
+        }
+        else
+        {
+            // 6.2 字面量：带索引(01) / 不索引(0000) / 永不索引(0001)
+            bool incremental = (b & 0xC0) == 0x40;
+            int prefix = incremental ? 6 : 4;
+            uint64_t index = 0;
+            if (!decode_integer(p, end, prefix, index)) return false;
+
+            Header h;
+            if (index != 0)
+            {
+                if (!lookup(index, h)) return false;
+            }
+            else if (!decode_string(p, end, h.first))
+            {
+                return false;
+            }
+            if (!decode_string(p, end, h.second)) return false;
+
+            if (incremental) insert(h);
+            headers.push_back(std::move(h));
+        }
+    }
+    return true;
+}
+
+bool HpackDecoder::decode_integer(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& value)
+{
+    if (p >= end) return false;
+    const uint8_t mask = static_cast<uint8_t>((1u << prefix_bits) - 1);
+    value = *p++ & mask;
+    if (value < mask) return true;
+
+    int shift = 0;
+    while (p < end)
+    {
+        uint8_t b = *p++;
+        value += static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+        shift += 7;
+        if (shift > 56) return false; // 防止恶意超长整数
+    }
+    return false;
+}
+
+bool HpackDecoder::decode_string(const uint8_t*& p, const uint8_t* end, std::string& out)
+{
+    if (p >= end) return false;
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t length = 0;
+    if (!decode_integer(p, end, 7, length)) return false;
+    if (length > static_cast<uint64_t>(end - p)) return false;
+
+    bool ok = true;
+    if (huffman)
+        ok = decode_huffman(p, static_cast<size_t>(length), out);
+    else
+        out.assign(reinterpret_cast<const char*>(p), static_cast<size_t>(length));
+    p += length;
+    return ok;
+}
+
+bool HpackDecoder::decode_huffman(const uint8_t* p, size_t len, std::string& out)
+{
+    const auto& nodes = huffman_tree().nodes;
+    out.clear();
+    out.reserve(len * 8 / 5);
+
+    size_t cur = 0;
+    int depth = 0;          // 当前未完成码字已消耗的位数
+    bool all_ones = true;   // 未完成码字是否全为 1（合法填充必须是 EOS 前缀）
+    for (size_t i = 0; i < len; ++i)
+    {
+        for (int bit_pos = 7; bit_pos >= 0; --bit_pos)
+        {
+            int bit = (p[i] >> bit_pos) & 1;
+            int16_t next = nodes[cur].child[bit];
+            if (next < 0) return false;
+            cur = static_cast<size_t>(next);
+            ++depth;
+            all_ones = all_ones && bit;
+
+            int16_t sym = nodes[cur].symbol;
+            if (sym >= 0)
+            {
+                if (sym == 256) return false; // 字符串中出现 EOS 视为解码错误
+                out.push_back(static_cast<char>(sym));
+                cur = 0;
+                depth = 0;
+                all_ones = true;
+            }
+        }
+    }
+    // 5.2 填充不得超过 7 位且必须为全 1
+    return depth <= 7 && all_ones;
+}
+
+bool HpackDecoder::lookup(uint64_t index, Header& header) const
+{
+    if (index == 0) return false;
+    if (index <= kStaticTableSize)
+    {
+        header = kStaticTable[index - 1];
+        return true;
+    }
+    uint64_t dyn = index - kStaticTableSize - 1;
+    if (dyn >= m_dynamic_table.size()) return false;
+    header = m_dynamic_table[static_cast<size_t>(dyn)];
+    return true;
+}
+
+void HpackDecoder::insert(const Header& header)
+{
+    size_t entry_size = header.first.size() + header.second.size() + 32;
+    if (entry_size > m_max_table_size)
+    {
+        // 4.4 条目大于表上限时清空动态表，且不插入
+        m_dynamic_table.clear();
+        m_table_size = 0;
+        return;
+    }
+    evict(m_max_table_size - entry_size);
+    m_dynamic_table.push_front(header);
+    m_table_size += entry_size;
+}
+
+void HpackDecoder::evict(size_t target_size)
+{
+    while (m_table_size > target_size && !m_dynamic_table.empty())
+    {
+        const Header& h = m_dynamic_table.back();
+        m_table_size -= h.first.size() + h.second.size() + 32;
+        m_dynamic_table.pop_back();
+    }
+}
@@ -0,0 +1,389 @@
+#include "Http1Parser.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+using Header = std::pair<std::string, std::string>;
+
+void append_header(nlohmann::json& headers, const std::string& name, const std::string& value)
+{
+    if (headers.contains(name))
+        headers[name] = headers[name].get<std::string>() + ", " + value;
+    else
+        headers[name] = value;
+}
+
+std::string trim(const std::string& s)
+{
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+}
+
+// 头部块拆为起始行与 (小写名, 值)，obs-fold 续行并入上一个头部
+void split_head(const std::string& head, std::string& start_line, std::vector<Header>& headers)
+{
+    size_t pos = head.find("\r\n");
+    start_line = head.substr(0, pos);
+    while (pos != std::string::npos)
+    {
+        size_t begin = pos + 2;
+        pos = head.find("\r\n", begin);
+        std::string line = head.substr(begin, pos == std::string::npos ? std::string::npos : pos - begin);
+        if (line.empty()) continue;
+        if ((line[0] == ' ' || line[0] == '\t') && !headers.empty())
+        {
+            headers.back().second += " " + trim(line);
+            continue;
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || colon == 0) continue;
+        std::string name = trim(line.substr(0, colon));
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        headers.emplace_back(name, trim(line.substr(colon + 1)));
+    }
+}
+
+// 最后一个 Transfer-Encoding 编码为 chunked 时按分块读取（RFC 7230 3.3.3）
+bool is_chunked(const std::vector<Header>& headers)
+{
+    bool chunked = false;
+    for (const auto& h : headers)
+    {
+        if (h.first != "transfer-encoding") continue;
+        std::string value = h.second;
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        size_t comma = value.rfind(',');
+        chunked = trim(comma == std::string::npos ? value : value.substr(comma + 1)) == "chunked";
+    }
+    return chunked;
+}
+
+// Content-Length，缺失或非法时返回 -1
+int64_t content_length(const std::vector<Header>& headers)
+{
+    for (const auto& h : headers)
+    {
+        if (h.first != "content-length") continue;
+        char* end = nullptr;
+        long long value = std::strtoll(h.second.c_str(), &end, 10);
+        if (end == h.second.c_str() || value < 0) return -1;
+        return value;
+    }
+    return -1;
+}
+
+} // namespace
+
+Http1Connection::Http1Connection(const HttpFlowInfo& base, StreamCallback on_done, bool tls)
+    : m_base(base)
+    , m_on_done(std::move(on_done))
+    , m_tls(tls)
+{
+    m_base.top_protocol = tls ? "HTTPS" : "HTTP";
+    m_base.http_version = "HTTP/1.1";
+}
+
+bool Http1Connection::is_request(const uint8_t* data, size_t len)
+{
+    // 方法为大写 token，起始行完整时要求以 HTTP/1.x 结尾
+    size_t i = 0;
+    while (i < len && i < 16 && data[i] >= 'A' && data[i] <= 'Z') ++i;
+    if (i < 3 || i >= len || data[i] != ' ') return false;
+
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + (len < MAX_HEAD_BYTES ? len : MAX_HEAD_BYTES);
+    const char* eol = std::search(begin, end, "\r\n", "\r\n" + 2);
+    if (eol == end) return true;
+    std::string line(begin, eol);
+    return line.size() > 9 && line.compare(line.size() - 9, 7, " HTTP/1") == 0;
+}
+
+bool Http1Connection::feed(Direction dir, const uint8_t* data, size_t len, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    if (st.phase == Phase::STOPPED) return true;
+    st.buffer.append(reinterpret_cast<const char*>(data), len);
+
+    while (true)
+    {
+        if (st.phase == Phase::STOPPED)
+        {
+            st.buffer.clear();
+            return true;
+        }
+        // 每轮处理一个阶段，没有进展（数据不足）时等待后续数据
+        Phase phase = st.phase;
+        size_t before = st.buffer.size();
+        bool ok = phase == Phase::HEAD ? parse_head(dir, ts) : parse_body(dir, ts);
+        if (!ok)
+        {
+            spdlog::debug("HTTP/1 protocol error on {} (direction {})", m_base.flow_id, static_cast<int>(dir));
+            return false;
+        }
+        if (st.phase == phase && st.buffer.size() == before) return true;
+    }
+}
+
+bool Http1Connection::parse_head(Direction dir, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    // 报文之间多余的 CRLF 忽略（RFC 7230 3.5）
+    size_t skip = 0;
+    while (st.buffer.compare(skip, 2, "\r\n") == 0) skip += 2;
+    if (skip) st.buffer.erase(0, skip);
+
+    size_t end = st.buffer.find("\r\n\r\n");
+    if (end == std::string::npos) return st.buffer.size() <= MAX_HEAD_BYTES;
+    end += 4;
+    std::string start_line;
+    std::vector<Header> headers;
+    split_head(st.buffer.substr(0, end - 2), start_line, headers);
+    st.buffer.erase(0, end);
+
+    bool chunked = is_chunked(headers);
+    int64_t length = content_length(headers);
+
+    if (dir == CLIENT_TO_SERVER)
+    {
+        // METHOD SP request-target SP HTTP-version
+        size_t sp1 = start_line.find(' ');
+        size_t sp2 = start_line.rfind(' ');
+        if (sp1 == std::string::npos || sp2 == sp1 || start_line.compare(sp2 + 1, 5, "HTTP/") != 0)
+            return false;
+
+        Http2Stream& ex = new_exchange(ts);
+        ex.flow.method = start_line.substr(0, sp1);
+        ex.flow.http_version = start_line.substr(sp2 + 1);
+        std::string target = start_line.substr(sp1 + 1, sp2 - sp1 - 1);
+        ex.request_header_bytes = end;
+        for (const auto& h : headers)
+        {
+            append_header(ex.request.headers, h.first, h.second);
+            if (h.first == "host") ex.flow.host = h.second;
+            else if (h.first == "content-type") ex.request.content_type = h.second;
+        }
+        if (target.compare(0, 7, "http://") == 0 || target.compare(0, 8, "https://") == 0)
+            ex.flow.url = target;
+        else
+            ex.flow.url = std::string(m_tls ? "https" : "http") + "://" + ex.flow.host + target;
+
+        st.current = &ex;
+        // 请求无长度头时没有 body
+        if (chunked) st.phase = Phase::CHUNK_SIZE;
+        else if (length > 0) { st.phase = Phase::LENGTH; st.remaining = static_cast<uint64_t>(length); }
+        else end_message(dir, ts);
+        return true;
+    }
+
+    // HTTP-version SP status-code SP reason-phrase
+    if (start_line.compare(0, 5, "HTTP/") != 0 || start_line.size() < 12) return false;
+    int status = std::atoi(start_line.c_str() + start_line.find(' ') + 1);
+    if (status < 100 || status > 999) return false;
+    // 1xx 为中间响应，不计入最终响应（101 除外）
+    if (status < 200 && status != 101) return true;
+
+    Http2Stream* ex = awaiting_response();
+    if (!ex)
+    {
+        // 未见到请求（如从连接中途开始采集），只记录响应
+        ex = &new_exchange(ts);
+        ex->request_done = true;
+        ex->request_end = ts;
+    }
+    ex->response_start = ts;
+    ex->response_header_bytes = end;
+    ex->flow.status_code = status;
+    for (const auto& h : headers)
+    {
+        append_header(ex->response.headers, h.first, h.second);
+        if (h.first == "content-type")
+        {
+            ex->response.content_type = h.second;
+            ex->flow.content_type = h.second;
+        }
+    }
+
+    st.current = ex;
+    if (status == 101)
+    {
+        // 协议切换（WebSocket 等）后的数据不再是 HTTP/1
+        end_message(dir, ts);
+        m_dir[CLIENT_TO_SERVER].phase = Phase::STOPPED;
+        m_dir[SERVER_TO_CLIENT].phase = Phase::STOPPED;
+        return true;
+    }
+    // HEAD 请求、204、304 的响应没有 body（RFC 7230 3.3.3）
+    if (ex->flow.method == "HEAD" || status == 204 || status == 304) end_message(dir, ts);
+    else if (chunked) st.phase = Phase::CHUNK_SIZE;
+    else if (length == 0) end_message(dir, ts);
+    else if (length > 0) { st.phase = Phase::LENGTH; st.remaining = static_cast<uint64_t>(length); }
+    else st.phase = Phase::UNTIL_CLOSE;
+    return true;
+}
+
+// 处理当前 body 阶段可处理的字节，阶段结束时切换
+bool Http1Connection::parse_body(Direction dir, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    switch (st.phase)
+    {
+        case Phase::LENGTH:
+        {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(st.remaining, st.buffer.size()));
+            append_body(dir, st.buffer.data(), n);
+            st.buffer.erase(0, n);
+            st.remaining -= n;
+            if (st.remaining == 0) end_message(dir, ts);
+            return true;
+        }
+        case Phase::CHUNK_SIZE:
+        {
+            size_t eol = st.buffer.find("\r\n");
+            if (eol == std::string::npos) return st.buffer.size() <= 1024;
+            char* end = nullptr;
+            unsigned long long size = std::strtoull(st.buffer.c_str(), &end, 16);
+            if (end == st.buffer.c_str()) return false;
+            st.buffer.erase(0, eol + 2);
+            if (size == 0)
+            {
+                st.phase = Phase::CHUNK_TRAILER;
+            }
+            else
+            {
+                st.phase = Phase::CHUNK_DATA;
+                st.remaining = size + 2;    // 块数据之后的 CRLF
+            }
+            return true;
+        }
+        case Phase::CHUNK_DATA:
+        {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(st.remaining, st.buffer.size()));
+            uint64_t data_left = st.remaining > 2 ? st.remaining - 2 : 0;
+            append_body(dir, st.buffer.data(), static_cast<size_t>(std::min<uint64_t>(n, data_left)));
+            st.buffer.erase(0, n);
+            st.remaining -= n;
+            if (st.remaining == 0) st.phase = Phase::CHUNK_SIZE;
+            return true;
+        }
+        case Phase::CHUNK_TRAILER:
+        {
+            size_t eol = st.buffer.find("\r\n");
+            if (eol == std::string::npos) return st.buffer.size() <= MAX_HEAD_BYTES;
+            st.buffer.erase(0, eol + 2);
+            if (eol == 0) end_message(dir, ts);
+            return true;
+        }
+        case Phase::UNTIL_CLOSE:
+        {
+            append_body(dir, st.buffer.data(), st.buffer.size());
+            st.buffer.clear();
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+void Http1Connection::append_body(Direction dir, const char* data, size_t len)
+{
+    Http2Stream* ex = m_dir[dir].current;
+    if (!ex || len == 0) return;
+    std::string& body = dir == CLIENT_TO_SERVER ? ex->request.body : ex->response.body;
+    if (dir == CLIENT_TO_SERVER) ex->request_body_bytes += len;
+    else ex->response_body_bytes += len;
+    size_t room = MAX_BODY_CAPTURE > body.size() ? MAX_BODY_CAPTURE - body.size() : 0;
+    body.append(data, std::min(room, len));
+}
+
+void Http1Connection::end_message(Direction dir, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    if (Http2Stream* ex = st.current)
+    {
+        if (dir == CLIENT_TO_SERVER)
+        {
+            ex->request_done = true;
+            ex->request_end = ts;
+        }
+        else
+        {
+            ex->response_done = true;
+            ex->response_end = ts;
+        }
+    }
+    st.current = nullptr;
+    st.phase = Phase::HEAD;
+    st.remaining = 0;
+    finish_completed();
+}
+
+Http2Stream& Http1Connection::new_exchange(const timeval& ts)
+{
+    m_exchanges.emplace_back();
+    Http2Stream& ex = m_exchanges.back();
+    ex.stream_id = ++m_count;
+    ex.flow = m_base;
+    ex.flow.flow_id = m_base.flow_id + "#" + std::to_string(ex.stream_id);
+    ex.flow.status_code = 0;
+    ex.request_start = ts;
+
+    ex.request.flow_id = ex.flow.flow_id;
+    ex.request.type = "request";
+    ex.request.top_protocol = m_base.top_protocol;
+    ex.request.headers = nlohmann::json::object();
+    ex.response.flow_id = ex.flow.flow_id;
+    ex.response.type = "response";
+    ex.response.top_protocol = m_base.top_protocol;
+    ex.response.headers = nlohmann::json::object();
+    return ex;
+}
+
+Http2Stream* Http1Connection::awaiting_response()
+{
+    for (auto& ex : m_exchanges)
+    {
+        if (!ex.response_done) return &ex;
+    }
+    return nullptr;
+}
+
+void Http1Connection::finish_completed()
+{
+    // 流水线请求的响应按顺序返回，队首完成后才输出后续交换
+    while (!m_exchanges.empty() && m_exchanges.front().request_done && m_exchanges.front().response_done)
+    {
+        Http2Stream& ex = m_exchanges.front();
+        ex.request.length = static_cast<int>(ex.request_body_bytes);
+        ex.response.length = static_cast<int>(ex.response_body_bytes);
+        if (m_on_done) m_on_done(ex);
+        m_exchanges.pop_front();
+    }
+}
+
+void Http1Connection::close(const timeval& ts)
+{
+    // 读到连接关闭的响应在此结束，其余未完成的交换保留已统计的大小与时间输出
+    for (auto& ex : m_exchanges)
+    {
+        if (!ex.response_done && ex.response_start.tv_sec != 0) ex.response_end = ts;
+        if (&ex == m_dir[SERVER_TO_CLIENT].current && m_dir[SERVER_TO_CLIENT].phase == Phase::UNTIL_CLOSE)
+            ex.response_done = true;
+    }
+    m_dir[CLIENT_TO_SERVER].current = nullptr;
+    m_dir[SERVER_TO_CLIENT].current = nullptr;
+    while (!m_exchanges.empty())
+    {
+        Http2Stream& ex = m_exchanges.front();
+        ex.request.length = static_cast<int>(ex.request_body_bytes);
+        ex.response.length = static_cast<int>(ex.response_body_bytes);
+        if (m_on_done) m_on_done(ex);
+        m_exchanges.pop_front();
+    }
+}
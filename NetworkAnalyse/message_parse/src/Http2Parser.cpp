@@ -0,0 +1,475 @@
+#include "Http2Parser.h"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+const char   kClientPreface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+const size_t kClientPrefaceLen = sizeof(kClientPreface) - 1;
+const size_t kFrameHeaderLen = 9;
+const size_t kMaxFrameLen = (1u << 24) - 1;     // SETTINGS_MAX_FRAME_SIZE 允许的最大值
+
+// 帧类型（RFC 7540 6.x）
+enum FrameType : uint8_t {
+    FRAME_DATA = 0x0,
+    FRAME_HEADERS = 0x1,
+    FRAME_PRIORITY = 0x2,
+    FRAME_RST_STREAM = 0x3,
+    FRAME_SETTINGS = 0x4,
+    FRAME_PUSH_PROMISE = 0x5,
+    FRAME_PING = 0x6,
+    FRAME_GOAWAY = 0x7,
+    FRAME_WINDOW_UPDATE = 0x8,
+    FRAME_CONTINUATION = 0x9,
+};
+
+// 帧标志
+const uint8_t FLAG_END_STREAM = 0x1;
+const uint8_t FLAG_ACK = 0x1;
+const uint8_t FLAG_END_HEADERS = 0x4;
+const uint8_t FLAG_PADDED = 0x8;
+const uint8_t FLAG_PRIORITY = 0x20;
+
+const uint16_t SETTINGS_HEADER_TABLE_SIZE = 0x1;
+const uint16_t SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+const uint16_t SETTINGS_MAX_FRAME_SIZE = 0x5;
+
+uint32_t read_u32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// 去掉 PADDED 填充，返回 false 表示填充长度非法
+bool strip_padding(uint8_t flags, const uint8_t*& payload, size_t& len)
+{
+    if (!(flags & FLAG_PADDED)) return true;
+    if (len < 1) return false;
+    size_t pad = payload[0];
+    if (pad >= len) return false;
+    payload += 1;
+    len -= 1 + pad;
+    return true;
+}
+
+void append_header(nlohmann::json& headers, const std::string& name, const std::string& value)
+{
+    if (headers.contains(name))
+        headers[name] = headers[name].get<std::string>() + ", " + value;
+    else
+        headers[name] = value;
+}
+
+void append_body(std::string& body, const uint8_t* data, size_t len)
+{
+    size_t room = Http2Connection::MAX_BODY_CAPTURE > body.size()
+                      ? Http2Connection::MAX_BODY_CAPTURE - body.size() : 0;
+    body.append(reinterpret_cast<const char*>(data), std::min(room, len));
+}
+
+size_t find_header_end(const std::string& buf)
+{
+    size_t pos = buf.find("\r\n\r\n");
+    return pos == std::string::npos ? pos : pos + 4;
+}
+
+} // namespace
+
+Http2Connection::Http2Connection(const HttpFlowInfo& base, StreamCallback on_done, bool upgrade)
+    : m_base(base)
+    , m_on_done(std::move(on_done))
+{
+    m_base.top_protocol = "HTTP2";
+    m_base.http_version = "HTTP/2.0";
+    m_dir[CLIENT_TO_SERVER].handshake_steps = upgrade ? 2 : 1;
+    m_dir[SERVER_TO_CLIENT].handshake_steps = upgrade ? 1 : 0;
+}
+
+bool Http2Connection::is_client_preface(const uint8_t* data, size_t len)
+{
+    return len >= kClientPrefaceLen && std::memcmp(data, kClientPreface, kClientPrefaceLen) == 0;
+}
+
+bool Http2Connection::is_h2c_upgrade(const uint8_t* data, size_t len)
+{
+    // 只检查 HTTP/1.1 请求的头部区域
+    static const char* kMethods[] = {"GET ", "POST ", "HEAD ", "OPTIONS ", "PUT "};
+    bool is_request = false;
+    for (const char* m : kMethods)
+    {
+        size_t n = std::strlen(m);
+        if (len >= n && std::memcmp(data, m, n) == 0) { is_request = true; break; }
+    }
+    if (!is_request) return false;
+
+    std::string head(reinterpret_cast<const char*>(data), std::min(len, size_t(4096)));
+    std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+    return head.find("\r\nupgrade: h2c") != std::string::npos;
+}
+
+bool Http2Connection::feed(Direction dir, const uint8_t* data, size_t len, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    st.buffer.append(reinterpret_cast<const char*>(data), len);
+
+    if (st.handshake_steps > 0)
+    {
+        if (!consume_handshake(dir, ts)) return false;
+        if (st.handshake_steps > 0) return st.buffer.size() <= 64 * 1024; // 握手报文不完整，继续等待
+    }
+
+    size_t offset = 0;
+    while (st.buffer.size() - offset >= kFrameHeaderLen)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(st.buffer.data()) + offset;
+        size_t frame_len = (size_t(p[0]) << 16) | (size_t(p[1]) << 8) | p[2];
+        if (frame_len > st.max_frame_size)
+        {
+            spdlog::debug("HTTP/2 frame of {} bytes exceeds max frame size {} on {}",
+                          frame_len, st.max_frame_size, m_base.flow_id);
+            return false;
+        }
+        if (st.buffer.size() - offset < kFrameHeaderLen + frame_len) break;
+
+        uint8_t type = p[3];
+        uint8_t flags = p[4];
+        uint32_t stream_id = read_u32(p + 5) & 0x7FFFFFFF;
+        if (!handle_frame(dir, type, flags, stream_id, p + kFrameHeaderLen, frame_len, ts))
+        {
+            spdlog::debug("HTTP/2 protocol error on {} (frame type {}, stream {})",
+                          m_base.flow_id, type, stream_id);
+            return false;
+        }
+        offset += kFrameHeaderLen + frame_len;
+    }
+    st.buffer.erase(0, offset);
+    return true;
+}
+
+// 越过握手阶段：Upgrade 请求/101 响应，以及客户端连接前言
+// 数据不足时保留 handshake_steps 并返回 true，返回 false 表示不是（或不再是）HTTP/2
+bool Http2Connection::consume_handshake(Direction dir, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    while (st.handshake_steps > 0)
+    {
+        if (dir == CLIENT_TO_SERVER && st.handshake_steps == 1)
+        {
+            if (st.buffer.size() < kClientPrefaceLen) return true;
+            if (!is_client_preface(reinterpret_cast<const uint8_t*>(st.buffer.data()), st.buffer.size()))
+                return false;
+            st.buffer.erase(0, kClientPrefaceLen);
+            st.handshake_steps = 0;
+            break;
+        }
+
+        size_t end = find_header_end(st.buffer);
+        if (end == std::string::npos) return true;
+
+        if (dir == CLIENT_TO_SERVER)
+        {
+            // 升级请求即流 1 的请求（RFC 7540 3.2），请求方向在此已结束
+            std::string head = st.buffer.substr(0, end);
+            Http2Stream& stream = get_stream(1, ts);
+            size_t sp1 = head.find(' ');
+            size_t sp2 = head.find(' ', sp1 + 1);
+            if (sp1 != std::string::npos && sp2 != std::string::npos)
+            {
+                stream.flow.method = head.substr(0, sp1);
+                stream.request.headers[":method"] = stream.flow.method;
+                stream.request.headers[":path"] = head.substr(sp1 + 1, sp2 - sp1 - 1);
+            }
+            std::string lower = head;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            size_t host = lower.find("\r\nhost:");
+            if (host != std::string::npos)
+            {
+                size_t vbeg = head.find_first_not_of(' ', host + 7);
+                size_t vend = head.find("\r\n", vbeg);
+                stream.flow.host = head.substr(vbeg, vend - vbeg);
+            }
+            stream.flow.url = "http://" + stream.flow.host + stream.request.headers.value(":path", "");
+            stream.request_header_bytes = end;
+            stream.request_done = true;
+            stream.request_end = ts;
+        }
+        else if (st.buffer.compare(0, 12, "HTTP/1.1 101") != 0)
+        {
+            // 服务端拒绝升级，按 HTTP/1.1 处理，不再属于 HTTP/2
+            return false;
+        }
+        st.buffer.erase(0, end);
+        --st.handshake_steps;
+    }
+    return true;
+}
+
+bool Http2Connection::handle_frame(Direction dir, uint8_t type, uint8_t flags, uint32_t stream_id,
+                                   const uint8_t* payload, size_t len, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+
+    // 头部块未结束时只允许同一流的 CONTINUATION（RFC 7540 6.10）
+    if (st.header_stream != 0 && (type != FRAME_CONTINUATION || stream_id != st.header_stream))
+        return false;
+
+    switch (type)
+    {
+        case FRAME_DATA:
+        {
+            if (stream_id == 0) return false;
+            if (!strip_padding(flags, payload, len)) return false;
+            auto it = m_streams.find(stream_id);
+            if (it != m_streams.end())
+            {
+                Http2Stream& stream = it->second;
+                if (dir == CLIENT_TO_SERVER)
+                {
+                    stream.request_body_bytes += len;
+                    append_body(stream.request.body, payload, len);
+                }
+                else
+                {
+                    stream.response_body_bytes += len;
+                    append_body(stream.response.body, payload, len);
+                }
+            }
+            if (flags & FLAG_END_STREAM) end_stream(dir, stream_id, ts);
+            break;
+        }
+        case FRAME_HEADERS:
+        {
+            if (stream_id == 0) return false;
+            size_t frame_len = len;
+            if (!strip_padding(flags, payload, len)) return false;
+            if (flags & FLAG_PRIORITY)
+            {
+                if (len < 5) return false;
+                payload += 5;
+                len -= 5;
+            }
+            st.header_stream = stream_id;
+            st.promised_stream = 0;
+            st.header_end_stream = (flags & FLAG_END_STREAM) != 0;
+            st.header_frame_bytes = frame_len;
+            st.header_block.assign(reinterpret_cast<const char*>(payload), len);
+            if (flags & FLAG_END_HEADERS) return handle_header_block(dir, ts);
+            break;
+        }
+        case FRAME_CONTINUATION:
+        {
+            if (st.header_stream == 0) return false;
+            st.header_block.append(reinterpret_cast<const char*>(payload), len);
+            st.header_frame_bytes += len;
+            if (flags & FLAG_END_HEADERS) return handle_header_block(dir, ts);
+            break;
+        }
+        case FRAME_PUSH_PROMISE:
+        {
+            if (dir != SERVER_TO_CLIENT || stream_id == 0) return false;
+            size_t frame_len = len;
+            if (!strip_padding(flags, payload, len)) return false;
+            if (len < 4) return false;
+            st.header_stream = stream_id;
+            st.promised_stream = read_u32(payload) & 0x7FFFFFFF;
+            st.header_end_stream = false;
+            st.header_frame_bytes = frame_len;
+            st.header_block.assign(reinterpret_cast<const char*>(payload + 4), len - 4);
+            if (flags & FLAG_END_HEADERS) return handle_header_block(dir, ts);
+            break;
+        }
+        case FRAME_RST_STREAM:
+        {
+            if (stream_id == 0 || len != 4) return false;
+            auto it = m_streams.find(stream_id);
+            if (it != m_streams.end())
+            {
+                it->second.reset = true;
+                finish_stream(stream_id);
+            }
+            break;
+        }
+        case FRAME_SETTINGS:
+        {
+            if (stream_id != 0 || (flags & FLAG_ACK)) break;
+            if (len % 6 != 0) return false;
+            for (size_t i = 0; i < len; i += 6)
+            {
+                uint16_t id = uint16_t((payload[i] << 8) | payload[i + 1]);
+                uint32_t value = read_u32(payload + i + 2);
+                // 一端声明的表大小、帧长度约束的是发往它的数据，即对向
+                if (id == SETTINGS_HEADER_TABLE_SIZE)
+                    m_dir[1 - dir].hpack.set_max_table_size(value);
+                else if (id == SETTINGS_MAX_FRAME_SIZE)
+                {
+                    if (value < DEFAULT_MAX_FRAME_SIZE || value > kMaxFrameLen) return false;
+                    m_dir[1 - dir].max_frame_size = value;
+                }
+                else if (id == SETTINGS_MAX_CONCURRENT_STREAMS)
+                    st.max_concurrent = std::min(size_t(value), size_t(MAX_STREAMS));
+            }
+            break;
+        }
+        case FRAME_PRIORITY:
+        case FRAME_PING:
+        case FRAME_GOAWAY:
+        case FRAME_WINDOW_UPDATE:
+        default:
+            // 对流归属无影响的帧，未知帧类型按 RFC 要求忽略
+            break;
+    }
+    return true;
+}
+
+bool Http2Connection::handle_header_block(Direction dir, const timeval& ts)
+{
+    DirectionState& st = m_dir[dir];
+    uint32_t stream_id = st.promised_stream ? st.promised_stream : st.header_stream;
+    bool promise = st.promised_stream != 0;
+    bool end = st.header_end_stream;
+    size_t frame_bytes = st.header_frame_bytes;
+
+    std::vector<HpackDecoder::Header> headers;
+    bool ok = st.hpack.decode(reinterpret_cast<const uint8_t*>(st.header_block.data()),
+                              st.header_block.size(), headers);
+    st.header_block.clear();
+    st.header_stream = 0;
+    st.promised_stream = 0;
+    // HPACK 状态一旦失步，后续头部块都无法解码，只能放弃整个连接
+    if (!ok) return false;
+
+    Http2Stream& stream = get_stream(stream_id, ts);
+    if (dir == CLIENT_TO_SERVER || promise)
+    {
+        // 首个头部块为请求头，其后为 trailers
+        stream.pushed = stream.pushed || promise;
+        stream.request_header_bytes += frame_bytes;
+        for (const auto& h : headers)
+        {
+            append_header(stream.request.headers, h.first, h.second);
+            if (h.first == ":method") stream.flow.method = h.second;
+            else if (h.first == ":authority") stream.flow.host = h.second;
+            else if (h.first == "content-type") stream.request.content_type = h.second;
+        }
+        std::string scheme = stream.request.headers.value(":scheme", "http");
+        std::string path = stream.request.headers.value(":path", "");
+        stream.flow.url = scheme + "://" + stream.flow.host + path;
+        if (promise)
+        {
+            stream.request_done = true;
+            stream.request_end = ts;
+        }
+    }
+    else
+    {
+        stream.response_header_bytes += frame_bytes;
+        int status = 0;
+        for (const auto& h : headers)
+        {
+            if (h.first == ":status") status = std::atoi(h.second.c_str());
+        }
+        // 1xx 为中间响应，不计入最终响应
+        if (status >= 100 && status < 200) return true;
+
+        bool first = stream.response_start.tv_sec == 0 && stream.response_start.tv_usec == 0;
+        if (first) stream.response_start = ts;
+        for (const auto& h : headers)
+        {
+            append_header(stream.response.headers, h.first, h.second);
+            if (h.first == "content-type")
+            {
+                stream.response.content_type = h.second;
+                stream.flow.content_type = h.second;
+            }
+        }
+        if (status) stream.flow.status_code = status;
+    }
+
+    if (end) end_stream(dir, stream_id, ts);
+    return true;
+}
+
+Http2Stream& Http2Connection::get_stream(uint32_t stream_id, const timeval& ts)
+{
+    auto it = m_streams.find(stream_id);
+    if (it != m_streams.end()) return it->second;
+
+    // 一端声明的并发上限约束对端发起的流：客户端请求流受服务端的限制，推送流受客户端的限制
+    size_t limit = std::min(size_t(MAX_STREAMS),
+                            m_dir[CLIENT_TO_SERVER].max_concurrent + m_dir[SERVER_TO_CLIENT].max_concurrent);
+    while (!m_streams.empty() && m_streams.size() >= std::max<size_t>(limit, 1)) evict_oldest_stream();
+
+    Http2Stream& stream = m_streams[stream_id];
+    stream.stream_id = stream_id;
+    stream.flow = m_base;
+    stream.flow.flow_id = m_base.flow_id + "#" + std::to_string(stream_id);
+    stream.flow.status_code = 0;
+    stream.request_start = ts;
+
+    stream.request.flow_id = stream.flow.flow_id;
+    stream.request.type = "request";
+    stream.request.top_protocol = m_base.top_protocol;
+    stream.request.headers = nlohmann::json::object();
+    stream.response.flow_id = stream.flow.flow_id;
+    stream.response.type = "response";
+    stream.response.top_protocol = m_base.top_protocol;
+    stream.response.headers = nlohmann::json::object();
+    return stream;
+}
+
+void Http2Connection::end_stream(Direction dir, uint32_t stream_id, const timeval& ts)
+{
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end()) return;
+
+    Http2Stream& stream = it->second;
+    if (dir == CLIENT_TO_SERVER)
+    {
+        stream.request_done = true;
+        stream.request_end = ts;
+    }
+    else
+    {
+        stream.response_done = true;
+        stream.response_end = ts;
+    }
+    if (stream.request_done && stream.response_done) finish_stream(stream_id);
+}
+
+void Http2Connection::finish_stream(uint32_t stream_id)
+{
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end()) return;
+
+    Http2Stream& stream = it->second;
+    stream.request.length = static_cast<int>(stream.request_body_bytes);
+    stream.response.length = static_cast<int>(stream.response_body_bytes);
+    if (m_on_done) m_on_done(stream);
+    m_streams.erase(it);
+}
+
+void Http2Connection::evict_oldest_stream()
+{
+    // 超出上限说明有流的结束帧没见到（丢包、解密中断），按开始时间最早的先输出，保留已统计的内容
+    auto oldest = m_streams.begin();
+    for (auto it = m_streams.begin(); it != m_streams.end(); ++it)
+    {
+        const timeval& a = it->second.request_start;
+        const timeval& b = oldest->second.request_start;
+        if (a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_usec < b.tv_usec)) oldest = it;
+    }
+    spdlog::debug("HTTP/2 stream limit reached on {}, flushing stream {}", m_base.flow_id, oldest->first);
+    finish_stream(oldest->first);
+}
+
+void Http2Connection::close(const timeval& ts)
+{
+    // 连接结束时未完成的流也要输出，保留已统计的大小与时间
+    while (!m_streams.empty())
+    {
+        Http2Stream& stream = m_streams.begin()->second;
+        if (!stream.response_done && (stream.response_end.tv_sec != 0 || stream.response_start.tv_sec != 0))
+            stream.response_end = ts;
+        finish_stream(m_streams.begin()->first);
+    }
+}
@@ -0,0 +1,206 @@
+#include "Ipv4Reassembler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const uint16_t IP_MF = 0x2000;
+const uint16_t IP_OFFSET_MASK = 0x1FFF;
+const size_t IP_MAX_LENGTH = 65535;
+
+inline uint16_t read16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+}
+
+Ipv4Reassembler::Ipv4Reassembler(const ReassemblyConfig& config)
+    : m_config(config)
+{
+}
+
+bool Ipv4Reassembler::is_fragment(const uint8_t* ip)
+{
+    return (read16(ip + 6) & (IP_MF | IP_OFFSET_MASK)) != 0;
+}
+
+Ipv4Reassembler::Result Ipv4Reassembler::process(const uint8_t* ip, size_t len, const timeval& ts,
+                                                 std::vector<uint8_t>& out)
+{
+    if (len < 20 || !is_fragment(ip)) return Result::NOT_FRAGMENT;
+
+    ++m_stats.fragments;
+    expire(ts.tv_sec);
+
+    size_t ihl = (ip[0] & 0x0F) * 4;
+    uint16_t frag = read16(ip + 6);
+    bool more = (frag & IP_MF) != 0;
+    uint32_t offset = static_cast<uint32_t>(frag & IP_OFFSET_MASK) * 8;
+    if (ihl < 20 || len < ihl)
+    {
+        ++m_stats.malformed;
+        return Result::DROPPED;
+    }
+    const uint8_t* data = ip + ihl;
+    size_t data_len = len - ihl;
+    // 非末片长度必须为 8 的倍数；重组后总长不能超过 IP 上限
+    if ((more && (data_len == 0 || data_len % 8 != 0)) || offset + data_len + ihl > IP_MAX_LENGTH)
+    {
+        ++m_stats.malformed;
+        return Result::DROPPED;
+    }
+
+    Key key{};
+    std::memcpy(&key.src, ip + 12, 4);
+    std::memcpy(&key.dst, ip + 16, 4);
+    key.id = read16(ip + 4);
+    key.protocol = ip[9];
+
+    auto it = m_datagrams.find(key);
+    if (it == m_datagrams.end())
+    {
+        if (m_datagrams.size() >= m_config.max_datagrams && !m_order.empty())
+        {
+            ++m_stats.evicted;
+            Key oldest = m_order.front();
+            remove(oldest);
+        }
+        it = m_datagrams.emplace(key, Datagram()).first;
+        it->second.first_seen = ts.tv_sec;
+        it->second.order = m_order.insert(m_order.end(), key);
+    }
+    Datagram& dg = it->second;
+
+    uint32_t end = offset + static_cast<uint32_t>(data_len);
+    bool consistent = true;
+    if (!more)
+    {
+        // 末片确定总长：与已知总长或已收区间冲突则不合法
+        if ((dg.have_last && dg.total != end) || (!dg.ranges.empty() && dg.ranges.rbegin()->second > end))
+            consistent = false;
+        dg.total = end;
+        dg.have_last = true;
+    }
+    else if (dg.have_last && end > dg.total)
+    {
+        consistent = false;
+    }
+    if (!consistent)
+    {
+        ++m_stats.malformed;
+        remove(key);
+        return Result::DROPPED;
+    }
+
+    if (offset == 0) dg.header.assign(ip, ip + ihl);
+    if (!add_fragment(dg, offset, data, data_len))
+    {
+        ++m_stats.overlaps;
+        remove(key);
+        return Result::DROPPED;
+    }
+    charge(dg);
+
+    // 超出内存上限时从最早的数据报开始淘汰，可能包括当前数据报
+    while (m_bytes > m_config.max_bytes && !m_order.empty())
+    {
+        ++m_stats.evicted;
+        Key oldest = m_order.front();
+        remove(oldest);
+    }
+    it = m_datagrams.find(key);
+    if (it == m_datagrams.end()) return Result::DROPPED;
+
+    if (!complete(it->second)) return Result::PENDING;
+
+    build(it->second, out);
+    remove(key);
+    ++m_stats.reassembled;
+    return Result::COMPLETE;
+}
+
+bool Ipv4Reassembler::add_fragment(Datagram& dg, uint32_t offset, const uint8_t* data, size_t len)
+{
+    uint32_t end = offset + static_cast<uint32_t>(len);
+
+    // 找到第一个与 [offset, end] 相交或相邻的区间
+    auto first = dg.ranges.upper_bound(offset);
+    if (first != dg.ranges.begin() && std::prev(first)->second >= offset) --first;
+
+    // 重叠部分必须与已收内容一致
+    for (auto r = first; r != dg.ranges.end() && r->first < end; ++r)
+    {
+        uint32_t s = std::max(r->first, offset);
+        uint32_t e = std::min(r->second, end);
+        if (s < e && std::memcmp(dg.payload.data() + s, data + (s - offset), e - s) != 0)
+            return false;
+    }
+
+    if (dg.payload.size() < end) dg.payload.resize(end);
+    std::memcpy(dg.payload.data() + offset, data, len);
+
+    // 合并区间
+    uint32_t merged_start = offset;
+    uint32_t merged_end = end;
+    auto r = first;
+    while (r != dg.ranges.end() && r->first <= merged_end)
+    {
+        merged_start = std::min(merged_start, r->first);
+        merged_end = std::max(merged_end, r->second);
+        r = dg.ranges.erase(r);
+    }
+    dg.ranges.emplace(merged_start, merged_end);
+    return true;
+}
+
+bool Ipv4Reassembler::complete(const Datagram& dg) const
+{
+    return dg.have_last && !dg.header.empty() && dg.ranges.size() == 1 &&
+           dg.ranges.begin()->first == 0 && dg.ranges.begin()->second == dg.total;
+}
+
+void Ipv4Reassembler::build(const Datagram& dg, std::vector<uint8_t>& out) const
+{
+    size_t ihl = dg.header.size();
+    size_t total_length = ihl + dg.total;
+    out.resize(total_length);
+    std::memcpy(out.data(), dg.header.data(), ihl);
+    std::memcpy(out.data() + ihl, dg.payload.data(), dg.total);
+
+    // 修正总长、清除分片字段并重算头部校验和
+    out[2] = static_cast<uint8_t>(total_length >> 8);
+    out[3] = static_cast<uint8_t>(total_length & 0xFF);
+    out[6] = out[7] = 0;
+    out[10] = out[11] = 0;
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < ihl; i += 2) sum += read16(out.data() + i);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    uint16_t checksum = static_cast<uint16_t>(~sum);
+    out[10] = static_cast<uint8_t>(checksum >> 8);
+    out[11] = static_cast<uint8_t>(checksum & 0xFF);
+}
+
+void Ipv4Reassembler::charge(Datagram& dg)
+{
+    size_t bytes = dg.payload.capacity() + dg.header.capacity() +
+                   dg.ranges.size() * (sizeof(uint32_t) * 2 + 32);     // 区间节点按红黑树节点估算
+    m_bytes = m_bytes + bytes - dg.charged;
+    dg.charged = bytes;
+}
+
+void Ipv4Reassembler::remove(const Key& key)
+{
+    auto it = m_datagrams.find(key);
+    if (it == m_datagrams.end()) return;
+    m_bytes -= it->second.charged;
+    m_order.erase(it->second.order);
+    m_datagrams.erase(it);
+}
+
+void Ipv4Reassembler::expire(std::time_t now)
+{
+    while (!m_order.empty())
+    {
+        auto it = m_datagrams.find(m_order.front());
+        if (now - it->second.first_seen < m_config.timeout) break;
+        ++m_stats.timed_out;
+        Key oldest = m_order.front();
+        remove(oldest);
+    }
+}
@@ -1,4 +1,6 @@
 #include "PacketParser.h"
+#include <BatchWriter.h>
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
@@ -17,8 +19,34 @@ std::string generateSessionId(const std::string& src_ip, int src_port,
             dst_ip + ":" + std::to_string(dst_port) + "-" + protocol;
 }
 
-PacketParser::PacketParser() : m_running(false) 
+// 生成规范化会话ID：端点排序后拼接，同一连接的两个方向得到同一个键；
+// side 输出发送端在排序中的位置（0 表示发送端在前）
+std::string generateFlowId(const std::string& src_ip, int src_port,
+                           const std::string& dst_ip, int dst_port,
+                           const std::string& protocol, int& side) {
+    int cmp = src_ip.compare(dst_ip);
+    side = (cmp < 0 || (cmp == 0 && src_port <= dst_port)) ? 0 : 1;
+    return side == 0 ? generateSessionId(src_ip, src_port, dst_ip, dst_port, protocol)
+                     : generateSessionId(dst_ip, dst_port, src_ip, src_port, protocol);
+}
+
+// 判断 TCP 报文发送端是否为连接发起方：优先依据握手标志，中途捕获的连接按端口推测
+static bool is_tcp_initiator(uint8_t flags, int src_port, int dst_port, bool& known) {
+    const uint8_t SYN = 0x02, ACK = 0x10;
+    known = (flags & SYN) != 0;
+    if (known) return !(flags & ACK);
+    // 知名端口一侧视为服务端，否则较小端口一侧视为服务端
+    if ((src_port < 1024) != (dst_port < 1024)) return dst_port < 1024;
+    return src_port > dst_port;
+}
+
+PacketParser::PacketParser() : m_running(false), m_lastFlushTime(std::time(nullptr)), m_flushInProgress(false),
+    m_address_reader(m_address_map)
 {
+    register_dissectors();
+    // 默认实验环境：代理出口地址换算为设备地址，可通过 set_address_map 替换
+    std::string error;
+    m_address_map.set_base({{"192.168.31.172", "192.168.31.200"}}, error);
 
 }
 
@@ -27,8 +55,34 @@ PacketParser::~PacketParser()
     stop();
 }
 
-void PacketParser::start(int uid) 
+void PacketParser::start(int uid, const CaptureOptions& options) 
 {
+    // 本次采集的地址映射条目（非法条目只记录日志，不影响采集）
+    std::string error;
+    if (!m_address_map.set_session(options.address_map, error))
+        spdlog::error("Invalid address map for capture: {}", error);
+
+    // 按本次采集的配置启用解析器并生成分发表，必须在解析线程启动前完成
+    m_dissectors.reset_enabled();
+    for (const auto& pair : options.dissectors)
+    {
+        if (!m_dissectors.set_enabled(pair.first, pair.second))
+            spdlog::warn("Unknown dissector: {}", pair.first);
+    }
+    m_dissectors.build();
+    m_udp_flows = m_dissectors.is_enabled("udp");
+    m_features = options.features;
+    m_bulk_load = options.bulk_load;
+    m_device = options.adb_serial;
+    // 批量导入时大批会话记录也走 LOAD DATA（列式存储后端不经过 MySQL）
+    m_session_bulk.reset(m_bulk_load && !m_mysql.column_store() ? new BulkLoader(m_mysql.endpoint()) : nullptr);
+    if (!options.tls_keylog.empty() && !m_keylog.open(options.tls_keylog, error))
+        spdlog::error("TLS key log unavailable, TLS decryption disabled: {}", error);
+    std::string enabled;
+    for (const auto& name : m_dissectors.enabled_names())
+        enabled += (enabled.empty() ? "" : ",") + name;
+    spdlog::info("Dissectors enabled: {}", enabled);
+
     m_running = true;
     m_parser_thread = std::thread(&PacketParser::parse_loop, this);
     m_sessionThread = std::thread(&PacketParser::session_management_loop, this);
@@ -53,28 +107,108 @@ void PacketParser::stop()
     if (m_sessionThread.joinable())
         m_sessionThread.join();
                 
-        // 刷新所有待处理的会话
+    // 停止采集后结束全部会话，输出终结记录
+    {
+        std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
+        m_sessions.close_all("stop");
+    }
     flush_pending_sessions();
+
+    // 解析线程已退出，输出仍在进行中的 HTTP 交换
+    timeval now{std::time(nullptr), 0};
+    for (auto& pair : m_http_conns)
+        close_http(pair.second, now);
+    m_http_conns.clear();
+    m_keylog.close();
+    flush_pending_http();
 }
     
 
+// 按地址映射表换算并转为文本，addr 为网络字节序
+void PacketParser::format_address(uint32_t addr, std::string& out) const
+{
+    if (const std::string* mapped = m_address_reader.lookup(addr))
+    {
+        out = *mapped;
+        return;
+    }
+    char text[INET_ADDRSTRLEN] = {0};
+    inet_ntop(AF_INET, &addr, text, INET_ADDRSTRLEN);
+    out = text;
+}
+
+bool PacketParser::set_address_map(const AddressMap::Entries& entries, bool session, std::string& error)
+{
+    return session ? m_address_map.set_session(entries, error) : m_address_map.set_base(entries, error);
+}
+
+// 登记协议解析器：端口/整协议绑定，新增协议只需在此注册
+void PacketParser::register_dissectors()
+{
+    const uint16_t IPV4 = 0x0800;
+    const uint8_t ICMP_PROTO = 1, TCP_PROTO = 6, UDP_PROTO = 17;
+
+    m_dissectors.add(std::make_shared<FunctionDissector>("tcp", [this](const PacketView& p) {
+        return parse_tcp(p.l4_data, p.l4_len, p.ts, p.src_ip, p.dst_ip, p.ip_header, p.ip_header_len,
+                         p.sample_rate);
+    }));
+    m_dissectors.bind_protocol("tcp", IPV4, TCP_PROTO);
+
+    m_dissectors.add(std::make_shared<FunctionDissector>("dns", [this](const PacketView& p) {
+        return parse_dns(p.payload, p.payload_len, p.ts, p.src_ip, p.dst_ip, p.ip_header, p.ip_header_len);
+    }));
+    m_dissectors.bind_port("dns", IPV4, UDP_PROTO, 53);
+
+    // mDNS 报文格式与 DNS 相同，局域网广播较多，默认关闭
+    m_dissectors.add(std::make_shared<FunctionDissector>("mdns", [this](const PacketView& p) {
+        return parse_dns(p.payload, p.payload_len, p.ts, p.src_ip, p.dst_ip, p.ip_header, p.ip_header_len);
+    }), false);
+    m_dissectors.bind_port("mdns", IPV4, UDP_PROTO, 5353);
+
+    // QUIC 连接迁移后端口不固定，短包头只能靠跟踪器中的连接 ID 识别，按启发式匹配；
+    // 看似 QUIC 但无法归属的报文仍按普通 UDP 流计数
+    m_dissectors.add(std::make_shared<FunctionDissector>("quic", [this](const PacketView& p) {
+        if (!parse_quic(p.payload, p.payload_len, p.ts, p.src_ip, p.src_port, p.dst_ip, p.dst_port, p.sample_rate)
+            && m_udp_flows)
+            track_udp(p.payload, p.payload_len, p.ts, p.src_ip, p.src_port, p.dst_ip, p.dst_port, p.sample_rate);
+        return json();
+    }, [this](const PacketView& p) {
+        return m_quic.recognizes(p.src_ip, p.src_port, p.dst_ip, p.dst_port, p.payload, p.payload_len);
+    }));
+    m_dissectors.bind_heuristic("quic", IPV4, UDP_PROTO);
+
+    // 其余 UDP（STUN、游戏、VoIP 等）不再逐包入库，按流累计后随会话刷新
+    m_dissectors.add(std::make_shared<FunctionDissector>("udp", [this](const PacketView& p) {
+        track_udp(p.payload, p.payload_len, p.ts, p.src_ip, p.src_port, p.dst_ip, p.dst_port, p.sample_rate);
+        return json();
+    }));
+    m_dissectors.bind_protocol("udp", IPV4, UDP_PROTO);
+
+    m_dissectors.add(std::make_shared<FunctionDissector>("icmp", [this](const PacketView& p) {
+        return parse_icmp(p.l4_data, p.l4_len, p.ts, p.src_ip, p.dst_ip, p.ip_header, p.ip_header_len);
+    }));
+    m_dissectors.bind_protocol("icmp", IPV4, ICMP_PROTO);
+}
+
     // 会话管理线程函数
 void PacketParser::session_management_loop() {
     while (m_running) {
         spdlog::debug("Session management thread checking for flush condition");
         
-        // 检查是否需要刷新
+        // 推进时间轮结束超时会话，再检查是否需要刷新
         bool shouldFlush = false;
         std::time_t now = std::time(nullptr);
         
         {
             std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
-            shouldFlush = (m_activeSessions.size() >= MIN_SESSIONS_BEFORE_FLUSH || 
+            m_sessions.tick(now);
+            shouldFlush = (m_sessions.pending_closed() >= MIN_SESSIONS_BEFORE_FLUSH || 
                           now - m_lastFlushTime >= FLUSH_TIMEOUT_SECONDS);
         }
         
         if (shouldFlush) {
             flush_pending_sessions(); // 刷新所有会话
+            flush_pending_http();
         } else {
             // 等待一段时间后再次检查
             std::unique_lock<std::mutex> lock(m_pendingMutex);
@@ -84,6 +218,7 @@ void PacketParser::session_management_loop() {
     
     // 程序停止前刷新所有会话
     flush_pending_sessions();
+    flush_pending_http();
     spdlog::info("Session management thread stopped");
 }
 
@@ -93,31 +228,36 @@ void PacketParser::flush_pending_sessions() {
         if (m_flushInProgress) return; // 避免并发刷新
     
     m_flushInProgress = true;
-    std::queue<SessionInfo> sessionsToFlush;
+    std::vector<SessionInfo> sessionsToFlush;
     std::time_t now = std::time(nullptr);
     
     {
         std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
-        spdlog::info("Flushing all sessions: count={}, last flush={}s ago", 
-                    m_activeSessions.size(), now - m_lastFlushTime);
-        
-        // 复制所有会话到待刷新队列
-        for (const auto& pair : m_activeSessions) {
-            sessionsToFlush.push(pair.second);
-        }
-        
-        // 清空活跃会话集
-        m_activeSessions.clear();
+        // 活跃会话只取增量，已结束的会话取终结记录，会话表本身不清空
+        m_sessions.collect(sessionsToFlush);
+        const SessionTableStats& stats = m_sessions.stats();
+        spdlog::info("Flushing sessions: records={}, active={}, last flush={}s ago", 
+                    sessionsToFlush.size(), m_sessions.size(), now - m_lastFlushTime);
+        spdlog::debug("Session table: created={} fin={} rst={} idle={} evicted={} clamped={} peak={} duplicates={}",
+                      stats.created, stats.closed_fin, stats.closed_rst, stats.expired_idle,
+                      stats.evicted, stats.clamped_time, stats.peak_entries, m_duplicates.duplicates());
         m_lastFlushTime = now;
     }
     
-    // 执行数据库写入
-    while (!sessionsToFlush.empty()) {
-        const auto& session = sessionsToFlush.front();
-        if (m_mysql.insert_or_update_session_info(session) != 1) {
-            spdlog::error("Failed to store session: {}", session.session_id);
-        }
-        sessionsToFlush.pop();
+    // 执行数据库写入：一个事务内多行 upsert（批量导入时大批记录经临时表合并），失败时转存暂存区待回放
+    int result = -1;
+    if (m_session_bulk && sessionsToFlush.size() >= SESSION_BULK_MIN_ROWS)
+        result = m_mysql.bulk_store_sessions(*m_session_bulk, sessionsToFlush);
+    if (result == -1) result = m_mysql.store_session_infos(sessionsToFlush);
+    // -2：批量合并的提交结果丢失且未能转存，增量不再重发，免得服务端已提交时重复累加
+    bool stored = result >= 0 || result == -2;
+    if (result < 0) {
+        spdlog::error("Failed to store {} session records", sessionsToFlush.size());
+    }
+    {
+        // 写入（或转存）成功后活跃会话才算已入库，否则退回增量下次重新输出
+        std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
+        m_sessions.confirm(stored);
     }
     
     m_flushInProgress = false;
@@ -143,6 +283,7 @@ void PacketParser::parse_loop()
     while (m_running) 
     {
         Packet packet;
+        size_t depth = 0;
         {
             std::unique_lock<std::mutex> lock(m_raw_mutex);
             // 等待直到有数据包可用
@@ -153,89 +294,147 @@ void PacketParser::parse_loop()
 
             packet = m_raw_packet_queue.front();
             m_raw_packet_queue.pop();
+            depth = m_raw_packet_queue.size();
         }
 
-        // 解析数据包
+        // 解析数据包，并把队列深度与解析耗时交给采样器判断是否过载
+        auto begin = std::chrono::steady_clock::now();
         parse_packet(packet);
+        auto end = std::chrono::steady_clock::now();
+        m_sampler.observe(depth,
+                          std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count(),
+                          std::chrono::duration_cast<std::chrono::microseconds>(end.time_since_epoch()).count());
     }
 }
 
-void PacketParser::parse_packet(const Packet& packet) 
+// 按链路层类型定位 IP 头，输出 EtherType 与链路层头长度，不支持的类型返回 false
+static bool link_layer(int link_type, const uint8_t* data, size_t len, uint16_t& ether_type, size_t& offset)
 {
-    if (packet.data.size() < sizeof(ETHER_HEADER)) return;
+    const int LINKTYPE_ETHERNET = 1;
+    const int LINKTYPE_RAW = 101;
+    const int LINKTYPE_LINUX_SLL = 113;
+    const int LINKTYPE_IPV4 = 228;
+    const int LINKTYPE_LINUX_SLL2 = 276;
+    const int DLT_RAW = 12;         // 部分平台上 RAW 的 DLT 取值
+
+    switch (link_type)
+    {
+    case LINKTYPE_ETHERNET:
+        if (len < sizeof(ETHER_HEADER)) return false;
+        ether_type = ntohs(reinterpret_cast<const ETHER_HEADER*>(data)->ether_type);
+        offset = sizeof(ETHER_HEADER);
+        return true;
+    case LINKTYPE_LINUX_SLL:
+        // packet_type(2) arphrd(2) addr_len(2) addr(8) protocol(2)
+        if (len < 16) return false;
+        ether_type = static_cast<uint16_t>((data[14] << 8) | data[15]);
+        offset = 16;
+        return true;
+    case LINKTYPE_LINUX_SLL2:
+        // protocol(2) reserved(2) ifindex(4) arphrd(2) packet_type(1) addr_len(1) addr(8)
+        if (len < 20) return false;
+        ether_type = static_cast<uint16_t>((data[0] << 8) | data[1]);
+        offset = 20;
+        return true;
+    case LINKTYPE_RAW:
+    case LINKTYPE_IPV4:
+    case DLT_RAW:
+        // 无链路层头，按 IP 版本号推断
+        if (len < 1) return false;
+        ether_type = (data[0] >> 4) == 4 ? 0x0800 : (data[0] >> 4) == 6 ? 0x86DD : 0;
+        offset = 0;
+        return true;
+    default:
+        return false;
+    }
+}
 
+void PacketParser::parse_packet(const Packet& packet) 
+{
     const uint8_t* data = packet.data.data();
-    ETHER_HEADER* eth = (ETHER_HEADER*)data;
-    // std::ostringstream ss;
-    // for (size_t i = 0; i < std::min(packet.data.size(), size_t(64)); ++i)
-    //     ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i]) << " ";spdlog::info("Raw packet hex dump: {}", ss.str());
-    // spdlog::info("Raw packet size: {}", packet.data.size());
-    // spdlog::info("Ether type: {:#06x}", ntohs(eth->ether_type));
     auto time = packet.timestamp;
 
-    json parsed;
+    // 以太网（宿主机网卡）、Linux cooked（设备端 tcpdump -i any）与裸 IP 链路
+    uint16_t ether_type = 0;
+    size_t l2_len = 0;
+    if (!link_layer(packet.link_type, data, packet.data.size(), ether_type, l2_len)) return;
+
+    // ARP 等非 IP 报文不解析
+    int l3 = DissectorRegistry::l3_index(ether_type);
+    if (l3 != DissectorRegistry::L3_IPV4) return;
+
+    if (packet.data.size() < l2_len + sizeof(IP_HEADER)) return;
+    const IP_HEADER* ip = reinterpret_cast<const IP_HEADER*>(data + l2_len);
+    size_t ip_header_len = (ip->versiosn_head_length & 0x0F) * 4;
 
-    switch (ntohs(eth->ether_type)) 
+    if (packet.data.size() < l2_len + ip_header_len) return;
+
+
+    const uint8_t* ip_header_ptr = data + l2_len;
+    const uint8_t* transport = ip_header_ptr + ip_header_len;
+    size_t transport_len = packet.data.size() - l2_len - ip_header_len;
+    // 以太网最小帧会在尾部填充，传输层长度以 IP 总长度为准
+    size_t ip_total_len = ntohs(ip->total_length);
+    if (ip_total_len >= ip_header_len && ip_total_len - ip_header_len < transport_len)
+        transport_len = ip_total_len - ip_header_len;
+
+    // 分片先重组，完整后以重组缓冲区替换原报文交给传输层解析
+    std::vector<uint8_t> reassembled;
+    if (Ipv4Reassembler::is_fragment(ip_header_ptr))
     {
-        case 0x0800: // IP
-        {
-            // spdlog::info("Parsing IP packet");
-            if (packet.data.size() < sizeof(ETHER_HEADER) + sizeof(IP_HEADER)) return;
-            const IP_HEADER* ip = reinterpret_cast<const IP_HEADER*>(data + sizeof(ETHER_HEADER));
-                size_t ip_header_len = (ip->versiosn_head_length & 0x0F) * 4;
-
-            if (packet.data.size() < sizeof(ETHER_HEADER) + ip_header_len) return;
-
-            // 获取源 IP 和目的 IP 地址
-            char src_ip[INET_ADDRSTRLEN] = {0};
-            char des_ip[INET_ADDRSTRLEN] = {0};
-            inet_ntop(AF_INET, &(ip->src_addr), src_ip, INET_ADDRSTRLEN);
-            inet_ntop(AF_INET, &(ip->des_addr), des_ip, INET_ADDRSTRLEN);
-
-            const uint8_t* transport = data + sizeof(ETHER_HEADER) + ip_header_len;
-            size_t transport_len = packet.data.size() - sizeof(ETHER_HEADER) - ip_header_len;
-            switch (ip->protocol) 
-            {
-                case 6: // TCP
+        auto result = m_reassembler.process(ip_header_ptr, ip_header_len + transport_len, time, reassembled);
+        if (result != Ipv4Reassembler::Result::COMPLETE) return;
+        ip_header_ptr = reassembled.data();
+        ip_header_len = (reassembled[0] & 0x0F) * 4;
+        transport = ip_header_ptr + ip_header_len;
+        transport_len = reassembled.size() - ip_header_len;
+    }
 
-                    parsed = parse_tcp(transport, packet.data.size() - sizeof(ETHER_HEADER) - ip_header_len,time, src_ip, des_ip , 
-                    data + sizeof(ETHER_HEADER), ip_header_len);
-                    break;
-                case 17: // UDP
-                {
-                    //spdlog::info("Parsing UDP packet");
-                    const UDP_HEADER* udp = reinterpret_cast<const UDP_HEADER*>(transport);
-                    uint16_t src_port = ntohs(udp->src_port);
-                    uint16_t des_port = ntohs(udp->des_port);
-
-                     if (src_port == 53 || des_port == 53) 
-                    {
-                        const uint8_t* udp_payload = transport + sizeof(UDP_HEADER);
-                        size_t udp_payload_len = transport_len - sizeof(UDP_HEADER);
-
-                        parsed = parse_dns(udp_payload, udp_payload_len, time, src_ip, des_ip,
-                                 data + sizeof(ETHER_HEADER), ip_header_len);
-                    }
-
-                    // parsed = parse_udp(transport, transport_len, time, src_ip, des_ip,
-                    //      data + sizeof(ETHER_HEADER), ip_header_len);
-                    break;
-                }
-                default:
-                    return;
-            }
-            break;
-        }
-        case 0x0806: // ARP
-            break;
-        default:
-            return;
+    PacketView view;
+    view.ts = time;
+    view.l3 = ether_type;
+    view.l4 = ip->protocol;
+    // 源/目的地址按映射表换算（代理出口 -> 设备地址等），未命中时转为点分十进制
+    m_address_reader.refresh();
+    format_address(ip->src_addr, view.src_ip);
+    format_address(ip->des_addr, view.dst_ip);
+    view.ip_header = ip_header_ptr;
+    view.ip_header_len = ip_header_len;
+    view.l4_data = transport;
+    view.l4_len = transport_len;
+    view.payload = transport;
+    view.payload_len = transport_len;
+    if (view.l4 == 6 && transport_len >= sizeof(TCP_HEADER))
+    {
+        const TCP_HEADER* tcp = reinterpret_cast<const TCP_HEADER*>(transport);
+        view.src_port = ntohs(tcp->src_port);
+        view.dst_port = ntohs(tcp->des_port);
     }
+    else if (view.l4 == 17)
+    {
+        if (transport_len < sizeof(UDP_HEADER)) return;
+        const UDP_HEADER* udp = reinterpret_cast<const UDP_HEADER*>(transport);
+        view.src_port = ntohs(udp->src_port);
+        view.dst_port = ntohs(udp->des_port);
+        view.payload = transport + sizeof(UDP_HEADER);
+        view.payload_len = transport_len - sizeof(UDP_HEADER);
+    }
+
+    // 子接口转发/镜像产生的重复副本只计数，不再解析入库
+    if (m_duplicates.is_duplicate(view)) return;
+
+    // 过载时按流采样，未入选的报文直接跳过
+    if (!m_sampler.admit(view, view.sample_rate)) return;
+
+    Dissector* dissector = m_dissectors.lookup(l3, view);
+    if (!dissector) return;
+    json parsed = dissector->dissect(view);
 
     // 如果解析成功, 将结果添加到相应的队列
     if (!parsed.is_null()) 
     {
         parsed["app_uid"] = app_uid;
+        if (!packet.device.empty()) parsed["device"] = packet.device;
         //改为异步存储
         {
             std::lock_guard<std::mutex> lock(m_storage_mutex);
@@ -309,22 +508,14 @@ void PacketParser::parse_packet(const Packet& packet)
  // TCP解析函数（修改部分）
 json PacketParser::parse_tcp(const uint8_t* data, size_t len, const timeval& ts,
                                 const std::string& src_ip, const std::string& des_ip,
-                                const uint8_t* ip_header_ptr, size_t ip_header_len)
+                                const uint8_t* ip_header_ptr, size_t ip_header_len,
+                                uint32_t sample_rate)
 {
    
    json j;    
-    // 确定实际的源IP和目的IP
-    std::string actualSrcIp, actualDesIp;
-    if (des_ip == "192.168.31.172") {
-        actualSrcIp = src_ip;
-        actualDesIp = m_src_ip;
-    } else if (src_ip == "192.168.31.172") {
-        actualSrcIp = m_src_ip;
-        actualDesIp = des_ip;
-    } else {
-        actualSrcIp = src_ip;
-        actualDesIp = des_ip;
-    }
+    // 地址映射（代理出口 -> 设备地址）已在 parse_packet 中完成
+    const std::string& actualSrcIp = src_ip;
+    const std::string& actualDesIp = des_ip;
 
     if (len < sizeof(TCP_HEADER)) return j;
     const TCP_HEADER* tcp = reinterpret_cast<const TCP_HEADER*>(data);
@@ -335,48 +526,54 @@ json PacketParser::parse_tcp(const uint8_t* data, size_t len, const timeval& ts,
     std::string protocol = "TCP";
     int src_port = static_cast<int>(ntohs(tcp->src_port));
     int dst_port = static_cast<int>(ntohs(tcp->des_port));
-    std::string sessionId = generateSessionId(actualSrcIp, src_port, actualDesIp, dst_port, protocol);
+    int side = 0;
+    std::string sessionId = generateFlowId(actualSrcIp, src_port, actualDesIp, dst_port, protocol, side);
 
     std::unique_lock<std::mutex> sessionsLock(m_sessionsMutex);
-    std::time_t now = std::time(nullptr);
-    bool shouldFlush = false;
-
-    // 更新或创建会话
-    if (m_activeSessions.find(sessionId) == m_activeSessions.end()) {
-        // 新建会话
-        SessionInfo newSession;
-        newSession.app_uid = app_uid;
-        newSession.timestamp = format_timeval(ts);
-        newSession.session_id = sessionId;
-        newSession.protocol = protocol;
-        newSession.src_ip = actualSrcIp;
-        newSession.src_port = src_port;
-        newSession.dst_ip = actualDesIp;
-        newSession.dst_port = dst_port;
-        newSession.size = 1;
-        newSession.last_update_time = now;
-        
-        m_activeSessions[sessionId] = newSession;
-        spdlog::info("New session created: {}", sessionId);
-    } else {
-        // 更新现有会话
-        auto& session = m_activeSessions[sessionId];
-        session.size++;
-        session.last_update_time = now;
-    }
-
-    // 检查是否需要刷新
-    if (m_activeSessions.size() >= MIN_SESSIONS_BEFORE_FLUSH || 
-        now - m_lastFlushTime >= FLUSH_TIMEOUT_SECONDS) {
-        shouldFlush = true;
+    std::time_t now = ts.tv_sec;    // 会话超时按报文时间计算
+    bool created = false;
+
+    // 更新或创建会话（两个方向同一条记录，状态跟踪、超时与淘汰由会话表负责）
+    SessionFlow& flow = m_sessions.touch(sessionId, protocol, tcp->flags, side, now, created);
+    SessionInfo& session = flow.info;
+    if (created) {
+        bool known = false;
+        bool initiator = is_tcp_initiator(tcp->flags, src_port, dst_port, known);
+        flow.client_side = static_cast<uint8_t>(initiator ? side : 1 - side);
+        session.app_uid = app_uid;
+        session.device = m_device;
+        session.timestamp_us = timeval_to_us(ts);
+        session.src_ip = initiator ? actualSrcIp : actualDesIp;
+        session.src_port = initiator ? src_port : dst_port;
+        session.dst_ip = initiator ? actualDesIp : actualSrcIp;
+        session.dst_port = initiator ? dst_port : src_port;
+        session.initiator_known = known;
+        spdlog::debug("New session created: {}", sessionId);
     }
+    int direction = (side == flow.client_side) ? 0 : 1;
+    // 计数为实际解析的报文，采样率另记在 sample_rate
+    session.size++;
+    if (direction == 0) session.packets_up++;
+    else session.packets_down++;
+    if (sample_rate > session.sample_rate) session.sample_rate = sample_rate;
+    if (timeval_to_us(ts) > session.last_seen_us) session.last_seen_us = timeval_to_us(ts);
+
+    tcp_metrics::update(session, flow.tcp, direction, tcp, len - tcp_header_len, ts);
+    if (m_features)
+        flow.features.update(direction, len - tcp_header_len, timeval_to_us(ts));
+
+    // 已结束的会话积累较多时提前刷新
+    bool shouldFlush = m_sessions.pending_closed() >= MIN_SESSIONS_BEFORE_FLUSH;
+    size_t pendingClosed = m_sessions.pending_closed();
 
     sessionsLock.unlock(); // 释放锁以避免长时间持有
+
+    track_http(actualSrcIp, src_port, actualDesIp, dst_port, tcp,
+                data + tcp_header_len, len - tcp_header_len, ts);
     
     // 需要刷新时，通知会话管理线程
     if (shouldFlush) {
-        spdlog::info("Triggering flush: sessions={}, timeout={}s", 
-                    m_activeSessions.size(), now - m_lastFlushTime);
+        spdlog::debug("Triggering flush: closed sessions={}", pendingClosed);
         {
             std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
             m_pendingCV.notify_one();
@@ -401,6 +598,339 @@ json PacketParser::parse_tcp(const uint8_t* data, size_t len, const timeval& ts,
 }
 
 
+void PacketParser::track_http(const std::string& src_ip, int src_port,
+                              const std::string& dst_ip, int dst_port,
+                              const TCP_HEADER* tcp, const uint8_t* payload, size_t payload_len,
+                              const timeval& ts)
+{
+    sweep_http(ts);
+
+    std::string src = src_ip + ":" + std::to_string(src_port);
+    std::string dst = dst_ip + ":" + std::to_string(dst_port);
+    std::string key = src < dst ? src + "-" + dst : dst + "-" + src;
+
+    auto it = m_http_conns.find(key);
+    if (it == m_http_conns.end())
+    {
+        // 只在客户端首个数据段上识别：连接前言（prior knowledge）、Upgrade: h2c，
+        // 或配置了 key log 时的 TLS ClientHello
+        if (payload_len == 0) return;
+        bool preface = Http2Connection::is_client_preface(payload, payload_len);
+        bool upgrade = !preface && Http2Connection::is_h2c_upgrade(payload, payload_len);
+        bool tls = !preface && !upgrade && m_keylog.is_open() && TlsDecryptor::is_client_hello(payload, payload_len);
+        if (!preface && !upgrade && !tls) return;
+
+        HttpTracker tracker;
+        tracker.base.flow_id = generateSessionId(src_ip, src_port, dst_ip, dst_port, "TCP");
+        tracker.base.app_uid = app_uid;
+        tracker.base.device = m_device;
+        tracker.base.protocol = "TCP";
+        tracker.base.src_ip = src_ip;
+        tracker.base.src_port = src_port;
+        tracker.base.dst_ip = dst_ip;
+        tracker.base.dst_port = dst_port;
+        tracker.client = src;
+        if (tls)
+        {
+            tracker.tls = std::make_unique<TlsDecryptor>(m_keylog);
+        }
+        else
+        {
+            tracker.h2 = std::make_unique<Http2Connection>(tracker.base, [this](Http2Stream& stream) {
+                std::lock_guard<std::mutex> lock(m_http_mutex);
+                m_pending_http.push_back(std::move(stream));
+            }, upgrade);
+        }
+        spdlog::info("HTTP connection detected ({}): {}",
+                     tls ? "tls" : upgrade ? "h2c upgrade" : "h2 prior knowledge", tracker.base.flow_id);
+        it = m_http_conns.emplace(key, std::move(tracker)).first;
+    }
+
+    HttpTracker& tracker = it->second;
+    tracker.last_seen = ts.tv_sec;
+    int dir = (src == tracker.client) ? Http2Connection::CLIENT_TO_SERVER : Http2Connection::SERVER_TO_CLIENT;
+
+    bool ok = true;
+    if (payload_len > 0)
+    {
+        uint32_t seq = ntohl(tcp->sequence);
+        if (!tracker.seq_valid[dir])
+        {
+            tracker.seq_valid[dir] = true;
+            tracker.next_seq[dir] = seq;
+        }
+        int32_t delta = static_cast<int32_t>(seq - tracker.next_seq[dir]);
+        if (delta > 0)
+        {
+            // 出现序号空洞（丢包/乱序），HPACK 与 TLS 记录状态都无法恢复，放弃该连接
+            spdlog::debug("HTTP stream gap on {}, dropping connection", key);
+            ok = false;
+        }
+        else if (static_cast<size_t>(-delta) < payload_len)
+        {
+            // 重传段只取尚未投递的部分
+            size_t skip = static_cast<size_t>(-delta);
+            ok = feed_http(tracker, dir, payload + skip, payload_len - skip, ts);
+            tracker.next_seq[dir] += static_cast<uint32_t>(payload_len - skip);
+        }
+    }
+
+    if (tcp->flags & 0x01) tracker.fin[dir] = true;
+    if (!ok || (tcp->flags & 0x04) || (tracker.fin[0] && tracker.fin[1]))
+    {
+        close_http(tracker, ts);
+        m_http_conns.erase(it);
+    }
+}
+
+bool PacketParser::feed_http(HttpTracker& tracker, int dir, const uint8_t* data, size_t len, const timeval& ts)
+{
+    if (!tracker.tls)
+        return tracker.h2->feed(static_cast<Http2Connection::Direction>(dir), data, len, ts);
+
+    std::string plaintext;
+    if (!tracker.tls->feed(static_cast<TlsDecryptor::Direction>(dir), data, len, plaintext)) return false;
+    if (plaintext.empty()) return true;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(plaintext.data());
+
+    if (!tracker.h2 && !tracker.h1)
+    {
+        // 首段明文决定应用层协议：ALPN 为 h2 或出现连接前言时按 HTTP/2，否则须为 HTTP/1 请求
+        auto on_done = [this](Http2Stream& stream) {
+            std::lock_guard<std::mutex> lock(m_http_mutex);
+            m_pending_http.push_back(std::move(stream));
+        };
+        bool h2 = tracker.tls->alpn() == "h2" ||
+                  (dir == Http2Connection::CLIENT_TO_SERVER && Http2Connection::is_client_preface(p, plaintext.size()));
+        if (h2)
+        {
+            tracker.h2 = std::make_unique<Http2Connection>(tracker.base, on_done);
+        }
+        else if (dir == Http2Connection::CLIENT_TO_SERVER && Http1Connection::is_request(p, plaintext.size()))
+        {
+            tracker.h1 = std::make_unique<Http1Connection>(tracker.base, on_done, true);
+        }
+        else
+        {
+            spdlog::debug("TLS connection {} ({}) does not carry HTTP, dropping",
+                          tracker.base.flow_id, tracker.tls->server_name());
+            return false;
+        }
+        spdlog::info("TLS connection decrypted: {} sni={} alpn={} version={:#06x} suite={:#06x}",
+                     tracker.base.flow_id, tracker.tls->server_name(), tracker.tls->alpn(),
+                     tracker.tls->version(), tracker.tls->cipher_suite());
+    }
+
+    if (tracker.h2)
+        return tracker.h2->feed(static_cast<Http2Connection::Direction>(dir), p, plaintext.size(), ts);
+    return tracker.h1->feed(static_cast<Http1Connection::Direction>(dir), p, plaintext.size(), ts);
+}
+
+void PacketParser::close_http(HttpTracker& tracker, const timeval& ts)
+{
+    if (tracker.h2) tracker.h2->close(ts);
+    if (tracker.h1) tracker.h1->close(ts);
+}
+
+void PacketParser::sweep_http(const timeval& ts)
+{
+    const std::time_t SWEEP_INTERVAL = 30;
+    const std::time_t IDLE_TIMEOUT = 120;
+    if (ts.tv_sec - m_last_http_sweep < SWEEP_INTERVAL) return;
+    m_last_http_sweep = ts.tv_sec;
+
+    for (auto it = m_http_conns.begin(); it != m_http_conns.end();)
+    {
+        if (ts.tv_sec - it->second.last_seen >= IDLE_TIMEOUT)
+        {
+            close_http(it->second, ts);
+            it = m_http_conns.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void PacketParser::flush_pending_http()
+{
+    std::vector<Http2Stream> streams;
+    {
+        std::lock_guard<std::mutex> lock(m_http_mutex);
+        streams.swap(m_pending_http);
+    }
+
+    std::vector<HttpFlowInfo> flows;
+    std::vector<HttpPacket> packets;
+
+    for (auto& stream : streams)
+    {
+        bool has_response = stream.response_start.tv_sec != 0 || stream.response_start.tv_usec != 0;
+        stream.flow.start_time_us = timeval_to_us(stream.request_start);
+        stream.request.timestamp_us = stream.flow.start_time_us;
+        stream.response.timestamp_us = timeval_to_us(has_response ? stream.response_start : stream.request_end);
+
+        auto ms = [](const timeval& a, const timeval& b) {
+            return (b.tv_sec - a.tv_sec) * 1000.0 + (b.tv_usec - a.tv_usec) / 1000.0;
+        };
+        spdlog::debug("HTTP stream {} {} {} status={} req={}B resp={}B ttfb={:.1f}ms total={:.1f}ms{}",
+                      stream.flow.flow_id, stream.flow.method, stream.flow.url, stream.flow.status_code,
+                      stream.request_header_bytes + stream.request_body_bytes,
+                      stream.response_header_bytes + stream.response_body_bytes,
+                      has_response ? ms(stream.request_start, stream.response_start) : 0.0,
+                      stream.response_done ? ms(stream.request_start, stream.response_end) : 0.0,
+                      stream.reset ? " (reset)" : "");
+
+        flows.push_back(std::move(stream.flow));
+        packets.push_back(std::move(stream.request));
+        if (has_response) packets.push_back(std::move(stream.response));
+    }
+
+    // 一个事务写入本轮所有流，失败时转存暂存区待回放
+    if (!flows.empty() && m_mysql.store_http_exchanges(flows, packets) < 0)
+        spdlog::error("Failed to store {} HTTP streams", flows.size());
+}
+
+bool PacketParser::parse_quic(const uint8_t* data, size_t len, const timeval& ts,
+                              const std::string& src_ip, int src_port,
+                              const std::string& des_ip, int des_port,
+                              uint32_t sample_rate)
+{
+    int direction = 0;
+    QuicConnection* conn = m_quic.process(src_ip, src_port, des_ip, des_port, data, len, ts, direction);
+    if (!conn) return false;
+
+    const std::string& client_ip = conn->client_ip;
+
+    // 以 original DCID 作为会话 ID，端口迁移后仍累计到同一行
+    std::string sessionId = "QUIC-" + conn->id;
+    std::time_t now = ts.tv_sec;
+    std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
+    bool created = false;
+    SessionFlow& flow = m_sessions.touch(sessionId, "QUIC", 0, direction, now, created);
+    SessionInfo& session = flow.info;
+    if (created)
+    {
+        session.app_uid = app_uid;
+        session.device = m_device;
+        session.timestamp_us = timeval_to_us(ts);
+        session.dst_ip = conn->server_ip;
+        session.dst_port = conn->server_port;
+        session.initiator_known = !conn->original_dcid.empty();    // 由客户端 Initial 确定
+    }
+    session.size++;
+    if (sample_rate > session.sample_rate) session.sample_rate = sample_rate;
+    if (direction == 0)
+    {
+        session.packets_up++;
+        session.bytes_up += len;
+    }
+    else
+    {
+        session.packets_down++;
+        session.bytes_down += len;
+    }
+    session.duration_us = (conn->last_seen.tv_sec - conn->first_seen.tv_sec) * 1000000LL +
+                          (conn->last_seen.tv_usec - conn->first_seen.tv_usec);
+    if (m_features) flow.features.update(direction, len, timeval_to_us(ts));
+    session.src_ip = client_ip;
+    session.src_port = conn->client_port;
+    if (session.server_name.empty()) session.server_name = conn->server_name;
+    if (timeval_to_us(ts) > session.last_seen_us) session.last_seen_us = timeval_to_us(ts);
+    return true;
+}
+
+void PacketParser::track_udp(const uint8_t* payload, size_t len, const timeval& ts,
+                             const std::string& src_ip, int src_port,
+                             const std::string& des_ip, int des_port,
+                             uint32_t sample_rate)
+{
+    int side = 0;
+    std::string sessionId = generateFlowId(src_ip, src_port, des_ip, des_port, "UDP", side);
+    std::time_t now = ts.tv_sec;
+    int64_t ts_us = timeval_to_us(ts);
+
+    std::lock_guard<std::mutex> sessionsLock(m_sessionsMutex);
+    bool created = false;
+    SessionFlow& flow = m_sessions.touch(sessionId, "UDP", 0, side, now, created);
+    SessionInfo& session = flow.info;
+    if (created)
+    {
+        // UDP 无握手：首包发送方视为发起方，但首包来自知名端口而对端不是时（抓包开始前已建立）反转
+        bool initiator = !(src_port < 1024 && des_port >= 1024);
+        flow.client_side = static_cast<uint8_t>(initiator ? side : 1 - side);
+        flow.tcp.first_us = ts_us;      // UDP 会话只用到首包时间
+        session.app_uid = app_uid;
+        session.device = m_device;
+        session.timestamp_us = timeval_to_us(ts);
+        session.src_ip = initiator ? src_ip : des_ip;
+        session.src_port = initiator ? src_port : des_port;
+        session.dst_ip = initiator ? des_ip : src_ip;
+        session.dst_port = initiator ? des_port : src_port;
+    }
+    // 首个非空负载的前若干字节，便于区分 STUN/RTP/私有协议
+    if (session.payload_fingerprint.empty() && len > 0)
+    {
+        static const char HEX[] = "0123456789abcdef";
+        size_t n = std::min(len, UDP_FINGERPRINT_BYTES);
+        session.payload_fingerprint.reserve(n * 2);
+        for (size_t i = 0; i < n; ++i)
+        {
+            session.payload_fingerprint.push_back(HEX[payload[i] >> 4]);
+            session.payload_fingerprint.push_back(HEX[payload[i] & 0x0F]);
+        }
+    }
+    int direction = (side == flow.client_side) ? 0 : 1;
+    session.size++;
+    if (direction == 0)
+    {
+        session.packets_up++;
+        session.bytes_up += len;
+    }
+    else
+    {
+        session.packets_down++;
+        session.bytes_down += len;
+    }
+    if (ts_us > flow.tcp.first_us) session.duration_us = ts_us - flow.tcp.first_us;
+    if (m_features) flow.features.update(direction, len, ts_us);
+    if (sample_rate > session.sample_rate) session.sample_rate = sample_rate;
+    if (ts_us > session.last_seen_us) session.last_seen_us = ts_us;
+}
+
+json PacketParser::parse_icmp(const uint8_t* data, size_t len, const timeval& ts,
+                              const std::string& src_ip, const std::string& des_ip,
+                              const uint8_t* ip_header_ptr, size_t ip_header_len)
+{
+    if (len < sizeof(ICMP_HEADER)) return {};
+    const ICMP_HEADER* icmp = reinterpret_cast<const ICMP_HEADER*>(data);
+
+    json j;
+    j["app_uid"] = app_uid;
+    j["protocol"] = "ICMP";
+    j["timestamp"] = timeval_to_us(ts);
+    j["src_ip"] = src_ip;
+    j["des_ip"] = des_ip;
+    j["type"] = icmp->type;
+    j["code"] = icmp->code;
+    j["checksum"] = ntohs(icmp->checksum);
+
+    // header 字段：IP 头 + ICMP 头
+    std::stringstream header_ss;
+    for (size_t i = 0; i < ip_header_len; ++i)
+        header_ss << std::hex << std::setw(2) << std::setfill('0') << (int)(ip_header_ptr[i]);
+    for (size_t i = 0; i < sizeof(ICMP_HEADER); ++i)
+        header_ss << std::hex << std::setw(2) << std::setfill('0') << (int)(data[i]);
+    j["header"] = header_ss.str();
+
+    std::stringstream ss;
+    for (size_t i = sizeof(ICMP_HEADER); i < len; ++i)
+        ss << std::hex << std::setw(2) << std::setfill('0') << (int)data[i];
+    j["data"] = ss.str();
+    return j;
+}
+
 json PacketParser::parse_udp(const uint8_t* data, size_t len, const timeval& ts,
                               const std::string& src_ip, const std::string& des_ip,
                             const uint8_t* ip_header_ptr, size_t ip_header_len)
@@ -419,7 +949,7 @@ json PacketParser::parse_udp(const uint8_t* data, size_t len, const timeval& ts,
     j["app_uid"] = app_uid;
     j["protocol"] = "UDP";
 
-    j["timestamp"] = format_timeval(ts);
+    j["timestamp"] = timeval_to_us(ts);
     j["src_ip"] = src_ip;
     j["des_ip"] = des_ip;
     j["src_port"] = ntohs(udp->src_port);
@@ -457,19 +987,10 @@ json PacketParser::parse_dns(const uint8_t* data, size_t len, const timeval& ts,
     j["app_uid"] = app_uid;
     j["protocol"] = "UDP";
     j["top_protocol"] = "DNS";
-    j["timestamp"] = format_timeval(ts);
+    j["timestamp"] = timeval_to_us(ts);
 
-    if(des_ip=="192.168.31.172")
-    {
-        j["src_ip"] = src_ip;
-        j["des_ip"] = m_src_ip;
-    }
-    else if(src_ip=="192.168.31.172")
-    {
-        
-        j["src_ip"] = m_src_ip;
-        j["des_ip"] = des_ip;
-    }
+    j["src_ip"] = src_ip;
+    j["des_ip"] = des_ip;
 
     const UDP_HEADER* udp = reinterpret_cast<const UDP_HEADER*>(data - sizeof(UDP_HEADER));
     uint16_t src_port = ntohs(udp->src_port);
@@ -525,49 +1046,34 @@ json PacketParser::parse_dns(const uint8_t* data, size_t len, const timeval& ts,
     return j;
 }
 
-std::string PacketParser::format_timeval(const timeval& tv) 
-{
-    char buffer[64];
-    std::time_t sec = tv.tv_sec;
-    std::tm* t = std::localtime(&sec);
-    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", t);
-    std::ostringstream oss;
-    oss << buffer << "." << std::setw(6) << std::setfill('0') << tv.tv_usec;
-    return oss.str();
-}
-
 void PacketParser::start_storage() 
 {
     m_storage_thread = std::thread([this]() {
-        while(m_running) 
+        // 报文记录按表攒批，满批或最早一行到期时组提交
+        BatchWriterConfig config;
+        if (m_bulk_load)
         {
-            json packet;
-            {
-                std::unique_lock<std::mutex> lock(m_storage_mutex);
-                m_storage_cv.wait(lock, [&]{ 
-                    return !m_storage_queue.empty() || !m_running; });
-                if (!m_running) break;
-                
-                packet = m_storage_queue.front();
-                m_storage_queue.pop();
-            }
-            
+            // 批量导入时放大批上限，单表积压够多再走 LOAD DATA
+            config.max_rows = 20000;
+            config.bulk_min_rows = 2000;
+        }
+        BatchWriter writer(m_mysql, config);
+        const int dns_table = writer.add_table(MySQLDAO::dns_packets_table());
+        const int icmp_table = writer.add_table(MySQLDAO::icmp_packets_table());
+
+        auto store = [&](const json& packet, int64_t now) {
             try {
                 if (packet["protocol"] == "TCP") 
                 {
-                    // //spdlog::info("TCP Storage");
-                    // if(m_mysql.store_tcp(packet)!=1)
-                    // {
-                    //     spdlog::error("TCP Storage failed");
-                    // }
+                    // TCP 报文不逐条入库，统计见会话表
                 }
                 else if(packet["protocol"] == "UDP")
                 {
-                    //spdlog::info("DNS Storage");
-                    if(m_mysql.store_dns(packet)!=1)
-                    {
-                        spdlog::error("UDP Storage failed");
-                    }
+                    writer.add(dns_table, MySQLDAO::dns_packet_row(packet), now);
+                }
+                else if(packet["protocol"] == "ICMP")
+                {
+                    writer.add(icmp_table, MySQLDAO::icmp_packet_row(packet), now);
                 }
                 
                 // 其他协议处理...
@@ -575,7 +1081,47 @@ void PacketParser::start_storage()
             {
                 spdlog::error("Storage failed: {}", e.what());
             }
+        };
+
+        std::queue<json> packets;
+        while(m_running) 
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_storage_mutex);
+                // 有积压行时最多等到其到期
+                int64_t deadline = writer.next_deadline_us();
+                auto ready = [&]{ return !m_storage_queue.empty() || !m_running; };
+                if (deadline == 0)
+                    m_storage_cv.wait(lock, ready);
+                else
+                    m_storage_cv.wait_for(lock, std::chrono::microseconds(std::max<int64_t>(deadline - now_us(), 0)), ready);
+                // 一次取走整个队列，减少与解析线程的锁竞争
+                packets.swap(m_storage_queue);
+            }
+
+            int64_t now = now_us();
+            while (!packets.empty())
+            {
+                store(packets.front(), now);
+                packets.pop();
+            }
+            writer.poll(now_us());
+        }
+
+        // 停止时写完队列中剩余的记录
+        {
+            std::lock_guard<std::mutex> lock(m_storage_mutex);
+            packets.swap(m_storage_queue);
+        }
+        int64_t now = now_us();
+        while (!packets.empty())
+        {
+            store(packets.front(), now);
+            packets.pop();
         }
+        writer.flush();
+        if (writer.dropped_rows() > 0)
+            spdlog::warn("Storage thread stopped, {} packet records lost to failed commits", writer.dropped_rows());
     });
 }
 
@@ -0,0 +1,97 @@
+#include "PcapStreamReader.h"
+#include <cstring>
+
+namespace {
+
+const size_t FILE_HEADER_LEN = 24;
+const size_t RECORD_HEADER_LEN = 16;
+
+const uint32_t MAGIC_MICRO = 0xA1B2C3D4;
+const uint32_t MAGIC_NANO = 0xA1B23C4D;
+
+uint32_t swap32(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+}
+
+} // namespace
+
+uint32_t PcapStreamReader::read_u32(const uint8_t* p) const
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return m_swapped ? swap32(v) : v;
+}
+
+bool PcapStreamReader::parse_header(const uint8_t* p)
+{
+    uint32_t magic;
+    std::memcpy(&magic, p, 4);
+    if (magic == MAGIC_MICRO || magic == MAGIC_NANO)
+        m_swapped = false;
+    else if (swap32(magic) == MAGIC_MICRO || swap32(magic) == MAGIC_NANO)
+        m_swapped = true;
+    else
+    {
+        m_error = "unrecognized pcap magic (pcapng is not supported)";
+        return false;
+    }
+    m_nanosecond = (m_swapped ? swap32(magic) : magic) == MAGIC_NANO;
+    // magic(4) version_major(2) version_minor(2) thiszone(4) sigfigs(4) snaplen(4) network(4)
+    m_link_type = static_cast<int>(read_u32(p + 20) & 0x0FFFFFFF);  // 高位为 FCS 标志
+    m_have_header = true;
+    return true;
+}
+
+bool PcapStreamReader::feed(const uint8_t* data, size_t len, const PacketCallback& on_packet)
+{
+    if (!m_error.empty()) return false;
+
+    // 缓冲区为空时直接在输入上解析，只把末尾不完整的部分拷入缓冲区
+    const uint8_t* p = data;
+    size_t avail = len;
+    bool buffered = !m_buffer.empty();
+    if (buffered)
+    {
+        m_buffer.append(reinterpret_cast<const char*>(data), len);
+        p = reinterpret_cast<const uint8_t*>(m_buffer.data());
+        avail = m_buffer.size();
+    }
+
+    size_t offset = 0;
+    if (!m_have_header)
+    {
+        if (avail < FILE_HEADER_LEN)
+        {
+            if (!buffered) m_buffer.assign(reinterpret_cast<const char*>(data), len);
+            return true;
+        }
+        if (!parse_header(p)) return false;
+        offset = FILE_HEADER_LEN;
+    }
+
+    while (avail - offset >= RECORD_HEADER_LEN)
+    {
+        const uint8_t* rec = p + offset;
+        uint32_t caplen = read_u32(rec + 8);
+        if (caplen > MAX_SNAPLEN)
+        {
+            m_error = "pcap record length " + std::to_string(caplen) + " exceeds limit";
+            return false;
+        }
+        if (avail - offset < RECORD_HEADER_LEN + caplen) break;
+
+        timeval ts;
+        ts.tv_sec = static_cast<time_t>(read_u32(rec));
+        uint32_t frac = read_u32(rec + 4);
+        ts.tv_usec = static_cast<suseconds_t>(m_nanosecond ? frac / 1000 : frac);
+        if (caplen > 0) on_packet(ts, rec + RECORD_HEADER_LEN, caplen);
+        offset += RECORD_HEADER_LEN + caplen;
+    }
+
+    if (buffered)
+        m_buffer.erase(0, offset);
+    else
+        m_buffer.assign(reinterpret_cast<const char*>(p + offset), avail - offset);
+    return true;
+}
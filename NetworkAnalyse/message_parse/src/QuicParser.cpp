@@ -0,0 +1,484 @@
+#include "QuicParser.h"
+#include "CryptoUtil.h"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+using crypto_util::Bytes;
+
+namespace {
+
+const uint32_t QUIC_V1 = 0x00000001;
+const uint32_t QUIC_V2 = 0x6b3343cf;
+const uint32_t QUIC_DRAFT29 = 0xff00001d;
+
+const size_t MAX_CID_LEN = 20;
+const size_t MAX_CRYPTO_BUFFER = 64 * 1024;     // ClientHello 重组上限
+const std::time_t IDLE_TIMEOUT = 300;           // 连接空闲超时（秒）
+const std::time_t EXPIRE_INTERVAL = 30;
+
+// 各版本 Initial 盐值与标签（RFC 9001 5.2 / RFC 9369 3.3）
+struct InitialParams
+{
+    const char* salt_hex;
+    const char* key_label;
+    const char* iv_label;
+    const char* hp_label;
+    uint8_t     initial_type;       // 长包头类型位中 Initial 的取值
+    uint8_t     retry_type;         // Retry 的取值（无长度字段）
+};
+
+const InitialParams* initial_params(uint32_t version)
+{
+    static const InitialParams v1 = {"38762cf7f55934b34d179ae6a4c80cadccbb7f0a",
+                                     "quic key", "quic iv", "quic hp", 0, 3};
+    static const InitialParams v2 = {"0dede3def700a6db819381be6e269dcbf9bd2ed9",
+                                     "quicv2 key", "quicv2 iv", "quicv2 hp", 1, 0};
+    static const InitialParams d29 = {"afbfec289993d24c9e9786f19c6111e04390a899",
+                                      "quic key", "quic iv", "quic hp", 0, 3};
+    switch (version)
+    {
+        case QUIC_V1:       return &v1;
+        case QUIC_V2:       return &v2;
+        case QUIC_DRAFT29:  return &d29;
+        default:            return nullptr;
+    }
+}
+
+bool read_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+{
+    if (p >= end) return false;
+    size_t n = size_t(1) << (*p >> 6);
+    if (static_cast<size_t>(end - p) < n) return false;
+    value = *p & 0x3F;
+    for (size_t i = 1; i < n; ++i) value = (value << 8) | p[i];
+    p += n;
+    return true;
+}
+
+uint32_t read_u32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+std::string make_tuple_key(const std::string& a_ip, int a_port, const std::string& b_ip, int b_port)
+{
+    std::string a = a_ip + ":" + std::to_string(a_port);
+    std::string b = b_ip + ":" + std::to_string(b_port);
+    return a < b ? a + "-" + b : b + "-" + a;
+}
+
+} // namespace
+
+bool QuicTracker::is_long_header(const uint8_t* data, size_t len)
+{
+    // 长包头 + 固定位，且版本号已知（版本协商包版本为 0）
+    if (len < 7 || (data[0] & 0xC0) != 0xC0) return false;
+    uint32_t version = read_u32(data + 1);
+    return version == 0 || initial_params(version) != nullptr;
+}
+
+bool QuicTracker::recognizes(const std::string& src_ip, int src_port,
+                             const std::string& dst_ip, int dst_port,
+                             const uint8_t* payload, size_t len) const
+{
+    if (len == 0) return false;
+    if (is_long_header(payload, len)) return true;
+    if (m_connections.empty()) return false;
+    if (find_short_header(payload, len)) return true;
+    return find_by_tuple(make_tuple_key(src_ip, src_port, dst_ip, dst_port)) != nullptr;
+}
+
+QuicConnection* QuicTracker::process(const std::string& src_ip, int src_port,
+                                     const std::string& dst_ip, int dst_port,
+                                     const uint8_t* payload, size_t len, const timeval& ts, int& direction)
+{
+    expire(ts);
+    if (len == 0) return nullptr;
+
+    std::string tuple = make_tuple_key(src_ip, src_port, dst_ip, dst_port);
+    ConnPtr conn;
+
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + len;
+    if (p[0] & 0x80)
+    {
+        // 长包头，可能有多个包合并在同一个 UDP 报文中
+        while (p < end && (p[0] & 0x80))
+        {
+            if (end - p < 7) break;
+            const uint8_t* pkt = p;
+            uint32_t version = read_u32(p + 1);
+            p += 5;
+            size_t dcid_len = *p++;
+            if (dcid_len > MAX_CID_LEN || static_cast<size_t>(end - p) < dcid_len + 1) break;
+            std::string dcid(reinterpret_cast<const char*>(p), dcid_len);
+            p += dcid_len;
+            size_t scid_len = *p++;
+            if (scid_len > MAX_CID_LEN || static_cast<size_t>(end - p) < scid_len) break;
+            std::string scid(reinterpret_cast<const char*>(p), scid_len);
+            p += scid_len;
+
+            if (!conn) conn = find_by_cid(dcid);
+            if (!conn) conn = find_by_tuple(tuple);
+
+            const InitialParams* params = initial_params(version);
+            if (version == 0 || !params)
+            {
+                // 版本协商包或未知版本：只做归属
+                break;
+            }
+
+            uint8_t type = (pkt[0] >> 4) & 0x03;
+            if (type == params->retry_type) break;
+
+            bool is_initial = type == params->initial_type;
+            if (is_initial)
+            {
+                uint64_t token_len = 0;
+                if (!read_varint(p, end, token_len) || token_len > static_cast<uint64_t>(end - p)) break;
+                p += token_len;
+            }
+            uint64_t length = 0;
+            if (!read_varint(p, end, length) || length > static_cast<uint64_t>(end - p)) break;
+            size_t pn_offset = static_cast<size_t>(p - pkt);
+            size_t packet_len = pn_offset + static_cast<size_t>(length);
+
+            // 未知连接上的客户端 Initial：DCID 即 original DCID，能解密即可确认客户端身份
+            if (!conn && is_initial)
+            {
+                ConnPtr candidate = create(src_ip, src_port, dst_ip, dst_port, dcid, version, ts);
+                if (decrypt_client_initial(*candidate, pkt, pn_offset, packet_len))
+                {
+                    conn = candidate;
+                    register_tuple(conn, tuple);
+                }
+                else
+                {
+                    remove(candidate);
+                }
+            }
+            else if (conn && is_initial && !conn->hello_done && conn->server_port == dst_port
+                     && conn->server_ip == dst_ip)
+            {
+                // ClientHello 可能跨多个 Initial 包
+                decrypt_client_initial(*conn, pkt, pn_offset, packet_len);
+            }
+
+            if (conn)
+            {
+                register_cid(conn, dcid);
+                register_cid(conn, scid);
+            }
+            p = pkt + packet_len;
+        }
+    }
+    else if (p[0] & 0x40)
+    {
+        // 短包头：DCID 长度不在包内，用已知长度逐一匹配；零长度 CID 退化为四元组匹配
+        conn = find_short_header(payload, len);
+        if (!conn) conn = find_by_tuple(tuple);
+    }
+
+    // 未能解析 Initial 的 443 端口流量（如抓包开始前已建立的连接）按四元组记账
+    if (!conn && (src_port == 443 || dst_port == 443) && (payload[0] & 0x40))
+    {
+        bool to_server = dst_port == 443;
+        conn = create(to_server ? src_ip : dst_ip, to_server ? src_port : dst_port,
+                      to_server ? dst_ip : src_ip, to_server ? dst_port : src_port,
+                      tuple, 0, ts);
+        register_tuple(conn, tuple);
+    }
+    if (!conn) return nullptr;
+
+    direction = (dst_ip == conn->server_ip && dst_port == conn->server_port) ? 0 : 1;
+
+    // 连接 ID 命中但四元组变化：客户端地址迁移
+    if (m_by_tuple.find(tuple) == m_by_tuple.end())
+    {
+        if (direction == 0 && (src_ip != conn->client_ip || src_port != conn->client_port))
+        {
+            spdlog::info("QUIC connection {} migrated: {}:{} -> {}:{}", conn->id,
+                         conn->client_ip, conn->client_port, src_ip, src_port);
+            conn->client_ip = src_ip;
+            conn->client_port = src_port;
+            ++conn->migrations;
+        }
+        register_tuple(conn, tuple);
+    }
+
+    conn->packets[direction]++;
+    conn->bytes[direction] += len;
+    conn->last_seen = ts;
+    return conn.get();
+}
+
+bool QuicTracker::client_initial_keys(uint32_t version, const std::string& dcid, QuicInitialKeys& keys)
+{
+    const InitialParams* params = initial_params(version);
+    if (!params) return false;
+
+    // RFC 9001 5.2：initial_secret = HKDF-Extract(salt, DCID)
+    Bytes salt = crypto_util::from_hex(params->salt_hex);
+    Bytes ikm(dcid.begin(), dcid.end());
+    Bytes initial_secret = crypto_util::hkdf_extract(crypto_util::Hash::SHA256, salt, ikm);
+    Bytes client_secret = crypto_util::hkdf_expand_label(crypto_util::Hash::SHA256, initial_secret,
+                                                         "client in", {}, 32);
+    keys.key = crypto_util::hkdf_expand_label(crypto_util::Hash::SHA256, client_secret, params->key_label, {}, 16);
+    keys.iv = crypto_util::hkdf_expand_label(crypto_util::Hash::SHA256, client_secret, params->iv_label, {}, 12);
+    keys.hp = crypto_util::hkdf_expand_label(crypto_util::Hash::SHA256, client_secret, params->hp_label, {}, 16);
+    return keys.key.size() == 16 && keys.iv.size() == 12 && keys.hp.size() == 16;
+}
+
+bool QuicTracker::decrypt_client_initial(QuicConnection& conn, const uint8_t* packet, size_t pn_offset,
+                                         size_t packet_len)
+{
+    QuicInitialKeys keys;
+    if (packet_len < pn_offset + 4 + 16 || !client_initial_keys(conn.version, conn.original_dcid, keys))
+        return false;
+
+    // 去除头部保护（RFC 9001 5.4）：采样位置固定为包号起始 + 4
+    uint8_t mask[16];
+    if (!crypto_util::aes_ecb_encrypt_block(keys.hp, packet + pn_offset + 4, mask)) return false;
+
+    Bytes header(packet, packet + pn_offset + 4);
+    header[0] ^= mask[0] & 0x0F;
+    size_t pn_len = (header[0] & 0x03) + 1;
+    uint64_t pn = 0;
+    for (size_t i = 0; i < pn_len; ++i)
+    {
+        header[pn_offset + i] ^= mask[1 + i];
+        pn = (pn << 8) | header[pn_offset + i];
+    }
+    header.resize(pn_offset + pn_len);
+
+    // 客户端首批 Initial 的包号很小，截断包号即完整包号
+    uint8_t nonce[12];
+    std::memcpy(nonce, keys.iv.data(), 12);
+    for (size_t i = 0; i < 8; ++i) nonce[11 - i] ^= static_cast<uint8_t>(pn >> (8 * i));
+
+    Bytes plain;
+    const uint8_t* ct = packet + pn_offset + pn_len;
+    size_t ct_len = packet_len - pn_offset - pn_len;
+    if (!crypto_util::aead_decrypt(crypto_util::Aead::AES_128_GCM, keys.key, nonce, sizeof(nonce),
+                                   header.data(), header.size(), ct, ct_len, plain))
+        return false;
+
+    handle_crypto_frames(conn, plain.data(), plain.size());
+    return true;
+}
+
+void QuicTracker::handle_crypto_frames(QuicConnection& conn, const uint8_t* data, size_t len)
+{
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    while (p < end)
+    {
+        uint64_t type = 0;
+        if (!read_varint(p, end, type)) return;
+        switch (type)
+        {
+            case 0x00: // PADDING
+            case 0x01: // PING
+                break;
+            case 0x02: // ACK
+            case 0x03: // ACK_ECN
+            {
+                uint64_t largest, delay, range_count, first_range, v;
+                if (!read_varint(p, end, largest) || !read_varint(p, end, delay)
+                    || !read_varint(p, end, range_count) || !read_varint(p, end, first_range))
+                    return;
+                for (uint64_t i = 0; i < range_count * 2; ++i)
+                    if (!read_varint(p, end, v)) return;
+                if (type == 0x03)
+                    for (int i = 0; i < 3; ++i)
+                        if (!read_varint(p, end, v)) return;
+                break;
+            }
+            case 0x06: // CRYPTO
+            {
+                uint64_t offset = 0, length = 0;
+                if (!read_varint(p, end, offset) || !read_varint(p, end, length)) return;
+                if (length > static_cast<uint64_t>(end - p)) return;
+                if (conn.crypto_bytes + length <= MAX_CRYPTO_BUFFER && !conn.hello_done)
+                {
+                    conn.crypto_fragments[offset].assign(reinterpret_cast<const char*>(p), length);
+                    conn.crypto_bytes += length;
+                }
+                p += length;
+                break;
+            }
+            case 0x1c: // CONNECTION_CLOSE
+            default:
+                // Initial 中不应出现其他帧，停止解析
+                p = end;
+                break;
+        }
+    }
+    if (!conn.hello_done) parse_client_hello(conn);
+}
+
+void QuicTracker::parse_client_hello(QuicConnection& conn)
+{
+    // 拼接从偏移 0 开始的连续 CRYPTO 数据
+    std::string stream;
+    for (const auto& frag : conn.crypto_fragments)
+    {
+        if (frag.first > stream.size()) break;
+        size_t overlap = stream.size() - static_cast<size_t>(frag.first);
+        if (overlap < frag.second.size()) stream.append(frag.second, overlap, std::string::npos);
+    }
+    if (stream.size() < 4) return;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(stream.data());
+    if (p[0] != 0x01)
+    {
+        conn.hello_done = true; // 不是 ClientHello
+        return;
+    }
+    size_t msg_len = (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | p[3];
+    if (stream.size() < 4 + msg_len)
+    {
+        if (conn.crypto_bytes >= MAX_CRYPTO_BUFFER) conn.hello_done = true;
+        return; // 等待后续 Initial
+    }
+
+    conn.hello_done = true;
+    conn.crypto_fragments.clear();
+
+    const uint8_t* end = p + 4 + msg_len;
+    p += 4 + 2 + 32;                                    // 版本 + 随机数
+    if (p >= end) return;
+    p += 1 + *p;                                        // session id
+    if (end - p < 2) return;
+    p += 2 + ((p[0] << 8) | p[1]);                      // cipher suites
+    if (p >= end) return;
+    p += 1 + *p;                                        // compression methods
+    if (end - p < 2) return;
+    size_t ext_total = (p[0] << 8) | p[1];
+    p += 2;
+    if (static_cast<size_t>(end - p) < ext_total) return;
+    const uint8_t* ext_end = p + ext_total;
+
+    while (ext_end - p >= 4)
+    {
+        uint16_t ext_type = uint16_t((p[0] << 8) | p[1]);
+        size_t ext_len = (p[2] << 8) | p[3];
+        p += 4;
+        if (static_cast<size_t>(ext_end - p) < ext_len) return;
+        const uint8_t* e = p;
+        if (ext_type == 0x0000 && ext_len >= 5)
+        {
+            // server_name：list_len(2) + name_type(1) + name_len(2) + name
+            size_t name_len = (e[3] << 8) | e[4];
+            if (e[2] == 0 && 5 + name_len <= ext_len)
+                conn.server_name.assign(reinterpret_cast<const char*>(e + 5), name_len);
+        }
+        else if (ext_type == 0x0010 && ext_len >= 3)
+        {
+            // ALPN：list_len(2) + proto_len(1) + proto，只取首选项
+            size_t proto_len = e[2];
+            if (3 + proto_len <= ext_len)
+                conn.alpn.assign(reinterpret_cast<const char*>(e + 3), proto_len);
+        }
+        p += ext_len;
+    }
+    spdlog::info("QUIC connection {} {}:{} -> {}:{} sni={} alpn={}", conn.id, conn.client_ip,
+                 conn.client_port, conn.server_ip, conn.server_port, conn.server_name, conn.alpn);
+}
+
+QuicTracker::ConnPtr QuicTracker::find_by_cid(const std::string& cid) const
+{
+    if (cid.empty()) return nullptr;
+    auto it = m_by_cid.find(cid);
+    return it == m_by_cid.end() ? nullptr : it->second;
+}
+
+QuicTracker::ConnPtr QuicTracker::find_short_header(const uint8_t* data, size_t len) const
+{
+    for (size_t cid_len : m_cid_lengths)
+    {
+        if (len < 1 + cid_len) continue;
+        auto it = m_by_cid.find(std::string(reinterpret_cast<const char*>(data + 1), cid_len));
+        if (it != m_by_cid.end()) return it->second;
+    }
+    return nullptr;
+}
+
+QuicTracker::ConnPtr QuicTracker::find_by_tuple(const std::string& tuple) const
+{
+    auto it = m_by_tuple.find(tuple);
+    return it == m_by_tuple.end() ? nullptr : it->second;
+}
+
+QuicTracker::ConnPtr QuicTracker::create(const std::string& client_ip, int client_port,
+                                         const std::string& server_ip, int server_port,
+                                         const std::string& dcid, uint32_t version, const timeval& ts)
+{
+    auto conn = std::make_shared<QuicConnection>();
+    conn->original_dcid = dcid;
+    conn->id = version ? crypto_util::to_hex(reinterpret_cast<const uint8_t*>(dcid.data()), dcid.size())
+                       : dcid;
+    conn->version = version;
+    conn->client_ip = client_ip;
+    conn->client_port = client_port;
+    conn->server_ip = server_ip;
+    conn->server_port = server_port;
+    conn->first_seen = ts;
+    conn->last_seen = ts;
+    // 无法解析 Initial 的连接没有 ClientHello 可等
+    conn->hello_done = version == 0;
+    m_connections[conn->id] = conn;
+    return conn;
+}
+
+void QuicTracker::register_cid(const ConnPtr& conn, const std::string& cid)
+{
+    if (cid.empty()) return;
+    auto res = m_by_cid.emplace(cid, conn);
+    if (!res.second) return;
+    conn->cids.push_back(cid);
+    if (std::find(m_cid_lengths.begin(), m_cid_lengths.end(), cid.size()) == m_cid_lengths.end())
+        m_cid_lengths.push_back(cid.size());
+}
+
+void QuicTracker::register_tuple(const ConnPtr& conn, const std::string& tuple)
+{
+    auto res = m_by_tuple.emplace(tuple, conn);
+    if (!res.second)
+    {
+        // 四元组被新连接复用
+        if (res.first->second == conn) return;
+        res.first->second = conn;
+    }
+    conn->tuples.push_back(tuple);
+}
+
+void QuicTracker::remove(const ConnPtr& conn)
+{
+    for (const auto& cid : conn->cids)
+    {
+        auto it = m_by_cid.find(cid);
+        if (it != m_by_cid.end() && it->second == conn) m_by_cid.erase(it);
+    }
+    for (const auto& tuple : conn->tuples)
+    {
+        auto it = m_by_tuple.find(tuple);
+        if (it != m_by_tuple.end() && it->second == conn) m_by_tuple.erase(it);
+    }
+    auto it = m_connections.find(conn->id);
+    if (it != m_connections.end() && it->second == conn) m_connections.erase(it);
+}
+
+void QuicTracker::expire(const timeval& ts)
+{
+    if (ts.tv_sec - m_last_expire < EXPIRE_INTERVAL) return;
+    m_last_expire = ts.tv_sec;
+
+    std::vector<ConnPtr> idle;
+    for (const auto& pair : m_connections)
+    {
+        if (ts.tv_sec - pair.second->last_seen.tv_sec >= IDLE_TIMEOUT) idle.push_back(pair.second);
+    }
+    for (const auto& conn : idle) remove(conn);
+}
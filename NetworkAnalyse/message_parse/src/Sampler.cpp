@@ -0,0 +1,125 @@
+#include "Sampler.h"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+const size_t SLOT_COUNT = 4096;     // 2 的幂
+const uint8_t TCP_CONTROL = 0x01 | 0x02 | 0x04;    // FIN | SYN | RST
+
+inline uint64_t mix(uint64_t v)
+{
+    v ^= v >> 33;
+    v *= 0xFF51AFD7ED558CCDULL;
+    v ^= v >> 33;
+    v *= 0xC4CEB9FE1A85EC53ULL;
+    v ^= v >> 33;
+    return v;
+}
+}
+
+Sampler::Sampler(const SamplerConfig& config)
+    : m_config(config)
+    , m_slots(SLOT_COUNT)
+{
+    // 采样率按 2 的幂调整，上限向下取整到 2 的幂
+    uint32_t max_rate = 1;
+    while (max_rate * 2 <= m_config.max_rate) max_rate *= 2;
+    m_config.max_rate = max_rate;
+}
+
+uint64_t Sampler::flow_hash(const PacketView& packet)
+{
+    uint32_t src = 0, dst = 0;
+    std::memcpy(&src, packet.ip_header + 12, 4);
+    std::memcpy(&dst, packet.ip_header + 16, 4);
+    uint64_t a = (static_cast<uint64_t>(src) << 16) | static_cast<uint16_t>(packet.src_port);
+    uint64_t b = (static_cast<uint64_t>(dst) << 16) | static_cast<uint16_t>(packet.dst_port);
+    // 两个端点排序后组合，使两个方向落到同一个哈希
+    uint64_t low = a < b ? a : b;
+    uint64_t high = a < b ? b : a;
+    return mix(mix(low) ^ (high * 0x9E3779B97F4A7C15ULL) ^ packet.l4);
+}
+
+bool Sampler::admit(const PacketView& packet, uint32_t& rate)
+{
+    rate = 1;
+    uint32_t current = m_rate.load(std::memory_order_relaxed);
+    if (current == 1) return true;
+
+    // 始终保留（两种模式相同，按 1 计）：非 TCP/UDP、DNS、TCP 控制报文（状态跟踪依赖）
+    if (packet.l4 != 6 && packet.l4 != 17) return true;
+    if (packet.src_port == 53 || packet.dst_port == 53) return true;
+    if (packet.l4 == 6 && packet.l4_len > 13 && (packet.l4_data[13] & TCP_CONTROL)) return true;
+
+    uint64_t hash = flow_hash(packet);
+    if (m_config.mode == SamplerConfig::Mode::FLOW)
+    {
+        // 整流取舍：保留的流每个报文代表 N 个流的报文
+        if (((hash >> 20) & (current - 1)) == 0)
+        {
+            rate = current;
+            return true;
+        }
+        ++m_skipped;
+        return false;
+    }
+
+    Slot& slot = m_slots[hash & (SLOT_COUNT - 1)];
+    if (slot.tag != hash)
+    {
+        slot.tag = hash;
+        slot.bytes = 0;
+        slot.packets = 0;
+    }
+    slot.bytes += packet.l4_len;
+    if (slot.bytes < m_config.elephant_bytes) return true;
+
+    if ((slot.packets++ & (current - 1)) == 0)
+    {
+        rate = current;
+        return true;
+    }
+    ++m_skipped;
+    return false;
+}
+
+void Sampler::observe(size_t queue_depth, int64_t parse_us, int64_t now_us)
+{
+    m_latency_us += (parse_us - m_latency_us) / 16;
+    if (now_us - m_last_adjust_us < m_config.adjust_interval_us) return;
+    m_last_adjust_us = now_us;
+
+    uint32_t current = m_rate.load(std::memory_order_relaxed);
+    int64_t queue_delay_us = static_cast<int64_t>(queue_depth) * m_latency_us;
+    bool overloaded = queue_depth > m_config.high_watermark || queue_delay_us > m_config.max_queue_delay_us;
+
+    if (overloaded)
+    {
+        m_calm_since_us = 0;
+        if (current < m_config.max_rate)
+        {
+            m_rate.store(current * 2, std::memory_order_relaxed);
+            spdlog::warn("Parser overloaded (queue={}, avg parse={}us), sampling rate 1/{}",
+                         queue_depth, m_latency_us, current * 2);
+        }
+        return;
+    }
+
+    if (current == 1 || queue_depth > m_config.low_watermark)
+    {
+        m_calm_since_us = 0;
+        return;
+    }
+    if (m_calm_since_us == 0)
+    {
+        m_calm_since_us = now_us;
+        return;
+    }
+    if (now_us - m_calm_since_us >= m_config.recover_after_us)
+    {
+        m_rate.store(current / 2, std::memory_order_relaxed);
+        m_calm_since_us = now_us;
+        spdlog::info("Parser load recovered (queue={}), sampling rate 1/{} (skipped {} packets so far)",
+                     queue_depth, current / 2, m_skipped);
+    }
+}
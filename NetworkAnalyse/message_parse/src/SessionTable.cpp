@@ -0,0 +1,330 @@
+#include "SessionTable.h"
+#include <algorithm>
+
+namespace {
+const uint8_t TCP_FIN = 0x01;
+const uint8_t TCP_SYN = 0x02;
+const uint8_t TCP_RST = 0x04;
+const uint8_t TCP_ACK = 0x10;
+}
+
+SessionTable::SessionTable(const SessionTableConfig& config)
+    : m_config(config)
+{
+    if (m_config.max_entries == 0) m_config.max_entries = 1;
+    m_entries.reserve(std::min<size_t>(m_config.max_entries, 4096));
+    m_index.reserve(std::min<size_t>(m_config.max_entries, 4096));
+}
+
+SessionFlow& SessionTable::touch(const std::string& session_id, const std::string& protocol,
+                                 uint8_t tcp_flags, int side, std::time_t now, bool& created)
+{
+    if (now > m_clock)
+    {
+        std::time_t wall = std::time(nullptr);
+        if (now > wall + m_config.max_clock_skew)
+        {
+            // 明显超前墙钟的报文时间（抓包端时钟错误或伪造）不推进时钟，否则会话会被提前批量超时
+            ++m_stats.clamped_time;
+            now = m_clock != 0 ? m_clock : wall;
+        }
+        else
+        {
+            m_clock = now;
+            m_clock_wall = wall;
+        }
+    }
+    if (!m_wheel.started()) m_wheel.start(now);
+
+    uint32_t index;
+    auto it = m_index.find(session_id);
+    if (it != m_index.end() && reused(m_entries[it->second], tcp_flags))
+    {
+        // 端口复用：旧连接已 RST 或双向 FIN，等待剩余报文期间收到新的 SYN，旧会话立即结束
+        bool rst = m_entries[it->second].state == State::RESET;
+        ++(rst ? m_stats.closed_rst : m_stats.closed_fin);
+        finish(it->second, rst ? "rst" : "fin");
+        it = m_index.end();
+    }
+    created = (it == m_index.end());
+    if (created)
+    {
+        index = allocate();
+        Entry& entry = m_entries[index];
+        entry.flow = SessionFlow{};
+        entry.flow.info.session_id = session_id;
+        entry.flow.info.protocol = protocol;
+        entry.tcp = (protocol == "TCP");
+        m_index.emplace(session_id, index);
+        ++m_stats.created;
+        if (m_index.size() > m_stats.peak_entries) m_stats.peak_entries = m_index.size();
+    }
+    else
+    {
+        index = it->second;
+        lru_unlink(index);
+    }
+    lru_push_front(index);
+
+    Entry& entry = m_entries[index];
+    if (now > entry.last_seen) entry.last_seen = now;   // 乱序到达的旧报文不回拨
+    bool shorter = entry.tcp && update_state(entry, tcp_flags, side & 1);
+    // 新建或超时缩短（FIN/RST）时重新登记；其余情况沿用已有定时器，到期时再按最后活跃时间顺延
+    if (created || shorter) schedule(index);
+
+    mark_dirty(index);
+    return entry.flow;
+}
+
+void SessionTable::mark_dirty(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    if (!entry.dirty)
+    {
+        entry.dirty = true;
+        m_dirty.push_back(index);
+    }
+}
+
+bool SessionTable::reused(const Entry& entry, uint8_t tcp_flags) const
+{
+    return entry.tcp && (tcp_flags & TCP_SYN) && !(tcp_flags & TCP_ACK) &&
+           (entry.state == State::RESET || entry.state == State::CLOSING);
+}
+
+bool SessionTable::update_state(Entry& entry, uint8_t tcp_flags, int side)
+{
+    State old = entry.state;
+    if (tcp_flags & TCP_RST)
+        entry.state = State::RESET;
+    else if (tcp_flags & TCP_FIN)
+    {
+        entry.fin[side] = true;
+        if (entry.state != State::RESET)
+            entry.state = (entry.fin[0] && entry.fin[1]) ? State::CLOSING : State::HALF_CLOSED;
+    }
+    else if (tcp_flags & TCP_SYN)
+    {
+        if (entry.state == State::ACTIVE) entry.state = State::SYN;
+    }
+    else if (tcp_flags & TCP_ACK)
+    {
+        // 中途捕获的连接（未见 SYN）直接视为已建立
+        if (entry.state == State::ACTIVE || entry.state == State::SYN) entry.state = State::ESTABLISHED;
+    }
+    return entry.state != old &&
+           (entry.state == State::HALF_CLOSED || entry.state == State::CLOSING || entry.state == State::RESET);
+}
+
+std::time_t SessionTable::timeout_of(const Entry& entry) const
+{
+    switch (entry.state)
+    {
+    case State::SYN:         return m_config.tcp_syn_timeout;
+    case State::ESTABLISHED: return m_config.tcp_idle_timeout;
+    case State::HALF_CLOSED: return m_config.tcp_half_closed_timeout;
+    case State::CLOSING:     return m_config.tcp_closing_timeout;
+    case State::RESET:       return 0;
+    default:                 return entry.tcp ? m_config.tcp_idle_timeout : m_config.idle_timeout;
+    }
+}
+
+void SessionTable::schedule(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    ++entry.timer_seq;
+    TimerWheel::TimerId id = (static_cast<uint64_t>(entry.timer_seq) << 32) | index;
+    m_wheel.schedule(id, static_cast<uint64_t>(entry.last_seen + timeout_of(entry)));
+}
+
+void SessionTable::tick(std::time_t wall_now)
+{
+    if (!m_wheel.started()) return;
+    expire(m_clock + std::max<std::time_t>(0, wall_now - m_clock_wall));
+}
+
+void SessionTable::expire(std::time_t now)
+{
+    if (!m_wheel.started()) return;
+
+    m_expired.clear();
+    m_wheel.advance(static_cast<uint64_t>(now), m_expired);
+    for (TimerWheel::TimerId id : m_expired)
+    {
+        uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFF);
+        uint32_t seq = static_cast<uint32_t>(id >> 32);
+        if (index >= m_entries.size()) continue;
+        Entry& entry = m_entries[index];
+        if (!entry.in_use || entry.timer_seq != seq) continue;     // 已释放或已重新登记
+
+        if (entry.last_seen + timeout_of(entry) > now)
+        {
+            schedule(index);
+            continue;
+        }
+
+        switch (entry.state)
+        {
+        case State::RESET:
+            ++m_stats.closed_rst;
+            finish(index, "rst");
+            break;
+        case State::HALF_CLOSED:
+        case State::CLOSING:
+            ++m_stats.closed_fin;
+            finish(index, "fin");
+            break;
+        default:
+            ++m_stats.expired_idle;
+            finish(index, "idle");
+            break;
+        }
+    }
+}
+
+uint32_t SessionTable::allocate()
+{
+    if (m_index.size() >= m_config.max_entries && m_lru_tail != NIL)
+    {
+        ++m_stats.evicted;
+        finish(m_lru_tail, "evicted");
+    }
+
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_entries.size());
+        m_entries.emplace_back();
+    }
+
+    // timer_seq 与 dirty 跨复用保留：前者使旧定时器失效，后者避免同一槽位重复进入待输出列表
+    Entry& entry = m_entries[index];
+    entry.flushed = Counters{};
+    entry.state = State::ACTIVE;
+    entry.fin[0] = entry.fin[1] = false;
+    entry.in_use = true;
+    entry.persisted = false;
+    entry.serial = ++m_serial;
+    entry.prev = entry.next = NIL;
+    return index;
+}
+
+SessionInfo SessionTable::take_delta(Entry& entry, bool final, bool* features_exported)
+{
+    const SessionInfo& info = entry.flow.info;
+    SessionInfo record = info;
+    record.size = info.size - entry.flushed.size;
+    record.packets_up = info.packets_up - entry.flushed.packets_up;
+    record.packets_down = info.packets_down - entry.flushed.packets_down;
+    record.bytes_up = info.bytes_up - entry.flushed.bytes_up;
+    record.bytes_down = info.bytes_down - entry.flushed.bytes_down;
+    record.retransmissions = info.retransmissions - entry.flushed.retransmissions;
+    record.out_of_order = info.out_of_order - entry.flushed.out_of_order;
+    record.zero_window = info.zero_window - entry.flushed.zero_window;
+    record.persisted = entry.persisted;
+    // 分类特征在前 N 个报文收齐时先输出一次（供在线分类），会话结束时再输出一次，
+    // 覆盖库中的值，使突发统计覆盖整条流而不是第 N 个报文时的快照
+    FlowFeatures& features = entry.flow.features;
+    if (features.count > 0 && (final || (!features.exported && features.full())))
+    {
+        record.features = features.to_json();
+        features.exported = true;
+        if (features_exported) *features_exported = true;
+    }
+
+    entry.flushed.size = info.size;
+    entry.flushed.packets_up = info.packets_up;
+    entry.flushed.packets_down = info.packets_down;
+    entry.flushed.bytes_up = info.bytes_up;
+    entry.flushed.bytes_down = info.bytes_down;
+    entry.flushed.retransmissions = info.retransmissions;
+    entry.flushed.out_of_order = info.out_of_order;
+    entry.flushed.zero_window = info.zero_window;
+    entry.flow.info.sample_rate = 1;        // 采样率按增量记录统计
+    return record;
+}
+
+void SessionTable::finish(uint32_t index, const char* reason)
+{
+    Entry& entry = m_entries[index];
+    SessionInfo record = take_delta(entry, true);
+    record.close_reason = reason;
+    record.end_time = entry.last_seen;
+    m_closed.push_back(std::move(record));
+
+    m_index.erase(entry.flow.info.session_id);
+    lru_unlink(index);
+    ++entry.timer_seq;
+    entry.in_use = false;
+    entry.flow = SessionFlow{};
+    m_free.push_back(index);
+}
+
+void SessionTable::collect(std::vector<SessionInfo>& out)
+{
+    // 先输出终结记录：同一 session_id 结束后又新建时，新会话的增量排在后面
+    for (auto& record : m_closed) out.push_back(std::move(record));
+    m_closed.clear();
+
+    for (uint32_t index : m_dirty)
+    {
+        Entry& entry = m_entries[index];
+        entry.dirty = false;
+        if (!entry.in_use) continue;
+        Unconfirmed pending{index, entry.serial, entry.flushed, false};
+        SessionInfo record = take_delta(entry, false, &pending.features_exported);
+        if (record.persisted && record.size == 0) continue;    // 无新增
+        m_unconfirmed.push_back(pending);
+        out.push_back(std::move(record));
+    }
+    m_dirty.clear();
+}
+
+void SessionTable::confirm(bool stored)
+{
+    for (const auto& pending : m_unconfirmed)
+    {
+        Entry& entry = m_entries[pending.index];
+        if (!entry.in_use || entry.serial != pending.serial) continue;     // 期间已结束（终结记录另行输出）
+        if (stored)
+        {
+            entry.persisted = true;
+            continue;
+        }
+        // 写库失败：退回本次增量，下次与新报文一起重新输出
+        entry.flushed = pending.before;
+        if (pending.features_exported) entry.flow.features.exported = false;
+        mark_dirty(pending.index);
+    }
+    m_unconfirmed.clear();
+}
+
+void SessionTable::close_all(const char* reason)
+{
+    while (m_lru_head != NIL) finish(m_lru_head, reason);
+}
+
+void SessionTable::lru_unlink(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    if (entry.prev != NIL) m_entries[entry.prev].next = entry.next;
+    else m_lru_head = entry.next;
+    if (entry.next != NIL) m_entries[entry.next].prev = entry.prev;
+    else m_lru_tail = entry.prev;
+    entry.prev = entry.next = NIL;
+}
+
+void SessionTable::lru_push_front(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    entry.prev = NIL;
+    entry.next = m_lru_head;
+    if (m_lru_head != NIL) m_entries[m_lru_head].prev = index;
+    m_lru_head = index;
+    if (m_lru_tail == NIL) m_lru_tail = index;
+}
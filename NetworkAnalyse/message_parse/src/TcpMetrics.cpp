@@ -0,0 +1,74 @@
+#include "TcpMetrics.h"
+#include <arpa/inet.h>
+
+namespace {
+const uint8_t TCP_FIN = 0x01;
+const uint8_t TCP_SYN = 0x02;
+const uint8_t TCP_RST = 0x04;
+const uint8_t TCP_ACK = 0x10;
+
+const int64_t DEFAULT_REORDER_WINDOW_US = 3000;    // RTT 未知时的乱序判定窗口
+}
+
+namespace tcp_metrics
+{
+
+void update(SessionInfo& info, TcpConnState& state, int direction,
+            const TCP_HEADER* tcp, size_t payload_len, const timeval& ts)
+{
+    int64_t now = timeval_to_us(ts);
+    uint8_t flags = tcp->flags;
+    TcpFlowState& fwd_state = state.dir[direction];
+    TcpFlowState& rev_state = state.dir[1 - direction];
+
+    if (state.first_us == 0) state.first_us = now;
+    if (now > state.first_us) info.duration_us = now - state.first_us;
+
+    if (direction == 0) info.bytes_up += payload_len;
+    else info.bytes_down += payload_len;
+
+    // 握手 RTT：SYN（本方向）-> SYN-ACK（反方向）-> ACK（本方向）
+    if ((flags & TCP_SYN) && !(flags & TCP_ACK))
+    {
+        fwd_state.syn_us = now;
+    }
+    else if ((flags & TCP_SYN) && (flags & TCP_ACK))
+    {
+        if (rev_state.syn_us) rev_state.synack_us = now;
+    }
+    else if ((flags & TCP_ACK) && info.handshake_rtt_us == 0 &&
+             fwd_state.syn_us && fwd_state.synack_us >= fwd_state.syn_us)
+    {
+        info.handshake_rtt_us = now - fwd_state.syn_us;
+    }
+
+    // 零窗口：接收方缓冲区已满，RST 段的窗口无意义
+    if (!(flags & TCP_RST) && tcp->window_size == 0) ++info.zero_window;
+
+    // 序号分析只针对占用序号空间的段（数据、SYN、FIN）
+    uint32_t seg_len = static_cast<uint32_t>(payload_len) + ((flags & TCP_SYN) ? 1 : 0) + ((flags & TCP_FIN) ? 1 : 0);
+    if (seg_len == 0 || (flags & TCP_RST)) return;
+
+    uint32_t seq = ntohl(tcp->sequence);
+    uint32_t seg_end = seq + seg_len;
+    if (!fwd_state.seq_valid)
+    {
+        fwd_state.next_seq = seg_end;
+        fwd_state.seq_valid = true;
+    }
+    else if (static_cast<int32_t>(seq - fwd_state.next_seq) < 0)
+    {
+        int64_t window = info.handshake_rtt_us > 0 ? info.handshake_rtt_us : DEFAULT_REORDER_WINDOW_US;
+        if (now - fwd_state.last_us < window) ++info.out_of_order;
+        else ++info.retransmissions;
+        if (static_cast<int32_t>(seg_end - fwd_state.next_seq) > 0) fwd_state.next_seq = seg_end;
+    }
+    else
+    {
+        // 序号前跳说明中间的段未被捕获（或将乱序到达），只推进期望序号
+        fwd_state.next_seq = seg_end;
+    }
+    fwd_state.last_us = now;
+}
+
+}
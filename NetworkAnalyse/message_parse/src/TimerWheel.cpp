@@ -0,0 +1,105 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+void TimerWheel::schedule(TimerId id, uint64_t expire_tick)
+{
+    insert({id, expire_tick}, m_current + 1);
+    ++m_count;
+}
+
+void TimerWheel::insert(const Timer& timer, uint64_t earliest)
+{
+    // 早于 earliest 的放入 earliest 对应的槽位：登记时为下一个 tick，级联时为当前 tick（随后立即处理）
+    uint64_t expire = timer.expire > earliest ? timer.expire : earliest;
+    uint64_t delta = expire - m_current;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+        ++level;
+    // 超出最高层范围的定时器放在最高层，级联时再重新计算
+    uint64_t slot = (expire >> (SLOT_BITS * level)) & (SLOTS - 1);
+    if (level == LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * LEVELS)))
+        slot = ((m_current >> (SLOT_BITS * level)) - 1) & (SLOTS - 1);
+    m_slots[level][slot].push_back(timer);
+}
+
+void TimerWheel::advance(uint64_t now_tick, std::vector<TimerId>& expired)
+{
+    if (m_current == 0) m_current = now_tick;
+    if (now_tick <= m_current) return;
+
+    // 逐 tick 推进的代价与间隔成正比：空轮直接跳到 now_tick；间隔超过一圈且多于定时器数量时改为整体重排
+    if (m_count == 0)
+    {
+        m_current = now_tick;
+        return;
+    }
+    if (now_tick - m_current > SLOTS && now_tick - m_current > m_count)
+    {
+        jump(now_tick, expired);
+        return;
+    }
+
+    while (m_current < now_tick)
+    {
+        ++m_current;
+
+        // 自高层向低层级联：到达上一层的边界时，把该层对应槽位重新分配
+        int top = 0;
+        while (top < LEVELS - 1 && (m_current & ((uint64_t(1) << (SLOT_BITS * (top + 1))) - 1)) == 0)
+            ++top;
+        for (int level = top; level >= 1; --level)
+        {
+            uint64_t index = (m_current >> (SLOT_BITS * level)) & (SLOTS - 1);
+            std::vector<Timer> timers;
+            timers.swap(m_slots[level][index]);
+            for (const auto& timer : timers) insert(timer, m_current);
+        }
+
+        std::vector<Timer> due;
+        due.swap(m_slots[0][m_current & (SLOTS - 1)]);
+        for (const auto& timer : due)
+        {
+            if (timer.expire <= m_current)
+            {
+                expired.push_back(timer.id);
+                --m_count;
+            }
+            else
+            {
+                insert(timer, m_current + 1);
+            }
+        }
+    }
+}
+
+void TimerWheel::jump(uint64_t now_tick, std::vector<TimerId>& expired)
+{
+    std::vector<Timer> timers;
+    timers.reserve(m_count);
+    for (auto& level : m_slots)
+    {
+        for (auto& slot : level)
+        {
+            timers.insert(timers.end(), slot.begin(), slot.end());
+            slot.clear();
+        }
+    }
+    // 按到期时间输出，与逐 tick 推进的顺序一致
+    std::stable_sort(timers.begin(), timers.end(),
+                     [](const Timer& a, const Timer& b) { return a.expire < b.expire; });
+
+    m_current = now_tick;
+    for (const auto& timer : timers)
+    {
+        if (timer.expire <= now_tick)
+        {
+            expired.push_back(timer.id);
+            --m_count;
+        }
+        else
+        {
+            insert(timer, now_tick + 1);
+        }
+    }
+}
@@ -0,0 +1,446 @@
+#include "TlsDecryptor.h"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+using crypto_util::Aead;
+using crypto_util::Bytes;
+using crypto_util::Hash;
+
+namespace {
+
+const size_t RECORD_HEADER_LEN = 5;
+const size_t MAX_RECORD_LEN = 16384 + 2048;         // 密文记录上限（RFC 5246 6.2.3）
+const size_t MAX_HANDSHAKE_BUFFER = 64 * 1024;
+const size_t TAG_LEN = 16;
+
+// 记录类型
+const uint8_t CONTENT_CCS = 20;
+const uint8_t CONTENT_ALERT = 21;
+const uint8_t CONTENT_HANDSHAKE = 22;
+const uint8_t CONTENT_APPLICATION = 23;
+
+// 握手消息类型
+const uint8_t HS_CLIENT_HELLO = 1;
+const uint8_t HS_SERVER_HELLO = 2;
+const uint8_t HS_ENCRYPTED_EXTENSIONS = 8;
+const uint8_t HS_FINISHED = 20;
+const uint8_t HS_KEY_UPDATE = 24;
+
+// 扩展类型
+const uint16_t EXT_SERVER_NAME = 0x0000;
+const uint16_t EXT_ALPN = 0x0010;
+const uint16_t EXT_SUPPORTED_VERSIONS = 0x002B;
+
+const uint16_t TLS12 = 0x0303;
+const uint16_t TLS13 = 0x0304;
+
+// HelloRetryRequest 的固定 ServerHello.random（RFC 8446 4.1.3）
+const uint8_t HRR_RANDOM[32] = {
+    0xCF, 0x21, 0xAD, 0x74, 0xE5, 0x9A, 0x61, 0x11, 0xBE, 0x1D, 0x8C, 0x02, 0x1E, 0x65, 0xB8, 0x91,
+    0xC2, 0xA2, 0x11, 0x16, 0x7A, 0xBB, 0x8C, 0x5E, 0x07, 0x9E, 0x09, 0xE2, 0xC8, 0xA8, 0x33, 0x9C};
+
+uint16_t read_u16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// 套件 -> AEAD 与 PRF 哈希，不支持时返回 false
+bool suite_params(uint16_t suite, Aead& aead, Hash& hash)
+{
+    switch (suite)
+    {
+    case 0x1301: case 0xC02B: case 0xC02F: case 0x009C: case 0x009E:
+        aead = Aead::AES_128_GCM; hash = Hash::SHA256; return true;
+    case 0x1302: case 0xC02C: case 0xC030: case 0x009D: case 0x009F:
+        aead = Aead::AES_256_GCM; hash = Hash::SHA384; return true;
+    case 0x1303: case 0xCCA8: case 0xCCA9: case 0xCCAA:
+        aead = Aead::CHACHA20_POLY1305; hash = Hash::SHA256; return true;
+    default:
+        return false;
+    }
+}
+
+// nonce = iv XOR 左侧补零的 64 位序号
+void xor_sequence(uint8_t* nonce, uint64_t seq)
+{
+    for (int i = 0; i < 8; ++i)
+        nonce[11 - i] ^= static_cast<uint8_t>(seq >> (i * 8));
+}
+
+} // namespace
+
+TlsDecryptor::TlsDecryptor(TlsKeyLog& keylog)
+    : m_keylog(keylog)
+{
+}
+
+bool TlsDecryptor::is_client_hello(const uint8_t* data, size_t len)
+{
+    return len >= 6 && data[0] == CONTENT_HANDSHAKE && data[1] == 0x03 && data[5] == HS_CLIENT_HELLO;
+}
+
+bool TlsDecryptor::feed(Direction dir, const uint8_t* data, size_t len, std::string& plaintext)
+{
+    if (m_unsupported) return false;
+    DirectionState& st = m_dir[dir];
+    st.buffer.append(reinterpret_cast<const char*>(data), len);
+
+    size_t offset = 0;
+    bool ok = true;
+    while (ok && st.buffer.size() - offset >= RECORD_HEADER_LEN)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(st.buffer.data()) + offset;
+        size_t record_len = read_u16(p + 3);
+        if (p[0] < CONTENT_CCS || p[0] > 24 || p[1] != 0x03 || record_len > MAX_RECORD_LEN)
+        {
+            spdlog::debug("TLS record framing lost (type {}, length {})", p[0], record_len);
+            return false;
+        }
+        if (st.buffer.size() - offset < RECORD_HEADER_LEN + record_len) break;
+
+        ok = handle_record(dir, st.buffer.substr(offset, RECORD_HEADER_LEN + record_len), plaintext);
+        offset += RECORD_HEADER_LEN + record_len;
+    }
+    st.buffer.erase(0, offset);
+    return ok && !m_unsupported;
+}
+
+bool TlsDecryptor::handle_record(Direction dir, std::string record, std::string& plaintext)
+{
+    DirectionState& st = m_dir[dir];
+    uint8_t type = static_cast<uint8_t>(record[0]);
+    const uint8_t* body = reinterpret_cast<const uint8_t*>(record.data()) + RECORD_HEADER_LEN;
+    size_t body_len = record.size() - RECORD_HEADER_LEN;
+
+    if (st.epoch == Epoch::PLAINTEXT)
+    {
+        if (type == CONTENT_HANDSHAKE) return handle_handshake(dir, body, body_len);
+        if (type == CONTENT_CCS && m_have_server_hello && m_version == TLS12)
+        {
+            // TLS 1.2：ChangeCipherSpec 之后本方向的记录均已加密
+            st.epoch = Epoch::APPLICATION;
+            st.seq = 0;
+            st.keyed = false;
+            install_keys(dir);
+        }
+        return true;
+    }
+
+    // TLS 1.3 的兼容性 ChangeCipherSpec 不加密也不计序号
+    if (type == CONTENT_CCS) return true;
+
+    if (!st.keyed && !install_keys(dir))
+    {
+        // key log 可能尚未同步到本连接，读取追加部分后再试
+        m_keylog.refresh_if_stale();
+        install_keys(dir);
+    }
+    st.pending_bytes += record.size();
+    st.pending.push_back(std::move(record));
+    if (!st.keyed)
+    {
+        if (st.pending_bytes > MAX_PENDING_BYTES)
+        {
+            spdlog::debug("TLS keys not found in key log, giving up connection");
+            return false;
+        }
+        return true;
+    }
+    return drain_pending(dir, plaintext);
+}
+
+bool TlsDecryptor::drain_pending(Direction dir, std::string& plaintext)
+{
+    DirectionState& st = m_dir[dir];
+    // 处理过程中可能切换 epoch（Finished 之后），新密钥缺失时剩余记录继续等待
+    while (st.keyed && !st.pending.empty())
+    {
+        std::string record = std::move(st.pending.front());
+        st.pending.pop_front();
+        st.pending_bytes -= record.size();
+        if (!handle_encrypted(dir, record, plaintext)) return false;
+    }
+    return true;
+}
+
+bool TlsDecryptor::handle_encrypted(Direction dir, const std::string& record, std::string& plaintext)
+{
+    DirectionState& st = m_dir[dir];
+    uint8_t type = 0;
+    Bytes out;
+    if (!decrypt_record(dir, record, type, out))
+    {
+        // TLS 1.3 客户端在握手阶段可能先发 0-RTT 早期数据（key log 不含早期密钥），跳过
+        if (m_version == TLS13 && dir == CLIENT_TO_SERVER && st.epoch == Epoch::HANDSHAKE) return true;
+        spdlog::debug("TLS record decryption failed (direction {}, seq {})", static_cast<int>(dir), st.seq);
+        return false;
+    }
+    ++st.seq;
+
+    switch (type)
+    {
+    case CONTENT_APPLICATION:
+        plaintext.append(reinterpret_cast<const char*>(out.data()), out.size());
+        return true;
+    case CONTENT_HANDSHAKE:
+        return handle_handshake(dir, out.data(), out.size());
+    case CONTENT_ALERT:
+    default:
+        return true;
+    }
+}
+
+bool TlsDecryptor::decrypt_record(Direction dir, const std::string& record, uint8_t& type, Bytes& out)
+{
+    DirectionState& st = m_dir[dir];
+    const uint8_t* header = reinterpret_cast<const uint8_t*>(record.data());
+    const uint8_t* body = header + RECORD_HEADER_LEN;
+    size_t body_len = record.size() - RECORD_HEADER_LEN;
+    uint8_t nonce[12];
+
+    if (m_version == TLS13)
+    {
+        // nonce = iv XOR seq，AAD 为记录头；明文末尾为真实类型，其后的零为填充
+        std::memcpy(nonce, st.iv.data(), 12);
+        xor_sequence(nonce, st.seq);
+        if (!crypto_util::aead_decrypt(m_aead, st.key, nonce, 12, header, RECORD_HEADER_LEN, body, body_len, out))
+            return false;
+        while (!out.empty() && out.back() == 0) out.pop_back();
+        if (out.empty()) return false;
+        type = out.back();
+        out.pop_back();
+        return true;
+    }
+
+    // TLS 1.2：GCM 为 4 字节隐式 salt + 8 字节显式 nonce（记录开头），ChaCha20 为 iv XOR seq（RFC 7905）
+    const uint8_t* ciphertext = body;
+    size_t ciphertext_len = body_len;
+    if (m_aead == Aead::CHACHA20_POLY1305)
+    {
+        std::memcpy(nonce, st.iv.data(), 12);
+        xor_sequence(nonce, st.seq);
+    }
+    else
+    {
+        if (body_len < 8) return false;
+        std::memcpy(nonce, st.iv.data(), 4);
+        std::memcpy(nonce + 4, body, 8);
+        ciphertext += 8;
+        ciphertext_len -= 8;
+    }
+    if (ciphertext_len < TAG_LEN) return false;
+
+    // AAD = seq_num(8) + type(1) + version(2) + 明文长度(2)
+    uint8_t aad[13];
+    for (int i = 0; i < 8; ++i) aad[i] = static_cast<uint8_t>(st.seq >> (56 - i * 8));
+    aad[8] = header[0];
+    aad[9] = header[1];
+    aad[10] = header[2];
+    size_t plain_len = ciphertext_len - TAG_LEN;
+    aad[11] = static_cast<uint8_t>(plain_len >> 8);
+    aad[12] = static_cast<uint8_t>(plain_len);
+    type = header[0];
+    return crypto_util::aead_decrypt(m_aead, st.key, nonce, 12, aad, sizeof(aad), ciphertext, ciphertext_len, out);
+}
+
+bool TlsDecryptor::handle_handshake(Direction dir, const uint8_t* data, size_t len)
+{
+    DirectionState& st = m_dir[dir];
+    st.handshake.append(reinterpret_cast<const char*>(data), len);
+
+    size_t offset = 0;
+    while (st.handshake.size() - offset >= 4)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(st.handshake.data()) + offset;
+        size_t msg_len = (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | p[3];
+        if (msg_len > MAX_HANDSHAKE_BUFFER) return false;
+        if (st.handshake.size() - offset < 4 + msg_len) break;
+        handle_handshake_message(dir, p[0], p + 4, msg_len);
+        offset += 4 + msg_len;
+        // TLS 1.2 的 Finished 与证书等不影响解密，ServerHello 之后切换 epoch 时剩余字节属于新 epoch
+    }
+    st.handshake.erase(0, offset);
+    return st.handshake.size() <= MAX_HANDSHAKE_BUFFER;
+}
+
+void TlsDecryptor::handle_handshake_message(Direction dir, uint8_t type, const uint8_t* body, size_t len)
+{
+    DirectionState& st = m_dir[dir];
+    switch (type)
+    {
+    case HS_CLIENT_HELLO:
+        if (dir == CLIENT_TO_SERVER) parse_client_hello(body, len);
+        break;
+    case HS_SERVER_HELLO:
+        if (dir == SERVER_TO_CLIENT) parse_server_hello(body, len);
+        break;
+    case HS_ENCRYPTED_EXTENSIONS:
+        if (dir == SERVER_TO_CLIENT && len >= 2) parse_extensions(body + 2, body + len, false);
+        break;
+    case HS_FINISHED:
+        // TLS 1.3：本方向 Finished 之后改用应用流量密钥
+        if (m_version == TLS13 && st.epoch == Epoch::HANDSHAKE)
+        {
+            st.epoch = Epoch::APPLICATION;
+            st.seq = 0;
+            st.keyed = false;
+            install_keys(dir);
+        }
+        break;
+    case HS_KEY_UPDATE:
+        if (m_version == TLS13 && st.epoch == Epoch::APPLICATION && st.keyed)
+        {
+            set_traffic_secret(dir, crypto_util::hkdf_expand_label(m_hash, st.secret, "traffic upd", {},
+                                                                   crypto_util::hash_length(m_hash)));
+            st.seq = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TlsDecryptor::parse_client_hello(const uint8_t* body, size_t len)
+{
+    // legacy_version(2) random(32) session_id<1> cipher_suites<2> compression<1> extensions<2>
+    const uint8_t* p = body;
+    const uint8_t* end = body + len;
+    if (end - p < 2 + 32 + 1) return;
+    std::memcpy(m_client_random, p + 2, 32);
+    m_have_client_random = true;
+    p += 34;
+    p += 1 + *p;
+    if (end - p < 2) return;
+    p += 2 + read_u16(p);
+    if (end - p < 1) return;
+    p += 1 + *p;
+    if (end - p < 2) return;
+    size_t ext_len = read_u16(p);
+    p += 2;
+    if (static_cast<size_t>(end - p) < ext_len) return;
+    parse_extensions(p, p + ext_len, true);
+}
+
+void TlsDecryptor::parse_server_hello(const uint8_t* body, size_t len)
+{
+    // legacy_version(2) random(32) session_id<1> cipher_suite(2) compression(1) extensions<2>
+    const uint8_t* p = body;
+    const uint8_t* end = body + len;
+    if (end - p < 2 + 32 + 1) return;
+    uint16_t legacy_version = read_u16(p);
+    const uint8_t* random = p + 2;
+    p += 34;
+    p += 1 + *p;
+    if (end - p < 3) return;
+    uint16_t suite = read_u16(p);
+    p += 3;
+
+    m_version = legacy_version;
+    if (end - p >= 2)
+    {
+        size_t ext_len = read_u16(p);
+        p += 2;
+        if (static_cast<size_t>(end - p) >= ext_len) parse_extensions(p, p + ext_len, false);
+    }
+
+    if (m_version == TLS13 && std::memcmp(random, HRR_RANDOM, 32) == 0)
+    {
+        // HelloRetryRequest：客户端会重发 ClientHello，等待真正的 ServerHello
+        return;
+    }
+
+    std::memcpy(m_server_random, random, 32);
+    m_have_server_hello = true;
+    m_suite = suite;
+    if ((m_version != TLS12 && m_version != TLS13) || !suite_params(suite, m_aead, m_hash))
+    {
+        spdlog::debug("TLS version {:#06x} / suite {:#06x} not supported for decryption", m_version, suite);
+        m_unsupported = true;
+        return;
+    }
+
+    if (m_version == TLS13)
+    {
+        // ServerHello 之后两个方向都进入握手加密阶段
+        for (int d = 0; d < 2; ++d)
+        {
+            m_dir[d].epoch = Epoch::HANDSHAKE;
+            m_dir[d].seq = 0;
+            m_dir[d].keyed = false;
+            install_keys(static_cast<Direction>(d));
+        }
+    }
+}
+
+void TlsDecryptor::parse_extensions(const uint8_t* p, const uint8_t* end, bool client)
+{
+    while (end - p >= 4)
+    {
+        uint16_t type = read_u16(p);
+        size_t len = read_u16(p + 2);
+        p += 4;
+        if (static_cast<size_t>(end - p) < len) return;
+        const uint8_t* e = p;
+        p += len;
+
+        if (type == EXT_SERVER_NAME && client && len >= 5)
+        {
+            // list_len(2) name_type(1) name_len(2) name
+            size_t name_len = read_u16(e + 3);
+            if (e[2] == 0 && 5 + name_len <= len)
+                m_server_name.assign(reinterpret_cast<const char*>(e + 5), name_len);
+        }
+        else if (type == EXT_ALPN && !client && len >= 3)
+        {
+            // 服务端只返回选中的一个协议：list_len(2) proto_len(1) proto
+            size_t proto_len = e[2];
+            if (3 + proto_len <= len) m_alpn.assign(reinterpret_cast<const char*>(e + 3), proto_len);
+        }
+        else if (type == EXT_SUPPORTED_VERSIONS && !client && len == 2)
+        {
+            m_version = read_u16(e);
+        }
+    }
+}
+
+bool TlsDecryptor::install_keys(Direction dir)
+{
+    DirectionState& st = m_dir[dir];
+    if (!m_have_client_random || !m_have_server_hello || m_unsupported) return false;
+    const TlsSecrets* secrets = m_keylog.find(m_client_random);
+    if (!secrets) return false;
+
+    if (m_version == TLS13)
+    {
+        const Bytes& secret = st.epoch == Epoch::HANDSHAKE
+            ? (dir == CLIENT_TO_SERVER ? secrets->client_handshake : secrets->server_handshake)
+            : (dir == CLIENT_TO_SERVER ? secrets->client_traffic : secrets->server_traffic);
+        if (secret.empty()) return false;
+        set_traffic_secret(dir, secret);
+        return true;
+    }
+
+    if (secrets->master_secret.empty()) return false;
+    // key_block = PRF(master_secret, "key expansion", server_random + client_random)，AEAD 套件无 MAC 密钥
+    size_t key_len = crypto_util::aead_key_length(m_aead);
+    size_t iv_len = m_aead == Aead::CHACHA20_POLY1305 ? 12 : 4;
+    Bytes seed(m_server_random, m_server_random + 32);
+    seed.insert(seed.end(), m_client_random, m_client_random + 32);
+    Bytes block = crypto_util::tls12_prf(m_hash, secrets->master_secret, "key expansion", seed,
+                                         2 * key_len + 2 * iv_len);
+    size_t key_offset = dir == CLIENT_TO_SERVER ? 0 : key_len;
+    size_t iv_offset = 2 * key_len + (dir == CLIENT_TO_SERVER ? 0 : iv_len);
+    st.key.assign(block.begin() + key_offset, block.begin() + key_offset + key_len);
+    st.iv.assign(block.begin() + iv_offset, block.begin() + iv_offset + iv_len);
+    st.keyed = true;
+    return true;
+}
+
+void TlsDecryptor::set_traffic_secret(Direction dir, const Bytes& secret)
+{
+    DirectionState& st = m_dir[dir];
+    st.secret = secret;
+    st.key = crypto_util::hkdf_expand_label(m_hash, secret, "key", {}, crypto_util::aead_key_length(m_aead));
+    st.iv = crypto_util::hkdf_expand_label(m_hash, secret, "iv", {}, 12);
+    st.keyed = true;
+}
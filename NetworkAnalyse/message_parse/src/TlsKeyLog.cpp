@@ -0,0 +1,107 @@
+#include "TlsKeyLog.h"
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+namespace {
+const size_t RANDOM_LEN = 32;
+}
+
+bool TlsKeyLog::open(const std::string& path, std::string& error)
+{
+    close();
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "cannot open key log: " + path;
+        return false;
+    }
+    m_path = path;
+    size_t added = refresh();
+    spdlog::info("TLS key log {} loaded: {} connections", path, added);
+    return true;
+}
+
+void TlsKeyLog::close()
+{
+    m_path.clear();
+    m_offset = 0;
+    m_partial.clear();
+    m_last_refresh = 0;
+    m_secrets.clear();
+}
+
+size_t TlsKeyLog::refresh_if_stale()
+{
+    if (std::time(nullptr) == m_last_refresh) return 0;
+    return refresh();
+}
+
+size_t TlsKeyLog::refresh()
+{
+    if (m_path.empty()) return 0;
+    m_last_refresh = std::time(nullptr);
+
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+    if (!file) return 0;
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    if (size < m_offset)
+    {
+        // 文件被替换：从头重读，已有条目保留
+        m_offset = 0;
+        m_partial.clear();
+    }
+    if (size == m_offset) return 0;
+
+    file.seekg(static_cast<std::streamoff>(m_offset));
+    std::string chunk(static_cast<size_t>(size - m_offset), '\0');
+    file.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+    chunk.resize(static_cast<size_t>(file.gcount()));
+    m_offset += chunk.size();
+
+    size_t added = 0;
+    std::string data = m_partial + chunk;
+    size_t start = 0;
+    for (size_t nl = data.find('\n'); nl != std::string::npos; nl = data.find('\n', start))
+    {
+        added += parse_line(data.substr(start, nl - start));
+        start = nl + 1;
+    }
+    m_partial = data.substr(start);
+    return added;
+}
+
+size_t TlsKeyLog::parse_line(const std::string& line)
+{
+    // <LABEL> <client_random 十六进制> <secret 十六进制>，# 开头为注释
+    if (line.empty() || line[0] == '#') return 0;
+    std::istringstream in(line);
+    std::string label, random_hex, secret_hex;
+    if (!(in >> label >> random_hex >> secret_hex)) return 0;
+
+    crypto_util::Bytes random = crypto_util::from_hex(random_hex);
+    crypto_util::Bytes secret = crypto_util::from_hex(secret_hex);
+    if (random.size() != RANDOM_LEN || secret.empty()) return 0;
+
+    std::string key(random.begin(), random.end());
+    bool created = m_secrets.find(key) == m_secrets.end();
+    TlsSecrets& secrets = m_secrets[key];
+    if (label == "CLIENT_RANDOM") secrets.master_secret = secret;
+    else if (label == "CLIENT_HANDSHAKE_TRAFFIC_SECRET") secrets.client_handshake = secret;
+    else if (label == "SERVER_HANDSHAKE_TRAFFIC_SECRET") secrets.server_handshake = secret;
+    else if (label == "CLIENT_TRAFFIC_SECRET_0") secrets.client_traffic = secret;
+    else if (label == "SERVER_TRAFFIC_SECRET_0") secrets.server_traffic = secret;
+    else
+    {
+        // EXPORTER_SECRET、EARLY_TRAFFIC_SECRET 等不参与解密
+        if (created) m_secrets.erase(key);
+        return 0;
+    }
+    return created ? 1 : 0;
+}
+
+const TlsSecrets* TlsKeyLog::find(const uint8_t* client_random) const
+{
+    auto it = m_secrets.find(std::string(reinterpret_cast<const char*>(client_random), RANDOM_LEN));
+    return it == m_secrets.end() ? nullptr : &it->second;
+}
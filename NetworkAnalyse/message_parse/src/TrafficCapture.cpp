@@ -15,13 +15,24 @@ TrafficCapture::~TrafficCapture()
     stop_capture();
 }
 
-bool TrafficCapture::start_capture(int uid)
+bool TrafficCapture::start_capture(int uid, const CaptureOptions& options)
 {
     if (m_running) return false;
     app_uid=uid;
+    m_pcap_file = options.pcap_file;
+    m_device = options.adb_serial;
     m_running = true;
-    m_packet_parser->start(uid);
-    m_capture_thread = std::thread(&TrafficCapture::thread_capture, this);
+    m_packet_parser->start(uid, options);
+    if (!options.adb_serial.empty())
+    {
+        // 设备端抓包不经过宿主机转发，设备内地址即真实地址
+        m_adb.reset(new AdbCapture(options.adb_serial, ""));
+        m_capture_thread = std::thread(&TrafficCapture::thread_adb_capture, this);
+    }
+    else
+    {
+        m_capture_thread = std::thread(&TrafficCapture::thread_capture, this);
+    }
 
     // 启动解析器
     return true;
@@ -34,6 +45,11 @@ bool TrafficCapture::start_capture(int uid)
 /// 中断 pcap 循环并关闭 pcap 句柄，同时确保捕获线程安全退出。
 
 /*******  9e5dd3aa-e608-49d4-b30b-c30c48c892e3  *******/
+bool TrafficCapture::set_address_map(const AddressMap::Entries& entries, bool session, std::string& error)
+{
+    return m_packet_parser->set_address_map(entries, session, error);
+}
+
 void TrafficCapture::stop_capture()
 {
     // 如果没有运行，则直接返回
@@ -47,6 +63,10 @@ void TrafficCapture::stop_capture()
     {
         pcap_breakloop(m_pcap_handle); // 使 pcap_loop 退出
     }
+    if (m_adb)
+    {
+        m_adb->stop(); // 结束 adb 进程，读取循环随管道关闭退出
+    }
 
     if (m_capture_thread.joinable()) 
     {
@@ -58,18 +78,33 @@ void TrafficCapture::stop_capture()
         pcap_close(m_pcap_handle);
         m_pcap_handle = nullptr;
     }
+    m_adb.reset();
+    m_device.clear();
 }
 
 void TrafficCapture::thread_capture()
 {
     char errbuf[PCAP_ERRBUF_SIZE] = {0};
 
-    // 打开 "any" 接口监听所有设备，可替换为具体接口如 "ens33"
-    m_pcap_handle = pcap_open_live("ens33", 65536, 1, 100, errbuf);
-    if (!m_pcap_handle) 
+    if (!m_pcap_file.empty())
     {
-        spdlog::error("pcap_open_live failed: {}", errbuf);
-        return;
+        // 离线回放：按文件中的时间戳解析，便于用 pcap 样本 + key log 复现
+        m_pcap_handle = pcap_open_offline(m_pcap_file.c_str(), errbuf);
+        if (!m_pcap_handle)
+        {
+            spdlog::error("pcap_open_offline failed: {}", errbuf);
+            return;
+        }
+    }
+    else
+    {
+        // 打开 "any" 接口监听所有设备，可替换为具体接口如 "ens33"
+        m_pcap_handle = pcap_open_live("ens33", 65536, 1, 100, errbuf);
+        if (!m_pcap_handle) 
+        {
+            spdlog::error("pcap_open_live failed: {}", errbuf);
+            return;
+        }
     }
 
     // 设置 BPF 过滤器
@@ -80,8 +115,23 @@ void TrafficCapture::thread_capture()
 
     spdlog::info("开始捕获 IP [{}] 的数据包...", m_target_ip);
 
+    m_link_type = pcap_datalink(m_pcap_handle);
+
     // 阻塞进入捕获循环
     pcap_loop(m_pcap_handle, 0, pcap_callback, reinterpret_cast<u_char*>(this));
+    if (!m_pcap_file.empty())
+        spdlog::info("pcap 文件 {} 回放结束", m_pcap_file);
+}
+
+void TrafficCapture::thread_adb_capture()
+{
+    spdlog::info("开始经 adb 在设备 [{}] 上捕获数据包...", m_adb->serial());
+    std::string error;
+    bool ok = m_adb->run([this](const timeval& ts, const uint8_t* data, size_t len, int link_type) {
+        if (m_running) process_packet(ts, data, len, link_type);
+    }, error);
+    if (!ok)
+        spdlog::error("adb capture on {} failed: {}", m_adb->serial(), error);
 }
 
 bool TrafficCapture::set_filter(const std::string& ip)
@@ -127,18 +177,21 @@ void TrafficCapture::pcap_callback(u_char* user, const struct pcap_pkthdr* heade
     auto now = header->ts; 
     if (self && self->m_running && header->caplen > 0) 
     {
-        self->process_packet(now,packet, header->caplen);
+        self->process_packet(now,packet, header->caplen, self->m_link_type);
     }
 }
 
 /// @brief  实际处理函数
 /// @param data     // 数据包数据
 /// @param length   // 数据包长度
-void TrafficCapture::process_packet(const timeval& timestamp, const u_char* data, size_t length)
+/// @param link_type // 链路层类型（LINKTYPE_*）
+void TrafficCapture::process_packet(const timeval& timestamp, const u_char* data, size_t length, int link_type)
 {
     std::lock_guard<std::mutex> lock(m_queue_mutex);
     Packet packet;
     packet.timestamp = timestamp; // 设置时间戳
+    packet.link_type = link_type;
+    packet.device = m_device;
     packet.data.resize(length); // 设置数据包大小
     memcpy(packet.data.data(), data, length);
     m_packet_parser->push_raw_packet(packet); // 将数据包推入队列.emplace(data, data + length);
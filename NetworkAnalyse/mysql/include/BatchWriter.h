@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "BulkLoader.h"
+#include "MySQLDAO.h"
+#include "SqlRow.h"
+
+/**
+ * @brief 批量写入参数
+ */
+struct BatchWriterConfig
+{
+    size_t          initial_rows = 64;          // 初始批大小（所有表合计的行数）
+    size_t          min_rows = 16;
+    size_t          max_rows = 2000;
+    int64_t         max_delay_us = 200000;      // 行最长等待时间，到期即提交
+    int64_t         target_commit_us = 50000;   // 期望的单次提交耗时，超过则缩小批大小
+    size_t          bulk_min_rows = 0;          // 单表积压行达到该值时改用 LOAD DATA LOCAL INFILE（经临时表合并），0 表示不用
+};
+
+/**
+ * @brief 按表累积行，达到批大小或最早一行到期时以组提交写入
+ *
+ * 一次提交把所有表的积压行写在同一个事务里（每张表一条多行 INSERT）。
+ * 批大小按提交耗时自适应：满批且耗时低于目标一半时翻倍，超过目标时减半。
+ * 开启 bulk_min_rows 时，大批量的表改用 MySQLDAO::bulk_store_rows 导入（不在组提交事务内）：
+ * 确定没有写入的行回落到多行 INSERT；提交结果丢失的批次以同一批次 id 转存暂存区，回放时按 id 去重，不会重复写入。
+ * 提交失败（或暂存区仍有积压）的行转存本地暂存区，由 SpoolReplayer 在库恢复后回放。
+ * 非线程安全，由单个存储线程使用。
+ */
+class BatchWriter
+{
+public:
+    explicit BatchWriter(MySQLDAO& dao, const BatchWriterConfig& config = BatchWriterConfig());
+    ~BatchWriter();
+
+    int                 add_table(const BatchTable& table);         // 登记目标表，返回表号
+    void                add(int table, SqlRow row, int64_t now_us); // 追加一行，达到批大小时立即提交
+    void                poll(int64_t now_us);                       // 最早一行到期时提交
+    void                flush();                                    // 提交全部积压行
+
+    int64_t             next_deadline_us() const;                   // 最早一行的到期时间，无积压为 0
+    size_t              pending_rows() const { return m_pending_rows; }
+    size_t              batch_rows() const { return m_batch_rows; }
+    uint64_t            dropped_rows() const { return m_dropped; }  // 写库与转存暂存区都失败而丢弃的行数
+
+private:
+    void                commit(bool full);
+
+    MySQLDAO&               m_dao;
+    BatchWriterConfig       m_config;
+    std::deque<BatchTable>  m_defs;                 // 登记的表（deque 保证 RowBatch 中的指针稳定）
+    std::vector<RowBatch>   m_tables;               // 表号 -> 积压行
+    size_t                  m_pending_rows = 0;
+    int64_t                 m_oldest_us = 0;        // 最早一行的加入时间
+    size_t                  m_batch_rows;
+    uint64_t                m_dropped = 0;
+    std::unique_ptr<BulkLoader> m_bulk;             // bulk_min_rows > 0 时创建
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief HTTP 报文体的存储编码（http_packets.body_codec）
+ *
+ * 低 4 位为压缩方式；BASE64 位表示压缩前做过 base64 解码（mitm 以 base64 转发二进制报文体），
+ * 读出时重新编码，还原为写入时的文本。
+ */
+namespace body_codec
+{
+constexpr uint8_t RAW = 0;              // 原文在 body 列（旧数据、过短或压缩无收益的报文体）
+constexpr uint8_t ZSTD = 1;             // zstd 帧在 body_data 列
+constexpr uint8_t ZSTD_DICT = 2;        // 使用字典的 zstd 帧，字典 id 记在帧头，字典存于 http_body_dicts
+constexpr uint8_t METHOD_MASK = 0x0f;
+constexpr uint8_t BASE64 = 0x10;
+
+// 标准字母表、带填充的 base64，也供落盘的 JSON 承载原始字节（JSON 字符串只能是 UTF-8）
+std::string base64_encode(const std::string& in);
+bool        base64_decode(const std::string& in, std::string& out);     // 只接受规范编码（无换行、填充规范）
+}
+
+/**
+ * @brief 按内容类别训练的 zstd 字典
+ */
+struct BodyDictionary
+{
+    uint32_t        id = 0;             // zstd 字典 id，帧头中记录，解压时据此找字典
+    std::string     content_class;
+    std::string     data;
+};
+
+/**
+ * @brief 字典的持久化：字典先落库再用于压缩，保证库中每个压缩体都能解开（MySQLDAO 以 http_body_dicts 表实现）
+ */
+class BodyDictionaryStore
+{
+public:
+    virtual ~BodyDictionaryStore() = default;
+
+    virtual bool    save(const BodyDictionary& dict) = 0;
+    virtual bool    load(uint32_t id, BodyDictionary& dict) = 0;
+    virtual bool    load_all(std::vector<BodyDictionary>& dicts) = 0;  // 按创建先后
+};
+
+struct EncodedBody
+{
+    uint8_t         codec = body_codec::RAW;
+    std::string     data;               // RAW 时为原文，否则为 zstd 帧
+};
+
+/**
+ * @brief HTTP 报文体压缩
+ *
+ * 按 Content-Type 归类（json / html / xml / javascript / css / text / form / binary），
+ * 每类收集报文体前缀作为样本，累计 TRAIN_BYTES 后训练一个字典并落库，此后该类用字典压缩；
+ * 小而同构的 JSON/HTML 报文体靠字典才压得动。binary 类（图片、压缩包等）不训练字典，
+ * 是规范 base64 文本时先解码再压缩。各类沿用最近训练的一个字典。
+ * 加载已有字典、训练与落库都在后台线程进行（首次压缩时启动）：encode 常在写库事务内调用，
+ * 不能等待训练或另借连接；字典落库成功后才切换，此前照常无字典压缩。
+ * 线程安全：压缩/解压上下文按线程缓存，字典只读共享。
+ */
+class BodyCompressor
+{
+public:
+    static constexpr int        LEVEL = 3;
+    static constexpr size_t     MIN_BYTES = 128;                    // 更短的报文体原样存储
+    static constexpr size_t     MAX_BYTES = 256 * 1024 * 1024;      // 解压结果上限，防止损坏数据申请超大内存
+    static constexpr size_t     DICT_CAPACITY = 64 * 1024;
+    static constexpr size_t     SAMPLE_PREFIX = 16 * 1024;          // 每个样本只取前缀，避免大报文体占满样本
+    static constexpr size_t     TRAIN_BYTES = 2 * 1024 * 1024;      // 样本累计到该字节数时训练
+    static constexpr size_t     MIN_SAMPLES = 100;
+
+    explicit BodyCompressor(std::shared_ptr<BodyDictionaryStore> store);
+    ~BodyCompressor();
+
+    /**
+     * 取进程内共享的实例，已存在时忽略 store
+     */
+    static std::shared_ptr<BodyCompressor> shared(std::shared_ptr<BodyDictionaryStore> store);
+    static std::string  content_class(const std::string& content_type);
+
+    EncodedBody         encode(const std::string& content_type, const std::string& body);
+    /**
+     * 还原报文体；字典不在内存时从 store 加载
+     * @return 失败（数据损坏、字典缺失）返回 false，error 为原因
+     */
+    bool                decode(uint8_t codec, const std::string& data, std::string& body, std::string& error);
+
+    nlohmann::json      status() const;
+
+private:
+    struct Dictionary;
+
+    struct TrainingJob
+    {
+        std::string                         content_class;
+        std::string                         samples;
+        std::vector<size_t>                 sizes;
+    };
+
+    struct ClassState
+    {
+        std::shared_ptr<const Dictionary>   active;             // 压缩使用的字典
+        std::string                         samples;            // 待训练的样本（首尾相接）
+        std::vector<size_t>                 sample_sizes;
+        bool                                training = false;   // 样本已交给后台线程
+        uint64_t                            bodies = 0;
+        uint64_t                            raw_bytes = 0;
+        uint64_t                            stored_bytes = 0;
+    };
+
+    void                load_dictionaries();
+    std::shared_ptr<const Dictionary> install(const BodyDictionary& dict, bool activate);
+    std::shared_ptr<const Dictionary> find(uint32_t id);
+    void                train(const TrainingJob& job);
+    void                run();                              // 后台线程：加载字典，之后逐个训练
+
+    std::shared_ptr<BodyDictionaryStore>    m_store;
+    std::once_flag                          m_start_once;
+    std::thread                             m_thread;
+    std::condition_variable                 m_cv;
+    mutable std::mutex                      m_mutex;        // 保护以下成员
+    std::map<std::string, ClassState>       m_classes;
+    std::map<uint32_t, std::shared_ptr<const Dictionary>> m_dictionaries;
+    std::deque<TrainingJob>                 m_jobs;         // 待训练的样本
+    bool                                    m_stop = false;
+    uint64_t                                m_decoded = 0;
+    uint64_t                                m_decode_failures = 0;
+};
+
+/**
+ * @brief 从库中读出的报文体：保留存储形式，首次 text() 时才解压
+ *
+ * 列出报文只看元数据时不付出解压开销。非线程安全。
+ */
+class StoredBody
+{
+public:
+    StoredBody() = default;
+    StoredBody(uint8_t codec, std::string data, std::shared_ptr<BodyCompressor> compressor);
+
+    const std::string&  text() const;       // 解压失败返回空串，原因见 error()
+    const std::string&  error() const { return m_error; }
+    uint8_t             codec() const { return m_codec; }
+    size_t              stored_bytes() const { return m_data.size(); }
+    bool                decoded() const { return m_decoded; }
+
+private:
+    uint8_t                         m_codec = body_codec::RAW;
+    std::string                     m_data;
+    std::shared_ptr<BodyCompressor> m_compressor;
+    mutable bool                    m_decoded = false;
+    mutable std::string             m_text;
+    mutable std::string             m_error;
+};
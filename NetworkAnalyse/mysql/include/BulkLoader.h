@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SqlRow.h"
+
+/**
+ * @brief 数据库连接参数（C API 连接使用，格式与连接池相同）
+ */
+struct MySqlEndpoint
+{
+    std::string     url;            // "host:port" 或 "tcp://host:port"
+    std::string     user;
+    std::string     pass;
+    std::string     schema;
+};
+
+/**
+ * @brief LOAD DATA LOCAL INFILE 批量导入
+ *
+ * 行先序列化到内存中的 TSV 缓冲区，缓冲区满或结束时经 local infile 回调直接流给服务端，
+ * 不落临时文件。Connector/C++ 不提供 local infile 回调，这里单独使用一条 MySQL C API 连接。
+ * 服务端须开启 local_infile。
+ *
+ * 两种方式：
+ *  - APPEND：直接导入目标表，每个缓冲区一次 LOAD DATA（语句级事务）。LOAD DATA 发出后连接断开
+ *    （2013、读超时）时无法得知服务端是否已提交，outcome_unknown() 为 true
+ *  - MERGE：先导入本连接的临时表 <table>__stage（只有目标表的这些列，不带索引与分区，另加
+ *    stage_seq 保持行序），finish() 时在一个事务内写入批次 id（spool_applied）并
+ *    INSERT ... SELECT 进目标表（可带 ON DUPLICATE KEY UPDATE 子句）。批次 id 已存在时整批跳过，
+ *    因此同一 id 重做是幂等的；只有 COMMIT 发出后连接断开时 outcome_unknown() 为 true，
+ *    此前的任何失败都确定没有写入。spool_applied 表由调用方建好（见 MySQLDAO）
+ * 连接设有连接/读写超时，出现 2006/2013（连接断开）时关闭连接，下次导入重新连接；
+ * 空闲后复用前先 ping，失效即重连。
+ *
+ * 非线程安全，一个实例同一时刻只进行一次导入。
+ */
+class BulkLoader
+{
+public:
+    enum class Mode
+    {
+        APPEND,         // 直接追加到目标表
+        MERGE,          // 经临时表与批次 id 在一个事务内合并进目标表
+    };
+
+    static const size_t DEFAULT_BUFFER_BYTES = 16 * 1024 * 1024;   // 缓冲区达到该大小即发送一次 LOAD DATA
+    static const unsigned int CONNECT_TIMEOUT_SEC = 5;
+    static const unsigned int READ_TIMEOUT_SEC = 60;               // 等待 LOAD DATA 结果（含服务端写入）
+    static const unsigned int WRITE_TIMEOUT_SEC = 30;
+
+    explicit BulkLoader(const MySqlEndpoint& endpoint, size_t buffer_bytes = DEFAULT_BUFFER_BYTES);
+    ~BulkLoader();
+
+    bool                connect();                                  // 每次导入前自动调用，连接失效时重连
+    // 开始一次导入；MERGE 须给出批次 id，on_duplicate 为追加在 INSERT ... SELECT 后的
+    // ON DUPLICATE KEY UPDATE 子句（列名须带目标表名限定，与临时表的同名列区分）
+    bool                begin(const BatchTable& table, Mode mode = Mode::APPEND,
+                              const std::string& batch_id = std::string(),
+                              const std::string& on_duplicate = std::string());
+    bool                append(const SqlRow& row);                  // 追加一行，缓冲区满时发送
+    bool                finish();                                   // 发送剩余数据（MERGE 时合并进目标表）
+    void                abort();                                    // 放弃本次导入中尚未发送（合并）的数据
+
+    // begin + append + finish，返回导入的行数，批次 id 此前已写入时为 0，-1 出错
+    // （APPEND 已发送成功的缓冲区不回滚；MERGE 出错时目标表不变，除非 outcome_unknown()）
+    int64_t             load(const BatchTable& table, const std::vector<SqlRow>& rows, Mode mode = Mode::APPEND,
+                             const std::string& batch_id = std::string(),
+                             const std::string& on_duplicate = std::string());
+
+    const std::string&  error() const { return m_error; }
+    bool                outcome_unknown() const { return m_outcome_unknown; }  // 上次失败时是否可能已(部分)写入
+    bool                already_applied() const { return m_already_applied; }  // 上次 MERGE 的批次 id 此前已写入
+
+    static void         append_tsv(std::string& out, const SqlRow& row, size_t columns);  // 一行 -> TSV（含换行）
+
+private:
+    bool                query(const std::string& sql);
+    bool                lost_connection() const { return m_errno == 2006 || m_errno == 2013; }
+    void                disconnect();
+    bool                send_buffer();                              // LOAD DATA 发送当前缓冲区
+    bool                merge();                                    // MERGE：批次 id + INSERT ... SELECT，一个事务
+    void                cleanup(const std::string& sql);            // 收尾语句（ROLLBACK、删临时表），保留原错误
+    std::string         column_list() const;
+    std::string         escape(const std::string& value) const;     // 字符串字面量转义（不含引号）
+
+    // local infile 回调：文件名被忽略，数据来自 m_buffer
+    static int          infile_init(void** ptr, const char* filename, void* userdata);
+    static int          infile_read(void* ptr, char* buf, unsigned int buf_len);
+    static void         infile_end(void* ptr);
+    static int          infile_error(void* ptr, char* msg, unsigned int msg_len);
+
+    MySqlEndpoint       m_endpoint;
+    size_t              m_buffer_bytes;
+    void*               m_mysql = nullptr;          // MYSQL*，头文件不引入 C API
+    std::string         m_buffer;                   // 待发送的 TSV
+    size_t              m_read_offset = 0;          // infile_read 已交出的字节
+    BatchTable          m_table;
+    Mode                m_mode = Mode::APPEND;
+    std::string         m_target;                   // LOAD DATA 的目标：APPEND 为目标表，MERGE 为临时表
+    std::string         m_batch_id;
+    std::string         m_on_duplicate;
+    bool                m_active = false;
+    int64_t             m_rows = 0;
+    bool                m_sent = false;             // 本次导入已有缓冲区发送成功
+    bool                m_outcome_unknown = false;
+    bool                m_already_applied = false;
+    unsigned int        m_errno = 0;                // 上一条失败语句的错误码
+    std::string         m_error;
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SqlRow.h"
+
+/**
+ * @brief 列式段文件：一组行按列编码后的不可变文件（ColumnStore 的存储单元）
+ *
+ * 布局（整数为本机字节序）：
+ *   magic "NCS1"(4) | 版本(4) | 头长度(4) | 行数(4) | 列数(4) | 各列元数据 | 各列数据
+ * 列元数据：列名、类型、编码、是否有 NULL、min/max（段级索引，扫描时据此跳过整段）、数据偏移与长度。
+ * 列数据：
+ *  - INT / DATETIME：相邻行差值 zigzag 后按 varint 存储（时间、计数类列差值很小）
+ *  - STRING：不同值不超过行数一半时字典编码（字典 + 每行 varint 编号），否则逐行 varint 长度 + 字节
+ *  - 有 NULL 时数据前是一个按行的位图
+ */
+namespace column_segment
+{
+
+enum class ColumnType : uint8_t { INT = 1, DATETIME = 2, STRING = 3 };
+enum class Encoding : uint8_t { DELTA = 1, DICT = 2, PLAIN = 3 };
+
+/**
+ * @brief 解码后的一列：字符串为指向段数据（mmap）的视图，段存活期间有效
+ */
+struct ColumnVector
+{
+    ColumnType                      type = ColumnType::INT;
+    const uint8_t*                  nulls = nullptr;    // NULL 位图，nullptr 表示没有 NULL
+    std::vector<int64_t>            ints;               // INT / DATETIME
+    std::vector<std::string_view>   dict;               // DICT：字典
+    std::vector<uint32_t>           codes;              // DICT：每行的字典编号
+    std::vector<std::string_view>   texts;              // PLAIN：每行的值
+
+    bool                is_null(size_t row) const { return nulls && (nulls[row >> 3] >> (row & 7) & 1); }
+    bool                is_dict() const { return !dict.empty() || !codes.empty(); }
+    std::string_view    text(size_t row) const { return is_dict() ? dict[codes[row]] : texts[row]; }
+};
+
+struct ColumnMeta
+{
+    std::string     name;
+    ColumnType      type = ColumnType::INT;
+    Encoding        encoding = Encoding::DELTA;
+    bool            has_nulls = false;
+    bool            has_minmax = false;     // 全为 NULL（或字符串过长）时没有
+    int64_t         min_int = 0;
+    int64_t         max_int = 0;
+    std::string     min_text;
+    std::string     max_text;
+    uint64_t        offset = 0;             // 相对段文件开头
+    uint64_t        length = 0;
+};
+
+/**
+ * @brief 把行编码为段文件内容；列类型按各列的非 NULL 值推断（有字符串即为 STRING）
+ */
+std::string         encode(const std::vector<std::string>& columns, const std::vector<SqlRow>& rows);
+
+/**
+ * @brief 只读的段视图：解析头部，按需解码列
+ *
+ * 不持有数据，data 须在视图使用期间有效（mmap 的文件或 encode 的结果）。
+ */
+class SegmentView
+{
+public:
+    bool                parse(const char* data, size_t size, std::string& error);
+
+    uint32_t            rows() const { return m_rows; }
+    const std::vector<ColumnMeta>& columns() const { return m_columns; }
+    int                 find(const std::string& column) const;    // 列下标，不存在返回 -1
+
+    bool                decode(int column, ColumnVector& out, std::string& error) const;
+
+private:
+    const char*             m_data = nullptr;
+    size_t                  m_size = 0;
+    uint32_t                m_rows = 0;
+    std::vector<ColumnMeta> m_columns;
+};
+
+/**
+ * @brief 只读 mmap 的文件
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool                open(const std::string& path, std::string& error);
+    const char*         data() const { return static_cast<const char*>(m_addr); }
+    size_t              size() const { return m_size; }
+
+private:
+    void*               m_addr = nullptr;
+    size_t              m_size = 0;
+};
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ColumnSegment.h"
+#include "SqlRow.h"
+
+/**
+ * @brief 列式存储参数
+ */
+struct ColumnStoreConfig
+{
+    size_t      segment_rows = 65536;       // 单个分区缓冲达到该行数即写出一个段
+    int64_t     flush_delay_ms = 10000;     // 缓冲最长停留时间，到期即写段（进程崩溃最多丢失这段时间的数据）
+    int         partition_hours = 24;       // 分区时长（小时，能整除 24），按本地时间对齐
+    int         retention_hours = 0;        // 超过该时长的分区整目录删除，0 表示不清理
+    size_t      max_unwritten_rows = 4 * 1024 * 1024;  // 写段失败（磁盘满等）后留在内存待重试的行数上限，超出时丢弃最早的
+};
+
+/**
+ * @brief 列式查询的过滤条件（多个条件为 AND）
+ */
+struct ColumnFilter
+{
+    enum class Op { EQ, NE, LT, LE, GT, GE };
+
+    std::string     column;
+    Op              op = Op::EQ;
+    SqlValue        value;                  // 与 INT/DATETIME 列比较时取整数（DATETIME 为 epoch 微秒）
+};
+
+/**
+ * @brief 聚合项，输出列名为 "op(column)"（COUNT 为 "count"）
+ */
+struct ColumnAggregate
+{
+    enum class Op { COUNT, SUM, MIN, MAX, AVG };
+
+    Op              op = Op::COUNT;
+    std::string     column;                 // COUNT 时忽略；其余须为 INT/DATETIME 列
+};
+
+struct ColumnQuery
+{
+    std::string                     table;
+    int64_t                         from_us = 0;        // timestamp 列范围 [from, to)，0 表示不限
+    int64_t                         to_us = 0;
+    std::vector<ColumnFilter>       filters;
+    std::vector<std::string>        columns;            // scan 的投影列，空为全部
+    std::vector<std::string>        group_by;           // aggregate 的分组列，空为整体聚合
+    std::vector<ColumnAggregate>    aggregates;
+    std::string                     order_by;           // aggregate 结果按该输出列降序，空为不排序
+    size_t                          limit = 1000;
+
+    /**
+     * 从请求 JSON 解析：{"table", "from", "to"（时间文本或 epoch 微秒）, "filters": [{"column","op","value"}],
+     * "columns", "group_by", "aggregates": [{"op","column"}], "order_by", "limit"}
+     */
+    static bool     from_json(const nlohmann::json& j, ColumnQuery& query, std::string& error);
+};
+
+/**
+ * @brief 嵌入式列式段存储：原始报文/会话/HTTP 记录的追加写入与扫描聚合
+ *
+ * 目录结构：<dir>/<表名>/<分区起点 YYYYMMDDHH>/<写出时间>-<序号>.seg，分区按 timestamp 列划分。
+ * 写入先进入按 (表, 分区) 的内存缓冲，满 segment_rows 行或超过 flush_delay_ms 后编码为一个不可变的段文件
+ * （临时文件 + rename），格式见 ColumnSegment.h。
+ * 查询 mmap 段文件只解码用到的列：先按分区目录与段内 timestamp 的 min/max 跳过不相关的段，
+ * 字典编码的字符串列对每个字典项只比较一次；尚未写出的缓冲行同样参与查询。
+ * 写段失败的缓冲不丢弃，隔 flush_delay_ms 后重试（期间照常参与查询），累计超过 max_unwritten_rows 时才丢弃最早的。
+ * 后台线程负责按时写段与按 retention_hours 删除过期分区。线程安全。
+ */
+class ColumnStore
+{
+public:
+    ColumnStore(const std::string& dir, const ColumnStoreConfig& config = ColumnStoreConfig());
+    ~ColumnStore();
+
+    // 进程内共享的实例：目录取环境变量 NETWORK_ANALYSE_COLUMN_STORE，未设置时返回 nullptr（不启用）；
+    // 分区保留天数取 NETWORK_ANALYSE_COLUMN_RETENTION_DAYS
+    static std::shared_ptr<ColumnStore> shared();
+
+    // 返回 false 表示表名非法，或写段失败后待重试的行超出上限而丢弃了数据
+    bool                append(const std::string& table, const std::vector<std::string>& columns,
+                               const std::vector<SqlRow>& rows);
+    void                flush();                // 写出全部缓冲
+
+    using RowCallback = std::function<bool(const std::vector<std::string>& columns, const SqlRow& row)>;
+
+    /**
+     * 逐行回调满足条件的记录，columns 为各值对应的列名（query.columns 为空时是所在段的全部列），
+     * 回调返回 false 或达到 limit 时停止
+     * @return 回调的行数，-1 出错（error 为原因）
+     */
+    int64_t             scan(const ColumnQuery& query, const RowCallback& callback, std::string& error);
+    /**
+     * 分组聚合，返回 JSON 数组（每组一个对象：分组列 + 各聚合项）；出错返回 null 并填写 error
+     */
+    nlohmann::json      aggregate(const ColumnQuery& query, std::string& error);
+    nlohmann::json      query(const nlohmann::json& request);   // JSON 请求：有 aggregates 时聚合，否则扫描
+
+    nlohmann::json      status() const;
+    const std::string&  dir() const { return m_dir; }
+
+private:
+    struct Buffer
+    {
+        std::vector<std::string>    columns;
+        std::vector<SqlRow>         rows;
+        int64_t                     first_us = 0;    // 第一行进入缓冲的时间
+    };
+    using BufferKey = std::pair<std::string, int64_t>;  // (表, 分区起点)
+
+    int64_t             partition_of(int64_t epoch_us) const;
+    std::string         partition_dir(const std::string& table, int64_t partition) const;
+    bool                write_segment(const std::string& table, int64_t partition, const Buffer& buffer);
+    // 写出一批缓冲，失败的放回 m_unwritten 等待重试；返回 false 表示有数据因超出上限被丢弃
+    bool                write_or_keep(std::vector<std::pair<BufferKey, Buffer>>& buffers);
+    void                flush_due(bool all);
+    void                drop_expired();
+    void                run();
+
+    // 依次访问与查询时间范围相关的段（包括缓冲行临时编码出的段），visitor 返回 false 时停止
+    bool                for_each_segment(const ColumnQuery& query,
+                                         const std::function<bool(const column_segment::SegmentView&)>& visitor,
+                                         std::string& error);
+
+    std::string                     m_dir;
+    ColumnStoreConfig               m_config;
+    mutable std::mutex              m_mutex;        // 保护缓冲与统计
+    std::map<BufferKey, Buffer>     m_buffers;
+    std::vector<std::pair<BufferKey, Buffer>> m_unwritten;     // 写段失败、等待重试的缓冲（先后顺序）
+    size_t                          m_unwritten_rows = 0;
+    uint64_t                        m_dropped_rows = 0;
+    uint64_t                        m_segment_seq = 0;
+    uint64_t                        m_rows_appended = 0;
+    uint64_t                        m_segments_written = 0;
+    uint64_t                        m_bytes_written = 0;
+    uint64_t                        m_write_failures = 0;
+
+    std::thread                     m_thread;
+    std::condition_variable         m_cv;
+    bool                            m_stop = false;
+};
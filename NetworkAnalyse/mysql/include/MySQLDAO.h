@@ -1,12 +1,25 @@
 #pragma once
 #include "MySQLPool.h"
+#include "BodyCodec.h"
+#include "BulkLoader.h"
+#include "SqlRow.h"
+#include "TimeFormat.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <optional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <vector>
 
 using json = nlohmann::json;
+class SpoolReplayer;
+class ColumnStore;
+class PartitionManager;
+
 struct HttpFlowInfo {
     std::string flow_id;
     int app_uid;
@@ -22,7 +35,8 @@ struct HttpFlowInfo {
     std::string method;
     int status_code;
     std::string content_type;
-    std::string start_time;
+    int64_t     start_time_us = 0;    // 请求开始时间（epoch 微秒）
+    std::string device;               // 来源设备序列号（adb 抓包时），本机网卡为空
 };
 struct HttpPacket {
     std::string flow_id;
@@ -30,11 +44,18 @@ struct HttpPacket {
     nlohmann::json headers;
     std::string top_protocol;
     std::string body;
-    std::string timestamp;
+    int64_t     timestamp_us = 0;     // epoch 微秒
     std::string content_type; // Content-Type header
     int length; 
 };
 
+// 从库中读出的 HTTP 报文：packet.body 为空，报文体在 body 中，读取时才解压
+struct HttpPacketRecord
+{
+    HttpPacket  packet;
+    StoredBody  body;
+};
+
 struct UserInfo 
 {
     std::string name;
@@ -48,7 +69,7 @@ struct UserInfo
 struct SessionInfo 
 {
     int app_uid;
-    std::string timestamp;
+    int64_t     timestamp_us = 0;     // 首包时间（epoch 微秒）
     std::string session_id;
     std::string protocol;
     std::string src_ip;
@@ -56,7 +77,27 @@ struct SessionInfo
     std::string dst_ip;
     int dst_port;
     int size;
-    std::time_t last_update_time; // 最后更新时间
+    std::string server_name;      // TLS/QUIC SNI（未知为空）
+    std::string device;           // 来源设备序列号（adb 抓包时），本机网卡为空
+    bool        initiator_known = false; // src 确为发起方（见到握手）；否则按端口推测
+    // 计数类字段与 size 相同，增量记录中为自上次输出以来的增量；up 为 src（发起方）->dst
+    uint64_t    packets_up = 0;
+    uint64_t    packets_down = 0;
+    uint64_t    bytes_up = 0;         // 负载字节
+    uint64_t    bytes_down = 0;
+    uint32_t    retransmissions = 0;  // 两个方向合计的重传段
+    uint32_t    out_of_order = 0;     // 两个方向合计的乱序段
+    uint32_t    zero_window = 0;      // 两个方向合计的零窗口通告
+    int64_t     handshake_rtt_us = 0; // 三次握手 RTT（SYN -> 最终 ACK），0 表示未观测到
+    int64_t     duration_us = 0;      // 首包到最近一包的时长
+    uint32_t    sample_rate = 1;      // 本条记录内报文的最大采样率，1 表示完整统计；计数均为实际解析的报文（未放大），
+                                      // 估算原始流量时乘以 sample_rate（流内采样时控制报文与大流前段按 1 保留，结果偏大）
+    std::string payload_fingerprint;  // UDP 流首个非空负载的前缀（十六进制），其余协议为空
+    std::string features;             // 分类特征 JSON（报文长度/间隔序列、突发统计），只在输出的那条记录中非空
+    int64_t     last_seen_us = 0;     // 最近一个报文的时间（epoch 微秒），写入 last_seen 列
+    std::string close_reason;     // 结束原因（fin/rst/idle/evicted/stop），活跃会话为空
+    std::time_t end_time = 0;     // 结束记录的最后活跃时间
+    bool        persisted = false; // 数据库中已有该会话行，可直接增量更新
 };
 
 class MySQLDAO {
@@ -82,14 +123,106 @@ public:
     int                 store_http(const json& j);
     int                 store_dns(const json& j);
 
+    // 批量写入：多张表的积压行在一个事务内提交（每张表一条多行 INSERT），返回写入行数，-1 出错
+    int                 insert_row_batches(const std::vector<RowBatch>& batches);
+    // 报文 JSON -> 批量写入行，列与 store_dns / store_icmp 相同
+    static const BatchTable&    dns_packets_table();
+    static SqlRow               dns_packet_row(const json& j);
+    static const BatchTable&    icmp_packets_table();
+    static SqlRow               icmp_packet_row(const json& j);
+    // 会话 / HTTP 记录 -> 行（列式存储后端使用），列与 MySQL 中同名表一致
+    static const BatchTable&    session_info_table();
+    static SqlRow               session_row(const SessionInfo& session);
+    static const BatchTable&    http_flow_table();
+    static SqlRow               http_flow_row(const HttpFlowInfo& info);
+    static const BatchTable&    http_packets_table();
+    static SqlRow               http_packet_row(const HttpPacket& packet);
+    MySqlEndpoint               endpoint() const;   // 连接参数（供 BulkLoader 建立 C API 连接）
+    json                        pool_status() const;    // 共享连接池的就绪状态与统计
+
     //存储会话
     int                 insert_or_update_session_info(const SessionInfo& session);
+    // 批量写入：多行 INSERT ... ON DUPLICATE KEY UPDATE，单个事务内完成；全部写入时返回记录数，否则 -1，
+    // 没写入的记录追加到 failed（无唯一索引逐条写入时可能只是部分记录）
+    int                 insert_or_update_session_infos(const std::vector<SessionInfo>& sessions,
+                                                       std::vector<SessionInfo>* failed = nullptr);
     // int                 insert_session_resource(const std::string& session_id, const std::string& resource);
     // int                 insert_session_packet(const std::string& session_id, const json& packet);
     
     //存储请求响应报文
     bool                 insert_http_flow_info(const HttpFlowInfo& info);
     bool                 insert_http_packet(const HttpPacket& pkt);
+    // 一个事务内写入一组 flow 与报文，返回写入条数；数据被拒时回滚后逐条重写，出错的记录记日志后丢弃。
+    // 遇到暂时性错误（见 is_transient）返回 -1，没写入的记录追加到 unwritten_*，供调用方转存
+    int                  insert_http_exchanges(const std::vector<HttpFlowInfo>& flows, const std::vector<HttpPacket>& packets,
+                                               std::vector<HttpFlowInfo>* unwritten_flows = nullptr,
+                                               std::vector<HttpPacket>* unwritten_packets = nullptr);
+    // 报文体按 Content-Type 用 zstd（及该类训练出的字典）压缩后存入 body_data，body_codec 记录编码（见 BodyCodec.h）
+    std::vector<HttpPacketRecord> get_http_packets(const std::string& flow_id);    // 按时间排序，出错返回空
+    json                 body_compression_status();     // 各内容类别的压缩率与字典
+
+    // 写入失败或本地暂存区仍有积压时转存暂存区（见 SpoolReplayer），由后台按序回放，写入方不等待数据库恢复
+    // 启用列式存储（column_store() 非空）时报文、会话与 HTTP 记录改写入列式段文件，MySQL 只保留用户与应用信息
+    // 返回 1 已写入，0 已转存待回放，-1 两者都失败（数据丢弃）
+    int                 store_row_batches(const std::vector<RowBatch>& batches);
+    int                 store_session_infos(const std::vector<SessionInfo>& sessions);
+    int                 store_http_exchanges(const std::vector<HttpFlowInfo>& flows, const std::vector<HttpPacket>& packets);
+    json                spool_status();         // 暂存区积压与回放统计
+    // 大批量写入：经 loader 导入临时表，再与新的批次 id 在一个事务内合并进目标表（BulkLoader::Mode::MERGE）
+    // 返回 1 已写入，0 提交结果丢失、已以同一 id 转存暂存区（回放时按 id 去重），
+    // -1 确定没有写入（暂存区有积压、无法去重或导入失败），调用方改用 store_row_batches / store_session_infos，
+    // -2 结果丢失且转存失败（数据可能丢失）；启用列式存储时不要调用
+    int                 bulk_store_rows(BulkLoader& loader, const RowBatch& batch);
+    int                 bulk_store_sessions(BulkLoader& loader, const std::vector<SessionInfo>& sessions);
+    ColumnStore*        column_store();         // 进程内共享的列式存储，未启用时为 nullptr（见 ColumnStore::shared）
+    json                partition_status() const;   // 分区维护状态，未启用（见 PartitionManager::shared）时为 null
+
+    // 回放一个暂存批次（SpoolReplayer 调用）：批次 id 与数据同一事务写入 spool_applied，重复回放被跳过
+    // 返回 1 已写入，0 此前已写入，-1 数据库暂不可用（稍后重试），-2 批次无法写入（解码失败或数据被拒）；
+    // 批次只写入一部分（逐条写入的会话）时返回 1，其余记录放在 requeue 中，由调用方重新暂存
+    int                 apply_spooled(const json& batch, json& requeue);
+    int                 purge_spool_markers(int64_t older_than_sec);    // 删除早于该时长的回放记录，返回删除行数
 private:
-    std::unique_ptr<MySqlPool> m_pool;
+    // 确保表中存在指定列（列名, 列定义），旧库缺失时自动补齐；定义为 DATETIME(6) 而已有列精度更低时加宽
+    bool                ensure_columns(const std::string& table,
+                                       const std::vector<std::pair<std::string, std::string>>& columns);
+    // 确保 column 上有唯一索引（分区表为 (column, timestamp)），已有重复数据无法建立时返回 false
+    bool                ensure_unique_index(const std::string& table, const std::string& index,
+                                            const std::string& column);
+    bool                ensure_session_schema();    // session_info 的补列与 session_id 唯一索引，失败时逐条写入并稍后重试
+    bool                ensure_spool_schema();      // 建 spool_applied 表，失败（库不可用）时下次重试
+    bool                ensure_http_body_schema();  // HTTP 表的压缩列、微秒时间与字典表，失败时按原文写入并稍后重试
+    void                migrate_http_times(PooledConnection& conn);     // 旧库中 ZMQ 来源的 UTC 时间一次性换算为本地时间
+    bool                ensure_row_schema();        // dns_packets / icmp_packets 的微秒时间与 device 列，失败时稍后重试
+    BodyCompressor*     body_compressor();          // 进程内共享的报文体压缩器（字典存于 http_body_dicts）
+    SpoolReplayer*      spool();                    // 首次使用时取进程内共享的暂存区
+    // bulk_store_* 的公共部分，spooled 只在结果丢失需要转存时调用
+    int                 bulk_merge(BulkLoader& loader, const BatchTable& table, const std::vector<SqlRow>& rows,
+                                   const std::string& on_duplicate, const std::function<json()>& spooled);
+
+    // 以下在调用方的连接（与事务）内写入，出错抛 sql::SQLException
+    int                 write_row_batches(PooledConnection& conn, const std::vector<RowBatch>& batches);
+    int                 write_session_upserts(PooledConnection& conn, const std::vector<SessionInfo>& sessions);
+    void                write_http_flow(PooledConnection& conn, const HttpFlowInfo& info);
+    void                write_http_packet(PooledConnection& conn, const HttpPacket& packet);
+
+    static const size_t SESSION_BATCH_ROWS = 500;   // 单条多行 INSERT 的最大行数（28 个占位符/行）
+    static constexpr int64_t SCHEMA_RETRY_US = 60 * 1000000LL;     // 改表失败（库不可用、无权限）后的重试间隔
+
+    std::shared_ptr<MySqlPool> m_pool;     // 进程内共享的连接池（MySqlPool::shared）
+    std::atomic<bool>          m_session_schema_ready{false};
+    std::atomic<int64_t>       m_session_schema_retry_us{0};
+    std::atomic<bool>          m_session_unique{false};    // session_id 唯一索引可用，批量 upsert 依赖它
+    std::atomic<bool>          m_spool_schema_ready{false};
+    std::atomic<bool>          m_http_body_schema_ready{false};
+    std::atomic<int64_t>       m_http_body_retry_us{0};     // 建表失败后下次重试的时间
+    std::atomic<bool>          m_row_schema_ready{false};
+    std::atomic<int64_t>       m_row_schema_retry_us{0};
+    std::once_flag             m_body_compressor_once;
+    std::shared_ptr<BodyCompressor> m_body_compressor;
+    std::once_flag             m_spool_once;
+    std::shared_ptr<SpoolReplayer> m_spool;                 // 按目录共享，见 spool()
+    std::once_flag             m_column_store_once;
+    std::shared_ptr<ColumnStore> m_column_store;
+    std::shared_ptr<PartitionManager> m_partitions;         // 按 timestamp 分区的表的维护，随 DAO 启动
 };
@@ -8,139 +8,246 @@
 #include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 
+#include <chrono>               // std::chrono::steady_clock
+#include <cstdint>              // uint64_t
 #include <memory>               // std::unique_ptr
-#include <queue>                // std::queue
+#include <string>               // std::string
+#include <deque>                // std::deque
+#include <list>                 // std::list
+#include <unordered_map>        // std::unordered_map
+#include <vector>               // std::vector
 #include <mutex>                // std::mutex, std::unique_lock
 #include <condition_variable>   // std::condition_variable
 #include <atomic>               // std::atomic
-#include <iostream>             // std::cerr
+#include <thread>               // std::thread
+
+/**
+ * @brief 连接池中的一条连接及其预编译语句缓存
+ *
+ * 语句以 SQL 文本为 ID，首次使用时在本连接上 prepare，之后取出缓存的语句清空参数重新绑定即可执行，
+ * 省去每次调用的 prepare 往返与服务端解析。语句归属于连接，reset() 换连接时全部作废。
+ * 缓存按最近使用淘汰，最多 MAX_STATEMENTS 条（服务端 max_prepared_stmt_count 是全局上限）。
+ * 非线程安全：同一时刻只被借出它的线程使用。
+ */
+class PooledConnection {
+public:
+    static const size_t MAX_STATEMENTS = 128;
+
+    explicit PooledConnection(std::unique_ptr<sql::Connection> con);
+
+    sql::Connection* connection() const { return m_con.get(); }
+
+    /**
+     * 取 sql 对应的预编译语句（参数已清空），未缓存时 prepare 并放入缓存
+     * 返回的指针归连接所有，仅在本次借用期间有效；prepare 失败抛 sql::SQLException
+     */
+    sql::PreparedStatement* prepare(const std::string& sql);
+
+    /**
+     * 换上新连接（重连后），旧连接上的语句全部作废
+     */
+    void reset(std::unique_ptr<sql::Connection> con);
+
+    size_t   cached_statements() const { return m_statements.size(); }
+    uint64_t prepares() const { return m_prepares; }    // 实际 prepare 次数
+    uint64_t hits() const { return m_hits; }            // 命中缓存次数
+
+    std::chrono::steady_clock::time_point last_used() const { return m_last_used; }
+    void touch() { m_last_used = std::chrono::steady_clock::now(); }
+
+private:
+    struct Statement {
+        std::unique_ptr<sql::PreparedStatement> stmt;
+        std::list<const std::string*>::iterator lru;
+    };
+
+    // 声明顺序保证析构时语句先于连接释放
+    std::unique_ptr<sql::Connection> m_con;
+    std::unordered_map<std::string, Statement> m_statements;   // SQL -> 语句
+    std::list<const std::string*> m_lru;                        // 指向 m_statements 的键，最近使用在前
+    uint64_t m_prepares = 0;
+    uint64_t m_hits = 0;
+    std::chrono::steady_clock::time_point m_last_used;          // 最近一次归还（或建立）的时间
+};
 
+class MySqlPool;
+
+/**
+ * @brief 借出的连接：离开作用域时自动归还连接池
+ *
+ * 可移动不可复制。借用失败（池关闭、超时或无法建立连接）时为空，if (!conn) 判断。
+ */
+class ConnectionLease {
+public:
+    ConnectionLease() = default;
+    ConnectionLease(MySqlPool* pool, std::unique_ptr<PooledConnection> con);
+    ConnectionLease(ConnectionLease&& other) noexcept;
+    ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+    ~ConnectionLease();
+
+    explicit operator bool() const { return m_con != nullptr; }
+    PooledConnection* operator->() const { return m_con.get(); }
+    PooledConnection& operator*() const { return *m_con; }
+
+    void release();     // 提前归还（如递归调用前），之后 lease 为空
+
+private:
+    MySqlPool* m_pool = nullptr;
+    std::unique_ptr<PooledConnection> m_con;
+};
+
+/**
+ * @brief 连接池参数
+ */
+struct MySqlPoolConfig {
+    int     min_size = 2;                   // 常驻连接数，启动时建立，空闲回收不低于该值
+    int     max_size = 10;                  // 连接数上限，借用时按需扩容
+    int64_t acquire_timeout_ms = 5000;      // 借用等待上限，超时返回空连接；<= 0 表示一直等待
+    int64_t idle_timeout_ms = 60000;        // 超出 min_size 的连接空闲超过该时长即关闭
+    int64_t validate_idle_ms = 5000;        // 空闲超过该时长的连接借出前先 ping，失败则重连
+
+    static MySqlPoolConfig for_size(int pool_size);   // 旧接口的 poolSize：作为上限，常驻连接取 min(poolSize, 2)
+};
+
+/**
+ * @brief 连接池统计（stats() 返回快照）
+ */
+struct MySqlPoolStats {
+    int      total = 0;             // 当前连接数（含借出的）
+    int      idle = 0;              // 空闲连接数
+    uint64_t acquired = 0;          // 借用成功次数
+    uint64_t timeouts = 0;          // 借用超时次数
+    uint64_t waits = 0;             // 需要等待的借用次数
+    uint64_t wait_us_total = 0;     // 借用等待总时长
+    uint64_t wait_us_max = 0;       // 单次借用最长等待
+    uint64_t created = 0;           // 新建连接数
+    uint64_t reconnects = 0;        // ping 失败后重连次数
+    uint64_t closed_idle = 0;       // 空闲回收关闭的连接数
+    uint64_t failures = 0;          // 建立/重建连接失败次数
+};
+
+/**
+ * @brief MySQL 连接池
+ *
+ * 进程内按 (url, user, schema) 共享：DAO 通过 shared() 取得同一个池，不再各自建池。
+ * 构造时不阻塞：常驻连接由后台线程并行建立（预热），state() / wait_ready() 查询就绪状态；
+ * 预热期间借用会等待先建好的连接，min_size 为 0 时完全按需建立。
+ */
 class MySqlPool:public std::enable_shared_from_this<MySqlPool> {
     // 友元类，允许 MySQLDAO 访问私有成员
     friend class MySQLDAO;
+    friend class ConnectionLease;
 
 public:
+    enum class State {
+        CONNECTING,     // 常驻连接预热中
+        READY,          // 至少有一条连接建立成功（或无需预热）
+        FAILED,         // 预热全部失败；之后借用仍会按需重试，成功即转为 READY
+    };
+
+    /**
+     * 取进程内共享的连接池，相同 (url, user, schema) 复用同一个实例，
+     * 最后一个使用者释放后连接池关闭；已存在时忽略 config
+     */
+    static std::shared_ptr<MySqlPool> shared(const std::string& url, const std::string& user,
+                                             const std::string& pass, const std::string& schema,
+                                             const MySqlPoolConfig& config = MySqlPoolConfig());
+
     /**
      * 构造函数：初始化连接池
      * @param url      数据库地址，如 "tcp://127.0.0.1:3306"
      * @param user     数据库用户名
      * @param pass     数据库密码
      * @param schema   默认使用的数据库名
-     * @param poolSize 连接池中连接的数量
+     * @param poolSize 连接池中连接数的上限（常驻连接取 min(poolSize, 2)）
+     * 一般通过 shared() 获取，不直接构造
      */
     MySqlPool(const std::string& url, const std::string& user,
               const std::string& pass, const std::string& schema,
-              int poolSize)
-        : m_url(url)
-        , m_user(user)
-        , m_pass(pass)
-        , m_schema(schema)
-        , m_poolSize(poolSize)
-        , b_stop_(false) 
-    {
-        try
-         {
-            // 初始化连接池中的连接
-            for (int i = 0; i < m_poolSize; ++i) 
-            {
-                // 获取 MySQL 驱动实例
-                sql::mysql::MySQL_Driver* driver = sql::mysql::get_mysql_driver_instance();
-
-                // 建立连接
-                std::unique_ptr<sql::Connection> con(driver->connect(m_url, m_user, m_pass));
-                
-                // 设置默认数据库
-                con->setSchema(m_schema);
-
-                // 设置字符集（避免乱码）
-                con->setClientOption("CHARSET", "utf8mb4");
-
-                // 将连接放入连接池队列中
-                m_pool.push(std::move(con));
-            }
-        } 
-        catch (sql::SQLException& e) 
-        {
-            std::cerr << "[MySqlPool] 初始化失败: " << e.what() << std::endl;
-        }
-    }
+              int poolSize);
+
+    MySqlPool(const std::string& url, const std::string& user,
+              const std::string& pass, const std::string& schema,
+              const MySqlPoolConfig& config);
 
     /**
-     * 获取连接：线程安全，若连接池为空则等待
-     * @return 数据库连接指针（unique_ptr），调用者需负责归还
+     * 获取连接：线程安全。优先复用空闲连接，不足且未达上限时新建，否则等待归还；
+     * 空闲较久的连接先 ping 校验，失效则重连（语句缓存随之作废）
+     * @return 借出的连接，离开作用域自动归还；池关闭、等待超时或无法建立连接时为空
      */
-    std::unique_ptr<sql::Connection> get_connection() 
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        
-        // 等待直到有连接可用或停止标志触发
-        m_cond.wait(lock, [this] {
-            return b_stop_ || !m_pool.empty();
-        });
-
-        // 若池已关闭或空，返回空指针
-        if (b_stop_ || m_pool.empty()) 
-        {
-            return nullptr;
-        }
-
-        // 获取连接
-        std::unique_ptr<sql::Connection> con = std::move(m_pool.front());
-        m_pool.pop();
-        return con;
-    }
+    ConnectionLease get_connection();
 
     /**
-     * 归还连接：将连接放回池中
-     * @param con 数据库连接指针（unique_ptr）
+     * 重建连接：换上新的物理连接并清空其语句缓存，失败时保留原连接
+     * @return 是否成功
      */
-    void return_connection(std::unique_ptr<sql::Connection> con) 
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (!b_stop_) {
-            m_pool.push(std::move(con));
-            m_cond.notify_one();  // 通知等待线程
-        }
-    }
+    bool reconnect(PooledConnection& con);
+
+    MySqlPoolStats stats() const;
+
+    State state() const;
+
+    /**
+     * 等待预热结束（最多 timeout_ms 毫秒）
+     * @return 是否已就绪（READY）
+     */
+    bool wait_ready(int64_t timeout_ms);
 
     /**
      * 主动关闭连接池，唤醒所有等待线程
      */
-    void Close() 
-    {
-        {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            b_stop_ = true;  // 设置关闭标志
-        }
-        m_cond.notify_all();  // 唤醒所有可能在等待连接的线程
-    }
+    void Close();
 
     /**
      * 析构函数：清理资源
      * 自动清空连接池（连接由 unique_ptr 管理，自动关闭）
      */
-    ~MySqlPool() 
-    {
-        Close();  // 确保池关闭
-        std::unique_lock<std::mutex> lock(m_mutex);
-        while (!m_pool.empty()) {
-            m_pool.pop();  // 连接会自动释放
-        }
-    }
+    ~MySqlPool();
 
 private:
+    /**
+     * 归还连接（由 ConnectionLease 调用）：放回空闲队列并回收空闲过久的多余连接
+     */
+    void return_connection(std::unique_ptr<PooledConnection> con);
+
+    /**
+     * 建立一条新连接（设置默认库与字符集），失败抛 sql::SQLException
+     */
+    std::unique_ptr<sql::Connection> create_connection();
+
+    /**
+     * 借出前校验：空闲超过 validate_idle_ms 时 ping，失效则重连；重连失败返回 false
+     */
+    bool validate(PooledConnection& con);
+
+    /**
+     * 预热：并行建立 min_size 条常驻连接，结束后更新 m_state（在 m_warmup 线程中运行）
+     */
+    void warm_up();
+
+    /**
+     * 取出空闲过久且超出 min_size 的连接（调用方持锁，在锁外释放返回的连接）
+     */
+    std::vector<std::unique_ptr<PooledConnection>> take_expired_locked();
+
     // 数据库连接信息
     std::string m_url;      // 数据库地址
     std::string m_user;     // 用户名
     std::string m_pass;     // 密码
     std::string m_schema;   // 默认数据库
-    int m_poolSize;         // 连接池大小
+    MySqlPoolConfig m_config;
 
-    // 连接池核心结构
-    std::queue<std::unique_ptr<sql::Connection>> m_pool; // 连接队列
+    // 连接池核心结构：空闲连接后进先出，最久未用的在队尾，便于回收
+    std::deque<std::unique_ptr<PooledConnection>> m_pool; // 空闲连接
+    int m_total = 0;                    // 当前连接数（空闲 + 借出 + 正在建立）
 
     // 多线程同步机制
-    std::mutex m_mutex;                 // 用于保护队列访问的互斥锁
+    mutable std::mutex m_mutex;         // 用于保护队列访问的互斥锁
     std::condition_variable m_cond;     // 用于线程等待和通知
-    std::atomic<bool> b_stop_;         // 标记连接池是否关闭
+    std::atomic<bool> b_stop_;          // 标记连接池是否关闭
+    MySqlPoolStats m_stats;             // 统计，m_mutex 保护（total/idle 在 stats() 中填充）
+    State m_state = State::CONNECTING;  // m_mutex 保护，变化时 notify_all
+    std::thread m_warmup;               // 预热线程，析构时 join
 };
@@ -0,0 +1,100 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MySQLPool.h"
+
+/**
+ * @brief 单张表的分区策略
+ */
+struct PartitionPolicy
+{
+    std::string     table;
+    int             partition_hours = 24;   // 分区时长（小时，能整除 24：1 为按小时，24 为按天），按本地时间对齐
+    int             retention_hours = 0;    // 上界早于 now - retention 的分区整体删除，0 表示不清理
+    int             precreate = 3;          // 当前分区之后提前建好的分区数
+};
+
+/**
+ * @brief 按 timestamp 列 RANGE 分区的表的维护：提前建分区、按保留时长删除过期分区
+ *
+ * 分区形如 PARTITION p<起点 YYYYMMDDHH> VALUES LESS THAN ('<下一起点>')，最后是 pmax（MAXVALUE）。
+ * 新分区由 REORGANIZE PARTITION pmax 拆出（pmax 为空，不搬数据）；过期分区 DROP PARTITION，
+ * 代替对大表的 DELETE。按时间范围的查询由分区裁剪只扫相关分区。
+ *
+ * 尚未分区的表首次维护时转换（整表重建一次，耗时与表大小相关）：
+ *  - MySQL 要求分区列出现在每个唯一索引中：主键与唯一索引补上 timestamp 列（session_id 唯一索引变为
+ *    (session_id, timestamp)，同一会话的首包时间不变，upsert 仍然命中）
+ *  - 主键列必须 NOT NULL：已有的 NULL 时间改为 1970-01-02（归入最早的分区），并建 BEFORE INSERT 触发器
+ *    把未知时间（写入 NULL）补为写入时刻；触发器建不了（权限不足）时不转换
+ *  - timestamp 不是 DATETIME、已按其他方式分区或有外键的表跳过并记录原因
+ * 后台线程启动时维护一次，之后每 interval_sec 秒一次。
+ */
+class PartitionManager
+{
+public:
+    static constexpr int64_t DEFAULT_INTERVAL_SEC = 3600;
+    static constexpr int64_t RETRY_INTERVAL_SEC = 60;      // 有表维护出错（如库不可用）时提前重试
+
+    PartitionManager(std::shared_ptr<MySqlPool> pool, std::vector<PartitionPolicy> policies,
+                     int64_t interval_sec = DEFAULT_INTERVAL_SEC);
+    ~PartitionManager();
+
+    /**
+     * 进程内共享的实例：策略取环境变量 NETWORK_ANALYSE_PARTITIONS，未设置时返回 nullptr（不启用）。
+     * 取值 "default" 为 dns_packets / http_packets / http_flow_info / session_info 按天分区、
+     * 分别保留 30 / 7 / 30 / 90 天；或逗号分隔的 "表:分区小时:保留时长"，
+     * 保留时长以 d（天，默认）或 h（小时）结尾，0 表示不清理，如 "http_packets:1:72h,dns_packets:24:30"
+     */
+    static std::shared_ptr<PartitionManager> shared(const std::shared_ptr<MySqlPool>& pool);
+    static bool         parse_policies(const std::string& spec, std::vector<PartitionPolicy>& policies,
+                                       std::string& error);
+
+    int                 maintain();             // 立即维护全部表，返回成功的表数
+    nlohmann::json      status() const;
+
+private:
+    struct Bound
+    {
+        std::string     name;
+        int64_t         upper = 0;              // VALUES LESS THAN 的 epoch 秒，MAXVALUE 为 INT64_MAX
+    };
+
+    struct TableState
+    {
+        std::string     state = "pending";      // partitioned / skipped（不满足分区条件）/ error（下次重试）
+        std::string     message;                // skipped / error 的原因
+        size_t          partitions = 0;
+        int64_t         oldest_upper = 0;       // 最早分区的上界（epoch 秒）
+        int64_t         newest_upper = 0;       // 最后一个有限上界
+        uint64_t        created = 0;            // 累计新建分区数
+        uint64_t        dropped = 0;            // 累计删除分区数
+        int64_t         last_run_us = 0;
+    };
+
+    bool                maintain_table(PooledConnection& conn, const PartitionPolicy& policy, TableState& state);
+    bool                convert_table(PooledConnection& conn, const PartitionPolicy& policy, TableState& state);
+    // 以下按 DDL 的结果同步修改 bounds
+    void                add_partitions(PooledConnection& conn, const PartitionPolicy& policy,
+                                       std::vector<Bound>& bounds, TableState& state);
+    void                drop_expired(PooledConnection& conn, const PartitionPolicy& policy,
+                                     std::vector<Bound>& bounds, TableState& state);
+    void                run();
+
+    std::shared_ptr<MySqlPool>          m_pool;
+    std::vector<PartitionPolicy>        m_policies;
+    int64_t                             m_interval_sec;
+
+    mutable std::mutex                  m_mutex;        // 保护 m_states 与 m_stop
+    std::map<std::string, TableState>   m_states;
+    std::mutex                          m_run_mutex;    // 串行化 maintain()
+    std::thread                         m_thread;
+    std::condition_variable             m_cv;
+    bool                                m_stop = false;
+};
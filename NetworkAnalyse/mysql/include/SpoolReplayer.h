@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "BulkLoader.h"
+#include "WriteSpool.h"
+
+class MySQLDAO;
+
+/**
+ * @brief 写入暂存与后台回放
+ *
+ * 写库失败（或暂存区仍有积压、需保持先后顺序）的批次以 JSON 追加到 WriteSpool，
+ * 后台线程按顺序取出交给 MySQLDAO::apply_spooled 回放：
+ *  - 每个批次带唯一 id，回放与 spool_applied 表中的 id 记录在同一事务内提交，重复回放会被跳过
+ *  - 数据库不可用时指数退避重试（最长 MAX_BACKOFF_MS），不丢弃
+ *  - 数据本身无法写入的批次转存 rejected.jsonl，避免堵住后续批次
+ *  - 只写入了一部分的批次（无唯一索引时逐条写入的会话），未写入的记录作为新批次追加到队尾
+ *  - 暂存区排空后清理超过 MARKER_RETENTION_SEC 的 spool_applied 记录
+ * 进程内按目录共享（shared()），最后一个使用者释放时停止回放线程。
+ */
+class SpoolReplayer
+{
+public:
+    static constexpr int64_t MAX_BACKOFF_MS = 30000;
+    static constexpr int64_t MARKER_RETENTION_SEC = 7 * 24 * 3600;    // spool_applied 记录保留时长，每次排空后清理
+
+    SpoolReplayer(const std::string& dir, const MySqlEndpoint& endpoint);
+    ~SpoolReplayer();
+
+    // 暂存目录：环境变量 NETWORK_ANALYSE_SPOOL_DIR，默认 ./spool
+    static std::string  default_dir();
+    static std::shared_ptr<SpoolReplayer> shared(const std::string& dir, const MySqlEndpoint& endpoint);
+
+    bool                append(nlohmann::json batch);   // 没有 id 时补上，落盘并唤醒回放线程
+    std::string         next_id();                      // 新的批次 id（结果未知的批量导入以同一 id 转存）
+    bool                backlogged() const;             // 暂存区还有未回放的批次
+    bool                is_open() const { return m_open; }
+    nlohmann::json      status() const;
+
+private:
+    void                run();
+    void                reject(const std::string& payload);
+
+    WriteSpool                  m_spool;
+    std::unique_ptr<MySQLDAO>   m_dao;                  // 回放专用，与写入方共享连接池
+    bool                        m_open = false;
+    std::string                 m_id_prefix;            // 批次 id 前缀（启动时间 + pid），保证跨进程唯一
+    std::atomic<uint64_t>       m_next_id{0};
+
+    std::thread                 m_thread;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_cv;
+    bool                        m_stop = false;
+
+    std::atomic<uint64_t>       m_spooled{0};           // 追加的批次数
+    std::atomic<uint64_t>       m_replayed{0};          // 回放写入的批次数
+    std::atomic<uint64_t>       m_duplicates{0};        // 已写入过而跳过的批次数
+    std::atomic<uint64_t>       m_rejected{0};          // 无法写入而转存 rejected.jsonl 的批次数
+};
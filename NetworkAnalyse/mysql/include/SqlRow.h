@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 批量写入的一列值，类型决定绑定方式
+ */
+struct SqlValue
+{
+    enum class Type : uint8_t { NUL, INT, UINT, STRING, DATETIME };
+
+    Type        type = Type::NUL;
+    int64_t     i = 0;              // INT，DATETIME 时为 epoch 微秒（0 写 NULL）
+    uint64_t    u = 0;              // UINT
+    std::string s;                  // STRING
+
+    static SqlValue null()                      { return SqlValue(); }
+    static SqlValue integer(int64_t v)          { SqlValue x; x.type = Type::INT; x.i = v; return x; }
+    static SqlValue uinteger(uint64_t v)        { SqlValue x; x.type = Type::UINT; x.u = v; return x; }
+    static SqlValue text(std::string v)         { SqlValue x; x.type = Type::STRING; x.s = std::move(v); return x; }
+    static SqlValue datetime_us(int64_t v)      { SqlValue x; x.type = Type::DATETIME; x.i = v; return x; }
+};
+
+using SqlRow = std::vector<SqlValue>;
+
+/**
+ * @brief 批量写入的目标表：列顺序与 SqlRow 中值的顺序一致
+ */
+struct BatchTable
+{
+    std::string                 name;
+    std::vector<std::string>    columns;
+};
+
+/**
+ * @brief 同一张表的一组待写入行
+ */
+struct RowBatch
+{
+    const BatchTable*           table = nullptr;
+    std::vector<SqlRow>         rows;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <sys/time.h>
+
+/*
+    @brief
+    时间戳统一以 epoch 微秒（int64）在各模块间传递，只在写库时转为 DATETIME 文本
+    DATETIME 列一律为本进程本地时区的时间（mitmproxy 送来的 UTC 时间同样换算），精度到微秒；
+    旧库中按 UTC 文本写入的 HTTP 记录由 MySQLDAO 首次改表时一次性换算
+*/
+
+inline int64_t timeval_to_us(const timeval& tv)
+{
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+int64_t             now_us();                                           // 当前时间（epoch 微秒）
+
+/**
+ * @brief 解析时间文本为 epoch 微秒
+ *
+ * 支持 "2025-05-25T07:50:41.520134Z"（mitmproxy）、带 ±HH:MM 时区偏移的 ISO 8601，
+ * 以及 "2025-05-25 07:50:41[.ffffff]"（无时区，按本地时间）。
+ * @return 格式不符时返回 false
+ */
+bool                parse_datetime_us(const std::string& text, int64_t& epoch_us);
+
+/**
+ * @brief epoch 微秒 -> "YYYY-MM-DD HH:MM:SS.ffffff"（本地时区）
+ *
+ * 缓存上一次的秒级前缀，同一秒内只改写微秒部分，不调用 localtime。
+ * 非线程安全，每个线程使用各自的实例（见 format_datetime_us）。
+ */
+class DateTimeFormatter
+{
+public:
+    const std::string&  format(int64_t epoch_us);
+
+private:
+    int64_t             m_second = INT64_MIN;   // 缓存前缀对应的秒
+    std::string         m_text;
+};
+
+std::string         format_datetime_us(int64_t epoch_us);              // 线程局部的格式化器，0 返回空串
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 本地只追加的写入暂存区（spool），数据库不可用时保存待写批次
+ *
+ * 目录下按序号分段：segment-<序号>.spool，每条记录为
+ *   magic(4) | 长度(4) | CRC32(4) | 负载
+ * 整数为本机字节序（spool 只在本机回放）。每次追加后 fdatasync，进程崩溃最多丢失正在写的一条。
+ * 读取进度保存在 checkpoint 文件（先写临时文件再 rename），完全消费的分段即删除。
+ * 打开时总是新开一个分段追加，旧分段末尾可能的残缺记录只会被读端跳过。
+ * 线程安全：追加与读取共用一把锁。
+ */
+class WriteSpool
+{
+public:
+    static const size_t DEFAULT_SEGMENT_BYTES = 64 * 1024 * 1024;   // 分段达到该大小后换新分段
+
+    explicit WriteSpool(const std::string& dir, size_t segment_bytes = DEFAULT_SEGMENT_BYTES);
+    ~WriteSpool();
+
+    bool                open(std::string& error);           // 创建目录、恢复读取进度
+    void                close();
+
+    bool                append(const std::string& payload); // 追加一条记录并落盘
+    bool                peek(std::string& payload);         // 读取下一条未消费的记录（不前进）
+    bool                commit();                           // 确认 peek 到的记录已处理，推进并保存进度
+
+    bool                empty() const;
+    uint64_t            pending_bytes() const;              // 未消费的字节数（含帧头）
+    uint64_t            skipped_records() const;            // 校验失败被跳过的记录数
+    const std::string&  dir() const { return m_dir; }
+
+private:
+    std::string         segment_path(uint64_t segment) const;
+    bool                open_write_segment(uint64_t segment);
+    bool                save_checkpoint();
+    void                finish_read_segment();              // 读端离开当前分段：删除它并移到下一个
+
+    std::string         m_dir;
+    size_t              m_segment_bytes;
+    mutable std::mutex  m_mutex;
+    bool                m_open = false;
+
+    std::vector<uint64_t> m_segments;                       // 现存分段序号（升序）
+    int                 m_write_fd = -1;
+    uint64_t            m_write_segment = 0;
+    uint64_t            m_write_offset = 0;
+
+    int                 m_read_fd = -1;
+    uint64_t            m_read_segment = 0;
+    uint64_t            m_read_offset = 0;
+    uint64_t            m_peek_end = 0;                     // peek 到的记录结束位置，0 表示没有
+    uint64_t            m_pending = 0;
+    uint64_t            m_skipped = 0;
+};
@@ -0,0 +1,106 @@
+#include "BatchWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+BatchWriter::BatchWriter(MySQLDAO& dao, const BatchWriterConfig& config)
+    : m_dao(dao)
+    , m_config(config)
+    , m_batch_rows(std::min(std::max(config.initial_rows, config.min_rows), config.max_rows))
+{
+    // 列式存储后端不经过 MySQL，无需 LOAD DATA
+    if (m_config.bulk_min_rows > 0 && !m_dao.column_store()) m_bulk.reset(new BulkLoader(dao.endpoint()));
+}
+
+BatchWriter::~BatchWriter()
+{
+    flush();
+}
+
+int BatchWriter::add_table(const BatchTable& table)
+{
+    m_defs.push_back(table);
+    RowBatch batch;
+    batch.table = &m_defs.back();
+    m_tables.push_back(std::move(batch));
+    return static_cast<int>(m_tables.size()) - 1;
+}
+
+void BatchWriter::add(int table, SqlRow row, int64_t now_us)
+{
+    if (table < 0 || static_cast<size_t>(table) >= m_tables.size()) return;
+    if (m_pending_rows == 0) m_oldest_us = now_us;
+    m_tables[table].rows.push_back(std::move(row));
+    if (++m_pending_rows >= m_batch_rows) commit(true);
+}
+
+void BatchWriter::poll(int64_t now_us)
+{
+    if (m_pending_rows > 0 && now_us - m_oldest_us >= m_config.max_delay_us) commit(false);
+}
+
+void BatchWriter::flush()
+{
+    if (m_pending_rows > 0) commit(false);
+}
+
+int64_t BatchWriter::next_deadline_us() const
+{
+    return m_pending_rows > 0 ? m_oldest_us + m_config.max_delay_us : 0;
+}
+
+void BatchWriter::commit(bool full)
+{
+    std::vector<RowBatch> batches;
+    for (auto& table : m_tables)
+    {
+        if (table.rows.empty()) continue;
+        RowBatch batch;
+        batch.table = table.table;
+        batch.rows.swap(table.rows);
+        batches.push_back(std::move(batch));
+    }
+    size_t rows = m_pending_rows;
+    m_pending_rows = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    if (m_bulk)
+    {
+        // 大批量的表经临时表合并导入，已写入或已转存的从组提交中移除；确定没写入的回落到 INSERT
+        for (auto& batch : batches)
+        {
+            if (batch.rows.size() < m_config.bulk_min_rows) continue;
+            int result = m_dao.bulk_store_rows(*m_bulk, batch);
+            if (result == -1)
+            {
+                spdlog::warn("Bulk load into {} not applied, falling back to INSERT: {}", batch.table->name, m_bulk->error());
+                continue;
+            }
+            if (result == -2) m_dropped += batch.rows.size();
+            batch.rows.clear();
+        }
+        batches.erase(std::remove_if(batches.begin(), batches.end(),
+                                     [](const RowBatch& b) { return b.rows.empty(); }), batches.end());
+    }
+    // 库不可用或暂存区有积压时转存本地暂存区，由后台回放
+    int stored = batches.empty() ? 1 : m_dao.store_row_batches(batches);
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    if (stored < 0)
+    {
+        size_t failed = 0;
+        for (const auto& batch : batches) failed += batch.rows.size();
+        m_dropped += failed;
+        spdlog::error("Batch commit of {} rows failed and could not be spooled, {} rows dropped so far", failed, m_dropped);
+    }
+
+    // 提交耗时超过目标说明批太大（或库已过载），减半；满批且很快则翻倍以摊薄往返
+    size_t previous = m_batch_rows;
+    if (elapsed > m_config.target_commit_us)
+        m_batch_rows = std::max(m_config.min_rows, m_batch_rows / 2);
+    else if (full && stored > 0 && elapsed < m_config.target_commit_us / 2)
+        m_batch_rows = std::min(m_config.max_rows, m_batch_rows * 2);
+    if (m_batch_rows != previous)
+        spdlog::debug("Batch size {} -> {} (commit of {} rows took {}us)", previous, m_batch_rows, rows, elapsed);
+}
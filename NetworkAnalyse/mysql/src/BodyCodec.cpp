@@ -0,0 +1,425 @@
+#include "BodyCodec.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <zstd.h>
+#include <zdict.h>
+#include <spdlog/spdlog.h>
+
+using nlohmann::json;
+
+struct BodyCompressor::Dictionary
+{
+    uint32_t        id = 0;
+    std::string     content_class;
+    size_t          size = 0;
+    ZSTD_CDict*     cdict = nullptr;
+    ZSTD_DDict*     ddict = nullptr;
+
+    ~Dictionary()
+    {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+    }
+};
+
+namespace {
+
+struct CCtxDeleter { void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); } };
+struct DCtxDeleter { void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); } };
+
+ZSTD_CCtx* thread_cctx()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx* thread_dctx()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+
+const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+}
+
+namespace body_codec
+{
+
+std::string base64_encode(const std::string& in)
+{
+    std::string out;
+    out.reserve((in.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < in.size(); i += 3)
+    {
+        uint32_t v = static_cast<uint8_t>(in[i]) << 16 | static_cast<uint8_t>(in[i + 1]) << 8 |
+                     static_cast<uint8_t>(in[i + 2]);
+        out += BASE64_CHARS[v >> 18 & 63];
+        out += BASE64_CHARS[v >> 12 & 63];
+        out += BASE64_CHARS[v >> 6 & 63];
+        out += BASE64_CHARS[v & 63];
+    }
+    if (i < in.size())
+    {
+        uint32_t v = static_cast<uint8_t>(in[i]) << 16;
+        if (i + 1 < in.size()) v |= static_cast<uint8_t>(in[i + 1]) << 8;
+        out += BASE64_CHARS[v >> 18 & 63];
+        out += BASE64_CHARS[v >> 12 & 63];
+        out += i + 1 < in.size() ? BASE64_CHARS[v >> 6 & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+// 只接受重新编码后与原文逐字节相同的 base64，保证读出时能原样还原
+bool base64_decode(const std::string& in, std::string& out)
+{
+    out.clear();
+    if (in.empty()) return true;
+    if (in.size() % 4 != 0) return false;
+    static const auto table = [] {
+        std::array<int8_t, 256> t;
+        t.fill(-1);
+        for (int i = 0; i < 64; ++i) t[static_cast<uint8_t>(BASE64_CHARS[i])] = static_cast<int8_t>(i);
+        return t;
+    }();
+
+    size_t padding = in[in.size() - 1] == '=' ? (in[in.size() - 2] == '=' ? 2 : 1) : 0;
+    out.reserve(in.size() / 4 * 3);
+    uint32_t v = 0;
+    for (size_t i = 0; i < in.size() - padding; ++i)
+    {
+        int8_t d = table[static_cast<uint8_t>(in[i])];
+        if (d < 0) return false;
+        v = v << 6 | static_cast<uint32_t>(d);
+        if (i % 4 == 3)
+        {
+            out += static_cast<char>(v >> 16);
+            out += static_cast<char>(v >> 8);
+            out += static_cast<char>(v);
+            v = 0;
+        }
+    }
+    if (padding == 1)
+    {
+        out += static_cast<char>(v >> 10);
+        out += static_cast<char>(v >> 2);
+    }
+    else if (padding == 2)
+    {
+        out += static_cast<char>(v >> 4);
+    }
+    return base64_encode(out) == in;
+}
+
+}
+
+BodyCompressor::BodyCompressor(std::shared_ptr<BodyDictionaryStore> store)
+    : m_store(std::move(store))
+{
+}
+
+BodyCompressor::~BodyCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;      // 未开始的训练放弃，样本不保留
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::shared_ptr<BodyCompressor> BodyCompressor::shared(std::shared_ptr<BodyDictionaryStore> store)
+{
+    static std::mutex mutex;
+    static std::weak_ptr<BodyCompressor> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<BodyCompressor> compressor = instance.lock();
+    if (!compressor)
+    {
+        compressor = std::make_shared<BodyCompressor>(std::move(store));
+        instance = compressor;
+    }
+    return compressor;
+}
+
+std::string BodyCompressor::content_class(const std::string& content_type)
+{
+    std::string type = content_type.substr(0, content_type.find(';'));
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    if (type.find("json") != std::string::npos) return "json";
+    if (type.find("html") != std::string::npos) return "html";
+    if (type.find("xml") != std::string::npos) return "xml";
+    if (type.find("javascript") != std::string::npos || type.find("ecmascript") != std::string::npos) return "javascript";
+    if (type.find("css") != std::string::npos) return "css";
+    if (type.find("x-www-form-urlencoded") != std::string::npos) return "form";
+    if (type.compare(0, 5, "text/") == 0) return "text";
+    return "binary";
+}
+
+EncodedBody BodyCompressor::encode(const std::string& content_type, const std::string& body)
+{
+    EncodedBody encoded;
+    std::string cls = content_class(content_type);
+    if (body.size() < MIN_BYTES)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ClassState& state = m_classes[cls];
+        ++state.bodies;
+        state.raw_bytes += body.size();
+        state.stored_bytes += body.size();
+        encoded.data = body;
+        return encoded;
+    }
+    std::call_once(m_start_once, [this] { m_thread = std::thread(&BodyCompressor::run, this); });
+
+    const std::string* input = &body;
+    std::string decoded;
+    uint8_t flags = 0;
+    if (cls == "binary" && body_codec::base64_decode(body, decoded))
+    {
+        input = &decoded;
+        flags = body_codec::BASE64;
+    }
+
+    std::shared_ptr<const Dictionary> dict;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ClassState& state = m_classes[cls];
+        dict = state.active;
+        if (!dict && cls != "binary" && !state.training)
+        {
+            size_t n = std::min(input->size(), SAMPLE_PREFIX);
+            state.samples.append(*input, 0, n);
+            state.sample_sizes.push_back(n);
+            if (state.samples.size() >= TRAIN_BYTES && state.sample_sizes.size() >= MIN_SAMPLES)
+            {
+                // 样本交给后台线程训练，本次及之后的报文体照常（无字典）压缩
+                TrainingJob job;
+                job.content_class = cls;
+                job.samples.swap(state.samples);
+                job.sizes.swap(state.sample_sizes);
+                m_jobs.push_back(std::move(job));
+                state.training = true;
+                queued = true;
+            }
+        }
+    }
+    if (queued) m_cv.notify_one();
+
+    // 帧带内容长度（解压时一次分配）与校验和（数据损坏时解压报错而不是返回错误内容）
+    ZSTD_CCtx* cctx = thread_cctx();
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, LEVEL);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    if (dict) ZSTD_CCtx_refCDict(cctx, dict->cdict);
+    std::string frame(ZSTD_compressBound(input->size()), '\0');
+    size_t n = ZSTD_compress2(cctx, &frame[0], frame.size(), input->data(), input->size());
+    if (ZSTD_isError(n))
+    {
+        spdlog::warn("Compressing {} byte {} body failed: {}", body.size(), cls, ZSTD_getErrorName(n));
+        n = body.size();
+    }
+
+    if (n < body.size())
+    {
+        frame.resize(n);
+        encoded.codec = static_cast<uint8_t>((dict ? body_codec::ZSTD_DICT : body_codec::ZSTD) | flags);
+        encoded.data = std::move(frame);
+    }
+    else
+    {
+        encoded.data = body;    // 压缩无收益（已压缩过的媒体等）
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ClassState& state = m_classes[cls];
+    ++state.bodies;
+    state.raw_bytes += body.size();
+    state.stored_bytes += encoded.data.size();
+    return encoded;
+}
+
+bool BodyCompressor::decode(uint8_t codec, const std::string& data, std::string& body, std::string& error)
+{
+    uint8_t method = codec & body_codec::METHOD_MASK;
+    if (method == body_codec::RAW)
+    {
+        body = data;
+        return true;
+    }
+
+    auto fail = [&](const std::string& reason) {
+        error = reason;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_decode_failures;
+        return false;
+    };
+    if (method != body_codec::ZSTD && method != body_codec::ZSTD_DICT)
+        return fail("unknown body codec " + std::to_string(codec));
+
+    unsigned long long size = ZSTD_getFrameContentSize(data.data(), data.size());
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > MAX_BYTES)
+        return fail("invalid zstd frame");
+
+    std::shared_ptr<const Dictionary> dict;
+    if (method == body_codec::ZSTD_DICT)
+    {
+        uint32_t id = ZSTD_getDictID_fromFrame(data.data(), data.size());
+        dict = find(id);
+        if (!dict) return fail("dictionary " + std::to_string(id) + " not found");
+    }
+
+    std::string out(static_cast<size_t>(size), '\0');
+    size_t n = dict ? ZSTD_decompress_usingDDict(thread_dctx(), &out[0], out.size(), data.data(), data.size(),
+                                                 dict->ddict)
+                    : ZSTD_decompressDCtx(thread_dctx(), &out[0], out.size(), data.data(), data.size());
+    if (ZSTD_isError(n)) return fail(ZSTD_getErrorName(n));
+    if (n != out.size()) return fail("truncated zstd frame");
+
+    body = (codec & body_codec::BASE64) ? body_codec::base64_encode(out) : std::move(out);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_decoded;
+    return true;
+}
+
+void BodyCompressor::load_dictionaries()
+{
+    std::vector<BodyDictionary> dicts;
+    if (!m_store || !m_store->load_all(dicts)) return;
+    for (const auto& dict : dicts) install(dict, true);
+    if (!dicts.empty()) spdlog::info("Loaded {} HTTP body dictionaries", dicts.size());
+}
+
+std::shared_ptr<const BodyCompressor::Dictionary> BodyCompressor::install(const BodyDictionary& dict, bool activate)
+{
+    auto entry = std::make_shared<Dictionary>();
+    entry->id = dict.id;
+    entry->content_class = dict.content_class;
+    entry->size = dict.data.size();
+    entry->cdict = ZSTD_createCDict(dict.data.data(), dict.data.size(), LEVEL);
+    entry->ddict = ZSTD_createDDict(dict.data.data(), dict.data.size());
+    if (!entry->cdict || !entry->ddict)
+    {
+        spdlog::error("Invalid HTTP body dictionary {} ({})", dict.id, dict.content_class);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dictionaries[dict.id] = entry;
+    if (activate) m_classes[dict.content_class].active = entry;
+    return entry;
+}
+
+std::shared_ptr<const BodyCompressor::Dictionary> BodyCompressor::find(uint32_t id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_dictionaries.find(id);
+        if (it != m_dictionaries.end()) return it->second;
+    }
+    // 其他进程训练的字典：按 id 从库中加载，只用于解压
+    BodyDictionary dict;
+    if (id == 0 || !m_store || !m_store->load(id, dict)) return nullptr;
+    return install(dict, false);
+}
+
+void BodyCompressor::run()
+{
+    load_dictionaries();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        if (m_stop) return;
+        TrainingJob job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+        train(job);
+        lock.lock();
+    }
+}
+
+void BodyCompressor::train(const TrainingJob& job)
+{
+    const std::string& content_class = job.content_class;
+    const std::string& samples = job.samples;
+    const std::vector<size_t>& sizes = job.sizes;
+    std::string data(DICT_CAPACITY, '\0');
+    size_t n = ZDICT_trainFromBuffer(&data[0], data.size(), samples.data(), sizes.data(),
+                                     static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(n))
+    {
+        spdlog::warn("Training {} body dictionary from {} samples failed: {}", content_class, sizes.size(),
+                     ZDICT_getErrorName(n));
+    }
+    else
+    {
+        data.resize(n);
+        BodyDictionary dict;
+        dict.id = ZDICT_getDictID(data.data(), data.size());
+        dict.content_class = content_class;
+        dict.data = std::move(data);
+        // 先落库再启用：否则用它压缩的报文体在进程重启后无法解开
+        if (dict.id == 0 || !m_store || !m_store->save(dict))
+            spdlog::warn("Cannot persist {} body dictionary, keep compressing without it", content_class);
+        else if (install(dict, true))
+            spdlog::info("Trained {} byte dictionary {} for {} bodies from {} samples", dict.data.size(), dict.id,
+                         content_class, sizes.size());
+    }
+
+    // 失败时重新收集样本再试
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_classes[content_class].training = false;
+}
+
+json BodyCompressor::status() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    json classes = json::object();
+    for (const auto& item : m_classes)
+    {
+        const ClassState& state = item.second;
+        json c;
+        c["bodies"] = state.bodies;
+        c["raw_bytes"] = state.raw_bytes;
+        c["stored_bytes"] = state.stored_bytes;
+        if (state.active)
+        {
+            c["dictionary"] = state.active->id;
+            c["dictionary_bytes"] = state.active->size;
+        }
+        else if (item.first != "binary")
+        {
+            c["sample_bytes"] = state.samples.size();
+        }
+        classes[item.first] = std::move(c);
+    }
+    json j;
+    j["classes"] = std::move(classes);
+    j["dictionaries"] = m_dictionaries.size();
+    j["decoded"] = m_decoded;
+    j["decode_failures"] = m_decode_failures;
+    return j;
+}
+
+StoredBody::StoredBody(uint8_t codec, std::string data, std::shared_ptr<BodyCompressor> compressor)
+    : m_codec(codec)
+    , m_data(std::move(data))
+    , m_compressor(std::move(compressor))
+{
+}
+
+const std::string& StoredBody::text() const
+{
+    if (m_decoded) return m_text;
+    m_decoded = true;
+    if ((m_codec & body_codec::METHOD_MASK) == body_codec::RAW) m_text = m_data;
+    else if (!m_compressor) m_error = "no body compressor";
+    else if (!m_compressor->decode(m_codec, m_data, m_text, m_error)) m_text.clear();
+    return m_text;
+}
@@ -0,0 +1,342 @@
+#include "BulkLoader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mysql.h>
+#include <spdlog/spdlog.h>
+#include "TimeFormat.h"
+
+namespace {
+
+MYSQL* handle(void* p)
+{
+    return static_cast<MYSQL*>(p);
+}
+
+// LOAD DATA 默认转义规则（ESCAPED BY '\\'）
+void append_escaped(std::string& out, const std::string& value)
+{
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\0': out += "\\0"; break;
+        default:   out += c; break;
+        }
+    }
+}
+
+} // namespace
+
+BulkLoader::BulkLoader(const MySqlEndpoint& endpoint, size_t buffer_bytes)
+    : m_endpoint(endpoint)
+    , m_buffer_bytes(buffer_bytes)
+{
+}
+
+BulkLoader::~BulkLoader()
+{
+    if (m_active) abort();
+    disconnect();
+}
+
+void BulkLoader::disconnect()
+{
+    if (!m_mysql) return;
+    mysql_close(handle(m_mysql));
+    m_mysql = nullptr;
+}
+
+bool BulkLoader::connect()
+{
+    if (m_mysql)
+    {
+        // 空闲期间服务端可能已断开（wait_timeout、重启），失效的连接换新的
+        if (mysql_ping(handle(m_mysql)) == 0) return true;
+        spdlog::info("Bulk load connection lost ({}), reconnecting", mysql_error(handle(m_mysql)));
+        disconnect();
+    }
+
+    // "tcp://host:port" / "host:port" / "host"
+    std::string address = m_endpoint.url;
+    if (address.compare(0, 6, "tcp://") == 0) address = address.substr(6);
+    std::string host = address;
+    unsigned int port = 3306;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos)
+    {
+        host = address.substr(0, colon);
+        port = static_cast<unsigned int>(std::atoi(address.c_str() + colon + 1));
+    }
+
+    MYSQL* mysql = mysql_init(nullptr);
+    if (!mysql)
+    {
+        m_error = "mysql_init failed";
+        return false;
+    }
+    unsigned int local_infile = 1;
+    unsigned int connect_timeout = CONNECT_TIMEOUT_SEC;
+    unsigned int read_timeout = READ_TIMEOUT_SEC;
+    unsigned int write_timeout = WRITE_TIMEOUT_SEC;
+    mysql_options(mysql, MYSQL_OPT_LOCAL_INFILE, &local_infile);
+    mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+    mysql_options(mysql, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
+    mysql_options(mysql, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
+    mysql_options(mysql, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+    if (!mysql_real_connect(mysql, host.c_str(), m_endpoint.user.c_str(), m_endpoint.pass.c_str(),
+                            m_endpoint.schema.c_str(), port, nullptr, 0))
+    {
+        m_error = std::string("connect failed: ") + mysql_error(mysql);
+        mysql_close(mysql);
+        return false;
+    }
+    mysql_set_local_infile_handler(mysql, &BulkLoader::infile_init, &BulkLoader::infile_read,
+                                   &BulkLoader::infile_end, &BulkLoader::infile_error, this);
+    m_mysql = mysql;
+    return true;
+}
+
+bool BulkLoader::query(const std::string& sql)
+{
+    if (mysql_real_query(handle(m_mysql), sql.data(), sql.size()) != 0)
+    {
+        m_errno = mysql_errno(handle(m_mysql));
+        m_error = std::string(mysql_error(handle(m_mysql))) + " (errno " + std::to_string(m_errno) + ")";
+        // 连接已断开（CR_SERVER_GONE_ERROR / CR_SERVER_LOST）：句柄不可再用，下次导入重连
+        if (lost_connection()) disconnect();
+        return false;
+    }
+    return true;
+}
+
+std::string BulkLoader::column_list() const
+{
+    std::string columns;
+    for (const auto& column : m_table.columns)
+        columns += (columns.empty() ? "" : ", ") + column;
+    return columns;
+}
+
+std::string BulkLoader::escape(const std::string& value) const
+{
+    std::string out(value.size() * 2 + 1, '\0');
+    out.resize(mysql_real_escape_string(handle(m_mysql), &out[0], value.data(), value.size()));
+    return out;
+}
+
+bool BulkLoader::begin(const BatchTable& table, Mode mode, const std::string& batch_id,
+                       const std::string& on_duplicate)
+{
+    if (m_active) abort();
+    m_error.clear();
+    m_errno = 0;
+    m_outcome_unknown = false;
+    m_already_applied = false;
+    if (mode == Mode::MERGE && batch_id.empty())
+    {
+        m_error = "merge load without batch id";
+        return false;
+    }
+    if (!connect()) return false;
+
+    m_table = table;
+    m_mode = mode;
+    m_target = table.name;
+    m_batch_id = batch_id;
+    m_on_duplicate = on_duplicate;
+    if (mode == Mode::MERGE)
+    {
+        // 临时表只对本连接可见，多个进程同时导入同一张表不会互相覆盖，连接断开时自动删除；
+        // CREATE ... SELECT 不复制索引与分区，批内同一唯一键的多行（同一会话的多条增量）都能暂存，
+        // 合并时按 stage_seq 的顺序逐行应用
+        m_target = table.name + "__stage";
+        if (!query("DROP TEMPORARY TABLE IF EXISTS " + m_target) ||
+            !query("CREATE TEMPORARY TABLE " + m_target +
+                   " (stage_seq BIGINT NOT NULL AUTO_INCREMENT PRIMARY KEY) SELECT " + column_list() +
+                   " FROM " + table.name + " LIMIT 0"))
+        {
+            spdlog::error("Cannot create staging table {}: {}", m_target, m_error);
+            return false;
+        }
+    }
+    m_rows = 0;
+    m_sent = false;
+    m_buffer.clear();
+    m_active = true;
+    return true;
+}
+
+void BulkLoader::append_tsv(std::string& out, const SqlRow& row, size_t columns)
+{
+    for (size_t c = 0; c < columns; ++c)
+    {
+        if (c) out += '\t';
+        if (c >= row.size())
+        {
+            out += "\\N";
+            continue;
+        }
+        const SqlValue& v = row[c];
+        switch (v.type)
+        {
+        case SqlValue::Type::INT:       out += std::to_string(v.i); break;
+        case SqlValue::Type::UINT:      out += std::to_string(v.u); break;
+        case SqlValue::Type::STRING:    append_escaped(out, v.s); break;
+        case SqlValue::Type::DATETIME:
+            if (v.i == 0) out += "\\N";
+            else out += format_datetime_us(v.i);
+            break;
+        case SqlValue::Type::NUL:
+        default:
+            out += "\\N";
+            break;
+        }
+    }
+    out += '\n';
+}
+
+bool BulkLoader::append(const SqlRow& row)
+{
+    if (!m_active) return false;
+    append_tsv(m_buffer, row, m_table.columns.size());
+    ++m_rows;
+    return m_buffer.size() < m_buffer_bytes || send_buffer();
+}
+
+bool BulkLoader::send_buffer()
+{
+    if (m_buffer.empty()) return true;
+    if (!m_mysql)
+    {
+        m_buffer.clear();
+        return false;
+    }
+    m_read_offset = 0;
+    // 文件名只是标识，infile_init 忽略它，数据取自 m_buffer
+    std::string sql = "LOAD DATA LOCAL INFILE 'memory:" + m_target + "' INTO TABLE " + m_target +
+                      " CHARACTER SET utf8mb4 FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\'"
+                      " LINES TERMINATED BY '\\n' (" + column_list() + ")";
+    size_t bytes = m_buffer.size();
+    bool ok = query(sql);
+    m_buffer.clear();
+    if (ok)
+    {
+        m_sent = true;
+        spdlog::debug("LOAD DATA into {}: {} bytes, {} rows affected", m_target, bytes,
+                      static_cast<uint64_t>(mysql_affected_rows(handle(m_mysql))));
+    }
+    else if (m_mode == Mode::APPEND && (m_errno == 2013 || m_sent))
+    {
+        // 语句发出后断开不知道服务端是否已执行；之前的缓冲区已提交时整批重写也会重复这部分。
+        // MERGE 只写临时表，失败不影响目标表
+        m_outcome_unknown = true;
+    }
+    return ok;
+}
+
+bool BulkLoader::merge()
+{
+    auto rollback = [this] {
+        cleanup("ROLLBACK");
+        return false;
+    };
+
+    if (!query("START TRANSACTION")) return false;
+    // 批次 id 与数据同一事务提交：id 已存在说明此前已合并过（结果丢失后的重做），整批跳过
+    if (!query("INSERT IGNORE INTO spool_applied (batch_id) VALUES ('" + escape(m_batch_id) + "')"))
+        return rollback();
+    if (mysql_affected_rows(handle(m_mysql)) == 0)
+    {
+        m_already_applied = true;
+        rollback();
+        return true;
+    }
+    std::string columns = column_list();
+    std::string sql = "INSERT INTO " + m_table.name + " (" + columns + ") SELECT " + columns + " FROM " + m_target +
+                      " ORDER BY stage_seq";
+    if (!m_on_duplicate.empty()) sql += " " + m_on_duplicate;
+    if (!query(sql)) return rollback();
+    if (!query("COMMIT"))
+    {
+        // 此前任何一步断开，服务端都会回滚未提交的事务；只有 COMMIT 的结果可能丢失
+        m_outcome_unknown = lost_connection();
+        return false;
+    }
+    return true;
+}
+
+bool BulkLoader::finish()
+{
+    if (!m_active) return false;
+    bool ok = send_buffer();
+    if (ok && m_mode == Mode::MERGE) ok = merge();
+    m_active = false;
+    if (m_mode == Mode::MERGE) cleanup("DROP TEMPORARY TABLE IF EXISTS " + m_target);
+    if (!ok) spdlog::error("Bulk load into {} failed to complete: {}", m_table.name, m_error);
+    else if (m_already_applied) spdlog::info("Bulk load batch {} was already merged into {}", m_batch_id, m_table.name);
+    return ok;
+}
+
+void BulkLoader::abort()
+{
+    m_buffer.clear();
+    m_active = false;
+    if (m_mode == Mode::MERGE) cleanup("DROP TEMPORARY TABLE IF EXISTS " + m_target);
+}
+
+void BulkLoader::cleanup(const std::string& sql)
+{
+    if (!m_mysql) return;
+    std::string error = m_error;
+    unsigned int code = m_errno;
+    query(sql);
+    m_error = error;
+    m_errno = code;
+}
+
+int64_t BulkLoader::load(const BatchTable& table, const std::vector<SqlRow>& rows, Mode mode,
+                         const std::string& batch_id, const std::string& on_duplicate)
+{
+    if (!begin(table, mode, batch_id, on_duplicate)) return -1;
+    for (const auto& row : rows)
+    {
+        if (!append(row))
+        {
+            abort();
+            return -1;
+        }
+    }
+    if (!finish()) return -1;
+    return m_already_applied ? 0 : m_rows;
+}
+
+int BulkLoader::infile_init(void** ptr, const char*, void* userdata)
+{
+    *ptr = userdata;
+    return 0;
+}
+
+int BulkLoader::infile_read(void* ptr, char* buf, unsigned int buf_len)
+{
+    auto* self = static_cast<BulkLoader*>(ptr);
+    size_t n = std::min<size_t>(buf_len, self->m_buffer.size() - self->m_read_offset);
+    std::memcpy(buf, self->m_buffer.data() + self->m_read_offset, n);
+    self->m_read_offset += n;
+    return static_cast<int>(n);
+}
+
+void BulkLoader::infile_end(void*)
+{
+}
+
+int BulkLoader::infile_error(void*, char* msg, unsigned int msg_len)
+{
+    std::snprintf(msg, msg_len, "in-memory bulk buffer unavailable");
+    return 2000;    // CR_UNKNOWN_ERROR
+}
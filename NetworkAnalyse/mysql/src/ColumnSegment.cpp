@@ -0,0 +1,384 @@
+#include "ColumnSegment.h"
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace column_segment
+{
+namespace {
+const uint32_t SEGMENT_MAGIC = 0x3153434E;      // "NCS1"
+const uint32_t SEGMENT_VERSION = 1;
+const size_t FIXED_HEADER_BYTES = 20;
+const size_t MAX_STAT_TEXT = 256;               // 超过该长度的字符串不记 min/max
+
+enum : uint8_t { FLAG_NULLS = 1, FLAG_MINMAX = 2 };
+
+void put_varint(std::string& out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool get_bytes(const uint8_t*& p, const uint8_t* end, std::string_view& out)
+{
+    uint64_t len = 0;
+    if (!get_varint(p, end, len) || len > static_cast<uint64_t>(end - p)) return false;
+    out = std::string_view(reinterpret_cast<const char*>(p), len);
+    p += len;
+    return true;
+}
+
+void put_bytes(std::string& out, std::string_view s)
+{
+    put_varint(out, s.size());
+    out.append(s.data(), s.size());
+}
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+void put_u32(std::string& out, uint32_t v)
+{
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+uint32_t get_u32(const char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+const SqlValue& cell(const std::vector<SqlRow>& rows, size_t row, size_t column)
+{
+    static const SqlValue null_value;
+    return column < rows[row].size() ? rows[row][column] : null_value;
+}
+
+// 差值按无符号回绕计算，任意两个 int64 之差都可还原
+int64_t wrapping_sub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }
+int64_t wrapping_add(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }
+
+void encode_integers(const std::vector<SqlRow>& rows, size_t column, ColumnMeta& meta, std::string& blob)
+{
+    int64_t prev = 0;
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+        const SqlValue& v = cell(rows, r, column);
+        int64_t x = prev;               // NULL 行差值为 0
+        if (v.type != SqlValue::Type::NUL)
+        {
+            x = v.type == SqlValue::Type::UINT ? static_cast<int64_t>(v.u) : v.i;
+            if (!meta.has_minmax || x < meta.min_int) meta.min_int = x;
+            if (!meta.has_minmax || x > meta.max_int) meta.max_int = x;
+            meta.has_minmax = true;
+        }
+        put_varint(blob, zigzag(wrapping_sub(x, prev)));
+        prev = x;
+    }
+}
+
+void encode_strings(const std::vector<SqlRow>& rows, size_t column, ColumnMeta& meta, std::string& blob)
+{
+    // 混入的数值列转为文本
+    std::deque<std::string> converted;
+    std::vector<std::string_view> values(rows.size());
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::string_view> dict;
+    bool has_value = false;
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+        const SqlValue& v = cell(rows, r, column);
+        switch (v.type)
+        {
+        case SqlValue::Type::NUL:       continue;
+        case SqlValue::Type::STRING:    values[r] = v.s; break;
+        case SqlValue::Type::UINT:      converted.push_back(std::to_string(v.u)); values[r] = converted.back(); break;
+        default:                        converted.push_back(std::to_string(v.i)); values[r] = converted.back(); break;
+        }
+        if (!has_value || values[r] < meta.min_text) meta.min_text = std::string(values[r]);
+        if (!has_value || values[r] > meta.max_text) meta.max_text = std::string(values[r]);
+        has_value = true;
+        if (ids.size() <= rows.size() / 2 && ids.emplace(values[r], static_cast<uint32_t>(dict.size())).second)
+            dict.push_back(values[r]);
+    }
+    meta.has_minmax = has_value && meta.min_text.size() <= MAX_STAT_TEXT && meta.max_text.size() <= MAX_STAT_TEXT;
+    if (!meta.has_minmax)
+    {
+        meta.min_text.clear();
+        meta.max_text.clear();
+    }
+
+    if (ids.size() <= rows.size() / 2)
+    {
+        meta.encoding = Encoding::DICT;
+        put_varint(blob, dict.size());
+        for (std::string_view entry : dict) put_bytes(blob, entry);
+        for (size_t r = 0; r < rows.size(); ++r)
+        {
+            // NULL 行占位为 0 号（位图中已标记）
+            auto it = cell(rows, r, column).type == SqlValue::Type::NUL ? ids.end() : ids.find(values[r]);
+            put_varint(blob, it == ids.end() ? 0 : it->second);
+        }
+    }
+    else
+    {
+        meta.encoding = Encoding::PLAIN;
+        for (std::string_view value : values) put_bytes(blob, value);
+    }
+}
+}
+
+std::string encode(const std::vector<std::string>& columns, const std::vector<SqlRow>& rows)
+{
+    std::vector<ColumnMeta> metas(columns.size());
+    std::vector<std::string> blobs(columns.size());
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+        ColumnMeta& meta = metas[c];
+        meta.name = columns[c];
+
+        std::string nulls((rows.size() + 7) / 8, '\0');
+        bool any_string = false, any_datetime = false;
+        for (size_t r = 0; r < rows.size(); ++r)
+        {
+            SqlValue::Type type = cell(rows, r, c).type;
+            if (type == SqlValue::Type::NUL) nulls[r >> 3] |= static_cast<char>(1 << (r & 7));
+            meta.has_nulls |= type == SqlValue::Type::NUL;
+            any_string |= type == SqlValue::Type::STRING;
+            any_datetime |= type == SqlValue::Type::DATETIME;
+        }
+        meta.type = any_string ? ColumnType::STRING : any_datetime ? ColumnType::DATETIME : ColumnType::INT;
+
+        std::string& blob = blobs[c];
+        if (meta.has_nulls) blob = nulls;
+        if (meta.type == ColumnType::STRING) encode_strings(rows, c, meta, blob);
+        else encode_integers(rows, c, meta, blob);
+    }
+
+    std::string head;
+    put_u32(head, SEGMENT_MAGIC);
+    put_u32(head, SEGMENT_VERSION);
+    put_u32(head, 0);                               // 头长度，最后回填
+    put_u32(head, static_cast<uint32_t>(rows.size()));
+    put_u32(head, static_cast<uint32_t>(columns.size()));
+    uint64_t offset = 0;                            // 相对数据区开头
+    for (size_t c = 0; c < metas.size(); ++c)
+    {
+        const ColumnMeta& meta = metas[c];
+        put_bytes(head, meta.name);
+        head.push_back(static_cast<char>(meta.type));
+        head.push_back(static_cast<char>(meta.encoding));
+        head.push_back(static_cast<char>((meta.has_nulls ? FLAG_NULLS : 0) | (meta.has_minmax ? FLAG_MINMAX : 0)));
+        if (meta.has_minmax && meta.type == ColumnType::STRING)
+        {
+            put_bytes(head, meta.min_text);
+            put_bytes(head, meta.max_text);
+        }
+        else if (meta.has_minmax)
+        {
+            put_varint(head, zigzag(meta.min_int));
+            put_varint(head, zigzag(meta.max_int));
+        }
+        put_varint(head, offset);
+        put_varint(head, blobs[c].size());
+        offset += blobs[c].size();
+    }
+    uint32_t head_len = static_cast<uint32_t>(head.size());
+    std::memcpy(&head[8], &head_len, sizeof(head_len));
+
+    head.reserve(head.size() + offset);
+    for (const auto& blob : blobs) head += blob;
+    return head;
+}
+
+bool SegmentView::parse(const char* data, size_t size, std::string& error)
+{
+    m_data = data;
+    m_size = size;
+    m_columns.clear();
+    if (size < FIXED_HEADER_BYTES || get_u32(data) != SEGMENT_MAGIC)
+    {
+        error = "not a column segment";
+        return false;
+    }
+    if (get_u32(data + 4) != SEGMENT_VERSION)
+    {
+        error = "unsupported segment version " + std::to_string(get_u32(data + 4));
+        return false;
+    }
+    uint32_t head_len = get_u32(data + 8);
+    m_rows = get_u32(data + 12);
+    uint32_t count = get_u32(data + 16);
+    if (head_len < FIXED_HEADER_BYTES || head_len > size)
+    {
+        error = "corrupt segment header";
+        return false;
+    }
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data) + FIXED_HEADER_BYTES;
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(data) + head_len;
+    for (uint32_t c = 0; c < count; ++c)
+    {
+        ColumnMeta meta;
+        std::string_view name, min_text, max_text;
+        uint64_t min_int = 0, max_int = 0;
+        if (!get_bytes(p, end, name) || end - p < 3)
+        {
+            error = "corrupt column header";
+            return false;
+        }
+        meta.name = std::string(name);
+        meta.type = static_cast<ColumnType>(*p++);
+        meta.encoding = static_cast<Encoding>(*p++);
+        uint8_t flags = *p++;
+        meta.has_nulls = flags & FLAG_NULLS;
+        meta.has_minmax = flags & FLAG_MINMAX;
+        bool ok = true;
+        if (meta.has_minmax && meta.type == ColumnType::STRING)
+        {
+            ok = get_bytes(p, end, min_text) && get_bytes(p, end, max_text);
+            meta.min_text = std::string(min_text);
+            meta.max_text = std::string(max_text);
+        }
+        else if (meta.has_minmax)
+        {
+            ok = get_varint(p, end, min_int) && get_varint(p, end, max_int);
+            meta.min_int = unzigzag(min_int);
+            meta.max_int = unzigzag(max_int);
+        }
+        ok = ok && get_varint(p, end, meta.offset) && get_varint(p, end, meta.length);
+        meta.offset += head_len;
+        if (!ok || meta.offset > size || meta.length > size - meta.offset)
+        {
+            error = "corrupt column header for " + meta.name;
+            return false;
+        }
+        m_columns.push_back(std::move(meta));
+    }
+    return true;
+}
+
+int SegmentView::find(const std::string& column) const
+{
+    for (size_t c = 0; c < m_columns.size(); ++c)
+        if (m_columns[c].name == column) return static_cast<int>(c);
+    return -1;
+}
+
+bool SegmentView::decode(int column, ColumnVector& out, std::string& error) const
+{
+    const ColumnMeta& meta = m_columns.at(column);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(m_data + meta.offset);
+    const uint8_t* end = p + meta.length;
+    out = ColumnVector();
+    out.type = meta.type;
+    auto fail = [&] {
+        error = "corrupt column data for " + meta.name;
+        return false;
+    };
+
+    if (meta.has_nulls)
+    {
+        size_t bitmap = (static_cast<size_t>(m_rows) + 7) / 8;
+        if (static_cast<size_t>(end - p) < bitmap) return fail();
+        out.nulls = p;
+        p += bitmap;
+    }
+
+    uint64_t v = 0;
+    switch (meta.encoding)
+    {
+    case Encoding::DELTA:
+    {
+        out.ints.resize(m_rows);
+        int64_t prev = 0;
+        for (uint32_t r = 0; r < m_rows; ++r)
+        {
+            if (!get_varint(p, end, v)) return fail();
+            prev = wrapping_add(prev, unzigzag(v));
+            out.ints[r] = prev;
+        }
+        return true;
+    }
+    case Encoding::DICT:
+    {
+        if (!get_varint(p, end, v) || v > static_cast<uint64_t>(end - p)) return fail();
+        out.dict.resize(v);
+        for (auto& entry : out.dict)
+            if (!get_bytes(p, end, entry)) return fail();
+        out.codes.resize(m_rows);
+        for (uint32_t r = 0; r < m_rows; ++r)
+        {
+            if (!get_varint(p, end, v) || (v >= out.dict.size() && !out.is_null(r))) return fail();
+            out.codes[r] = static_cast<uint32_t>(v);
+        }
+        // 全为 NULL 的列字典为空，NULL 行的占位编号指向一个空串
+        if (out.dict.empty()) out.dict.emplace_back();
+        return true;
+    }
+    case Encoding::PLAIN:
+    {
+        out.texts.resize(m_rows);
+        for (auto& text : out.texts)
+            if (!get_bytes(p, end, text)) return fail();
+        return true;
+    }
+    }
+    return fail();
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_addr) ::munmap(m_addr, m_size);
+}
+
+bool MappedFile::open(const std::string& path, std::string& error)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = "open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        error = "empty or unreadable segment " + path;
+        ::close(fd);
+        return false;
+    }
+    void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        error = "mmap " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    m_addr = addr;
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+}
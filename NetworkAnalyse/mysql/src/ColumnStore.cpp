@@ -0,0 +1,898 @@
+#include "ColumnStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "TimeFormat.h"
+
+using nlohmann::json;
+using namespace column_segment;
+
+namespace {
+const char* TIME_COLUMN = "timestamp";
+const size_t MAX_QUERY_LIMIT = 100000;
+const int64_t DROP_INTERVAL_US = 60 * 1000000LL;
+
+// 表名直接用作目录名，只允许字母数字下划线（查询来自 HTTP 请求）
+bool valid_name(const std::string& name)
+{
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    });
+}
+
+bool make_dir(const std::string& path)
+{
+    return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool write_all(int fd, const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::vector<std::string> list_dir(const std::string& path)
+{
+    std::vector<std::string> names;
+    if (DIR* d = ::opendir(path.c_str()))
+    {
+        while (dirent* entry = ::readdir(d))
+            if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+        ::closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void remove_tree(const std::string& path)
+{
+    for (const auto& name : list_dir(path)) ::unlink((path + "/" + name).c_str());
+    ::rmdir(path.c_str());
+}
+
+// 分区目录名 YYYYMMDDHH（本地时间）-> 起点 epoch 秒，不是分区目录返回 -1
+int64_t parse_partition(const std::string& name)
+{
+    std::tm tm = {};
+    if (name.size() != 10 ||
+        std::sscanf(name.c_str(), "%4d%2d%2d%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour) != 4)
+        return -1;
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&tm));
+}
+
+int compare(int64_t a, int64_t b) { return a < b ? -1 : a > b ? 1 : 0; }
+int compare(std::string_view a, std::string_view b) { int c = a.compare(b); return c < 0 ? -1 : c > 0 ? 1 : 0; }
+
+bool test(ColumnFilter::Op op, int c)
+{
+    switch (op)
+    {
+    case ColumnFilter::Op::EQ: return c == 0;
+    case ColumnFilter::Op::NE: return c != 0;
+    case ColumnFilter::Op::LT: return c < 0;
+    case ColumnFilter::Op::LE: return c <= 0;
+    case ColumnFilter::Op::GT: return c > 0;
+    case ColumnFilter::Op::GE: return c >= 0;
+    }
+    return false;
+}
+
+// 段内 [min, max] 中是否可能有满足 op value 的值
+template <class T>
+bool range_may_match(ColumnFilter::Op op, const T& min, const T& max, const T& value)
+{
+    switch (op)
+    {
+    case ColumnFilter::Op::EQ: return compare(min, value) <= 0 && compare(max, value) >= 0;
+    case ColumnFilter::Op::NE: return !(compare(min, value) == 0 && compare(max, value) == 0);
+    case ColumnFilter::Op::LT: return compare(min, value) < 0;
+    case ColumnFilter::Op::LE: return compare(min, value) <= 0;
+    case ColumnFilter::Op::GT: return compare(max, value) > 0;
+    case ColumnFilter::Op::GE: return compare(max, value) >= 0;
+    }
+    return true;
+}
+
+json cell_json(const ColumnVector& column, size_t row)
+{
+    if (column.is_null(row)) return nullptr;
+    switch (column.type)
+    {
+    case ColumnType::INT:       return column.ints[row];
+    case ColumnType::DATETIME:  return format_datetime_us(column.ints[row]);
+    case ColumnType::STRING:    return std::string(column.text(row));
+    }
+    return nullptr;
+}
+
+SqlValue cell_value(const ColumnVector& column, size_t row)
+{
+    if (column.is_null(row)) return SqlValue::null();
+    switch (column.type)
+    {
+    case ColumnType::INT:       return SqlValue::integer(column.ints[row]);
+    case ColumnType::DATETIME:  return SqlValue::datetime_us(column.ints[row]);
+    case ColumnType::STRING:    return SqlValue::text(std::string(column.text(row)));
+    }
+    return SqlValue::null();
+}
+
+/**
+ * 一个段上的查询：绑定过滤条件（按列类型转换比较值、min/max 剪枝、字典预匹配），按需解码列
+ */
+class SegmentMatcher
+{
+public:
+    explicit SegmentMatcher(const SegmentView& view) : m_view(view) {}
+
+    /**
+     * @return 1 可能有命中，0 整段可跳过（缺列、min/max 不相交或数据损坏），-1 过滤值与列类型不符
+     */
+    int bind(const std::vector<ColumnFilter>& filters, std::string& error)
+    {
+        for (const auto& filter : filters)
+        {
+            int index = m_view.find(filter.column);
+            if (index < 0) return 0;    // 缺列视为全 NULL，任何比较都不成立
+            const ColumnMeta& meta = m_view.columns()[index];
+            // 段内该列全为 NULL：任何比较都不成立。此时列类型无从推断（编码为 INT），
+            // 不能按 INT 转换过滤值，否则文本/时间条件会被当作类型不符而使整个查询失败
+            if (meta.has_nulls && !meta.has_minmax && meta.type != ColumnType::STRING) return 0;
+
+            // 先用 min/max 判断，整段跳过时不必解码
+            Bound bound;
+            bound.op = filter.op;
+            if (meta.type == ColumnType::STRING)
+            {
+                const SqlValue& v = filter.value;
+                bound.text = v.type == SqlValue::Type::STRING ? v.s
+                           : v.type == SqlValue::Type::UINT ? std::to_string(v.u) : std::to_string(v.i);
+                if (meta.has_minmax && !range_may_match<std::string_view>(filter.op, meta.min_text, meta.max_text, bound.text))
+                    return 0;
+                if (!(bound.column = load(index))) return 0;
+                if (bound.column->is_dict())
+                {
+                    // 每个字典项只比较一次，逐行只查表
+                    bound.dict_match.resize(bound.column->dict.size());
+                    for (size_t i = 0; i < bound.column->dict.size(); ++i)
+                        bound.dict_match[i] = test(filter.op, compare(bound.column->dict[i], bound.text));
+                }
+            }
+            else
+            {
+                if (!integer_value(filter, meta.type, bound.number, error)) return -1;
+                if (meta.has_minmax && !range_may_match<int64_t>(filter.op, meta.min_int, meta.max_int, bound.number))
+                    return 0;
+                if (!(bound.column = load(index))) return 0;
+            }
+            m_bounds.push_back(std::move(bound));
+        }
+        return 1;
+    }
+
+    bool match(size_t row) const
+    {
+        for (const auto& bound : m_bounds)
+        {
+            const ColumnVector& column = *bound.column;
+            if (column.is_null(row)) return false;
+            bool ok = column.type != ColumnType::STRING ? test(bound.op, compare(column.ints[row], bound.number))
+                    : !bound.dict_match.empty() ? bound.dict_match[column.codes[row]] != 0
+                    : test(bound.op, compare(column.text(row), bound.text));
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    // 按列名取解码后的列，段内没有该列或解码失败返回 nullptr
+    const ColumnVector* column(const std::string& name)
+    {
+        int index = m_view.find(name);
+        return index < 0 ? nullptr : load(index);
+    }
+
+    uint32_t rows() const { return m_view.rows(); }
+
+private:
+    struct Bound
+    {
+        ColumnFilter::Op        op = ColumnFilter::Op::EQ;
+        const ColumnVector*     column = nullptr;
+        int64_t                 number = 0;
+        std::string             text;
+        std::vector<uint8_t>    dict_match;
+    };
+
+    const ColumnVector* load(int index)
+    {
+        auto it = m_decoded.find(index);
+        if (it != m_decoded.end()) return it->second.get();
+        std::unique_ptr<ColumnVector> column(new ColumnVector());
+        std::string error;
+        if (!m_view.decode(index, *column, error))
+        {
+            spdlog::warn("Column store: {}, segment skipped", error);
+            column.reset();
+        }
+        return (m_decoded[index] = std::move(column)).get();
+    }
+
+    static bool integer_value(const ColumnFilter& filter, ColumnType type, int64_t& out, std::string& error)
+    {
+        const SqlValue& v = filter.value;
+        switch (v.type)
+        {
+        case SqlValue::Type::INT:
+        case SqlValue::Type::DATETIME:  out = v.i; return true;
+        case SqlValue::Type::UINT:      out = static_cast<int64_t>(v.u); return true;
+        case SqlValue::Type::STRING:
+        {
+            if (type == ColumnType::DATETIME && parse_datetime_us(v.s, out)) return true;
+            char* end = nullptr;
+            errno = 0;
+            out = std::strtoll(v.s.c_str(), &end, 10);
+            if (!v.s.empty() && *end == '\0' && errno == 0) return true;
+            break;
+        }
+        default:
+            break;
+        }
+        error = "filter value for " + filter.column + " is not a number";
+        return false;
+    }
+
+    const SegmentView&                                          m_view;
+    std::vector<Bound>                                          m_bounds;
+    std::unordered_map<int, std::unique_ptr<ColumnVector>>      m_decoded;
+};
+
+struct Accumulator
+{
+    uint64_t    count = 0;
+    int64_t     sum = 0;
+    int64_t     min = 0;
+    int64_t     max = 0;
+};
+
+struct Group
+{
+    json                        keys = json::object();
+    uint64_t                    rows = 0;
+    std::vector<Accumulator>    values;
+};
+
+std::string aggregate_name(const ColumnAggregate& aggregate)
+{
+    static const char* kOps[] = {"count", "sum", "min", "max", "avg"};
+    if (aggregate.op == ColumnAggregate::Op::COUNT) return "count";
+    return std::string(kOps[static_cast<int>(aggregate.op)]) + "(" + aggregate.column + ")";
+}
+
+std::vector<ColumnFilter> query_filters(const ColumnQuery& query)
+{
+    std::vector<ColumnFilter> filters = query.filters;
+    if (query.from_us > 0)
+        filters.push_back(ColumnFilter{TIME_COLUMN, ColumnFilter::Op::GE, SqlValue::datetime_us(query.from_us)});
+    if (query.to_us > 0)
+        filters.push_back(ColumnFilter{TIME_COLUMN, ColumnFilter::Op::LT, SqlValue::datetime_us(query.to_us)});
+    return filters;
+}
+
+bool time_value(const json& j, int64_t& out)
+{
+    if (j.is_number_integer()) { out = j.get<int64_t>(); return true; }
+    return j.is_string() && parse_datetime_us(j.get<std::string>(), out);
+}
+}
+
+bool ColumnQuery::from_json(const json& j, ColumnQuery& query, std::string& error)
+{
+    static const std::map<std::string, ColumnFilter::Op> kFilterOps = {
+        {"=", ColumnFilter::Op::EQ}, {"!=", ColumnFilter::Op::NE}, {"<", ColumnFilter::Op::LT},
+        {"<=", ColumnFilter::Op::LE}, {">", ColumnFilter::Op::GT}, {">=", ColumnFilter::Op::GE}};
+    static const std::map<std::string, ColumnAggregate::Op> kAggregateOps = {
+        {"count", ColumnAggregate::Op::COUNT}, {"sum", ColumnAggregate::Op::SUM}, {"min", ColumnAggregate::Op::MIN},
+        {"max", ColumnAggregate::Op::MAX}, {"avg", ColumnAggregate::Op::AVG}};
+
+    try
+    {
+        query = ColumnQuery();
+        query.table = j.at("table").get<std::string>();
+        if (j.contains("from") && !time_value(j["from"], query.from_us)) { error = "bad 'from'"; return false; }
+        if (j.contains("to") && !time_value(j["to"], query.to_us)) { error = "bad 'to'"; return false; }
+        for (const auto& f : j.value("filters", json::array()))
+        {
+            ColumnFilter filter;
+            filter.column = f.at("column").get<std::string>();
+            auto op = kFilterOps.find(f.value("op", "="));
+            if (op == kFilterOps.end()) { error = "unknown filter op for " + filter.column; return false; }
+            filter.op = op->second;
+            const json& value = f.at("value");
+            if (value.is_number_unsigned()) filter.value = SqlValue::uinteger(value.get<uint64_t>());
+            else if (value.is_number_integer()) filter.value = SqlValue::integer(value.get<int64_t>());
+            else if (value.is_string()) filter.value = SqlValue::text(value.get<std::string>());
+            else { error = "filter value for " + filter.column + " must be a number or string"; return false; }
+            query.filters.push_back(std::move(filter));
+        }
+        query.columns = j.value("columns", std::vector<std::string>());
+        query.group_by = j.value("group_by", std::vector<std::string>());
+        for (const auto& a : j.value("aggregates", json::array()))
+        {
+            ColumnAggregate aggregate;
+            auto op = kAggregateOps.find(a.at("op").get<std::string>());
+            if (op == kAggregateOps.end()) { error = "unknown aggregate op"; return false; }
+            aggregate.op = op->second;
+            aggregate.column = a.value("column", "");
+            if (aggregate.op != ColumnAggregate::Op::COUNT && aggregate.column.empty())
+            {
+                error = "aggregate needs a column";
+                return false;
+            }
+            query.aggregates.push_back(std::move(aggregate));
+        }
+        query.order_by = j.value("order_by", "");
+        query.limit = std::min<size_t>(j.value("limit", static_cast<size_t>(1000)), MAX_QUERY_LIMIT);
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+        return false;
+    }
+}
+
+ColumnStore::ColumnStore(const std::string& dir, const ColumnStoreConfig& config)
+    : m_dir(dir)
+    , m_config(config)
+{
+    if (m_config.partition_hours <= 0 || 24 % m_config.partition_hours != 0) m_config.partition_hours = 24;
+    if (!make_dir(m_dir)) spdlog::error("Column store: cannot create {}: {}", m_dir, std::strerror(errno));
+    m_thread = std::thread(&ColumnStore::run, this);
+}
+
+ColumnStore::~ColumnStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    flush();
+    if (m_unwritten_rows > 0)
+        spdlog::error("Column store: {} rows could not be written and are lost", m_unwritten_rows);
+}
+
+std::shared_ptr<ColumnStore> ColumnStore::shared()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<ColumnStore> instance;
+
+    const char* dir = std::getenv("NETWORK_ANALYSE_COLUMN_STORE");
+    if (!dir || !*dir) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<ColumnStore> store = instance.lock();
+    if (!store)
+    {
+        ColumnStoreConfig config;
+        if (const char* days = std::getenv("NETWORK_ANALYSE_COLUMN_RETENTION_DAYS"))
+            config.retention_hours = std::max(0, std::atoi(days)) * 24;
+        store = std::make_shared<ColumnStore>(dir, config);
+        instance = store;
+        spdlog::info("Column store enabled at {} (retention {}h)", dir, config.retention_hours);
+    }
+    return store;
+}
+
+int64_t ColumnStore::partition_of(int64_t epoch_us) const
+{
+    std::time_t seconds = static_cast<std::time_t>((epoch_us > 0 ? epoch_us : now_us()) / 1000000);
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    tm.tm_hour = tm.tm_hour / m_config.partition_hours * m_config.partition_hours;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&tm));
+}
+
+std::string ColumnStore::partition_dir(const std::string& table, int64_t partition) const
+{
+    std::time_t seconds = static_cast<std::time_t>(partition);
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    char name[16];
+    std::strftime(name, sizeof(name), "%Y%m%d%H", &tm);
+    return m_dir + "/" + table + "/" + name;
+}
+
+bool ColumnStore::append(const std::string& table, const std::vector<std::string>& columns,
+                         const std::vector<SqlRow>& rows)
+{
+    if (!valid_name(table))
+    {
+        spdlog::error("Column store: invalid table name '{}'", table);
+        return false;
+    }
+    auto time_it = std::find(columns.begin(), columns.end(), TIME_COLUMN);
+    size_t time_column = static_cast<size_t>(time_it - columns.begin());
+
+    std::vector<std::pair<BufferKey, Buffer>> full;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int64_t now = now_us();
+        // 相邻行大多落在同一分区，缓存上一行的分区范围以省去 localtime
+        int64_t cached_begin = 0, cached_end = 0, partition = 0;
+        for (const auto& row : rows)
+        {
+            int64_t ts = time_column < row.size() ? row[time_column].i : 0;
+            if (ts <= 0) ts = now;
+            if (ts < cached_begin || ts >= cached_end)
+            {
+                partition = partition_of(ts);
+                cached_begin = partition * 1000000;
+                cached_end = cached_begin + static_cast<int64_t>(m_config.partition_hours) * 3600 * 1000000;
+            }
+
+            BufferKey key(table, partition);
+            Buffer& buffer = m_buffers[key];
+            if (!buffer.rows.empty() && buffer.columns != columns)
+            {
+                // 列变化（升级后表结构不同）：旧缓冲先单独成段
+                full.emplace_back(key, std::move(buffer));
+                buffer = Buffer();
+            }
+            if (buffer.rows.empty())
+            {
+                buffer.columns = columns;
+                buffer.first_us = now;
+            }
+            buffer.rows.push_back(row);
+            if (buffer.rows.size() >= m_config.segment_rows)
+            {
+                full.emplace_back(key, std::move(buffer));
+                m_buffers.erase(key);
+            }
+        }
+        m_rows_appended += rows.size();
+    }
+
+    return write_or_keep(full);
+}
+
+bool ColumnStore::write_segment(const std::string& table, int64_t partition, const Buffer& buffer)
+{
+    if (buffer.rows.empty()) return true;
+    std::string data = encode(buffer.columns, buffer.rows);
+
+    std::string dir = partition_dir(table, partition);
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        seq = ++m_segment_seq;
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%016" PRId64 "-%06" PRIu64 ".seg", now_us(), seq);
+    std::string path = dir + name;
+    std::string tmp = path + ".tmp";
+
+    bool ok = make_dir(m_dir + "/" + table) && make_dir(dir);
+    int fd = ok ? ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    ok = fd >= 0 && write_all(fd, data.data(), data.size()) && ::fdatasync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    ok = ok && ::rename(tmp.c_str(), path.c_str()) == 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!ok)
+    {
+        ++m_write_failures;
+        spdlog::error("Column store: failed to write {} rows to {}: {}", buffer.rows.size(), path, std::strerror(errno));
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    ++m_segments_written;
+    m_bytes_written += data.size();
+    spdlog::debug("Column store: wrote {} rows of {} to {} ({} bytes)", buffer.rows.size(), table, path, data.size());
+    return true;
+}
+
+bool ColumnStore::write_or_keep(std::vector<std::pair<BufferKey, Buffer>>& buffers)
+{
+    std::vector<std::pair<BufferKey, Buffer>> failed;
+    for (auto& item : buffers)
+    {
+        if (!write_segment(item.first.first, item.first.second, item.second)) failed.push_back(std::move(item));
+    }
+    if (failed.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t now = now_us();
+    for (auto& item : failed)
+    {
+        item.second.first_us = now;     // flush_delay_ms 后再试
+        m_unwritten_rows += item.second.rows.size();
+        m_unwritten.push_back(std::move(item));
+    }
+    bool dropped = false;
+    while (m_unwritten_rows > m_config.max_unwritten_rows && !m_unwritten.empty())
+    {
+        const auto& oldest = m_unwritten.front();
+        size_t rows = oldest.second.rows.size();
+        spdlog::error("Column store: {} unwritten rows exceed the limit, dropped {} rows of {}",
+                      m_unwritten_rows, rows, oldest.first.first);
+        m_unwritten_rows -= rows;
+        m_dropped_rows += rows;
+        m_unwritten.erase(m_unwritten.begin());
+        dropped = true;
+    }
+    return !dropped;
+}
+
+void ColumnStore::flush_due(bool all)
+{
+    std::vector<std::pair<BufferKey, Buffer>> due;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int64_t now = now_us();
+        // 先重试此前写失败的缓冲，保持先后顺序
+        for (auto it = m_unwritten.begin(); it != m_unwritten.end();)
+        {
+            if (all || now - it->second.first_us >= m_config.flush_delay_ms * 1000)
+            {
+                m_unwritten_rows -= it->second.rows.size();
+                due.push_back(std::move(*it));
+                it = m_unwritten.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (auto it = m_buffers.begin(); it != m_buffers.end();)
+        {
+            if (all || now - it->second.first_us >= m_config.flush_delay_ms * 1000)
+            {
+                due.emplace_back(it->first, std::move(it->second));
+                it = m_buffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    write_or_keep(due);
+}
+
+void ColumnStore::flush()
+{
+    flush_due(true);
+}
+
+void ColumnStore::drop_expired()
+{
+    if (m_config.retention_hours <= 0) return;
+    // 分区最长 24 小时：起点早于 截止时间 - 分区时长 的分区已全部过期
+    int64_t cutoff = now_us() / 1000000 - static_cast<int64_t>(m_config.retention_hours) * 3600
+                   - static_cast<int64_t>(m_config.partition_hours) * 3600;
+    for (const auto& table : list_dir(m_dir))
+    {
+        for (const auto& name : list_dir(m_dir + "/" + table))
+        {
+            int64_t start = parse_partition(name);
+            if (start < 0 || start >= cutoff) continue;
+            remove_tree(m_dir + "/" + table + "/" + name);
+            spdlog::info("Column store: dropped expired partition {}/{}", table, name);
+        }
+    }
+}
+
+void ColumnStore::run()
+{
+    int64_t last_drop = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait_for(lock, std::chrono::seconds(1), [this] { return m_stop; });
+            if (m_stop) break;
+        }
+        flush_due(false);
+        if (now_us() - last_drop >= DROP_INTERVAL_US)
+        {
+            drop_expired();
+            last_drop = now_us();
+        }
+    }
+}
+
+bool ColumnStore::for_each_segment(const ColumnQuery& query,
+                                   const std::function<bool(const SegmentView&)>& visitor,
+                                   std::string& error)
+{
+    if (!valid_name(query.table))
+    {
+        error = "invalid table name";
+        return false;
+    }
+
+    std::string table_dir = m_dir + "/" + query.table;
+    for (const auto& name : list_dir(table_dir))
+    {
+        // 分区最长 24 小时（分区时长可能改过），按此判断分区是否与查询范围相交
+        int64_t start = parse_partition(name);
+        if (start < 0) continue;
+        if (query.to_us > 0 && start * 1000000 >= query.to_us) continue;
+        if (query.from_us > 0 && (start + 24 * 3600) * 1000000 <= query.from_us) continue;
+
+        for (const auto& file : list_dir(table_dir + "/" + name))
+        {
+            if (file.size() < 4 || file.compare(file.size() - 4, 4, ".seg") != 0) continue;
+            std::string path = table_dir + "/" + name + "/" + file;
+            MappedFile mapped;
+            SegmentView view;
+            std::string reason;
+            if (!mapped.open(path, reason) || !view.parse(mapped.data(), mapped.size(), reason))
+            {
+                spdlog::warn("Column store: skipping {}: {}", path, reason);
+                continue;
+            }
+            if (!visitor(view)) return true;
+        }
+    }
+
+    // 尚未写出的缓冲行：临时编码成段，与文件中的段走同一路径
+    std::vector<std::pair<std::vector<std::string>, std::vector<SqlRow>>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& item : m_unwritten)
+            if (item.first.first == query.table) pending.emplace_back(item.second.columns, item.second.rows);
+        for (const auto& item : m_buffers)
+            if (item.first.first == query.table) pending.emplace_back(item.second.columns, item.second.rows);
+    }
+    for (const auto& item : pending)
+    {
+        std::string data = encode(item.first, item.second);
+        SegmentView view;
+        std::string reason;
+        if (view.parse(data.data(), data.size(), reason) && !visitor(view)) return true;
+    }
+    return true;
+}
+
+int64_t ColumnStore::scan(const ColumnQuery& query, const RowCallback& callback, std::string& error)
+{
+    std::vector<ColumnFilter> filters = query_filters(query);
+    int64_t emitted = 0;
+    bool failed = false;
+    bool ok = for_each_segment(query, [&](const SegmentView& view) {
+        SegmentMatcher matcher(view);
+        int bound = matcher.bind(filters, error);
+        if (bound < 0) { failed = true; return false; }
+        if (bound == 0) return true;
+
+        std::vector<std::string> names = query.columns;
+        if (names.empty())
+            for (const auto& meta : view.columns()) names.push_back(meta.name);
+        std::vector<const ColumnVector*> columns;
+        for (const auto& name : names) columns.push_back(matcher.column(name));
+
+        SqlRow row(names.size());
+        for (size_t r = 0; r < matcher.rows(); ++r)
+        {
+            if (!matcher.match(r)) continue;
+            for (size_t c = 0; c < columns.size(); ++c)
+                row[c] = columns[c] ? cell_value(*columns[c], r) : SqlValue::null();
+            ++emitted;
+            if (!callback(names, row) || static_cast<size_t>(emitted) >= query.limit) return false;
+        }
+        return true;
+    }, error);
+    return ok && !failed ? emitted : -1;
+}
+
+json ColumnStore::aggregate(const ColumnQuery& query, std::string& error)
+{
+    std::vector<ColumnFilter> filters = query_filters(query);
+    std::unordered_map<std::string, Group> groups;
+    bool failed = false;
+    bool ok = for_each_segment(query, [&](const SegmentView& view) {
+        SegmentMatcher matcher(view);
+        int bound = matcher.bind(filters, error);
+        if (bound < 0) { failed = true; return false; }
+        if (bound == 0) return true;
+
+        std::vector<const ColumnVector*> keys;
+        for (const auto& name : query.group_by) keys.push_back(matcher.column(name));
+        std::vector<const ColumnVector*> values;
+        for (const auto& aggregate : query.aggregates)
+        {
+            const ColumnVector* column = aggregate.op == ColumnAggregate::Op::COUNT ? nullptr : matcher.column(aggregate.column);
+            if (column && column->type == ColumnType::STRING)
+            {
+                error = "cannot aggregate string column " + aggregate.column;
+                failed = true;
+                return false;
+            }
+            values.push_back(column);
+        }
+
+        std::string key;
+        for (size_t r = 0; r < matcher.rows(); ++r)
+        {
+            if (!matcher.match(r)) continue;
+            key.clear();
+            for (const ColumnVector* column : keys)
+            {
+                if (!column || column->is_null(r)) key += 'n';
+                else if (column->type == ColumnType::STRING)
+                {
+                    std::string_view text = column->text(r);
+                    key += 's' + std::to_string(text.size()) + ':';
+                    key.append(text.data(), text.size());
+                }
+                else key += 'i' + std::to_string(column->ints[r]) + ';';
+            }
+            Group& group = groups[key];
+            if (group.rows++ == 0)
+            {
+                group.values.resize(query.aggregates.size());
+                for (size_t k = 0; k < keys.size(); ++k)
+                    group.keys[query.group_by[k]] = keys[k] ? cell_json(*keys[k], r) : json(nullptr);
+            }
+            for (size_t a = 0; a < values.size(); ++a)
+            {
+                const ColumnVector* column = values[a];
+                Accumulator& acc = group.values[a];
+                if (!column)
+                {
+                    // COUNT 计行数；其余聚合列在本段缺失，视为 NULL
+                    if (query.aggregates[a].op == ColumnAggregate::Op::COUNT) ++acc.count;
+                    continue;
+                }
+                if (column->is_null(r)) continue;
+                int64_t v = column->ints[r];
+                if (acc.count == 0 || v < acc.min) acc.min = v;
+                if (acc.count == 0 || v > acc.max) acc.max = v;
+                acc.sum += v;
+                ++acc.count;
+            }
+        }
+        return true;
+    }, error);
+    if (!ok || failed) return nullptr;
+
+    std::vector<json> rows;
+    rows.reserve(groups.size());
+    for (auto& item : groups)
+    {
+        Group& group = item.second;
+        json row = std::move(group.keys);
+        for (size_t a = 0; a < query.aggregates.size(); ++a)
+        {
+            const ColumnAggregate& aggregate = query.aggregates[a];
+            const Accumulator& acc = group.values[a];
+            json& out = row[aggregate_name(aggregate)];
+            bool is_time = aggregate.column == TIME_COLUMN;
+            switch (aggregate.op)
+            {
+            case ColumnAggregate::Op::COUNT: out = acc.count; break;
+            case ColumnAggregate::Op::SUM:   out = acc.sum; break;
+            case ColumnAggregate::Op::MIN:   out = acc.count ? (is_time ? json(format_datetime_us(acc.min)) : json(acc.min)) : json(nullptr); break;
+            case ColumnAggregate::Op::MAX:   out = acc.count ? (is_time ? json(format_datetime_us(acc.max)) : json(acc.max)) : json(nullptr); break;
+            case ColumnAggregate::Op::AVG:   out = acc.count ? json(static_cast<double>(acc.sum) / acc.count) : json(nullptr); break;
+            }
+        }
+        rows.push_back(std::move(row));
+    }
+    if (!query.order_by.empty())
+    {
+        const std::string& key = query.order_by;
+        std::sort(rows.begin(), rows.end(), [&key](const json& a, const json& b) {
+            auto ia = a.find(key), ib = b.find(key);
+            if (ia == a.end() || ib == b.end()) return ia != a.end();
+            return *ib < *ia;
+        });
+    }
+    if (rows.size() > query.limit) rows.resize(query.limit);
+    return json(std::move(rows));
+}
+
+json ColumnStore::query(const json& request)
+{
+    json result;
+    ColumnQuery query;
+    std::string error;
+    if (!ColumnQuery::from_json(request, query, error))
+    {
+        result["error"] = 1;
+        result["message"] = error;
+        return result;
+    }
+
+    if (!query.aggregates.empty())
+    {
+        json rows = aggregate(query, error);
+        if (rows.is_null())
+        {
+            result["error"] = 1;
+            result["message"] = error;
+            return result;
+        }
+        result["error"] = 0;
+        result["rows"] = std::move(rows);
+        return result;
+    }
+
+    json rows = json::array();
+    int64_t count = scan(query, [&](const std::vector<std::string>& names, const SqlRow& row) {
+        json item = json::object();
+        for (size_t c = 0; c < row.size(); ++c)
+        {
+            const SqlValue& v = row[c];
+            const std::string& name = names[c];
+            switch (v.type)
+            {
+            case SqlValue::Type::INT:       item[name] = v.i; break;
+            case SqlValue::Type::UINT:      item[name] = v.u; break;
+            case SqlValue::Type::STRING:    item[name] = v.s; break;
+            case SqlValue::Type::DATETIME:  item[name] = format_datetime_us(v.i); break;
+            case SqlValue::Type::NUL:       item[name] = nullptr; break;
+            }
+        }
+        rows.push_back(std::move(item));
+        return true;
+    }, error);
+    if (count < 0)
+    {
+        result["error"] = 1;
+        result["message"] = error;
+        return result;
+    }
+    result["error"] = 0;
+    result["rows"] = std::move(rows);
+    return result;
+}
+
+json ColumnStore::status() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t buffered = 0;
+    for (const auto& item : m_buffers) buffered += item.second.rows.size();
+    json j;
+    j["dir"] = m_dir;
+    j["buffered_rows"] = buffered;
+    j["unwritten_rows"] = m_unwritten_rows;     // 写段失败、等待重试
+    j["dropped_rows"] = m_dropped_rows;
+    j["rows_appended"] = m_rows_appended;
+    j["segments_written"] = m_segments_written;
+    j["bytes_written"] = m_bytes_written;
+    j["write_failures"] = m_write_failures;
+    j["partition_hours"] = m_config.partition_hours;
+    j["retention_hours"] = m_config.retention_hours;
+    return j;
+}
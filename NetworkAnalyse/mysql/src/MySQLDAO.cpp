@@ -1,41 +1,404 @@
 #include "MySQLDAO.h"
+#include "ColumnStore.h"
+#include "PartitionManager.h"
+#include "SpoolReplayer.h"
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <spdlog/spdlog.h>
 
-std::string format_mysql_datetime(const std::string& iso_time) {
-    if (iso_time.empty()) return "";
+namespace {
+// 绑定 DATETIME 参数：保留微秒（DATETIME(6) 列可完整保存），0 表示未知写 NULL
+void set_datetime(sql::PreparedStatement* stmt, int idx, int64_t epoch_us)
+{
+    if (epoch_us == 0) stmt->setNull(idx, sql::DataType::TIMESTAMP);
+    else stmt->setString(idx, format_datetime_us(epoch_us));
+}
+
+// 报文 JSON 的 timestamp：解析线程输出 epoch 微秒，兼容旧的时间文本
+int64_t json_timestamp(const json& j)
+{
+    auto it = j.find("timestamp");
+    if (it == j.end()) return 0;
+    if (it->is_number_integer()) return it->get<int64_t>();
+    int64_t epoch_us = 0;
+    if (it->is_string() && parse_datetime_us(it->get_ref<const std::string&>(), epoch_us)) return epoch_us;
+    return 0;
+}
+
+// 多行语句的行数：满 chunk 之外的余数按 2 的幂拆分，
+// 使每张表的语句形态有限（约 log2(chunk) 种），都能命中连接上缓存的预编译语句
+size_t multi_row_count(size_t remaining, size_t chunk)
+{
+    if (remaining >= chunk) return chunk;
+    size_t count = 1;
+    while (count * 2 <= remaining) count *= 2;
+    return count;
+}
 
-    // 示例："2025-05-25T07:50:41.520134Z"
-    std::string formatted = iso_time;
-    size_t t_pos = formatted.find('T');
-    if (t_pos != std::string::npos) {
-        formatted[t_pos] = ' ';
+// 在一个事务内执行 body（返回写入数），成功则提交；失败回滚后把异常抛给调用方
+template <class Body>
+int in_transaction(PooledConnection& conn, Body&& body)
+{
+    sql::Connection* con = conn.connection();
+    con->setAutoCommit(false);
+    try
+    {
+        int written = body();
+        con->commit();
+        con->setAutoCommit(true);
+        return written;
+    }
+    catch (...)
+    {
+        try
+        {
+            con->rollback();
+            con->setAutoCommit(true);
+        }
+        catch (const std::exception& re)
+        {
+            spdlog::error("Rollback failed: {}", re.what());
+        }
+        throw;
     }
-    size_t dot_pos = formatted.find('.');
-    if (dot_pos != std::string::npos) {
-        formatted = formatted.substr(0, dot_pos); // 去掉毫秒
+}
+
+// 会话增量合并进已有行的规则（多行 INSERT 与批量导入的 INSERT ... SELECT 共用）；
+// INSERT ... SELECT 的来源表有同名列，目标表的列都要带表名限定
+const char* kSessionUpsert = R"(
+        ON DUPLICATE KEY UPDATE
+            session_info.packet_count = session_info.packet_count + VALUES(packet_count),
+            session_info.packets_up = session_info.packets_up + VALUES(packets_up),
+            session_info.packets_down = session_info.packets_down + VALUES(packets_down),
+            session_info.bytes_up = session_info.bytes_up + VALUES(bytes_up),
+            session_info.bytes_down = session_info.bytes_down + VALUES(bytes_down),
+            session_info.retransmissions = session_info.retransmissions + VALUES(retransmissions),
+            session_info.out_of_order = session_info.out_of_order + VALUES(out_of_order),
+            session_info.zero_window = session_info.zero_window + VALUES(zero_window),
+            session_info.handshake_rtt_us = IF(VALUES(handshake_rtt_us) > 0, VALUES(handshake_rtt_us),
+                                               session_info.handshake_rtt_us),
+            session_info.duration_us = GREATEST(session_info.duration_us, VALUES(duration_us)),
+            session_info.sample_rate = GREATEST(session_info.sample_rate, VALUES(sample_rate)),
+            session_info.server_name = IF(VALUES(server_name) <> '', VALUES(server_name), session_info.server_name),
+            session_info.close_reason = IF(VALUES(close_reason) <> '', VALUES(close_reason), session_info.close_reason),
+            session_info.end_time = IFNULL(VALUES(end_time), session_info.end_time),
+            session_info.payload_fingerprint = IF(session_info.payload_fingerprint = '', VALUES(payload_fingerprint),
+                                                  session_info.payload_fingerprint),
+            session_info.last_seen = IFNULL(VALUES(last_seen), session_info.last_seen),
+            session_info.features = IFNULL(VALUES(features), session_info.features)
+    )";
+
+// 稍后重试可能成功的错误：连接断开/拒绝、连接数满、库停机或只读维护、锁等待超时与死锁
+bool is_transient(const sql::SQLException& e)
+{
+    switch (e.getErrorCode())
+    {
+    case 1040: case 1053: case 1205: case 1213: case 1290:
+    case 2002: case 2003: case 2006: case 2013: case 2055:
+        return true;
+    default:
+        return false;
     }
-    size_t z_pos = formatted.find('Z');
-    if (z_pos != std::string::npos) {
-        formatted = formatted.substr(0, z_pos);
+}
+
+// ---- 暂存批次的 JSON 编码（spool 记录格式，回放时原样还原）----
+
+json sql_value_to_json(const SqlValue& v)
+{
+    switch (v.type)
+    {
+    case SqlValue::Type::INT:       return v.i;
+    case SqlValue::Type::UINT:      return v.u;
+    case SqlValue::Type::STRING:    return v.s;
+    case SqlValue::Type::DATETIME:  return json{{"t", v.i}};
+    case SqlValue::Type::NUL:
+    default:                        return nullptr;
     }
-    return formatted;
+}
+
+SqlValue sql_value_from_json(const json& j)
+{
+    if (j.is_number_unsigned()) return SqlValue::uinteger(j.get<uint64_t>());
+    if (j.is_number_integer()) return SqlValue::integer(j.get<int64_t>());
+    if (j.is_string()) return SqlValue::text(j.get<std::string>());
+    if (j.is_object()) return SqlValue::datetime_us(j.at("t").get<int64_t>());
+    return SqlValue::null();
+}
+
+json session_to_json(const SessionInfo& s)
+{
+    return json{{"app_uid", s.app_uid}, {"timestamp_us", s.timestamp_us}, {"session_id", s.session_id},
+                {"protocol", s.protocol}, {"src_ip", s.src_ip}, {"src_port", s.src_port},
+                {"dst_ip", s.dst_ip}, {"dst_port", s.dst_port}, {"size", s.size},
+                {"server_name", s.server_name}, {"device", s.device}, {"initiator_known", s.initiator_known},
+                {"packets_up", s.packets_up}, {"packets_down", s.packets_down},
+                {"bytes_up", s.bytes_up}, {"bytes_down", s.bytes_down},
+                {"retransmissions", s.retransmissions}, {"out_of_order", s.out_of_order},
+                {"zero_window", s.zero_window}, {"handshake_rtt_us", s.handshake_rtt_us},
+                {"duration_us", s.duration_us}, {"sample_rate", s.sample_rate},
+                {"payload_fingerprint", s.payload_fingerprint}, {"features", s.features},
+                {"last_seen_us", s.last_seen_us},
+                {"close_reason", s.close_reason}, {"end_time", static_cast<int64_t>(s.end_time)},
+                {"persisted", s.persisted}};
+}
+
+SessionInfo session_from_json(const json& j)
+{
+    SessionInfo s;
+    s.app_uid = j.at("app_uid").get<int>();
+    s.timestamp_us = j.at("timestamp_us").get<int64_t>();
+    s.session_id = j.at("session_id").get<std::string>();
+    s.protocol = j.at("protocol").get<std::string>();
+    s.src_ip = j.at("src_ip").get<std::string>();
+    s.src_port = j.at("src_port").get<int>();
+    s.dst_ip = j.at("dst_ip").get<std::string>();
+    s.dst_port = j.at("dst_port").get<int>();
+    s.size = j.at("size").get<int>();
+    s.server_name = j.at("server_name").get<std::string>();
+    s.device = j.value("device", "");      // 旧的暂存记录没有该字段
+    s.initiator_known = j.at("initiator_known").get<bool>();
+    s.packets_up = j.at("packets_up").get<uint64_t>();
+    s.packets_down = j.at("packets_down").get<uint64_t>();
+    s.bytes_up = j.at("bytes_up").get<uint64_t>();
+    s.bytes_down = j.at("bytes_down").get<uint64_t>();
+    s.retransmissions = j.at("retransmissions").get<uint32_t>();
+    s.out_of_order = j.at("out_of_order").get<uint32_t>();
+    s.zero_window = j.at("zero_window").get<uint32_t>();
+    s.handshake_rtt_us = j.at("handshake_rtt_us").get<int64_t>();
+    s.duration_us = j.at("duration_us").get<int64_t>();
+    s.sample_rate = j.at("sample_rate").get<uint32_t>();
+    s.payload_fingerprint = j.at("payload_fingerprint").get<std::string>();
+    s.features = j.at("features").get<std::string>();
+    // 旧的暂存记录只有秒级的 last_update_time
+    if (j.contains("last_seen_us")) s.last_seen_us = j.at("last_seen_us").get<int64_t>();
+    else s.last_seen_us = j.at("last_update_time").get<int64_t>() * 1000000;
+    s.close_reason = j.at("close_reason").get<std::string>();
+    s.end_time = static_cast<std::time_t>(j.at("end_time").get<int64_t>());
+    s.persisted = j.at("persisted").get<bool>();
+    return s;
+}
+
+json rows_batch(const std::vector<RowBatch>& batches)
+{
+    json tables = json::array();
+    for (const auto& batch : batches)
+    {
+        json rows = json::array();
+        for (const auto& row : batch.rows)
+        {
+            json values = json::array();
+            for (const auto& v : row) values.push_back(sql_value_to_json(v));
+            rows.push_back(std::move(values));
+        }
+        tables.push_back({{"table", batch.table->name}, {"columns", batch.table->columns}, {"rows", std::move(rows)}});
+    }
+    return json{{"kind", "rows"}, {"tables", std::move(tables)}};
+}
+
+json sessions_batch(const std::vector<SessionInfo>& sessions)
+{
+    json items = json::array();
+    for (const auto& session : sessions) items.push_back(session_to_json(session));
+    return json{{"kind", "sessions"}, {"sessions", std::move(items)}};
+}
+
+json http_flow_to_json(const HttpFlowInfo& f)
+{
+    return json{{"flow_id", f.flow_id}, {"app_uid", f.app_uid}, {"protocol", f.protocol},
+                {"top_protocol", f.top_protocol}, {"src_ip", f.src_ip}, {"http_version", f.http_version},
+                {"src_port", f.src_port}, {"dst_ip", f.dst_ip}, {"dst_port", f.dst_port},
+                {"host", f.host}, {"url", f.url}, {"method", f.method}, {"status_code", f.status_code},
+                {"content_type", f.content_type}, {"start_time_us", f.start_time_us}, {"device", f.device}};
+}
+
+HttpFlowInfo http_flow_from_json(const json& j)
+{
+    HttpFlowInfo f;
+    f.flow_id = j.at("flow_id").get<std::string>();
+    f.app_uid = j.at("app_uid").get<int>();
+    f.protocol = j.at("protocol").get<std::string>();
+    f.top_protocol = j.at("top_protocol").get<std::string>();
+    f.src_ip = j.at("src_ip").get<std::string>();
+    f.http_version = j.at("http_version").get<std::string>();
+    f.src_port = j.at("src_port").get<int>();
+    f.dst_ip = j.at("dst_ip").get<std::string>();
+    f.dst_port = j.at("dst_port").get<int>();
+    f.host = j.at("host").get<std::string>();
+    f.url = j.at("url").get<std::string>();
+    f.method = j.at("method").get<std::string>();
+    f.status_code = j.at("status_code").get<int>();
+    f.content_type = j.at("content_type").get<std::string>();
+    f.start_time_us = j.at("start_time_us").get<int64_t>();
+    f.device = j.value("device", "");      // 旧的暂存记录没有该字段
+    return f;
+}
+
+// 报文体与首部可能含非 UTF-8 字节，直接放进 JSON 会在 dump 时被替换：
+// 报文体按原始字节 base64，首部先转 CBOR（字符串按字节保存）再 base64
+json http_packet_to_json(const HttpPacket& p)
+{
+    std::vector<uint8_t> headers = json::to_cbor(p.headers);
+    return json{{"flow_id", p.flow_id}, {"type", p.type},
+                {"headers_b64", body_codec::base64_encode(std::string(headers.begin(), headers.end()))},
+                {"top_protocol", p.top_protocol}, {"body_b64", body_codec::base64_encode(p.body)},
+                {"timestamp_us", p.timestamp_us}, {"content_type", p.content_type}, {"length", p.length}};
+}
+
+HttpPacket http_packet_from_json(const json& j)
+{
+    HttpPacket p;
+    p.flow_id = j.at("flow_id").get<std::string>();
+    p.type = j.at("type").get<std::string>();
+    p.top_protocol = j.at("top_protocol").get<std::string>();
+    std::string bytes;
+    if (j.contains("headers_b64"))
+    {
+        if (!body_codec::base64_decode(j.at("headers_b64").get<std::string>(), bytes))
+            throw std::invalid_argument("bad headers_b64");
+        p.headers = json::from_cbor(bytes);
+    }
+    else
+    {
+        p.headers = j.at("headers");        // 旧格式的溢写记录
+    }
+    if (j.contains("body_b64"))
+    {
+        if (!body_codec::base64_decode(j.at("body_b64").get<std::string>(), p.body))
+            throw std::invalid_argument("bad body_b64");
+    }
+    else
+    {
+        p.body = j.at("body").get<std::string>();
+    }
+    p.timestamp_us = j.at("timestamp_us").get<int64_t>();
+    p.content_type = j.at("content_type").get<std::string>();
+    p.length = j.at("length").get<int>();
+    return p;
+}
+
+json http_batch(const std::vector<HttpFlowInfo>& flows, const std::vector<HttpPacket>& packets)
+{
+    json flow_items = json::array();
+    json packet_items = json::array();
+    for (const auto& flow : flows) flow_items.push_back(http_flow_to_json(flow));
+    for (const auto& packet : packets) packet_items.push_back(http_packet_to_json(packet));
+    return json{{"kind", "http"}, {"flows", std::move(flow_items)}, {"packets", std::move(packet_items)}};
+}
+
+std::string read_blob(sql::ResultSet* res, int idx)
+{
+    std::unique_ptr<std::istream> in(res->getBlob(idx));
+    if (!in) return std::string();
+    return std::string(std::istreambuf_iterator<char>(*in), std::istreambuf_iterator<char>());
+}
+
+// 报文体字典存于 http_body_dicts（表由 ensure_http_body_schema 建立），与写入方共享连接池
+class MySqlBodyDictionaryStore : public BodyDictionaryStore
+{
+public:
+    explicit MySqlBodyDictionaryStore(std::shared_ptr<MySqlPool> pool) : m_pool(std::move(pool)) {}
+
+    bool save(const BodyDictionary& dict) override
+    {
+        auto conn = m_pool->get_connection();
+        if (!conn) return false;
+        try
+        {
+            sql::PreparedStatement* stmt =
+                conn->prepare("INSERT INTO http_body_dicts (dict_id, content_class, dict) VALUES (?, ?, ?)");
+            std::istringstream data(dict.data);
+            stmt->setUInt(1, dict.id);
+            stmt->setString(2, dict.content_class);
+            stmt->setBlob(3, &data);
+            stmt->executeUpdate();
+            return true;
+        }
+        catch (const sql::SQLException& e)
+        {
+            spdlog::error("Saving body dictionary {} failed: {}", dict.id, e.what());
+            return false;
+        }
+    }
+
+    bool load(uint32_t id, BodyDictionary& dict) override
+    {
+        auto conn = m_pool->get_connection();
+        if (!conn) return false;
+        try
+        {
+            sql::PreparedStatement* stmt =
+                conn->prepare("SELECT content_class, dict FROM http_body_dicts WHERE dict_id = ?");
+            stmt->setUInt(1, id);
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            if (!res->next()) return false;
+            dict.id = id;
+            dict.content_class = res->getString(1);
+            dict.data = read_blob(res.get(), 2);
+            return true;
+        }
+        catch (const sql::SQLException& e)
+        {
+            spdlog::error("Loading body dictionary {} failed: {}", id, e.what());
+            return false;
+        }
+    }
+
+    bool load_all(std::vector<BodyDictionary>& dicts) override
+    {
+        auto conn = m_pool->get_connection();
+        if (!conn) return false;
+        try
+        {
+            sql::PreparedStatement* stmt = conn->prepare(
+                "SELECT dict_id, content_class, dict FROM http_body_dicts ORDER BY created_at, dict_id");
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next())
+            {
+                BodyDictionary dict;
+                dict.id = static_cast<uint32_t>(res->getUInt64(1));
+                dict.content_class = res->getString(2);
+                dict.data = read_blob(res.get(), 3);
+                dicts.push_back(std::move(dict));
+            }
+            return true;
+        }
+        catch (const sql::SQLException& e)
+        {
+            spdlog::error("Loading body dictionaries failed: {}", e.what());
+            return false;
+        }
+    }
+
+private:
+    std::shared_ptr<MySqlPool> m_pool;
+};
 }
 
 
 MySQLDAO::MySQLDAO(const std::string& url="192.168.98.185:3308", const std::string& user="root",
                    const std::string& pass="123456", const std::string& schema="appnetworkanalyse", int poolSize=10)
 {
-    m_pool = std::make_unique<MySqlPool>(url, user, pass, schema, poolSize);
+    m_pool = MySqlPool::shared(url, user, pass, schema, MySqlPoolConfig::for_size(poolSize));
+    m_partitions = PartitionManager::shared(m_pool);
 }
 
 MySQLDAO::MySQLDAO()
 {
-     m_pool = std::make_unique<MySqlPool>("192.168.98.185:3308", "root", "123456", "appnetworkanalyse", 10);
+     m_pool = MySqlPool::shared("192.168.98.185:3308", "root", "123456", "appnetworkanalyse", MySqlPoolConfig::for_size(10));
+     m_partitions = PartitionManager::shared(m_pool);
 }
 MySQLDAO::~MySQLDAO() {
-    m_pool->Close();
+    // 连接池为进程共享，随最后一个使用者释放
 }
 
 // 注册用户,返回 1 成功，0 重复用户名/邮箱，-1 出错
@@ -47,8 +410,8 @@ int MySQLDAO::reg_user(const std::string& name, const std::string& email, const
     try 
     {
         // 检查用户名或邮箱是否已存在
-        std::unique_ptr<sql::PreparedStatement> checkStmt(
-            conn->prepareStatement("SELECT COUNT(*) FROM users WHERE username=? OR email=?"));
+        sql::PreparedStatement* checkStmt =
+            conn->prepare("SELECT COUNT(*) FROM users WHERE username=? OR email=?");
         checkStmt->setString(1, name);
         checkStmt->setString(2, email);
         std::unique_ptr<sql::ResultSet> res(checkStmt->executeQuery());
@@ -59,8 +422,8 @@ int MySQLDAO::reg_user(const std::string& name, const std::string& email, const
         }
 
         // 插入用户
-        std::unique_ptr<sql::PreparedStatement> insertStmt(
-            conn->prepareStatement("INSERT INTO users (username, password, email, user_type) VALUES (?, ?, ?, 'user')"));
+        sql::PreparedStatement* insertStmt =
+            conn->prepare("INSERT INTO users (username, password, email, user_type) VALUES (?, ?, ?, 'user')");
         insertStmt->setString(1, name);
         insertStmt->setString(2, pwd);  // 实际使用中应为哈希
         insertStmt->setString(3, email);
@@ -71,7 +434,6 @@ int MySQLDAO::reg_user(const std::string& name, const std::string& email, const
     {
         return -1;
     }
-    m_pool->return_connection(std::move(conn));
 }
 
 // 删除用户,返回 1 成功，0 用户不存在，-1 出错
@@ -82,8 +444,8 @@ int MySQLDAO::del_user_by_name(const std::string& name)
 
     try
     {
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("DELETE FROM users WHERE username=?"));
+        sql::PreparedStatement* stmt =
+            conn->prepare("DELETE FROM users WHERE username=?");
         stmt->setString(1, name);
         int rows = stmt->executeUpdate();
         return rows > 0 ? 1 : 0;
@@ -92,15 +454,16 @@ int MySQLDAO::del_user_by_name(const std::string& name)
     {
         return -1;
     }
-    m_pool->return_connection(std::move(conn));
 }
 
 int MySQLDAO::update_user(const UserInfo& user)
 {
+    auto conn = m_pool->get_connection();
+    if (!conn) return -1;
+
     try {
-        auto conn = m_pool->get_connection();
         std::string sql = "UPDATE users SET email=?, password=?, user_type=? WHERE username=?";
-        std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+        sql::PreparedStatement* stmt = conn->prepare(sql);
 
         stmt->setString(1, user.email);
         stmt->setString(2, user.pwd);
@@ -111,7 +474,7 @@ int MySQLDAO::update_user(const UserInfo& user)
         return affected_rows > 0 ? 1 : 0;
     }
     catch (const sql::SQLException& e) {
-        std::cerr << "MySQLDAO::update_user error: " << e.what() << std::endl;
+        spdlog::error("MySQLDAO::update_user error: {}", e.what());
         return -1;
     }
 }
@@ -125,8 +488,8 @@ UserInfo MySQLDAO::get_user_by_name(const std::string& name)
 
     try 
     {
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("SELECT username, email, user_type FROM users WHERE username=?"));
+        sql::PreparedStatement* stmt =
+            conn->prepare("SELECT username, email, user_type FROM users WHERE username=?");
         stmt->setString(1, name);
 
         std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
@@ -143,8 +506,6 @@ UserInfo MySQLDAO::get_user_by_name(const std::string& name)
         {
             return UserInfo();  // 用户不存在
         }
-        // 归还连接
-        m_pool->return_connection(std::move(conn));
     } 
     catch (...) 
     {
@@ -161,34 +522,31 @@ int MySQLDAO::add_user_with_role(const std::string& name, const std::string& ema
     try 
     {
         // 检查用户名或邮箱是否已存在
-        std::unique_ptr<sql::PreparedStatement> checkStmt(
-            conn->prepareStatement("SELECT COUNT(*) FROM users WHERE username=? OR email=?"));
+        sql::PreparedStatement* checkStmt =
+            conn->prepare("SELECT COUNT(*) FROM users WHERE username=? OR email=?");
         checkStmt->setString(1, name);
         checkStmt->setString(2, email);
         std::unique_ptr<sql::ResultSet> res(checkStmt->executeQuery());
         res->next();
         if (res->getInt(1) > 0)
         {
-            m_pool->return_connection(std::move(conn));
             return 0;  // 用户已存在
         }
 
         // 插入用户（支持传入角色）
-        std::unique_ptr<sql::PreparedStatement> insertStmt(
-            conn->prepareStatement("INSERT INTO users (username, password, email, user_type) VALUES (?, ?, ?, ?)"));
+        sql::PreparedStatement* insertStmt =
+            conn->prepare("INSERT INTO users (username, password, email, user_type) VALUES (?, ?, ?, ?)");
         insertStmt->setString(1, name);
         insertStmt->setString(2, pwd);  // 实际中应加密哈希
         insertStmt->setString(3, email);
         insertStmt->setString(4, role);
         insertStmt->execute();
 
-        m_pool->return_connection(std::move(conn));
         return 1;
     }
     catch (const std::exception& e)
     {
         spdlog::error("Error in add_user_with_role: {}", e.what());
-        m_pool->return_connection(std::move(conn));
         return -1;
     }
 }
@@ -210,7 +568,7 @@ int MySQLDAO::store_tcp(const json& j)
             ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
         )";
 
-        std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+        sql::PreparedStatement* stmt = conn->prepare(sql);
 
         // 必填字段
         if (j.contains("app_uid")) 
@@ -224,7 +582,7 @@ int MySQLDAO::store_tcp(const json& j)
             stmt->setInt(1, std::stoi(j["app_uid"].get<std::string>()));
             } 
         }
-        stmt->setString(2, j.value("timestamp", ""));
+        set_datetime(stmt, 2, json_timestamp(j));
         stmt->setString(3, j.value("src_ip", ""));
         stmt->setString(4, j.value("des_ip", ""));
         stmt->setInt(5, j.value("src_port", 0));
@@ -253,11 +611,9 @@ int MySQLDAO::store_tcp(const json& j)
         stmt->execute();
 
         // 如果插入成功，返回 1，失败返回 -1
-        m_pool->return_connection(std::move(conn));
         return 1;
 
     } catch (const std::exception& e) {
-        m_pool->return_connection(std::move(conn));
         spdlog::error("Error storing TCP packet: {}", e.what());
         return -1;
     }
@@ -286,16 +642,15 @@ int MySQLDAO::store_udp(const json& j)
 
     try 
     {
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement(
+        sql::PreparedStatement* stmt =
+            conn->prepare(
                 "INSERT INTO udp_packets "
                 "(app_uid, timestamp, src_ip, des_ip, src_port, des_port, packet_len, data, header) "
                 "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"
-            )
         );
 
         stmt->setInt(1, j.value("app_uid", -1));
-        stmt->setString(2, j.value("timestamp", ""));
+        set_datetime(stmt, 2, json_timestamp(j));
         stmt->setString(3, j.value("src_ip", ""));
         stmt->setString(4, j.value("des_ip", ""));
         stmt->setInt(5, j.value("src_port", 0));
@@ -306,19 +661,18 @@ int MySQLDAO::store_udp(const json& j)
 
         stmt->execute();
 
-        m_pool->return_connection(std::move(conn));
         return 1;
     } 
     catch (const std::exception& e) 
     {
         spdlog::error("MySQL insert error: {}", e.what());
-        m_pool->return_connection(std::move(conn));
         return -1;
     }
 }
 
 int MySQLDAO::store_dns(const json& j)
 {
+    ensure_row_schema();
     auto conn = m_pool->get_connection();
     if (!conn) return -1;
 
@@ -326,15 +680,15 @@ int MySQLDAO::store_dns(const json& j)
         std::string sql = R"(
             INSERT INTO dns_packets (
                 app_uid, timestamp, src_ip, src_port,des_ip,des_port,
-                transaction_id, qdcount, ancount, queries
-            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+                transaction_id, qdcount, ancount, queries, device
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
         )";
 
-        std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+        sql::PreparedStatement* stmt = conn->prepare(sql);
 
         // app_uid 支持整型和字符串
         stmt->setInt(1, j.value("app_uid", 0));
-        stmt->setString(2, j.value("timestamp", ""));
+        set_datetime(stmt, 2, json_timestamp(j));
         stmt->setString(3, j.value("src_ip", ""));
         stmt->setInt(4, j.value("src_port", 0));
         stmt->setString(5, j.value("des_ip", ""));
@@ -346,13 +700,12 @@ int MySQLDAO::store_dns(const json& j)
 
     
         stmt->setString(10, j.value("queries", ""));
+        stmt->setString(11, j.value("device", ""));
 
         stmt->execute();
 
-        m_pool->return_connection(std::move(conn));
         return 1;
     } catch (const std::exception& e) {
-        m_pool->return_connection(std::move(conn));
         spdlog::error("Error storing DNS packet: {}", e.what());
         return -1;
     }
@@ -360,15 +713,16 @@ int MySQLDAO::store_dns(const json& j)
 
 int MySQLDAO::store_icmp(const json& j) 
 {
+    ensure_row_schema();
     auto conn = m_pool->get_connection();
     if (!conn) return -1;
 
     try 
     {
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("INSERT INTO icmp_packets (app_uid,timestamp, src_ip, des_ip,type, code, checksum, data,header) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+        sql::PreparedStatement* stmt =
+            conn->prepare("INSERT INTO icmp_packets (app_uid,timestamp, src_ip, des_ip,type, code, checksum, data,header, device) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
         stmt->setInt(1, j["app_uid"].get<int>());
-        stmt->setString(2, j["timestamp"].get<std::string>());
+        set_datetime(stmt, 2, json_timestamp(j));
         stmt->setString(3, j["src_ip"].get<std::string>());
         stmt->setString(4, j["des_ip"].get<std::string>());
         stmt->setInt(5, j["type"].get<int>());
@@ -376,14 +730,13 @@ int MySQLDAO::store_icmp(const json& j)
         stmt->setInt(7, j["checksum"].get<int>());
         stmt->setString(8, j["data"].get<std::string>());
         stmt->setString(9, j["header"].get<std::string>());
+        stmt->setString(10, j.value("device", ""));
         stmt->execute();
-        m_pool->return_connection(std::move(conn));
         return 1;
 
     } 
     catch (...) 
     {
-        m_pool->return_connection(std::move(conn));
         return -1;
     }
 }
@@ -402,13 +755,11 @@ int MySQLDAO::store_http(const json& j)
                 method, path, length, content
             ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
         )";
-        auto stmt = std::unique_ptr<sql::PreparedStatement>(
-            conn->prepareStatement(sql)
-        );
+        sql::PreparedStatement* stmt = conn->prepare(sql);
         int idx=1;
         stmt->setInt   (idx++, j.value("app_uid", 0));
         stmt->setString(idx++, j.value("type", ""));
-        stmt->setString(idx++, j.value("timestamp", ""));
+        set_datetime(stmt, idx++, json_timestamp(j));
         stmt->setString(idx++, j.value("src_ip", ""));
         stmt->setInt   (idx++, j.value("src_port", 0));
         stmt->setString(idx++, j.value("dst_ip", ""));
@@ -419,16 +770,263 @@ int MySQLDAO::store_http(const json& j)
         stmt->setInt   (idx++, j.value("length", 0));
         stmt->setString(idx++, j.value("content", ""));
         stmt->execute();
-        m_pool->return_connection(std::move(conn));
         return 1;
     } catch (const std::exception& e) 
     {
         spdlog::error("Error storing HTTP packet: {}", e.what());
-        m_pool->return_connection(std::move(conn));
         return -1;
     }
 }
 
+const BatchTable& MySQLDAO::dns_packets_table()
+{
+    static const BatchTable table{"dns_packets", {"app_uid", "timestamp", "src_ip", "src_port", "des_ip", "des_port",
+                                                  "transaction_id", "qdcount", "ancount", "queries", "device"}};
+    return table;
+}
+
+SqlRow MySQLDAO::dns_packet_row(const json& j)
+{
+    return {SqlValue::integer(j.value("app_uid", 0)),
+            SqlValue::datetime_us(json_timestamp(j)),
+            SqlValue::text(j.value("src_ip", "")),
+            SqlValue::integer(j.value("src_port", 0)),
+            SqlValue::text(j.value("des_ip", "")),
+            SqlValue::integer(j.value("des_port", 0)),
+            SqlValue::integer(j.value("transaction_id", 0)),
+            SqlValue::integer(j.value("qdcount", 0)),
+            SqlValue::integer(j.value("ancount", 0)),
+            SqlValue::text(j.value("queries", "")),
+            SqlValue::text(j.value("device", ""))};
+}
+
+const BatchTable& MySQLDAO::icmp_packets_table()
+{
+    static const BatchTable table{"icmp_packets", {"app_uid", "timestamp", "src_ip", "des_ip", "type", "code",
+                                                   "checksum", "data", "header", "device"}};
+    return table;
+}
+
+SqlRow MySQLDAO::icmp_packet_row(const json& j)
+{
+    return {SqlValue::integer(j.value("app_uid", 0)),
+            SqlValue::datetime_us(json_timestamp(j)),
+            SqlValue::text(j.value("src_ip", "")),
+            SqlValue::text(j.value("des_ip", "")),
+            SqlValue::integer(j.value("type", 0)),
+            SqlValue::integer(j.value("code", 0)),
+            SqlValue::integer(j.value("checksum", 0)),
+            SqlValue::text(j.value("data", "")),
+            SqlValue::text(j.value("header", "")),
+            SqlValue::text(j.value("device", ""))};
+}
+
+const BatchTable& MySQLDAO::session_info_table()
+{
+    static const BatchTable table{"session_info", {"app_uid", "timestamp", "session_id", "protocol", "src_ip", "src_port",
+                                                   "dst_ip", "dst_port", "packet_count", "server_name", "close_reason",
+                                                   "end_time", "initiator_known", "packets_up", "packets_down",
+                                                   "bytes_up", "bytes_down", "retransmissions", "out_of_order",
+                                                   "zero_window", "handshake_rtt_us", "duration_us", "sample_rate",
+                                                   "payload_fingerprint", "last_seen", "features", "device"}};
+    return table;
+}
+
+SqlRow MySQLDAO::session_row(const SessionInfo& session)
+{
+    // 与 MySQL 中的增量 upsert 不同，列式存储逐条追加增量记录，查询时按 session_id 聚合
+    auto seconds = [](std::time_t t) { return t > 0 ? SqlValue::datetime_us(static_cast<int64_t>(t) * 1000000) : SqlValue::null(); };
+    return {SqlValue::integer(session.app_uid),
+            SqlValue::datetime_us(session.timestamp_us),
+            SqlValue::text(session.session_id),
+            SqlValue::text(session.protocol),
+            SqlValue::text(session.src_ip),
+            SqlValue::integer(session.src_port),
+            SqlValue::text(session.dst_ip),
+            SqlValue::integer(session.dst_port),
+            SqlValue::integer(session.size),
+            SqlValue::text(session.server_name),
+            SqlValue::text(session.close_reason),
+            seconds(session.end_time),
+            SqlValue::integer(session.initiator_known ? 1 : 0),
+            SqlValue::uinteger(session.packets_up),
+            SqlValue::uinteger(session.packets_down),
+            SqlValue::uinteger(session.bytes_up),
+            SqlValue::uinteger(session.bytes_down),
+            SqlValue::uinteger(session.retransmissions),
+            SqlValue::uinteger(session.out_of_order),
+            SqlValue::uinteger(session.zero_window),
+            SqlValue::integer(session.handshake_rtt_us),
+            SqlValue::integer(session.duration_us),
+            SqlValue::uinteger(session.sample_rate),
+            SqlValue::text(session.payload_fingerprint),
+            SqlValue::datetime_us(session.last_seen_us),
+            session.features.empty() ? SqlValue::null() : SqlValue::text(session.features),
+            SqlValue::text(session.device)};
+}
+
+const BatchTable& MySQLDAO::http_flow_table()
+{
+    static const BatchTable table{"http_flow_info", {"app_uid", "flow_id", "timestamp", "src_ip", "src_port", "dst_ip",
+                                                     "dst_port", "protocol", "top_protocol", "http_version", "method",
+                                                     "host", "url", "status", "content_type", "device"}};
+    return table;
+}
+
+SqlRow MySQLDAO::http_flow_row(const HttpFlowInfo& info)
+{
+    return {SqlValue::integer(info.app_uid),
+            SqlValue::text(info.flow_id),
+            SqlValue::datetime_us(info.start_time_us),
+            SqlValue::text(info.src_ip),
+            SqlValue::integer(info.src_port),
+            SqlValue::text(info.dst_ip),
+            SqlValue::integer(info.dst_port),
+            SqlValue::text(info.protocol),
+            SqlValue::text(info.top_protocol),
+            SqlValue::text(info.http_version),
+            SqlValue::text(info.method),
+            SqlValue::text(info.host),
+            SqlValue::text(info.url),
+            SqlValue::integer(info.status_code),
+            SqlValue::text(info.content_type),
+            SqlValue::text(info.device)};
+}
+
+const BatchTable& MySQLDAO::http_packets_table()
+{
+    static const BatchTable table{"http_packets", {"flow_id", "direction", "protocol", "timestamp", "headers", "body",
+                                                   "content_type", "length"}};
+    return table;
+}
+
+SqlRow MySQLDAO::http_packet_row(const HttpPacket& packet)
+{
+    return {SqlValue::text(packet.flow_id),
+            SqlValue::text(packet.type == "response" ? "response" : "request"),
+            SqlValue::text(packet.top_protocol),
+            SqlValue::datetime_us(packet.timestamp_us),
+            SqlValue::text(packet.headers.dump(-1, ' ', false, json::error_handler_t::replace)),
+            SqlValue::text(packet.body),
+            SqlValue::text(packet.content_type),
+            SqlValue::integer(packet.length)};
+}
+
+MySqlEndpoint MySQLDAO::endpoint() const
+{
+    return MySqlEndpoint{m_pool->m_url, m_pool->m_user, m_pool->m_pass, m_pool->m_schema};
+}
+
+json MySQLDAO::pool_status() const
+{
+    static const char* kStates[] = {"connecting", "ready", "failed"};
+    MySqlPoolStats stats = m_pool->stats();
+    json j;
+    j["state"] = kStates[static_cast<int>(m_pool->state())];
+    j["total"] = stats.total;
+    j["idle"] = stats.idle;
+    j["acquired"] = stats.acquired;
+    j["waits"] = stats.waits;
+    j["wait_us_total"] = stats.wait_us_total;
+    j["wait_us_max"] = stats.wait_us_max;
+    j["timeouts"] = stats.timeouts;
+    j["created"] = stats.created;
+    j["reconnects"] = stats.reconnects;
+    j["closed_idle"] = stats.closed_idle;
+    j["failures"] = stats.failures;
+    return j;
+}
+
+bool MySQLDAO::ensure_row_schema()
+{
+    if (m_row_schema_ready) return true;
+    int64_t now = now_us();
+    if (now < m_row_schema_retry_us) return false;
+    m_row_schema_retry_us = now + SCHEMA_RETRY_US;
+
+    if (!ensure_columns("dns_packets", {{"timestamp", "DATETIME(6) NULL"},
+                                        {"device", "VARCHAR(64) NOT NULL DEFAULT ''"}}) ||
+        !ensure_columns("icmp_packets", {{"timestamp", "DATETIME(6) NULL"},
+                                         {"device", "VARCHAR(64) NOT NULL DEFAULT ''"}}))
+        return false;
+    m_row_schema_ready = true;
+    return true;
+}
+
+int MySQLDAO::insert_row_batches(const std::vector<RowBatch>& batches)
+{
+    ensure_row_schema();
+    auto conn = m_pool->get_connection();
+    if (!conn) return -1;
+
+    try
+    {
+        return in_transaction(*conn, [&] { return write_row_batches(*conn, batches); });
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error writing row batches: {}", e.what());
+        return -1;
+    }
+}
+
+int MySQLDAO::write_row_batches(PooledConnection& conn, const std::vector<RowBatch>& batches)
+{
+    // 单条语句的占位符上限为 65535，按列数拆分
+    const size_t MAX_PLACEHOLDERS = 60000;
+
+    int written = 0;
+    for (const auto& batch : batches)
+    {
+        const BatchTable& table = *batch.table;
+        if (batch.rows.empty() || table.columns.empty()) continue;
+        size_t chunk = std::max<size_t>(1, MAX_PLACEHOLDERS / table.columns.size());
+
+        std::string head = "INSERT INTO " + table.name + " (";
+        std::string row = "(";
+        for (size_t c = 0; c < table.columns.size(); ++c)
+        {
+            head += (c ? ", " : "") + table.columns[c];
+            row += c ? ", ?" : "?";
+        }
+        head += ") VALUES ";
+        row += ")";
+
+        for (size_t begin = 0, end = 0; begin < batch.rows.size(); begin = end)
+        {
+            end = begin + multi_row_count(batch.rows.size() - begin, chunk);
+            std::string sql = head;
+            for (size_t r = begin; r < end; ++r)
+                sql += (r != begin ? ", " : "") + row;
+
+            sql::PreparedStatement* stmt = conn.prepare(sql);
+            int idx = 1;
+            for (size_t r = begin; r < end; ++r)
+            {
+                const SqlRow& values = batch.rows[r];
+                for (size_t c = 0; c < table.columns.size(); ++c, ++idx)
+                {
+                    // 列数不足的行补 NULL
+                    if (c >= values.size()) { stmt->setNull(idx, sql::DataType::VARCHAR); continue; }
+                    const SqlValue& v = values[c];
+                    switch (v.type)
+                    {
+                    case SqlValue::Type::INT:       stmt->setInt64(idx, v.i); break;
+                    case SqlValue::Type::UINT:      stmt->setUInt64(idx, v.u); break;
+                    case SqlValue::Type::STRING:    stmt->setString(idx, v.s); break;
+                    case SqlValue::Type::DATETIME:  set_datetime(stmt, idx, v.i); break;
+                    case SqlValue::Type::NUL:
+                    default:                        stmt->setNull(idx, sql::DataType::VARCHAR); break;
+                    }
+                }
+            }
+            stmt->execute();
+            written += static_cast<int>(end - begin);
+        }
+    }
+    return written;
+}
+
 int MySQLDAO::store_app_info_if_not_exists(int app_uid, const std::string& package_name)
 {
     auto conn = m_pool->get_connection();
@@ -436,31 +1034,28 @@ int MySQLDAO::store_app_info_if_not_exists(int app_uid, const std::string& packa
 
     try {
         // 1. 检查是否存在对应 UID 或包名的记录
-        std::unique_ptr<sql::PreparedStatement> checkStmt(
-            conn->prepareStatement("SELECT COUNT(*) FROM applications WHERE app_uid = ? OR package_name = ?"));
+        sql::PreparedStatement* checkStmt =
+            conn->prepare("SELECT COUNT(*) FROM applications WHERE app_uid = ? OR package_name = ?");
         checkStmt->setInt(1, app_uid);
         checkStmt->setString(2, package_name);
         std::unique_ptr<sql::ResultSet> res(checkStmt->executeQuery());
         res->next();
 
         if (res->getInt(1) > 0) {
-            m_pool->return_connection(std::move(conn));
             return 0;  // 已存在，不插入
         }
 
         // 2. 插入新记录
-        std::unique_ptr<sql::PreparedStatement> insertStmt(
-            conn->prepareStatement("INSERT INTO applications (app_uid, package_name) VALUES (?, ?)"));
+        sql::PreparedStatement* insertStmt =
+            conn->prepare("INSERT INTO applications (app_uid, package_name) VALUES (?, ?)");
         insertStmt->setInt(1, app_uid);
         insertStmt->setString(2, package_name);
         insertStmt->execute();
 
-        m_pool->return_connection(std::move(conn));
         return 1;  // 插入成功
 
     } catch (const std::exception& e) {
         spdlog::error("store_app_info_if_not_exists error: {}", e.what());
-        m_pool->return_connection(std::move(conn));
         return -1;  // 异常
     }
 }
@@ -470,142 +1065,1037 @@ bool MySQLDAO::insert_http_flow_info(const HttpFlowInfo& info) {
     auto conn = m_pool->get_connection();
     if (!conn) return false;
     try {
-
-
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement(R"(
-                INSERT INTO http_flow_info (
-                    app_uid,flow_id, timestamp, src_ip, src_port, dst_ip, dst_port, protocol,
-                    top_protocol, http_version, method, host, url, status, content_type
-                ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-            )")
-        );
-
-        stmt->setInt(1, info.app_uid);                  // 对应app_uid
-        stmt->setString(2, info.flow_id);               // 对应flow_id
-        stmt->setString(3, format_mysql_datetime(info.start_time)); // 对应timestamp
-        stmt->setString(4, info.src_ip);                // 对应src_ip
-        stmt->setInt(5, info.src_port);                 // 对应src_port
-        stmt->setString(6, info.dst_ip);                // 对应dst_ip
-        stmt->setInt(7, info.dst_port);                 // 对应dst_port
-        stmt->setString(8, info.protocol);              // 对应protocol
-        stmt->setString(9, info.top_protocol);          // 对应top_protocol
-        stmt->setString(10, info.http_version);         // 对应http_version
-        stmt->setString(11, info.method);               // 对应method
-        stmt->setString(12, info.host);                 // 对应host (之前跳过了)
-        stmt->setString(13, info.url);                  // 对应url
-        stmt->setInt(14, info.status_code);             // 对应status
-        stmt->setString(15, info.content_type);         // 对应content_type
-
-        stmt->executeUpdate();
-        m_pool->return_connection(std::move(conn));
+        write_http_flow(*conn, info);
         return true;
 
     } catch (const sql::SQLException& e) {
-        m_pool->return_connection(std::move(conn));
         spdlog::error("insert_http_flow_info error: {}", e.what());
         return false;
     }
 }
 
+void MySQLDAO::write_http_flow(PooledConnection& conn, const HttpFlowInfo& info)
+{
+    sql::PreparedStatement* stmt =
+        conn.prepare(R"(
+            INSERT INTO http_flow_info (
+                app_uid,flow_id, timestamp, src_ip, src_port, dst_ip, dst_port, protocol,
+                top_protocol, http_version, method, host, url, status, content_type, device
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        )"
+    );
+
+    stmt->setInt(1, info.app_uid);                  // 对应app_uid
+    stmt->setString(2, info.flow_id);               // 对应flow_id
+    set_datetime(stmt, 3, info.start_time_us);     // 对应timestamp
+    stmt->setString(4, info.src_ip);                // 对应src_ip
+    stmt->setInt(5, info.src_port);                 // 对应src_port
+    stmt->setString(6, info.dst_ip);                // 对应dst_ip
+    stmt->setInt(7, info.dst_port);                 // 对应dst_port
+    stmt->setString(8, info.protocol);              // 对应protocol
+    stmt->setString(9, info.top_protocol);          // 对应top_protocol
+    stmt->setString(10, info.http_version);         // 对应http_version
+    stmt->setString(11, info.method);               // 对应method
+    stmt->setString(12, info.host);                 // 对应host (之前跳过了)
+    stmt->setString(13, info.url);                  // 对应url
+    stmt->setInt(14, info.status_code);             // 对应status
+    stmt->setString(15, info.content_type);         // 对应content_type
+    stmt->setString(16, info.device);               // 对应device
+
+    stmt->executeUpdate();
+}
+
 bool MySQLDAO::insert_http_packet(const HttpPacket& packet) {
+    ensure_http_body_schema();
     auto conn = m_pool->get_connection();
     if (!conn) return false;
     try 
     {
+        write_http_packet(*conn, packet);
+        return true;
 
-        // 验证并转换direction值为ENUM允许的值
-        std::string direction;
-        if (packet.type == "request") {
-            direction = "request";
-        } else if (packet.type == "response") {
-            direction = "response";
-        } else {
-            // 未知类型，默认设为request或记录错误
-            direction = "request";
-            spdlog::error("Invalid direction value: '{}', using default 'request'", packet.type);
-        }
+    } catch (const sql::SQLException& e) {
+        spdlog::error("insert_http_packet error: {}", e.what());
+        return false;
+    }
+}
 
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement(R"(
+void MySQLDAO::write_http_packet(PooledConnection& conn, const HttpPacket& packet)
+{
+    // 验证并转换direction值为ENUM允许的值
+    std::string direction;
+    if (packet.type == "request") {
+        direction = "request";
+    } else if (packet.type == "response") {
+        direction = "response";
+    } else {
+        // 未知类型，默认设为request或记录错误
+        direction = "request";
+        spdlog::error("Invalid direction value: '{}', using default 'request'", packet.type);
+    }
+
+    // 压缩列尚未就绪（旧库补列失败）时按原文写入 body
+    if (!m_http_body_schema_ready)
+    {
+        sql::PreparedStatement* stmt =
+            conn.prepare(R"(
                 INSERT INTO http_packets (
                     flow_id, direction, protocol, timestamp, headers, body, content_type, length
                 ) VALUES (?, ?, ?, ?, ?, ?, ?, ?)
-            )")
+            )"
         );
 
         stmt->setString(1, packet.flow_id);
         stmt->setString(2, direction); // 使用验证后的direction值
         stmt->setString(3, packet.top_protocol);
-        stmt->setString(4, format_mysql_datetime(packet.timestamp));
+        set_datetime(stmt, 4, packet.timestamp_us);
         stmt->setString(5, packet.headers.dump());
         stmt->setString(6, packet.body);
         stmt->setString(7, packet.content_type);
         stmt->setInt(8, packet.length);
 
         stmt->executeUpdate();
+        return;
+    }
+
+    // 压缩后的报文体存 body_data，body 留空；不压缩（过短或无收益）时仍存 body
+    EncodedBody encoded = body_compressor()->encode(packet.content_type, packet.body);
+    bool raw = encoded.codec == body_codec::RAW;
+    std::istringstream data(encoded.data);
+
+    sql::PreparedStatement* stmt =
+        conn.prepare(R"(
+            INSERT INTO http_packets (
+                flow_id, direction, protocol, timestamp, headers, body, content_type, length, body_codec, body_data
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        )"
+    );
+
+    stmt->setString(1, packet.flow_id);
+    stmt->setString(2, direction);
+    stmt->setString(3, packet.top_protocol);
+    set_datetime(stmt, 4, packet.timestamp_us);
+    stmt->setString(5, packet.headers.dump());
+    stmt->setString(6, raw ? encoded.data : std::string());
+    stmt->setString(7, packet.content_type);
+    stmt->setInt(8, packet.length);
+    stmt->setUInt(9, encoded.codec);
+    if (raw) stmt->setNull(10, sql::DataType::BLOB);
+    else stmt->setBlob(10, &data);
+
+    stmt->executeUpdate();
+}
+
+std::vector<HttpPacketRecord> MySQLDAO::get_http_packets(const std::string& flow_id)
+{
+    std::vector<HttpPacketRecord> records;
+    bool compressed = ensure_http_body_schema();
+    auto conn = m_pool->get_connection();
+    if (!conn) return records;
 
-        m_pool->return_connection(std::move(conn));
+    try
+    {
+        sql::PreparedStatement* stmt = conn->prepare(compressed
+            ? "SELECT flow_id, direction, protocol, timestamp, headers, body, content_type, length, body_codec, body_data "
+              "FROM http_packets WHERE flow_id = ? ORDER BY timestamp"
+            : "SELECT flow_id, direction, protocol, timestamp, headers, body, content_type, length "
+              "FROM http_packets WHERE flow_id = ? ORDER BY timestamp");
+        stmt->setString(1, flow_id);
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        while (res->next())
+        {
+            HttpPacketRecord record;
+            HttpPacket& packet = record.packet;
+            packet.flow_id = res->getString(1);
+            packet.type = res->getString(2);
+            packet.top_protocol = res->getString(3);
+            parse_datetime_us(res->getString(4), packet.timestamp_us);
+            packet.headers = json::parse(res->getString(5), nullptr, false);
+            if (packet.headers.is_discarded()) packet.headers = res->getString(5);
+            packet.content_type = res->getString(7);
+            packet.length = res->getInt(8);
+
+            // 压缩数据原样带出，StoredBody::text() 时才解压
+            uint8_t codec = compressed ? static_cast<uint8_t>(res->getInt(9)) : body_codec::RAW;
+            if ((codec & body_codec::METHOD_MASK) == body_codec::RAW)
+                record.body = StoredBody(codec, res->getString(6), nullptr);
+            else
+                record.body = StoredBody(codec, read_blob(res.get(), 10), m_body_compressor);
+            records.push_back(std::move(record));
+        }
+    }
+    catch (const sql::SQLException& e)
+    {
+        spdlog::error("get_http_packets({}) error: {}", flow_id, e.what());
+        records.clear();
+    }
+    return records;
+}
+
+bool MySQLDAO::ensure_http_body_schema()
+{
+    if (m_http_body_schema_ready) return true;
+    // 库不可用或无权改表时先按原文写入，隔一段时间再试，不必每次写入都重试
+    int64_t now = now_us();
+    if (now < m_http_body_retry_us) return false;
+    m_http_body_retry_us = now + SCHEMA_RETRY_US;
+
+    if (!ensure_columns("http_flow_info", {{"timestamp", "DATETIME(6) NULL"},
+                                           {"device", "VARCHAR(64) NOT NULL DEFAULT ''"}}) ||
+        !ensure_columns("http_packets", {{"timestamp", "DATETIME(6) NULL"},
+                                         {"body_codec", "TINYINT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"body_data", "LONGBLOB NULL"}}))
+        return false;
+
+    auto conn = m_pool->get_connection();
+    if (!conn) return false;
+    try
+    {
+        std::unique_ptr<sql::Statement> stmt(conn->connection()->createStatement());
+        stmt->execute(R"(
+            CREATE TABLE IF NOT EXISTS http_body_dicts (
+                dict_id         INT UNSIGNED NOT NULL PRIMARY KEY,
+                content_class   VARCHAR(32) NOT NULL,
+                dict            MEDIUMBLOB NOT NULL,
+                created_at      DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6)
+            )
+        )");
+        stmt->execute(R"(
+            CREATE TABLE IF NOT EXISTS schema_migrations (
+                name        VARCHAR(64) NOT NULL PRIMARY KEY,
+                applied_at  DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6)
+            )
+        )");
+        migrate_http_times(*conn);
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("ensure_http_body_schema error: {}", e.what());
+        return false;
+    }
+    body_compressor();
+    m_http_body_schema_ready = true;
+    return true;
+}
+
+void MySQLDAO::migrate_http_times(PooledConnection& conn)
+{
+    // 旧版本把 mitmproxy（ZMQ）的 UTC 时间原样写成文本，抓包解析的记录则一直是本地时间；
+    // 现在统一为本地时间，旧的 UTC 行（flow_id 不含解析器生成的 '#'）按本进程当前的 UTC 偏移一次性换算。
+    // 迁移标记与换算同一事务提交，多个实例并发启动时只执行一次
+    std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    long offset_min = tm.tm_gmtoff / 60;
+    char offset[16];
+    std::snprintf(offset, sizeof(offset), "%c%02ld:%02ld", offset_min < 0 ? '-' : '+',
+                  std::labs(offset_min) / 60, std::labs(offset_min) % 60);
+
+    int migrated = in_transaction(conn, [&] {
+        sql::PreparedStatement* mark = conn.prepare("INSERT IGNORE INTO schema_migrations (name) VALUES (?)");
+        mark->setString(1, "http_utc_times_to_local");
+        if (mark->executeUpdate() == 0) return 0;
+        int rows = 0;
+        for (const char* table : {"http_flow_info", "http_packets"})
+        {
+            sql::PreparedStatement* stmt = conn.prepare(
+                std::string("UPDATE ") + table + " SET timestamp = CONVERT_TZ(timestamp, '+00:00', ?) "
+                "WHERE timestamp IS NOT NULL AND flow_id NOT LIKE '%#%'");
+            stmt->setString(1, offset);
+            rows += stmt->executeUpdate();
+        }
+        return rows;
+    });
+    if (migrated > 0) spdlog::info("Converted {} HTTP rows from UTC to local time ({})", migrated, offset);
+}
+
+BodyCompressor* MySQLDAO::body_compressor()
+{
+    std::call_once(m_body_compressor_once, [this] {
+        m_body_compressor = BodyCompressor::shared(std::make_shared<MySqlBodyDictionaryStore>(m_pool));
+    });
+    return m_body_compressor.get();
+}
+
+json MySQLDAO::body_compression_status()
+{
+    return body_compressor()->status();
+}
+
+int MySQLDAO::insert_http_exchanges(const std::vector<HttpFlowInfo>& flows, const std::vector<HttpPacket>& packets,
+                                    std::vector<HttpFlowInfo>* unwritten_flows,
+                                    std::vector<HttpPacket>* unwritten_packets)
+{
+    ensure_http_body_schema();
+    auto unwritten_all = [&] {
+        if (unwritten_flows) unwritten_flows->insert(unwritten_flows->end(), flows.begin(), flows.end());
+        if (unwritten_packets) unwritten_packets->insert(unwritten_packets->end(), packets.begin(), packets.end());
+        return -1;
+    };
+    auto conn = m_pool->get_connection();
+    if (!conn) return unwritten_all();
+
+    try
+    {
+        return in_transaction(*conn, [&] {
+            for (const auto& flow : flows) write_http_flow(*conn, flow);
+            for (const auto& packet : packets) write_http_packet(*conn, packet);
+            return static_cast<int>(flows.size() + packets.size());
+        });
+    }
+    catch (const sql::SQLException& e)
+    {
+        spdlog::error("Error writing {} http flows / {} packets: {} (code {})",
+                      flows.size(), packets.size(), e.what(), e.getErrorCode());
+        if (is_transient(e)) return unwritten_all();
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error writing {} http flows / {} packets: {}", flows.size(), packets.size(), e.what());
+        return unwritten_all();
+    }
+
+    // 数据被拒（如重复的 flow_id、超长字段）：事务已回滚，逐条重写，只丢弃出错的那几条
+    int written = 0;
+    bool transient = false;
+    auto write_one = [&](const std::string& flow_id, auto&& write) {
+        if (transient) return false;
+        try
+        {
+            write();
+            ++written;
+            return true;
+        }
+        catch (const sql::SQLException& e)
+        {
+            transient = is_transient(e);
+            if (!transient) spdlog::error("Dropped rejected http record of flow {}: {}", flow_id, e.what());
+            return !transient;
+        }
+        catch (const std::exception& e)
+        {
+            spdlog::error("Dropped rejected http record of flow {}: {}", flow_id, e.what());
+            return true;
+        }
+    };
+    for (const auto& flow : flows)
+    {
+        if (!write_one(flow.flow_id, [&] { write_http_flow(*conn, flow); }) && unwritten_flows)
+            unwritten_flows->push_back(flow);
+    }
+    for (const auto& packet : packets)
+    {
+        if (!write_one(packet.flow_id, [&] { write_http_packet(*conn, packet); }) && unwritten_packets)
+            unwritten_packets->push_back(packet);
+    }
+    return transient ? -1 : written;
+}
+
+
+bool MySQLDAO::ensure_columns(const std::string& table,
+                              const std::vector<std::pair<std::string, std::string>>& columns)
+{
+    auto conn = m_pool->get_connection();
+    if (!conn) return false;
+
+    try
+    {
+        struct Existing
+        {
+            std::string     data_type;
+            int             precision = 0;
+            bool            nullable = true;
+            bool            has_default = false;
+            std::string     column_default;
+            std::string     extra;
+        };
+        sql::PreparedStatement* stmt = conn->prepare(
+            "SELECT COLUMN_NAME, DATA_TYPE, DATETIME_PRECISION, IS_NULLABLE, COLUMN_DEFAULT, EXTRA "
+            "FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ?");
+        stmt->setString(1, table);
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        std::map<std::string, Existing> existing;
+        while (res->next())
+        {
+            Existing& column = existing[res->getString(1)];
+            column.data_type = res->getString(2);
+            std::transform(column.data_type.begin(), column.data_type.end(), column.data_type.begin(), ::tolower);
+            column.precision = res->isNull(3) ? 0 : res->getInt(3);
+            column.nullable = res->getString(4) == "YES";
+            column.has_default = !res->isNull(5);
+            if (column.has_default) column.column_default = res->getString(5);
+            column.extra = res->getString(6);
+        }
+
+        std::unique_ptr<sql::Statement> alter(conn->connection()->createStatement());
+        for (const auto& column : columns)
+        {
+            auto it = existing.find(column.first);
+            if (it != existing.end())
+            {
+                // 旧库的秒级 DATETIME 加宽为 DATETIME(6)（整表重建），保留原有的可空性、默认值与 ON UPDATE
+                const Existing& old = it->second;
+                if (column.second.compare(0, 11, "DATETIME(6)") != 0 || old.data_type != "datetime" || old.precision >= 6)
+                    continue;
+                std::string definition = std::string("DATETIME(6)") + (old.nullable ? " NULL" : " NOT NULL");
+                if (old.has_default)
+                {
+                    definition += " DEFAULT ";
+                    definition += old.column_default.compare(0, 17, "CURRENT_TIMESTAMP") == 0
+                                ? std::string("CURRENT_TIMESTAMP(6)") : "'" + old.column_default + "'";
+                }
+                std::string extra = old.extra;
+                std::transform(extra.begin(), extra.end(), extra.begin(), ::tolower);
+                if (extra.find("on update current_timestamp") != std::string::npos)
+                    definition += " ON UPDATE CURRENT_TIMESTAMP(6)";
+                alter->execute("ALTER TABLE " + table + " MODIFY COLUMN " + column.first + " " + definition);
+                spdlog::info("Widened column {}.{} to DATETIME(6)", table, column.first);
+                continue;
+            }
+            try
+            {
+                alter->execute("ALTER TABLE " + table + " ADD COLUMN " + column.first + " " + column.second);
+                spdlog::info("Added column {}.{}", table, column.first);
+            }
+            catch (const sql::SQLException& e)
+            {
+                // 1060: 其他实例已并发添加
+                if (e.getErrorCode() != 1060) throw;
+            }
+        }
         return true;
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("ensure_columns({}) error: {}", table, e.what());
+        return false;
+    }
+}
 
-    } catch (const sql::SQLException& e) {
-        m_pool->return_connection(std::move(conn));
-        spdlog::error("insert_http_packet error: {}", e.what());
+bool MySQLDAO::ensure_unique_index(const std::string& table, const std::string& index,
+                                   const std::string& column)
+{
+    auto conn = m_pool->get_connection();
+    if (!conn) return false;
+
+    try
+    {
+        // 已有以该列开头的唯一索引（名称不限）即可；按 timestamp 分区的表（见 PartitionManager）为 (column, timestamp)
+        sql::PreparedStatement* stmt = conn->prepare(
+            "SELECT INDEX_NAME FROM information_schema.STATISTICS "
+            "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? AND NON_UNIQUE = 0 "
+            "GROUP BY INDEX_NAME HAVING SUM(SEQ_IN_INDEX = 1 AND COLUMN_NAME = ?) = 1 "
+            "AND SUM(SEQ_IN_INDEX > 1 AND COLUMN_NAME <> 'timestamp') = 0 AND COUNT(*) <= 2");
+        stmt->setString(1, table);
+        stmt->setString(2, column);
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        if (!res->next())
+        {
+            std::unique_ptr<sql::Statement> alter(conn->connection()->createStatement());
+            try
+            {
+                try
+                {
+                    alter->execute("ALTER TABLE " + table + " ADD UNIQUE INDEX " + index + " (" + column + ")");
+                }
+                catch (const sql::SQLException& e)
+                {
+                    // 1503: 分区表的唯一索引必须包含分区列
+                    if (e.getErrorCode() != 1503) throw;
+                    alter->execute("ALTER TABLE " + table + " ADD UNIQUE INDEX " + index + " (" + column + ", `timestamp`)");
+                }
+                spdlog::info("Added unique index {}.{} ({})", table, index, column);
+            }
+            catch (const sql::SQLException& e)
+            {
+                // 1061: 其他实例已并发添加；1062: 已有重复数据
+                if (e.getErrorCode() == 1062)
+                {
+                    spdlog::warn("Cannot add unique index on {}.{}: duplicate rows exist", table, column);
+                    return false;
+                }
+                if (e.getErrorCode() != 1061) throw;
+            }
+        }
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("ensure_unique_index({}.{}) error: {}", table, column, e.what());
         return false;
     }
 }
 
+bool MySQLDAO::ensure_session_schema()
+{
+    if (m_session_schema_ready) return true;
+    // 库不可用时先逐条写入，隔一段时间再试，不让首次调用时的故障决定进程此后的写入方式
+    int64_t now = now_us();
+    if (now < m_session_schema_retry_us) return false;
+    m_session_schema_retry_us = now + SCHEMA_RETRY_US;
+
+    if (!ensure_columns("session_info", {{"server_name", "VARCHAR(255) NOT NULL DEFAULT ''"},
+                                         {"close_reason", "VARCHAR(16) NOT NULL DEFAULT ''"},
+                                         {"timestamp", "DATETIME(6) NULL"},
+                                         {"end_time", "DATETIME(6) NULL"},
+                                         {"initiator_known", "TINYINT(1) NOT NULL DEFAULT 0"},
+                                         {"packets_up", "BIGINT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"packets_down", "BIGINT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"bytes_up", "BIGINT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"bytes_down", "BIGINT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"retransmissions", "INT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"out_of_order", "INT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"zero_window", "INT UNSIGNED NOT NULL DEFAULT 0"},
+                                         {"handshake_rtt_us", "BIGINT NOT NULL DEFAULT 0"},
+                                         {"duration_us", "BIGINT NOT NULL DEFAULT 0"},
+                                         {"sample_rate", "INT UNSIGNED NOT NULL DEFAULT 1"},
+                                         {"payload_fingerprint", "VARCHAR(64) NOT NULL DEFAULT ''"},
+                                         {"last_seen", "DATETIME(6) NULL"},
+                                         {"features", "TEXT NULL"},
+                                         {"device", "VARCHAR(64) NOT NULL DEFAULT ''"}}))
+        return false;
+    m_session_unique = ensure_unique_index("session_info", "uk_session_id", "session_id");
+    if (!m_session_unique)
+    {
+        spdlog::warn("session_info has no unique session_id index, batch upsert falls back to per-row writes");
+        return false;
+    }
+    m_session_schema_ready = true;
+    return true;
+}
 
 int MySQLDAO::insert_or_update_session_info(const SessionInfo& session) {
+    ensure_session_schema();
+
     auto conn = m_pool->get_connection();
     if (!conn) return -1;
 
     try 
     {
-        std::string check_sql = "SELECT COUNT(*) FROM session_info WHERE session_id = ?";
-        std::unique_ptr<sql::PreparedStatement> check_stmt(conn->prepareStatement(check_sql));
-        check_stmt->setString(1, session.session_id);
-        std::unique_ptr<sql::ResultSet> res(check_stmt->executeQuery());
-        res->next();
-        bool exists = res->getInt(1) > 0;
-
-        if (!exists) {
-            std::string insert_sql = R"(
-                INSERT INTO session_info (
-                    app_uid, timestamp, session_id, protocol,
-                    src_ip, src_port, dst_ip, dst_port, packet_count
-                ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+        // 增量记录：已入库的会话直接累加，省去逐条 SELECT
+        if (session.persisted) {
+            std::string update_sql = R"(
+                UPDATE session_info SET
+                    packet_count = packet_count + ?,
+                    packets_up = packets_up + ?,
+                    packets_down = packets_down + ?,
+                    bytes_up = bytes_up + ?,
+                    bytes_down = bytes_down + ?,
+                    retransmissions = retransmissions + ?,
+                    out_of_order = out_of_order + ?,
+                    zero_window = zero_window + ?,
+                    handshake_rtt_us = IF(? > 0, ?, handshake_rtt_us),
+                    duration_us = GREATEST(duration_us, ?),
+                    sample_rate = GREATEST(sample_rate, ?),
+                    server_name = IF(? <> '', ?, server_name),
+                    close_reason = IF(? <> '', ?, close_reason),
+                    end_time = IF(? > 0, FROM_UNIXTIME(?), end_time),
+                    payload_fingerprint = IF(payload_fingerprint = '', ?, payload_fingerprint),
+                    last_seen = IFNULL(?, last_seen),
+                    features = IF(? <> '', ?, features)
+                WHERE session_id = ?
             )";
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(insert_sql));
-            stmt->setInt(1, session.app_uid);
-            stmt->setString(2, format_mysql_datetime(session.timestamp));
-            stmt->setString(3, session.session_id);
-            stmt->setString(4, session.protocol);
-            stmt->setString(5, session.src_ip);
-            stmt->setInt(6, session.src_port);
-            stmt->setString(7, session.dst_ip);
-            stmt->setInt(8, session.dst_port);
-            stmt->setInt(9,session.size);
-            stmt->execute();
-        } else {
-            std::string update_sql = "UPDATE session_info SET packet_count = packet_count + ? WHERE session_id = ?";
-            std::unique_ptr<sql::PreparedStatement> update_stmt(conn->prepareStatement(update_sql));
-            update_stmt->setInt(1, static_cast<int>(session.size)); // 增量更新
-            update_stmt->setString(2, session.session_id);
+            sql::PreparedStatement* update_stmt = conn->prepare(update_sql);
+            int idx = 1;
+            update_stmt->setInt(idx++, session.size);
+            update_stmt->setUInt64(idx++, session.packets_up);
+            update_stmt->setUInt64(idx++, session.packets_down);
+            update_stmt->setUInt64(idx++, session.bytes_up);
+            update_stmt->setUInt64(idx++, session.bytes_down);
+            update_stmt->setUInt(idx++, session.retransmissions);
+            update_stmt->setUInt(idx++, session.out_of_order);
+            update_stmt->setUInt(idx++, session.zero_window);
+            update_stmt->setInt64(idx++, session.handshake_rtt_us);
+            update_stmt->setInt64(idx++, session.handshake_rtt_us);
+            update_stmt->setInt64(idx++, session.duration_us);
+            update_stmt->setUInt(idx++, session.sample_rate);
+            update_stmt->setString(idx++, session.server_name);
+            update_stmt->setString(idx++, session.server_name);
+            update_stmt->setString(idx++, session.close_reason);
+            update_stmt->setString(idx++, session.close_reason);
+            update_stmt->setInt64(idx++, static_cast<int64_t>(session.end_time));
+            update_stmt->setInt64(idx++, static_cast<int64_t>(session.end_time));
+            update_stmt->setString(idx++, session.payload_fingerprint);
+            set_datetime(update_stmt, idx++, session.last_seen_us);
+            update_stmt->setString(idx++, session.features);
+            update_stmt->setString(idx++, session.features);
+            update_stmt->setString(idx++, session.session_id);
             update_stmt->execute();
+            return 1;
+        } else {
+            std::string check_sql = "SELECT COUNT(*) FROM session_info WHERE session_id = ?";
+            sql::PreparedStatement* check_stmt = conn->prepare(check_sql);
+            check_stmt->setString(1, session.session_id);
+            std::unique_ptr<sql::ResultSet> res(check_stmt->executeQuery());
+            res->next();
+            if (res->getInt(1) > 0) {
+                // 同一 session_id 的旧会话行（如端口复用）：按增量记录处理
+                conn.release();
+                SessionInfo existing = session;
+                existing.persisted = true;
+                return insert_or_update_session_info(existing);
+            }
         }
 
-        m_pool->return_connection(std::move(conn));
+        std::string insert_sql = R"(
+            INSERT INTO session_info (
+                app_uid, timestamp, session_id, protocol,
+                src_ip, src_port, dst_ip, dst_port, packet_count, server_name,
+                close_reason, end_time, initiator_known, packets_up, packets_down,
+                bytes_up, bytes_down, retransmissions, out_of_order, zero_window,
+                handshake_rtt_us, duration_us, sample_rate, payload_fingerprint, last_seen,
+                features, device
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, IF(? > 0, FROM_UNIXTIME(?), NULL),
+                      ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, NULLIF(?, ''), ?)
+        )";
+        sql::PreparedStatement* stmt = conn->prepare(insert_sql);
+        stmt->setInt(1, session.app_uid);
+        set_datetime(stmt, 2, session.timestamp_us);
+        stmt->setString(3, session.session_id);
+        stmt->setString(4, session.protocol);
+        stmt->setString(5, session.src_ip);
+        stmt->setInt(6, session.src_port);
+        stmt->setString(7, session.dst_ip);
+        stmt->setInt(8, session.dst_port);
+        stmt->setInt(9,session.size);
+        stmt->setString(10, session.server_name);
+        stmt->setString(11, session.close_reason);
+        stmt->setInt64(12, static_cast<int64_t>(session.end_time));
+        stmt->setInt64(13, static_cast<int64_t>(session.end_time));
+        stmt->setBoolean(14, session.initiator_known);
+        stmt->setUInt64(15, session.packets_up);
+        stmt->setUInt64(16, session.packets_down);
+        stmt->setUInt64(17, session.bytes_up);
+        stmt->setUInt64(18, session.bytes_down);
+        stmt->setUInt(19, session.retransmissions);
+        stmt->setUInt(20, session.out_of_order);
+        stmt->setUInt(21, session.zero_window);
+        stmt->setInt64(22, session.handshake_rtt_us);
+        stmt->setInt64(23, session.duration_us);
+        stmt->setUInt(24, session.sample_rate);
+        stmt->setString(25, session.payload_fingerprint);
+        set_datetime(stmt, 26, session.last_seen_us);
+        stmt->setString(27, session.features);
+        stmt->setString(28, session.device);
+        stmt->execute();
+
         return 1;
     } 
     catch (const std::exception& e) 
     {
-        m_pool->return_connection(std::move(conn));
         spdlog::error("Error inserting/updating session_info: {}", e.what());
         return -1;
     }
 }
 
+int MySQLDAO::insert_or_update_session_infos(const std::vector<SessionInfo>& sessions,
+                                             std::vector<SessionInfo>* failed)
+{
+    if (sessions.empty()) return 0;
+    ensure_session_schema();
+
+    // 没有唯一索引时 ON DUPLICATE KEY 不会命中，只能逐条写入；有一条失败即整体失败，失败的记录交给调用方
+    if (!m_session_unique)
+    {
+        int written = 0;
+        for (const auto& session : sessions)
+        {
+            if (insert_or_update_session_info(session) == 1)
+            {
+                ++written;
+                continue;
+            }
+            spdlog::error("Failed to store session: {}", session.session_id);
+            if (failed) failed->push_back(session);
+        }
+        return written == static_cast<int>(sessions.size()) ? written : -1;
+    }
+
+    auto conn = m_pool->get_connection();
+    try
+    {
+        if (conn) return in_transaction(*conn, [&] { return write_session_upserts(*conn, sessions); });
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error batch upserting {} session_info rows: {}", sessions.size(), e.what());
+    }
+    if (failed) failed->insert(failed->end(), sessions.begin(), sessions.end());
+    return -1;
+}
+
+int MySQLDAO::write_session_upserts(PooledConnection& conn, const std::vector<SessionInfo>& sessions)
+{
+    // 新会话插入，已有会话（增量记录或同 ID 的旧行）按与逐条 UPDATE 相同的规则合并
+    static const char* kColumns = R"(
+        INSERT INTO session_info (
+            app_uid, timestamp, session_id, protocol,
+            src_ip, src_port, dst_ip, dst_port, packet_count, server_name,
+            close_reason, end_time, initiator_known, packets_up, packets_down,
+            bytes_up, bytes_down, retransmissions, out_of_order, zero_window,
+            handshake_rtt_us, duration_us, sample_rate, payload_fingerprint, last_seen,
+            features, device
+        ) VALUES )";
+    static const char* kRow = "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, IF(? > 0, FROM_UNIXTIME(?), NULL), "
+                              "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, NULLIF(?, ''), ?)";
+    for (size_t begin = 0, end = 0; begin < sessions.size(); begin = end)
+    {
+        end = begin + multi_row_count(sessions.size() - begin, SESSION_BATCH_ROWS);
+        std::string sql = kColumns;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (i != begin) sql += ", ";
+            sql += kRow;
+        }
+        sql += kSessionUpsert;
+
+        sql::PreparedStatement* stmt = conn.prepare(sql);
+        int idx = 1;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const SessionInfo& session = sessions[i];
+            stmt->setInt(idx++, session.app_uid);
+            set_datetime(stmt, idx++, session.timestamp_us);
+            stmt->setString(idx++, session.session_id);
+            stmt->setString(idx++, session.protocol);
+            stmt->setString(idx++, session.src_ip);
+            stmt->setInt(idx++, session.src_port);
+            stmt->setString(idx++, session.dst_ip);
+            stmt->setInt(idx++, session.dst_port);
+            stmt->setInt(idx++, session.size);
+            stmt->setString(idx++, session.server_name);
+            stmt->setString(idx++, session.close_reason);
+            stmt->setInt64(idx++, static_cast<int64_t>(session.end_time));
+            stmt->setInt64(idx++, static_cast<int64_t>(session.end_time));
+            stmt->setBoolean(idx++, session.initiator_known);
+            stmt->setUInt64(idx++, session.packets_up);
+            stmt->setUInt64(idx++, session.packets_down);
+            stmt->setUInt64(idx++, session.bytes_up);
+            stmt->setUInt64(idx++, session.bytes_down);
+            stmt->setUInt(idx++, session.retransmissions);
+            stmt->setUInt(idx++, session.out_of_order);
+            stmt->setUInt(idx++, session.zero_window);
+            stmt->setInt64(idx++, session.handshake_rtt_us);
+            stmt->setInt64(idx++, session.duration_us);
+            stmt->setUInt(idx++, session.sample_rate);
+            stmt->setString(idx++, session.payload_fingerprint);
+            set_datetime(stmt, idx++, session.last_seen_us);
+            stmt->setString(idx++, session.features);
+            stmt->setString(idx++, session.device);
+        }
+        stmt->execute();
+    }
+    return static_cast<int>(sessions.size());
+}
+
+SpoolReplayer* MySQLDAO::spool()
+{
+    std::call_once(m_spool_once, [this] {
+        m_spool = SpoolReplayer::shared(SpoolReplayer::default_dir(), endpoint());
+    });
+    return m_spool.get();
+}
+
+json MySQLDAO::spool_status()
+{
+    return spool()->status();
+}
+
+ColumnStore* MySQLDAO::column_store()
+{
+    std::call_once(m_column_store_once, [this] { m_column_store = ColumnStore::shared(); });
+    return m_column_store.get();
+}
+
+json MySQLDAO::partition_status() const
+{
+    return m_partitions ? m_partitions->status() : json();
+}
+
+int MySQLDAO::bulk_merge(BulkLoader& loader, const BatchTable& table, const std::vector<SqlRow>& rows,
+                         const std::string& on_duplicate, const std::function<json()>& spooled)
+{
+    SpoolReplayer* replayer = spool();
+    // 暂存区有积压时不能越过它先写；批次 id 记录表不可用时无法保证幂等，都交给常规写入
+    if (replayer->backlogged() || !ensure_spool_schema()) return -1;
+
+    std::string id = replayer->next_id();
+    if (loader.load(table, rows, BulkLoader::Mode::MERGE, id, on_duplicate) >= 0) return 1;
+    if (!loader.outcome_unknown()) return -1;
+
+    // COMMIT 的结果丢失：以同一 id 转存，服务端若已提交，回放时 spool_applied 中已有该 id 而跳过
+    spdlog::warn("Bulk merge of {} rows into {} lost its result, spooling batch {}: {}",
+                 rows.size(), table.name, id, loader.error());
+    json batch = spooled();
+    batch["id"] = id;
+    if (replayer->append(std::move(batch))) return 0;
+    spdlog::error("Spooling bulk batch {} failed, {} rows for {} may be lost", id, rows.size(), table.name);
+    return -2;
+}
+
+int MySQLDAO::bulk_store_rows(BulkLoader& loader, const RowBatch& batch)
+{
+    ensure_row_schema();
+    return bulk_merge(loader, *batch.table, batch.rows, std::string(),
+                      [&] { return rows_batch({batch}); });
+}
+
+int MySQLDAO::bulk_store_sessions(BulkLoader& loader, const std::vector<SessionInfo>& sessions)
+{
+    // 增量记录要与已有行累加，依赖 session_id 唯一索引
+    if (!ensure_session_schema() || !m_session_unique) return -1;
+    std::vector<SqlRow> rows;
+    rows.reserve(sessions.size());
+    for (const auto& session : sessions) rows.push_back(session_row(session));
+    return bulk_merge(loader, session_info_table(), rows, kSessionUpsert,
+                      [&] { return sessions_batch(sessions); });
+}
+
+int MySQLDAO::store_row_batches(const std::vector<RowBatch>& batches)
+{
+    if (batches.empty()) return 1;
+    if (ColumnStore* store = column_store())
+    {
+        bool ok = true;
+        for (const auto& batch : batches)
+            ok = store->append(batch.table->name, batch.table->columns, batch.rows) && ok;
+        return ok ? 1 : -1;
+    }
+    SpoolReplayer* replayer = spool();
+    // 暂存区有积压时直接排到队尾：保持写入顺序，也不必每批都等一次不可用的数据库
+    if (!replayer->backlogged() && insert_row_batches(batches) >= 0) return 1;
+    return replayer->append(rows_batch(batches)) ? 0 : -1;
+}
+
+int MySQLDAO::store_session_infos(const std::vector<SessionInfo>& sessions)
+{
+    if (sessions.empty()) return 1;
+    if (ColumnStore* store = column_store())
+    {
+        std::vector<SqlRow> rows;
+        rows.reserve(sessions.size());
+        for (const auto& session : sessions) rows.push_back(session_row(session));
+        const BatchTable& table = session_info_table();
+        return store->append(table.name, table.columns, rows) ? 1 : -1;
+    }
+    SpoolReplayer* replayer = spool();
+    // 增量记录按顺序累加，积压时同样不能越过暂存区先写；逐条写入时只转存没写进去的记录
+    std::vector<SessionInfo> failed;
+    if (replayer->backlogged()) failed = sessions;
+    else if (insert_or_update_session_infos(sessions, &failed) >= 0) return 1;
+
+    return replayer->append(sessions_batch(failed)) ? 0 : -1;
+}
+
+int MySQLDAO::store_http_exchanges(const std::vector<HttpFlowInfo>& flows, const std::vector<HttpPacket>& packets)
+{
+    if (flows.empty() && packets.empty()) return 1;
+    if (ColumnStore* store = column_store())
+    {
+        std::vector<SqlRow> flow_rows, packet_rows;
+        for (const auto& flow : flows) flow_rows.push_back(http_flow_row(flow));
+        for (const auto& packet : packets) packet_rows.push_back(http_packet_row(packet));
+        bool ok = store->append(http_flow_table().name, http_flow_table().columns, flow_rows);
+        ok = store->append(http_packets_table().name, http_packets_table().columns, packet_rows) && ok;
+        return ok ? 1 : -1;
+    }
+    SpoolReplayer* replayer = spool();
+    // 只有暂时性错误（库不可用、锁超时等）才转存；被拒的记录在 insert_http_exchanges 中逐条剔除
+    if (replayer->backlogged()) return replayer->append(http_batch(flows, packets)) ? 0 : -1;
+    std::vector<HttpFlowInfo> unwritten_flows;
+    std::vector<HttpPacket> unwritten_packets;
+    if (insert_http_exchanges(flows, packets, &unwritten_flows, &unwritten_packets) >= 0) return 1;
+    return replayer->append(http_batch(unwritten_flows, unwritten_packets)) ? 0 : -1;
+}
+
+bool MySQLDAO::ensure_spool_schema()
+{
+    if (m_spool_schema_ready) return true;
+    auto conn = m_pool->get_connection();
+    if (!conn) return false;
+
+    try
+    {
+        std::unique_ptr<sql::Statement> stmt(conn->connection()->createStatement());
+        stmt->execute(R"(
+            CREATE TABLE IF NOT EXISTS spool_applied (
+                batch_id    VARCHAR(64) NOT NULL PRIMARY KEY,
+                applied_at  DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6),
+                KEY idx_applied_at (applied_at)
+            )
+        )");
+        m_spool_schema_ready = true;
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("ensure_spool_schema error: {}", e.what());
+        return false;
+    }
+}
+
+int MySQLDAO::apply_spooled(const json& batch, json& requeue)
+{
+    std::string id = batch.value("id", "");
+    std::string kind = batch.value("kind", "");
+
+    // 先完整解码，记录本身有问题时不必占用连接
+    std::vector<BatchTable> tables;
+    std::vector<RowBatch> row_batches;
+    std::vector<SessionInfo> sessions;
+    std::vector<HttpFlowInfo> flows;
+    std::vector<HttpPacket> packets;
+    try
+    {
+        if (id.empty()) throw std::invalid_argument("missing batch id");
+        if (kind == "rows")
+        {
+            const json& items = batch.at("tables");
+            tables.reserve(items.size());       // row_batches 指向其中的元素，不能再扩容
+            for (const auto& item : items)
+            {
+                tables.push_back(BatchTable{item.at("table").get<std::string>(),
+                                            item.at("columns").get<std::vector<std::string>>()});
+                RowBatch rows;
+                rows.table = &tables.back();
+                for (const auto& values : item.at("rows"))
+                {
+                    SqlRow row;
+                    for (const auto& v : values) row.push_back(sql_value_from_json(v));
+                    rows.rows.push_back(std::move(row));
+                }
+                row_batches.push_back(std::move(rows));
+            }
+        }
+        else if (kind == "sessions")
+        {
+            for (const auto& item : batch.at("sessions")) sessions.push_back(session_from_json(item));
+        }
+        else if (kind == "http")
+        {
+            for (const auto& item : batch.at("flows")) flows.push_back(http_flow_from_json(item));
+            for (const auto& item : batch.at("packets")) packets.push_back(http_packet_from_json(item));
+        }
+        else
+        {
+            throw std::invalid_argument("unknown batch kind '" + kind + "'");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Cannot decode spooled batch {}: {}", id, e.what());
+        return -2;
+    }
+
+    if (!ensure_spool_schema()) return -1;
+    if (kind == "rows") ensure_row_schema();
+    if (kind == "sessions") ensure_session_schema();
+    if (kind == "http") ensure_http_body_schema();
+
+    auto conn = m_pool->get_connection();
+    if (!conn) return -1;
+
+    try
+    {
+        // 没有 session_id 唯一索引时只能逐条写入，无法与回放记录同在一个事务：至少一次
+        if (kind == "sessions" && !m_session_unique)
+        {
+            sql::PreparedStatement* check = conn->prepare("SELECT 1 FROM spool_applied WHERE batch_id = ?");
+            check->setString(1, id);
+            std::unique_ptr<sql::ResultSet> res(check->executeQuery());
+            if (res->next()) return 0;
+            conn.release();
+
+            // 已写入的增量不能随整批重放（会重复累加）：部分失败时只把失败的记录作为新批次交回
+            std::vector<SessionInfo> failed;
+            if (insert_or_update_session_infos(sessions, &failed) < 0)
+            {
+                if (failed.size() == sessions.size()) return -1;
+                requeue = sessions_batch(failed);
+            }
+            conn = m_pool->get_connection();
+            if (!conn) return -1;
+            sql::PreparedStatement* mark = conn->prepare("INSERT IGNORE INTO spool_applied (batch_id) VALUES (?)");
+            mark->setString(1, id);
+            mark->executeUpdate();
+            return 1;
+        }
+
+        // 回放记录与数据同一事务提交：已提交过的批次插入不了记录，整批跳过
+        return in_transaction(*conn, [&] {
+            sql::PreparedStatement* mark = conn->prepare("INSERT IGNORE INTO spool_applied (batch_id) VALUES (?)");
+            mark->setString(1, id);
+            if (mark->executeUpdate() == 0) return 0;
+
+            if (kind == "rows") write_row_batches(*conn, row_batches);
+            else if (kind == "sessions") write_session_upserts(*conn, sessions);
+            else
+            {
+                for (const auto& flow : flows) write_http_flow(*conn, flow);
+                for (const auto& packet : packets) write_http_packet(*conn, packet);
+            }
+            return 1;
+        });
+    }
+    catch (const sql::SQLException& e)
+    {
+        spdlog::error("Replaying spooled batch {} ({}) failed: {} (code {})", id, kind, e.what(), e.getErrorCode());
+        if (is_transient(e)) return -1;
+        if (kind != "http") return -2;
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Replaying spooled batch {} ({}) failed: {}", id, kind, e.what());
+        return -2;
+    }
+
+    // HTTP 批次中有被拒的记录：事务已回滚，逐条重写（出错的记录丢弃），同会话批次的逐条路径一样至少一次
+    std::vector<HttpFlowInfo> unwritten_flows;
+    std::vector<HttpPacket> unwritten_packets;
+    conn.release();
+    if (insert_http_exchanges(flows, packets, &unwritten_flows, &unwritten_packets) < 0)
+    {
+        if (unwritten_flows.size() == flows.size() && unwritten_packets.size() == packets.size()) return -1;
+        requeue = http_batch(unwritten_flows, unwritten_packets);
+    }
+    conn = m_pool->get_connection();
+    if (!conn) return -1;
+    try
+    {
+        sql::PreparedStatement* mark = conn->prepare("INSERT IGNORE INTO spool_applied (batch_id) VALUES (?)");
+        mark->setString(1, id);
+        mark->executeUpdate();
+        return 1;
+    }
+    catch (const sql::SQLException& e)
+    {
+        // 数据已写入，不能再整批重试；记录缺失只意味着重启后重复回放时不会被跳过
+        spdlog::error("Marking spooled batch {} as applied failed: {}", id, e.what());
+        return 1;
+    }
+}
+
+int MySQLDAO::purge_spool_markers(int64_t older_than_sec)
+{
+    if (!ensure_spool_schema()) return -1;
+    auto conn = m_pool->get_connection();
+    if (!conn) return -1;
+
+    try
+    {
+        // 按服务端时间比较，与 applied_at 的默认值同一时区
+        sql::PreparedStatement* stmt = conn->prepare(
+            "DELETE FROM spool_applied WHERE applied_at < NOW(6) - INTERVAL ? SECOND");
+        stmt->setInt64(1, older_than_sec);
+        return stmt->executeUpdate();
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("purge_spool_markers error: {}", e.what());
+        return -1;
+    }
+}
+
 // // 插入 session_resources 表
 // int MySQLDAO::insert_session_resource(const std::string& session_id, const std::string& resource) {
 //     auto conn = m_pool->get_connection();
@@ -0,0 +1,414 @@
+#include "MySQLPool.h"
+#include <algorithm>
+#include <future>
+#include <map>
+#include <spdlog/spdlog.h>
+
+namespace {
+uint64_t elapsed_us(std::chrono::steady_clock::time_point since)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+}
+
+MySqlPoolConfig MySqlPoolConfig::for_size(int pool_size)
+{
+    MySqlPoolConfig config;
+    config.max_size = std::max(1, pool_size);
+    config.min_size = std::min(config.min_size, config.max_size);
+    return config;
+}
+
+PooledConnection::PooledConnection(std::unique_ptr<sql::Connection> con)
+    : m_con(std::move(con))
+{
+    touch();
+}
+
+sql::PreparedStatement* PooledConnection::prepare(const std::string& sql)
+{
+    auto it = m_statements.find(sql);
+    if (it != m_statements.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        it->second.stmt->clearParameters();
+        ++m_hits;
+        return it->second.stmt.get();
+    }
+
+    std::unique_ptr<sql::PreparedStatement> stmt(m_con->prepareStatement(sql));
+    if (m_statements.size() >= MAX_STATEMENTS)
+    {
+        m_statements.erase(*m_lru.back());
+        m_lru.pop_back();
+    }
+    auto inserted = m_statements.emplace(sql, Statement{std::move(stmt), m_lru.end()}).first;
+    m_lru.push_front(&inserted->first);
+    inserted->second.lru = m_lru.begin();
+    ++m_prepares;
+    return inserted->second.stmt.get();
+}
+
+void PooledConnection::reset(std::unique_ptr<sql::Connection> con)
+{
+    m_statements.clear();
+    m_lru.clear();
+    m_con = std::move(con);
+    touch();
+}
+
+ConnectionLease::ConnectionLease(MySqlPool* pool, std::unique_ptr<PooledConnection> con)
+    : m_pool(pool)
+    , m_con(std::move(con))
+{
+}
+
+ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_con(std::move(other.m_con))
+{
+    other.m_pool = nullptr;
+}
+
+ConnectionLease& ConnectionLease::operator=(ConnectionLease&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_pool = other.m_pool;
+        m_con = std::move(other.m_con);
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+ConnectionLease::~ConnectionLease()
+{
+    release();
+}
+
+void ConnectionLease::release()
+{
+    if (m_con && m_pool) m_pool->return_connection(std::move(m_con));
+    m_con.reset();
+    m_pool = nullptr;
+}
+
+MySqlPool::MySqlPool(const std::string& url, const std::string& user,
+                     const std::string& pass, const std::string& schema,
+                     int poolSize)
+    : MySqlPool(url, user, pass, schema, MySqlPoolConfig::for_size(poolSize))
+{
+}
+
+MySqlPool::MySqlPool(const std::string& url, const std::string& user,
+                     const std::string& pass, const std::string& schema,
+                     const MySqlPoolConfig& config)
+    : m_url(url)
+    , m_user(user)
+    , m_pass(pass)
+    , m_schema(schema)
+    , m_config(config)
+    , b_stop_(false)
+{
+    m_config.max_size = std::max(1, m_config.max_size);
+    m_config.min_size = std::max(0, std::min(m_config.min_size, m_config.max_size));
+    if (m_config.min_size == 0)
+    {
+        m_state = State::READY;
+        return;
+    }
+
+    // 驱动实例的首次获取不是线程安全的，先在构造线程里完成
+    sql::mysql::get_mysql_driver_instance();
+    // 先占好常驻连接的名额，借用者会等待预热建好的连接而不是另建
+    m_total = m_config.min_size;
+    m_warmup = std::thread(&MySqlPool::warm_up, this);
+}
+
+std::shared_ptr<MySqlPool> MySqlPool::shared(const std::string& url, const std::string& user,
+                                             const std::string& pass, const std::string& schema,
+                                             const MySqlPoolConfig& config)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<MySqlPool>> pools;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<MySqlPool>& slot = pools[user + "@" + url + "/" + schema];
+    std::shared_ptr<MySqlPool> pool = slot.lock();
+    if (!pool)
+    {
+        pool = std::make_shared<MySqlPool>(url, user, pass, schema, config);
+        slot = pool;
+    }
+    return pool;
+}
+
+void MySqlPool::warm_up()
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<std::unique_ptr<sql::Connection>>> pending;
+    for (int i = 0; i < m_config.min_size; ++i)
+        pending.push_back(std::async(std::launch::async, [this] { return create_connection(); }));
+
+    int opened = 0;
+    std::string error;
+    for (auto& future : pending)
+    {
+        std::unique_ptr<PooledConnection> con;
+        try
+        {
+            con = std::make_unique<PooledConnection>(future.get());
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (con && !b_stop_)
+        {
+            m_pool.push_back(std::move(con));
+            ++m_stats.created;
+            ++opened;
+        }
+        else
+        {
+            // 建立失败（或池已关闭）：让出名额，借用时按需重试
+            --m_total;
+            if (!con) ++m_stats.failures;
+        }
+        m_cond.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_state = opened > 0 ? State::READY : State::FAILED;
+    }
+    m_cond.notify_all();
+
+    if (opened > 0)
+        spdlog::info("MySqlPool ready: {} of {} connections to {} in {}us",
+                     opened, m_config.min_size, m_url, elapsed_us(start));
+    else
+        spdlog::error("MySqlPool could not connect to {}: {}", m_url, error);
+}
+
+ConnectionLease MySqlPool::get_connection()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(m_config.acquire_timeout_ms);
+    bool waited = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::unique_ptr<PooledConnection> con;
+    bool create = false;
+    while (true)
+    {
+        if (b_stop_) return ConnectionLease();
+        if (!m_pool.empty())
+        {
+            con = std::move(m_pool.front());
+            m_pool.pop_front();
+            break;
+        }
+        if (m_total < m_config.max_size)
+        {
+            // 先占名额再在锁外建立连接
+            ++m_total;
+            create = true;
+            break;
+        }
+        if (m_config.acquire_timeout_ms > 0 && std::chrono::steady_clock::now() >= deadline)
+        {
+            uint64_t wait_us = elapsed_us(start);
+            ++m_stats.timeouts;
+            ++m_stats.waits;
+            m_stats.wait_us_total += wait_us;
+            m_stats.wait_us_max = std::max(m_stats.wait_us_max, wait_us);
+            lock.unlock();
+            spdlog::warn("MySqlPool exhausted: no connection within {}ms ({} connections in use)",
+                         m_config.acquire_timeout_ms, m_config.max_size);
+            return ConnectionLease();
+        }
+        waited = true;
+        if (m_config.acquire_timeout_ms > 0) m_cond.wait_until(lock, deadline);
+        else m_cond.wait(lock);
+    }
+    uint64_t wait_us = elapsed_us(start);
+    ++m_stats.acquired;
+    if (waited)
+    {
+        ++m_stats.waits;
+        m_stats.wait_us_total += wait_us;
+        m_stats.wait_us_max = std::max(m_stats.wait_us_max, wait_us);
+    }
+    lock.unlock();
+
+    bool ok = false;
+    if (create)
+    {
+        try
+        {
+            con = std::make_unique<PooledConnection>(create_connection());
+            ok = true;
+        }
+        catch (sql::SQLException& e)
+        {
+            spdlog::error("MySqlPool failed to open connection: {}", e.what());
+        }
+    }
+    else
+    {
+        ok = validate(*con);
+    }
+
+    if (!ok)
+    {
+        // 放弃这条连接并让出名额，等待者可再尝试建立
+        con.reset();
+        std::lock_guard<std::mutex> guard(m_mutex);
+        --m_total;
+        ++m_stats.failures;
+        m_cond.notify_one();
+        return ConnectionLease();
+    }
+    if (create)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        ++m_stats.created;
+        if (m_state == State::FAILED)
+        {
+            m_state = State::READY;
+            m_cond.notify_all();
+        }
+    }
+    return ConnectionLease(this, std::move(con));
+}
+
+bool MySqlPool::validate(PooledConnection& con)
+{
+    sql::Connection* raw = con.connection();
+    bool closed = !raw || raw->isClosed();
+    if (!closed && std::chrono::steady_clock::now() - con.last_used() < std::chrono::milliseconds(m_config.validate_idle_ms))
+        return true;
+
+    try
+    {
+        if (!closed && raw->isValid()) return true;
+    }
+    catch (sql::SQLException& e)
+    {
+        spdlog::warn("MySqlPool ping failed: {}", e.what());
+    }
+    return reconnect(con);
+}
+
+bool MySqlPool::reconnect(PooledConnection& con)
+{
+    try
+    {
+        con.reset(create_connection());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.reconnects;
+        return true;
+    }
+    catch (sql::SQLException& e)
+    {
+        spdlog::error("MySqlPool reconnect failed: {}", e.what());
+        return false;
+    }
+}
+
+void MySqlPool::return_connection(std::unique_ptr<PooledConnection> con)
+{
+    std::vector<std::unique_ptr<PooledConnection>> expired;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (b_stop_)
+        {
+            --m_total;      // 池已关闭：连接在锁外随 con 释放
+        }
+        else
+        {
+            con->touch();
+            m_pool.push_front(std::move(con));
+            expired = take_expired_locked();
+            m_cond.notify_one();  // 通知等待线程
+        }
+    }
+    // 关闭连接涉及网络往返，放在锁外
+}
+
+std::vector<std::unique_ptr<PooledConnection>> MySqlPool::take_expired_locked()
+{
+    std::vector<std::unique_ptr<PooledConnection>> expired;
+    auto now = std::chrono::steady_clock::now();
+    while (!m_pool.empty() && m_total > m_config.min_size &&
+           now - m_pool.back()->last_used() >= std::chrono::milliseconds(m_config.idle_timeout_ms))
+    {
+        expired.push_back(std::move(m_pool.back()));
+        m_pool.pop_back();
+        --m_total;
+        ++m_stats.closed_idle;
+    }
+    return expired;
+}
+
+std::unique_ptr<sql::Connection> MySqlPool::create_connection()
+{
+    // 获取 MySQL 驱动实例
+    sql::mysql::MySQL_Driver* driver = sql::mysql::get_mysql_driver_instance();
+
+    // 建立连接
+    std::unique_ptr<sql::Connection> con(driver->connect(m_url, m_user, m_pass));
+
+    // 设置默认数据库
+    con->setSchema(m_schema);
+
+    // 设置字符集（避免乱码）
+    con->setClientOption("CHARSET", "utf8mb4");
+    return con;
+}
+
+MySqlPoolStats MySqlPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MySqlPoolStats stats = m_stats;
+    stats.total = m_total;
+    stats.idle = static_cast<int>(m_pool.size());
+    return stats;
+}
+
+MySqlPool::State MySqlPool::state() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state;
+}
+
+bool MySqlPool::wait_ready(int64_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                    [this] { return b_stop_ || m_state != State::CONNECTING; });
+    return m_state == State::READY;
+}
+
+void MySqlPool::Close()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        b_stop_ = true;  // 设置关闭标志
+    }
+    m_cond.notify_all();  // 唤醒所有可能在等待连接的线程
+}
+
+MySqlPool::~MySqlPool()
+{
+    Close();  // 确保池关闭
+    if (m_warmup.joinable()) m_warmup.join();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_total -= static_cast<int>(m_pool.size());
+    m_pool.clear();  // 连接会自动释放
+}
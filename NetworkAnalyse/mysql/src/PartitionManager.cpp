@@ -0,0 +1,594 @@
+#include "PartitionManager.h"
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <spdlog/spdlog.h>
+#include "TimeFormat.h"
+
+using nlohmann::json;
+
+namespace {
+
+const char* const MAXVALUE_NAME = "pmax";
+const char* const HISTORY_NAME = "phistory";    // 转换时容纳既有数据的分区
+
+bool valid_name(const std::string& name)
+{
+    if (name.empty() || name.size() > 64) return false;
+    for (char c : name)
+        if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_')) return false;
+    return true;
+}
+
+std::string quote_name(const std::string& name)
+{
+    return "`" + name + "`";
+}
+
+// 所在分区的起点（本地时间按 hours 对齐，epoch 秒）
+int64_t period_floor(int64_t seconds, int hours)
+{
+    std::time_t t = static_cast<std::time_t>(seconds);
+    std::tm tm;
+    localtime_r(&t, &tm);
+    tm.tm_hour = tm.tm_hour / hours * hours;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&tm));
+}
+
+// 下一个分区的起点；夏令时切换时按本地钟点重新对齐
+int64_t period_next(int64_t start, int hours)
+{
+    std::time_t t = static_cast<std::time_t>(start);
+    std::tm tm;
+    localtime_r(&t, &tm);
+    tm.tm_hour += hours;
+    tm.tm_isdst = -1;
+    int64_t next = period_floor(static_cast<int64_t>(std::mktime(&tm)), hours);
+    return next > start ? next : start + hours * 3600;
+}
+
+std::string format_local(int64_t seconds, const char* format)
+{
+    std::time_t t = static_cast<std::time_t>(seconds);
+    std::tm tm;
+    localtime_r(&t, &tm);
+    char text[32];
+    std::strftime(text, sizeof(text), format, &tm);
+    return text;
+}
+
+std::string partition_name(int64_t lower)
+{
+    return "p" + format_local(lower, "%Y%m%d%H");
+}
+
+std::string partition_clause(const std::string& name, int64_t upper)
+{
+    if (upper == INT64_MAX) return "PARTITION " + name + " VALUES LESS THAN (MAXVALUE)";
+    return "PARTITION " + name + " VALUES LESS THAN ('" + format_local(upper, "%Y-%m-%d %H:%M:%S") + "')";
+}
+
+// PARTITION_DESCRIPTION："'2026-10-20 00:00:00'" 或 "MAXVALUE"
+bool parse_bound(std::string text, int64_t& upper)
+{
+    if (text == "MAXVALUE")
+    {
+        upper = INT64_MAX;
+        return true;
+    }
+    if (text.size() >= 2 && text.front() == '\'' && text.back() == '\'') text = text.substr(1, text.size() - 2);
+    int64_t epoch_us = 0;
+    if (!parse_datetime_us(text, epoch_us)) return false;
+    upper = epoch_us / 1000000;
+    return true;
+}
+
+void execute(PooledConnection& conn, const std::string& sql)
+{
+    std::unique_ptr<sql::Statement> stmt(conn.connection()->createStatement());
+    stmt->execute(sql);
+}
+
+}
+
+PartitionManager::PartitionManager(std::shared_ptr<MySqlPool> pool, std::vector<PartitionPolicy> policies,
+                                   int64_t interval_sec)
+    : m_pool(std::move(pool))
+    , m_policies(std::move(policies))
+    , m_interval_sec(std::max<int64_t>(interval_sec, 1))
+{
+    m_thread = std::thread(&PartitionManager::run, this);
+}
+
+PartitionManager::~PartitionManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::shared_ptr<PartitionManager> PartitionManager::shared(const std::shared_ptr<MySqlPool>& pool)
+{
+    static std::mutex mutex;
+    static std::weak_ptr<PartitionManager> instance;
+
+    const char* spec = std::getenv("NETWORK_ANALYSE_PARTITIONS");
+    if (!spec || !*spec) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<PartitionManager> manager = instance.lock();
+    if (!manager)
+    {
+        std::vector<PartitionPolicy> policies;
+        std::string error;
+        if (!parse_policies(spec, policies, error))
+        {
+            spdlog::error("Invalid NETWORK_ANALYSE_PARTITIONS \"{}\": {}", spec, error);
+            return nullptr;
+        }
+        manager = std::make_shared<PartitionManager>(pool, std::move(policies));
+        instance = manager;
+        spdlog::info("Partition maintenance enabled: {}", spec);
+    }
+    return manager;
+}
+
+bool PartitionManager::parse_policies(const std::string& spec, std::vector<PartitionPolicy>& policies,
+                                      std::string& error)
+{
+    policies.clear();
+    if (spec == "default")
+    {
+        policies = {{"dns_packets", 24, 30 * 24},
+                    {"http_packets", 24, 7 * 24},
+                    {"http_flow_info", 24, 30 * 24},
+                    {"session_info", 24, 90 * 24}};
+        return true;
+    }
+
+    size_t start = 0;
+    while (start <= spec.size())
+    {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        size_t first = item.find(':');
+        size_t second = first == std::string::npos ? first : item.find(':', first + 1);
+        if (second == std::string::npos)
+        {
+            error = "expected table:hours:retention, got \"" + item + "\"";
+            return false;
+        }
+
+        PartitionPolicy policy;
+        policy.table = item.substr(0, first);
+        std::string hours = item.substr(first + 1, second - first - 1);
+        std::string retention = item.substr(second + 1);
+        if (!valid_name(policy.table))
+        {
+            error = "invalid table name \"" + policy.table + "\"";
+            return false;
+        }
+
+        char* rest = nullptr;
+        long value = std::strtol(hours.c_str(), &rest, 10);
+        if (hours.empty() || *rest || value <= 0 || 24 % value != 0)
+        {
+            error = "partition hours of " + policy.table + " must divide 24";
+            return false;
+        }
+        policy.partition_hours = static_cast<int>(value);
+
+        int unit = 24;
+        if (!retention.empty() && (retention.back() == 'd' || retention.back() == 'h'))
+        {
+            unit = retention.back() == 'h' ? 1 : 24;
+            retention.pop_back();
+        }
+        value = std::strtol(retention.c_str(), &rest, 10);
+        if (retention.empty() || *rest || value < 0 || value > INT_MAX / 24)
+        {
+            error = "invalid retention of " + policy.table;
+            return false;
+        }
+        policy.retention_hours = static_cast<int>(value) * unit;
+        if (policy.retention_hours > 0 && policy.retention_hours < policy.partition_hours)
+        {
+            error = "retention of " + policy.table + " is shorter than one partition";
+            return false;
+        }
+        policies.push_back(policy);
+    }
+    if (policies.empty()) error = "no tables";
+    return !policies.empty();
+}
+
+int PartitionManager::maintain()
+{
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+    auto conn = m_pool->get_connection();
+    if (!conn)
+    {
+        spdlog::warn("Partition maintenance skipped: no database connection");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& policy : m_policies)
+        {
+            TableState& state = m_states[policy.table];
+            state.state = "error";
+            state.message = "no database connection";
+        }
+        return 0;
+    }
+
+    int maintained = 0;
+    for (const auto& policy : m_policies)
+    {
+        TableState state;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            state = m_states[policy.table];
+        }
+        std::string previous = state.message;
+        state.message.clear();
+        try
+        {
+            if (maintain_table(*conn, policy, state)) ++maintained;
+            else if (state.message != previous)
+                spdlog::warn("Partitioning of {} skipped: {}", policy.table, state.message);
+        }
+        catch (const sql::SQLException& e)
+        {
+            state.state = "error";
+            state.message = e.what();
+            spdlog::error("Partition maintenance of {} failed: {} (code {})", policy.table, e.what(), e.getErrorCode());
+        }
+        state.last_run_us = now_us();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_states[policy.table] = state;
+    }
+    return maintained;
+}
+
+bool PartitionManager::maintain_table(PooledConnection& conn, const PartitionPolicy& policy, TableState& state)
+{
+    sql::PreparedStatement* stmt = conn.prepare(
+        "SELECT PARTITION_NAME, PARTITION_METHOD, PARTITION_EXPRESSION, PARTITION_DESCRIPTION "
+        "FROM information_schema.PARTITIONS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? "
+        "ORDER BY PARTITION_ORDINAL_POSITION");
+    stmt->setString(1, policy.table);
+    std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+
+    bool exists = false;
+    std::vector<Bound> bounds;
+    std::string method;
+    std::string expression;
+    std::string bad_bound;
+    while (res->next())
+    {
+        exists = true;
+        if (res->isNull(1)) continue;   // 未分区的表只有一行，分区名为 NULL
+        method = res->getString(2);
+        expression = res->getString(3);
+        Bound bound;
+        bound.name = res->getString(1);
+        if (!parse_bound(res->getString(4), bound.upper)) bad_bound = res->getString(4);
+        bounds.push_back(bound);
+    }
+    res.reset();
+
+    if (!exists)
+    {
+        state.state = "skipped";
+        state.message = "table does not exist";
+        return false;
+    }
+    if (bounds.empty()) return convert_table(conn, policy, state) && maintain_table(conn, policy, state);
+
+    expression.erase(std::remove(expression.begin(), expression.end(), '`'), expression.end());
+    if (method != "RANGE COLUMNS" || expression != "timestamp" || !bad_bound.empty())
+    {
+        state.state = "skipped";
+        state.message = "partitioned by " + method + "(" + expression + ")" +
+                        (bad_bound.empty() ? "" : " with unrecognised bound " + bad_bound) + ", expected RANGE COLUMNS(timestamp)";
+        return false;
+    }
+
+    add_partitions(conn, policy, bounds, state);
+    drop_expired(conn, policy, bounds, state);
+
+    state.state = "partitioned";
+    state.partitions = bounds.size();
+    state.oldest_upper = bounds.front().upper == INT64_MAX ? 0 : bounds.front().upper;
+    state.newest_upper = 0;
+    for (const auto& bound : bounds)
+        if (bound.upper != INT64_MAX) state.newest_upper = std::max(state.newest_upper, bound.upper);
+    return true;
+}
+
+bool PartitionManager::convert_table(PooledConnection& conn, const PartitionPolicy& policy, TableState& state)
+{
+    const std::string table = quote_name(policy.table);
+
+    sql::PreparedStatement* stmt = conn.prepare(
+        "SELECT DATA_TYPE, COLUMN_TYPE, IS_NULLABLE, COLUMN_DEFAULT FROM information_schema.COLUMNS "
+        "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? AND COLUMN_NAME = 'timestamp'");
+    stmt->setString(1, policy.table);
+    std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+    if (!res->next())
+    {
+        state.state = "skipped";
+        state.message = "no timestamp column";
+        return false;
+    }
+    std::string data_type = res->getString(1);
+    std::transform(data_type.begin(), data_type.end(), data_type.begin(), ::tolower);
+    std::string column_type = res->getString(2);
+    bool nullable = res->getString(3) == "YES";
+    std::string column_default;
+    if (!res->isNull(4))
+    {
+        column_default = res->getString(4);
+        // CURRENT_TIMESTAMP 等表达式原样保留，其余为字面量
+        if (column_default.compare(0, 17, "CURRENT_TIMESTAMP") != 0) column_default = "'" + column_default + "'";
+    }
+    res.reset();
+    if (data_type != "datetime")
+    {
+        state.state = "skipped";
+        state.message = "timestamp is " + data_type + ", hourly RANGE COLUMNS bounds need DATETIME";
+        return false;
+    }
+
+    // 分区表不支持外键
+    stmt = conn.prepare(
+        "SELECT COUNT(*) FROM information_schema.KEY_COLUMN_USAGE "
+        "WHERE TABLE_SCHEMA = DATABASE() AND REFERENCED_TABLE_NAME IS NOT NULL "
+        "AND (TABLE_NAME = ? OR REFERENCED_TABLE_NAME = ?)");
+    stmt->setString(1, policy.table);
+    stmt->setString(2, policy.table);
+    res.reset(stmt->executeQuery());
+    if (res->next() && res->getInt64(1) > 0)
+    {
+        state.state = "skipped";
+        state.message = "table has foreign keys";
+        return false;
+    }
+
+    // 唯一索引补上 timestamp 列（保留原列顺序与前缀长度）
+    stmt = conn.prepare(
+        "SELECT INDEX_NAME, COLUMN_NAME, SUB_PART FROM information_schema.STATISTICS "
+        "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = ? AND NON_UNIQUE = 0 "
+        "ORDER BY INDEX_NAME, SEQ_IN_INDEX");
+    stmt->setString(1, policy.table);
+    res.reset(stmt->executeQuery());
+    std::map<std::string, std::vector<std::string>> unique_indexes;
+    std::map<std::string, bool> has_timestamp;
+    while (res->next())
+    {
+        std::string index = res->getString(1);
+        std::string column = res->getString(2);
+        std::string part = quote_name(column);
+        if (!res->isNull(3)) part += "(" + res->getString(3) + ")";
+        unique_indexes[index].push_back(part);
+        if (column == "timestamp") has_timestamp[index] = true;
+    }
+    res.reset();
+
+    std::vector<std::string> clauses;
+    bool primary_changed = false;
+    for (const auto& index : unique_indexes)
+    {
+        if (has_timestamp[index.first]) continue;
+        std::string columns;
+        for (const auto& part : index.second) columns += part + ", ";
+        columns += "`timestamp`";
+        if (index.first == "PRIMARY")
+        {
+            primary_changed = true;
+            clauses.push_back("DROP PRIMARY KEY, ADD PRIMARY KEY (" + columns + ")");
+        }
+        else
+        {
+            clauses.push_back("DROP INDEX " + quote_name(index.first) + ", ADD UNIQUE INDEX " +
+                              quote_name(index.first) + " (" + columns + ")");
+        }
+    }
+
+    // 主键列不能为 NULL：未知时间由触发器补为写入时刻，先于改表建好，建不了就不转换
+    const std::string trigger = quote_name(policy.table + "_timestamp_fill");
+    bool trigger_created = false;
+    if (primary_changed && nullable)
+    {
+        try
+        {
+            execute(conn, "CREATE TRIGGER " + trigger + " BEFORE INSERT ON " + table +
+                          " FOR EACH ROW SET NEW.`timestamp` = IFNULL(NEW.`timestamp`, NOW(6))");
+            trigger_created = true;
+        }
+        catch (const sql::SQLException& e)
+        {
+            // 1359: 触发器已存在（上次转换中断）
+            if (e.getErrorCode() != 1359)
+            {
+                state.state = "skipped";
+                state.message = std::string("cannot create NULL timestamp trigger: ") + e.what();
+                return false;
+            }
+        }
+        execute(conn, "UPDATE " + table + " SET `timestamp` = '1970-01-02 00:00:00' WHERE `timestamp` IS NULL");
+        clauses.insert(clauses.begin(), "MODIFY COLUMN `timestamp` " + column_type + " NOT NULL" +
+                                        (column_default.empty() ? "" : " DEFAULT " + column_default));
+    }
+
+    int64_t now = now_us() / 1000000;
+    int64_t lower = period_floor(now, policy.partition_hours);
+    std::string partitions = partition_clause(HISTORY_NAME, lower);
+    for (int i = 0; i <= policy.precreate; ++i)
+    {
+        int64_t upper = period_next(lower, policy.partition_hours);
+        partitions += ", " + partition_clause(partition_name(lower), upper);
+        lower = upper;
+    }
+    partitions += ", " + partition_clause(MAXVALUE_NAME, INT64_MAX);
+
+    std::string sql = "ALTER TABLE " + table + " ";
+    for (const auto& clause : clauses) sql += clause + ", ";
+    if (!clauses.empty()) sql.erase(sql.size() - 2, 1);
+    sql += "PARTITION BY RANGE COLUMNS(`timestamp`) (" + partitions + ")";
+
+    spdlog::info("Partitioning {} by {}h on timestamp, the table is rebuilt once", policy.table,
+                 policy.partition_hours);
+    try
+    {
+        execute(conn, sql);
+    }
+    catch (const sql::SQLException&)
+    {
+        if (trigger_created)
+        {
+            try { execute(conn, "DROP TRIGGER IF EXISTS " + trigger); }
+            catch (const sql::SQLException&) {}
+        }
+        throw;
+    }
+    spdlog::info("Partitioned {}", policy.table);
+    state.created += static_cast<uint64_t>(policy.precreate) + 1;
+    return true;
+}
+
+void PartitionManager::add_partitions(PooledConnection& conn, const PartitionPolicy& policy,
+                                      std::vector<Bound>& bounds, TableState& state)
+{
+    const int hours = policy.partition_hours;
+    int64_t now = now_us() / 1000000;
+    int64_t current = period_floor(now, hours);
+    int64_t target = current;
+    for (int i = 0; i <= policy.precreate; ++i) target = period_next(target, hours);
+
+    bool has_max = bounds.back().upper == INT64_MAX;
+    int64_t lower = INT64_MIN;
+    for (const auto& bound : bounds)
+        if (bound.upper != INT64_MAX) lower = std::max(lower, bound.upper);
+
+    std::vector<Bound> added;
+    if (lower == INT64_MIN)
+    {
+        lower = current;    // 只有 MAXVALUE 分区：当前分区之前的数据都拆到第一个新分区
+    }
+    else if (lower < current)
+    {
+        // 停机期间的空档合为一个分区，不按周期补建（既省分区数，也多半随即过期）
+        added.push_back({partition_name(lower), current});
+        lower = current;
+    }
+    while (lower < target)
+    {
+        int64_t upper = period_next(period_floor(lower, hours), hours);
+        added.push_back({partition_name(lower), upper});
+        lower = upper;
+    }
+    if (added.empty()) return;
+
+    std::string clauses;
+    for (const auto& bound : added)
+        clauses += (clauses.empty() ? "" : ", ") + partition_clause(bound.name, bound.upper);
+
+    // MAXVALUE 分区只在提前建好的分区都用完后才有数据，正常情况下拆分它不搬数据
+    if (has_max)
+    {
+        const std::string max_name = bounds.back().name;
+        execute(conn, "ALTER TABLE " + quote_name(policy.table) + " REORGANIZE PARTITION " + max_name + " INTO (" +
+                      clauses + ", " + partition_clause(max_name, INT64_MAX) + ")");
+    }
+    else
+    {
+        execute(conn, "ALTER TABLE " + quote_name(policy.table) + " ADD PARTITION (" + clauses + ")");
+    }
+    spdlog::info("Added {} partitions to {} up to {}", added.size(), policy.table,
+                 format_local(added.back().upper, "%Y-%m-%d %H:%M:%S"));
+    bounds.insert(has_max ? bounds.end() - 1 : bounds.end(), added.begin(), added.end());
+    state.created += added.size();
+}
+
+void PartitionManager::drop_expired(PooledConnection& conn, const PartitionPolicy& policy,
+                                    std::vector<Bound>& bounds, TableState& state)
+{
+    if (policy.retention_hours <= 0) return;
+    int64_t cutoff = now_us() / 1000000 - static_cast<int64_t>(policy.retention_hours) * 3600;
+
+    // 分区上界不超过 cutoff 即整个分区都已过期；至少保留一个分区
+    std::string names;
+    size_t expired = 0;
+    while (expired + 1 < bounds.size() && bounds[expired].upper != INT64_MAX && bounds[expired].upper <= cutoff)
+    {
+        names += (names.empty() ? "" : ", ") + bounds[expired].name;
+        ++expired;
+    }
+    if (expired == 0) return;
+
+    execute(conn, "ALTER TABLE " + quote_name(policy.table) + " DROP PARTITION " + names);
+    spdlog::info("Dropped {} expired partitions of {}: {}", expired, policy.table, names);
+    bounds.erase(bounds.begin(), bounds.begin() + expired);
+    state.dropped += expired;
+}
+
+void PartitionManager::run()
+{
+    while (true)
+    {
+        maintain();
+        bool failed = false;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (const auto& item : m_states) failed = failed || item.second.state == "error";
+        int64_t wait_sec = failed ? std::min(m_interval_sec, RETRY_INTERVAL_SEC) : m_interval_sec;
+        if (m_cv.wait_for(lock, std::chrono::seconds(wait_sec), [this] { return m_stop; })) break;
+    }
+}
+
+json PartitionManager::status() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    json tables = json::object();
+    for (const auto& policy : m_policies)
+    {
+        json t;
+        t["partition_hours"] = policy.partition_hours;
+        t["retention_hours"] = policy.retention_hours;
+        auto it = m_states.find(policy.table);
+        if (it != m_states.end())
+        {
+            const TableState& state = it->second;
+            t["state"] = state.state;
+            if (!state.message.empty()) t["message"] = state.message;
+            t["partitions"] = state.partitions;
+            if (state.oldest_upper) t["oldest_until"] = format_local(state.oldest_upper, "%Y-%m-%d %H:%M:%S");
+            if (state.newest_upper) t["newest_until"] = format_local(state.newest_upper, "%Y-%m-%d %H:%M:%S");
+            t["created"] = state.created;
+            t["dropped"] = state.dropped;
+            if (state.last_run_us) t["last_run"] = format_datetime_us(state.last_run_us);
+        }
+        else
+        {
+            t["state"] = "pending";
+        }
+        tables[policy.table] = std::move(t);
+    }
+    json j;
+    j["interval_sec"] = m_interval_sec;
+    j["tables"] = std::move(tables);
+    return j;
+}
@@ -0,0 +1,162 @@
+#include "SpoolReplayer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+#include "MySQLDAO.h"
+#include "TimeFormat.h"
+
+SpoolReplayer::SpoolReplayer(const std::string& dir, const MySqlEndpoint& endpoint)
+    : m_spool(dir)
+    , m_dao(new MySQLDAO(endpoint.url, endpoint.user, endpoint.pass, endpoint.schema, 10))
+    , m_id_prefix(std::to_string(now_us()) + "-" + std::to_string(::getpid()) + "-")
+{
+    std::string error;
+    m_open = m_spool.open(error);
+    if (!m_open)
+    {
+        spdlog::error("Write spool unavailable, failed writes will be dropped: {}", error);
+        return;
+    }
+    m_thread = std::thread(&SpoolReplayer::run, this);
+}
+
+SpoolReplayer::~SpoolReplayer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::string SpoolReplayer::default_dir()
+{
+    const char* dir = std::getenv("NETWORK_ANALYSE_SPOOL_DIR");
+    return dir && *dir ? dir : "spool";
+}
+
+std::shared_ptr<SpoolReplayer> SpoolReplayer::shared(const std::string& dir, const MySqlEndpoint& endpoint)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<SpoolReplayer>> replayers;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<SpoolReplayer>& slot = replayers[dir];
+    std::shared_ptr<SpoolReplayer> replayer = slot.lock();
+    if (!replayer)
+    {
+        replayer = std::make_shared<SpoolReplayer>(dir, endpoint);
+        slot = replayer;
+    }
+    return replayer;
+}
+
+bool SpoolReplayer::append(nlohmann::json batch)
+{
+    if (!m_open) return false;
+    if (!batch.contains("id")) batch["id"] = next_id();
+    // 原始字节（报文体、首部）已由调用方 base64；其余文本字段仍可能有非 UTF-8 字节，替换而不是抛异常
+    if (!m_spool.append(batch.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace)))
+        return false;
+    ++m_spooled;
+    m_cv.notify_one();
+    return true;
+}
+
+std::string SpoolReplayer::next_id()
+{
+    return m_id_prefix + std::to_string(++m_next_id);
+}
+
+bool SpoolReplayer::backlogged() const
+{
+    return m_open && !m_spool.empty();
+}
+
+nlohmann::json SpoolReplayer::status() const
+{
+    nlohmann::json j;
+    j["dir"] = m_spool.dir();
+    j["open"] = m_open;
+    j["pending_bytes"] = m_spool.pending_bytes();
+    j["spooled"] = m_spooled.load();
+    j["replayed"] = m_replayed.load();
+    j["duplicates"] = m_duplicates.load();
+    j["rejected"] = m_rejected.load();
+    j["corrupt_skipped"] = m_spool.skipped_records();
+    return j;
+}
+
+void SpoolReplayer::reject(const std::string& payload)
+{
+    std::ofstream out(m_spool.dir() + "/rejected.jsonl", std::ios::app);
+    out << payload << '\n';
+    ++m_rejected;
+}
+
+void SpoolReplayer::run()
+{
+    int64_t backoff_ms = 0;
+    bool draining = false;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stop) break;
+            if (backoff_ms > 0)
+            {
+                m_cv.wait_for(lock, std::chrono::milliseconds(backoff_ms), [this] { return m_stop; });
+                if (m_stop) break;
+            }
+        }
+
+        std::string payload;
+        if (!m_spool.peek(payload))
+        {
+            if (draining)
+            {
+                spdlog::info("Write spool drained: {} batches replayed", m_replayed.load());
+                draining = false;
+                m_dao->purge_spool_markers(MARKER_RETENTION_SEC);
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait_for(lock, std::chrono::seconds(1), [this] { return m_stop; });
+            continue;
+        }
+        draining = true;
+
+        nlohmann::json batch = nlohmann::json::parse(payload, nullptr, false);
+        nlohmann::json requeue;
+        int result = batch.is_discarded() ? -2 : m_dao->apply_spooled(batch, requeue);
+        if (result == -1)
+        {
+            // 数据库仍不可用：不前进，退避后重试同一批次
+            backoff_ms = std::min(MAX_BACKOFF_MS, std::max<int64_t>(500, backoff_ms * 2));
+            spdlog::warn("Spool replay failed, retrying in {}ms ({} bytes pending)",
+                         backoff_ms, m_spool.pending_bytes());
+            continue;
+        }
+        backoff_ms = 0;
+        if (result == -2)
+        {
+            spdlog::error("Spooled batch cannot be written, moved to rejected.jsonl");
+            reject(payload);
+        }
+        else if (result == 0)
+        {
+            ++m_duplicates;
+        }
+        else
+        {
+            ++m_replayed;
+        }
+        // 部分写入的批次：未写入的记录排到队尾，本批次照常提交
+        if (!requeue.is_null() && !append(std::move(requeue)))
+            spdlog::error("Cannot requeue unwritten records of a spooled batch, dropped");
+        m_spool.commit();
+    }
+}
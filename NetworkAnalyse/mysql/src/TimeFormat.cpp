@@ -0,0 +1,138 @@
+#include "TimeFormat.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+int64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+bool read_digits(const char*& p, const char* end, int count, int& value)
+{
+    if (end - p < count) return false;
+    value = 0;
+    for (int i = 0; i < count; ++i, ++p)
+    {
+        if (*p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+bool expect(const char*& p, const char* end, char c)
+{
+    if (p == end || *p != c) return false;
+    ++p;
+    return true;
+}
+}
+
+bool parse_datetime_us(const std::string& text, int64_t& epoch_us)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    std::tm tm{};
+    int year, month, day, hour, minute, second;
+    if (!read_digits(p, end, 4, year) || !expect(p, end, '-') ||
+        !read_digits(p, end, 2, month) || !expect(p, end, '-') ||
+        !read_digits(p, end, 2, day)) return false;
+    if (p == end || (*p != 'T' && *p != ' ')) return false;
+    ++p;
+    if (!read_digits(p, end, 2, hour) || !expect(p, end, ':') ||
+        !read_digits(p, end, 2, minute) || !expect(p, end, ':') ||
+        !read_digits(p, end, 2, second)) return false;
+
+    // 小数秒：超过 6 位截断，不足补零
+    int64_t micros = 0;
+    if (p != end && *p == '.')
+    {
+        ++p;
+        int digits = 0;
+        while (p != end && *p >= '0' && *p <= '9')
+        {
+            if (digits < 6) micros = micros * 10 + (*p - '0');
+            ++digits;
+            ++p;
+        }
+        if (digits == 0) return false;
+        for (; digits < 6; ++digits) micros *= 10;
+    }
+
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+
+    std::time_t seconds;
+    if (p == end)
+    {
+        tm.tm_isdst = -1;
+        seconds = std::mktime(&tm);
+    }
+    else if (*p == 'Z' && p + 1 == end)
+    {
+        seconds = timegm(&tm);
+    }
+    else if (*p == '+' || *p == '-')
+    {
+        int sign = *p++ == '-' ? -1 : 1;
+        int off_hour, off_minute = 0;
+        if (!read_digits(p, end, 2, off_hour)) return false;
+        if (p != end && *p == ':') ++p;
+        if (p != end && !read_digits(p, end, 2, off_minute)) return false;
+        if (p != end) return false;
+        seconds = timegm(&tm) - sign * (off_hour * 3600 + off_minute * 60);
+    }
+    else
+    {
+        return false;
+    }
+    if (seconds == static_cast<std::time_t>(-1)) return false;
+    epoch_us = static_cast<int64_t>(seconds) * 1000000 + micros;
+    return true;
+}
+
+const std::string& DateTimeFormatter::format(int64_t epoch_us)
+{
+    int64_t second = epoch_us / 1000000;
+    int64_t micros = epoch_us % 1000000;
+    if (micros < 0)
+    {
+        micros += 1000000;
+        --second;
+    }
+
+    if (second != m_second)
+    {
+        // 换秒时才做一次时区换算
+        std::time_t t = static_cast<std::time_t>(second);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        char buffer[32];
+        int n = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.000000",
+                              tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+        m_text.assign(buffer, n);
+        m_second = second;
+    }
+
+    // 改写末尾 6 位微秒
+    char* digits = &m_text[m_text.size() - 1];
+    for (int i = 0; i < 6; ++i, --digits)
+    {
+        *digits = static_cast<char>('0' + micros % 10);
+        micros /= 10;
+    }
+    return m_text;
+}
+
+std::string format_datetime_us(int64_t epoch_us)
+{
+    if (epoch_us == 0) return std::string();
+    thread_local DateTimeFormatter formatter;
+    return formatter.format(epoch_us);
+}
@@ -0,0 +1,354 @@
+#include "WriteSpool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+namespace {
+const uint32_t SPOOL_MAGIC = 0x314C5053;        // "SPL1"
+const size_t HEADER_BYTES = 12;
+const uint32_t MAX_RECORD_BYTES = 256u * 1024 * 1024;
+
+uint32_t crc32(const void* data, size_t len)
+{
+    static uint32_t table[256];
+    static bool init = [] {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)init;
+
+    uint32_t crc = 0xFFFFFFFFu;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool write_all(int fd, const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 读满 len 字节，返回实际读到的字节数（文件末尾时不足）
+size_t pread_all(int fd, char* data, size_t len, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t n = ::pread(fd, data + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    return done;
+}
+
+uint64_t file_size(const std::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+}
+
+WriteSpool::WriteSpool(const std::string& dir, size_t segment_bytes)
+    : m_dir(dir)
+    , m_segment_bytes(segment_bytes)
+{
+}
+
+WriteSpool::~WriteSpool()
+{
+    close();
+}
+
+std::string WriteSpool::segment_path(uint64_t segment) const
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "/segment-%016" PRIu64 ".spool", segment);
+    return m_dir + name;
+}
+
+bool WriteSpool::open(std::string& error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_open) return true;
+
+    if (::mkdir(m_dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        error = "mkdir " + m_dir + ": " + std::strerror(errno);
+        return false;
+    }
+    DIR* d = ::opendir(m_dir.c_str());
+    if (!d)
+    {
+        error = "opendir " + m_dir + ": " + std::strerror(errno);
+        return false;
+    }
+    m_segments.clear();
+    while (dirent* entry = ::readdir(d))
+    {
+        uint64_t segment = 0;
+        char tail[8] = {0};
+        if (std::sscanf(entry->d_name, "segment-%" SCNu64 ".%6s", &segment, tail) == 2 &&
+            std::strcmp(tail, "spool") == 0)
+            m_segments.push_back(segment);
+    }
+    ::closedir(d);
+    std::sort(m_segments.begin(), m_segments.end());
+
+    // 读取进度：缺失时从最早的分段开始
+    m_read_segment = m_segments.empty() ? 1 : m_segments.front();
+    m_read_offset = 0;
+    if (FILE* f = std::fopen((m_dir + "/checkpoint").c_str(), "r"))
+    {
+        uint64_t segment = 0, offset = 0;
+        if (std::fscanf(f, "%" SCNu64 " %" SCNu64, &segment, &offset) == 2)
+        {
+            m_read_segment = segment;
+            m_read_offset = offset;
+        }
+        std::fclose(f);
+    }
+
+    // 进度之前的分段已消费完（删除前崩溃时残留）
+    while (!m_segments.empty() && m_segments.front() < m_read_segment)
+    {
+        ::unlink(segment_path(m_segments.front()).c_str());
+        m_segments.erase(m_segments.begin());
+    }
+    if (m_segments.empty() || m_segments.front() != m_read_segment)
+    {
+        if (!m_segments.empty()) m_read_segment = m_segments.front();
+        m_read_offset = 0;
+    }
+
+    m_pending = 0;
+    for (uint64_t segment : m_segments)
+    {
+        uint64_t size = file_size(segment_path(segment));
+        m_pending += segment == m_read_segment ? size - std::min(size, m_read_offset) : size;
+    }
+
+    uint64_t next = m_segments.empty() ? m_read_segment : m_segments.back() + 1;
+    if (!open_write_segment(next))
+    {
+        error = "open " + segment_path(next) + ": " + std::strerror(errno);
+        return false;
+    }
+    m_open = true;
+    if (m_pending > 0)
+        spdlog::info("Spool {}: {} bytes pending in {} segments", m_dir, m_pending, m_segments.size() - 1);
+    return true;
+}
+
+void WriteSpool::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_write_fd >= 0) ::close(m_write_fd);
+    if (m_read_fd >= 0) ::close(m_read_fd);
+    m_write_fd = -1;
+    m_read_fd = -1;
+    m_peek_end = 0;
+    m_open = false;
+}
+
+bool WriteSpool::open_write_segment(uint64_t segment)
+{
+    int fd = ::open(segment_path(segment).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    if (m_write_fd >= 0) ::close(m_write_fd);
+    m_write_fd = fd;
+    m_write_segment = segment;
+    m_write_offset = file_size(segment_path(segment));
+    if (m_segments.empty() || m_segments.back() != segment) m_segments.push_back(segment);
+    return true;
+}
+
+bool WriteSpool::append(const std::string& payload)
+{
+    if (payload.size() > MAX_RECORD_BYTES)
+    {
+        spdlog::error("Spool record of {} bytes exceeds limit", payload.size());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open) return false;
+
+    if (m_write_offset >= m_segment_bytes && !open_write_segment(m_write_segment + 1))
+    {
+        spdlog::error("Spool {}: cannot open new segment: {}", m_dir, std::strerror(errno));
+        return false;
+    }
+
+    uint32_t header[3] = {SPOOL_MAGIC, static_cast<uint32_t>(payload.size()), crc32(payload.data(), payload.size())};
+    std::string frame(reinterpret_cast<const char*>(header), HEADER_BYTES);
+    frame += payload;
+    if (!write_all(m_write_fd, frame.data(), frame.size()) || ::fdatasync(m_write_fd) != 0)
+    {
+        spdlog::error("Spool {}: write failed: {}", m_dir, std::strerror(errno));
+        // 写了一半的记录由读端按校验失败跳过，新记录写到新分段
+        open_write_segment(m_write_segment + 1);
+        return false;
+    }
+    m_write_offset += frame.size();
+    m_pending += frame.size();
+    return true;
+}
+
+void WriteSpool::finish_read_segment()
+{
+    // 未读的剩余部分（残缺或损坏）不再计入待处理
+    uint64_t size = file_size(segment_path(m_read_segment));
+    m_pending -= std::min<uint64_t>(m_pending, size - std::min(size, m_read_offset));
+    if (m_read_fd >= 0) ::close(m_read_fd);
+    m_read_fd = -1;
+    ::unlink(segment_path(m_read_segment).c_str());
+    m_segments.erase(std::remove(m_segments.begin(), m_segments.end(), m_read_segment), m_segments.end());
+    m_read_segment = m_segments.empty() ? m_write_segment : m_segments.front();
+    m_read_offset = 0;
+    save_checkpoint();
+}
+
+bool WriteSpool::peek(std::string& payload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open) return false;
+
+    while (true)
+    {
+        if (m_read_fd < 0)
+        {
+            m_read_fd = ::open(segment_path(m_read_segment).c_str(), O_RDONLY | O_CLOEXEC);
+            if (m_read_fd < 0)
+            {
+                if (m_read_segment == m_write_segment) return false;
+                finish_read_segment();      // 分段丢失
+                continue;
+            }
+        }
+
+        uint32_t header[3];
+        size_t got = pread_all(m_read_fd, reinterpret_cast<char*>(header), HEADER_BYTES, m_read_offset);
+        bool active = m_read_segment == m_write_segment;
+        if (got == 0 || (got < HEADER_BYTES && !active))
+        {
+            // 分段读完（或末尾是崩溃时写了一半的帧头）
+            if (active) return false;
+            if (got) ++m_skipped;
+            finish_read_segment();
+            continue;
+        }
+        if (got < HEADER_BYTES) return false;
+
+        uint64_t end = m_read_offset + HEADER_BYTES + header[1];
+        if (header[0] != SPOOL_MAGIC || header[1] > MAX_RECORD_BYTES)
+        {
+            // 帧头损坏，无法定位下一条：放弃本分段剩余部分
+            spdlog::error("Spool {}: corrupt record header in segment {} at {}, skipping rest of segment",
+                          m_dir, m_read_segment, m_read_offset);
+            ++m_skipped;
+            if (active)
+            {
+                // 活动分段：后续追加写到新分段，当前分段就此封存
+                open_write_segment(m_write_segment + 1);
+            }
+            finish_read_segment();
+            continue;
+        }
+
+        payload.resize(header[1]);
+        got = pread_all(m_read_fd, &payload[0], header[1], m_read_offset + HEADER_BYTES);
+        if (got < header[1])
+        {
+            if (active) return false;
+            ++m_skipped;
+            finish_read_segment();
+            continue;
+        }
+        if (crc32(payload.data(), payload.size()) != header[2])
+        {
+            spdlog::error("Spool {}: checksum mismatch in segment {} at {}, skipping record",
+                          m_dir, m_read_segment, m_read_offset);
+            ++m_skipped;
+            m_pending -= std::min<uint64_t>(m_pending, end - m_read_offset);
+            m_read_offset = end;
+            save_checkpoint();
+            continue;
+        }
+        m_peek_end = end;
+        return true;
+    }
+}
+
+bool WriteSpool::commit()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open || m_peek_end == 0) return false;
+    m_pending -= std::min<uint64_t>(m_pending, m_peek_end - m_read_offset);
+    m_read_offset = m_peek_end;
+    m_peek_end = 0;
+    if (m_read_segment != m_write_segment && m_read_offset >= file_size(segment_path(m_read_segment)))
+    {
+        finish_read_segment();
+        return true;
+    }
+    return save_checkpoint();
+}
+
+bool WriteSpool::save_checkpoint()
+{
+    std::string path = m_dir + "/checkpoint";
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    char text[64];
+    int len = std::snprintf(text, sizeof(text), "%" PRIu64 " %" PRIu64 "\n", m_read_segment, m_read_offset);
+    bool ok = write_all(fd, text, static_cast<size_t>(len)) && ::fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        spdlog::error("Spool {}: cannot save checkpoint: {}", m_dir, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool WriteSpool::empty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending == 0;
+}
+
+uint64_t WriteSpool::pending_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+uint64_t WriteSpool::skipped_records() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_skipped;
+}
@@ -0,0 +1,318 @@
+// adb 抓包与 pcap 流解析的检查：PcapStreamReader 按任意分块、两种字节序与时间精度解析，
+// AdbCapture 经环境变量 ADB 指向的替身脚本（参数写入文件、向标准输出写 pcap）启动、读取与停止。
+// 不依赖测试框架，全部通过返回 0。
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AdbCapture.h"
+#include "PcapStreamReader.h"
+
+namespace {
+
+const uint32_t MAGIC_MICRO = 0xA1B2C3D4;
+const uint32_t MAGIC_NANO = 0xA1B23C4D;
+const int LINKTYPE_ETHERNET = 1;
+const int LINKTYPE_LINUX_SLL = 113;
+
+struct Record
+{
+    uint32_t                sec;
+    uint32_t                frac;       // 微秒或纳秒，取决于魔数
+    std::vector<uint8_t>    data;
+};
+
+struct Received
+{
+    timeval                 ts;
+    std::vector<uint8_t>    data;
+};
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+void put_u16(std::string& out, uint16_t v, bool big_endian)
+{
+    for (int i = 0; i < 2; ++i) out += static_cast<char>(v >> (big_endian ? 8 * (1 - i) : 8 * i));
+}
+
+void put_u32(std::string& out, uint32_t v, bool big_endian)
+{
+    for (int i = 0; i < 4; ++i) out += static_cast<char>(v >> (big_endian ? 8 * (3 - i) : 8 * i));
+}
+
+std::string build_pcap(uint32_t magic, bool big_endian, int link_type, const std::vector<Record>& records)
+{
+    std::string out;
+    put_u32(out, magic, big_endian);
+    put_u16(out, 2, big_endian);
+    put_u16(out, 4, big_endian);
+    put_u32(out, 0, big_endian);
+    put_u32(out, 0, big_endian);
+    put_u32(out, 262144, big_endian);
+    put_u32(out, static_cast<uint32_t>(link_type), big_endian);
+    for (const auto& record : records)
+    {
+        put_u32(out, record.sec, big_endian);
+        put_u32(out, record.frac, big_endian);
+        put_u32(out, static_cast<uint32_t>(record.data.size()), big_endian);
+        put_u32(out, static_cast<uint32_t>(record.data.size()), big_endian);
+        out.append(record.data.begin(), record.data.end());
+    }
+    return out;
+}
+
+std::vector<Record> sample_records()
+{
+    std::vector<Record> records;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        Record record;
+        record.sec = 1700000000 + i;
+        record.frac = 123456 + i;
+        // 长度不同（含超过一个读缓冲区分块的记录），内容可区分
+        record.data.resize(i == 3 ? 70000 : 20 + 37 * i);
+        for (size_t b = 0; b < record.data.size(); ++b) record.data[b] = static_cast<uint8_t>(b * 7 + i);
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+void expect_records(const std::vector<Received>& got, const std::vector<Record>& want, bool nanosecond,
+                    const std::string& name)
+{
+    expect(got.size() == want.size(), name, "got " + std::to_string(got.size()) + " packets, want " +
+                                            std::to_string(want.size()));
+    for (size_t i = 0; i < got.size() && i < want.size(); ++i)
+    {
+        long usec = static_cast<long>(nanosecond ? want[i].frac / 1000 : want[i].frac);
+        expect(got[i].ts.tv_sec == static_cast<time_t>(want[i].sec) && got[i].ts.tv_usec == usec, name,
+               "timestamp of packet " + std::to_string(i));
+        expect(got[i].data == want[i].data, name, "payload of packet " + std::to_string(i));
+    }
+}
+
+// 整个流按固定块大小投递
+std::vector<Received> feed_chunked(PcapStreamReader& reader, const std::string& stream, size_t chunk, bool& ok)
+{
+    std::vector<Received> got;
+    auto on_packet = [&](const timeval& ts, const uint8_t* data, size_t len) {
+        got.push_back(Received{ts, std::vector<uint8_t>(data, data + len)});
+    };
+    ok = true;
+    for (size_t offset = 0; offset < stream.size() && ok; offset += chunk)
+    {
+        size_t n = std::min(chunk, stream.size() - offset);
+        ok = reader.feed(reinterpret_cast<const uint8_t*>(stream.data()) + offset, n, on_packet);
+    }
+    return got;
+}
+
+void check_stream_reader()
+{
+    std::vector<Record> records = sample_records();
+
+    // 微秒、本机字节序（小端）：文件头与记录在任意位置被切开
+    std::string micro = build_pcap(MAGIC_MICRO, false, LINKTYPE_LINUX_SLL, records);
+    for (size_t chunk : {size_t(1), size_t(3), size_t(16), size_t(23), size_t(24), size_t(25), size_t(4096), micro.size()})
+    {
+        std::string name = "pcap microsecond, chunk " + std::to_string(chunk);
+        PcapStreamReader reader;
+        bool ok = false;
+        std::vector<Received> got = feed_chunked(reader, micro, chunk, ok);
+        expect(ok, name, "feed failed: " + reader.error());
+        expect(reader.has_header() && reader.link_type() == LINKTYPE_LINUX_SLL, name, "link type");
+        expect_records(got, records, false, name);
+    }
+
+    // 纳秒、大端写入
+    std::vector<Record> nano_records = records;
+    for (auto& record : nano_records) record.frac = record.frac * 1000 + 999;
+    std::string nano = build_pcap(MAGIC_NANO, true, LINKTYPE_ETHERNET, nano_records);
+    {
+        PcapStreamReader reader;
+        bool ok = false;
+        std::vector<Received> got = feed_chunked(reader, nano, 7, ok);
+        expect(ok, "pcap nanosecond big-endian", "feed failed: " + reader.error());
+        expect(reader.link_type() == LINKTYPE_ETHERNET, "pcap nanosecond big-endian", "link type");
+        expect_records(got, nano_records, true, "pcap nanosecond big-endian");
+    }
+
+    // 文件头不足 24 字节时只缓存
+    {
+        PcapStreamReader reader;
+        bool ok = false;
+        feed_chunked(reader, micro.substr(0, 20), 20, ok);
+        expect(ok && !reader.has_header() && reader.link_type() == -1, "pcap partial header", "header parsed early");
+    }
+
+    // pcapng 的区块类型不是 pcap 魔数，之后的投递也失败
+    {
+        std::string pcapng = micro;
+        const uint8_t block_type[] = {0x0A, 0x0D, 0x0D, 0x0A};
+        pcapng.replace(0, 4, reinterpret_cast<const char*>(block_type), 4);
+        PcapStreamReader reader;
+        bool ok = true;
+        feed_chunked(reader, pcapng, pcapng.size(), ok);
+        expect(!ok && !reader.error().empty(), "pcapng rejected", "accepted");
+        const uint8_t more = 0;
+        expect(!reader.feed(&more, 1, [](const timeval&, const uint8_t*, size_t) {}), "pcapng rejected",
+               "feed after error succeeded");
+    }
+
+    // 记录长度超过上限视为流损坏
+    {
+        std::string corrupt = micro;
+        std::string caplen;
+        put_u32(caplen, PcapStreamReader::MAX_SNAPLEN + 1, false);
+        corrupt.replace(24 + 8, 4, caplen);
+        PcapStreamReader reader;
+        bool ok = true;
+        std::vector<Received> got = feed_chunked(reader, corrupt, corrupt.size(), ok);
+        expect(!ok && got.empty(), "pcap oversized record", "accepted");
+    }
+}
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+bool write_file(const std::string& path, const std::string& data, mode_t mode = 0644)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+    out.close();
+    return out && chmod(path.c_str(), mode) == 0;
+}
+
+// 替身 adb：参数逐行写入 args，随后执行 body
+bool write_fake_adb(const std::string& dir, const std::string& body)
+{
+    return write_file(dir + "/adb", "#!/bin/sh\nprintf '%s\\n' \"$@\" > '" + dir + "/args'\n" + body + "\n", 0755);
+}
+
+struct CaptureResult
+{
+    bool                    ok = false;
+    std::string             error;
+    std::vector<Received>   packets;
+    std::vector<int>        link_types;
+};
+
+CaptureResult capture(AdbCapture& adb)
+{
+    CaptureResult result;
+    result.ok = adb.run([&](const timeval& ts, const uint8_t* data, size_t len, int link_type) {
+        result.packets.push_back(Received{ts, std::vector<uint8_t>(data, data + len)});
+        result.link_types.push_back(link_type);
+    }, result.error);
+    return result;
+}
+
+void check_adb_capture()
+{
+    char dir_template[] = "/tmp/adb_capture.XXXXXX";
+    if (!mkdtemp(dir_template))
+    {
+        expect(false, "adb capture", "cannot create temp dir");
+        return;
+    }
+    const std::string dir = dir_template;
+    setenv("ADB", (dir + "/adb").c_str(), 1);
+
+    std::vector<Record> records = sample_records();
+    std::string pcap = build_pcap(MAGIC_MICRO, false, LINKTYPE_LINUX_SLL, records);
+    expect(write_file(dir + "/capture.pcap", pcap), "adb capture", "cannot write pcap");
+
+    // 正常结束：报文全部交出，命令行为 -s <serial> exec-out tcpdump ... <filter>
+    {
+        expect(write_fake_adb(dir, "exec cat '" + dir + "/capture.pcap'"), "adb capture", "cannot write fake adb");
+        AdbCapture adb("emulator-5554", "udp port 53");
+        CaptureResult result = capture(adb);
+        expect(result.ok, "adb capture", "run failed: " + result.error);
+        expect_records(result.packets, records, false, "adb capture");
+        bool sll = !result.link_types.empty();
+        for (int link_type : result.link_types) sll = sll && link_type == LINKTYPE_LINUX_SLL;
+        expect(sll, "adb capture", "link type");
+        expect(read_file(dir + "/args") ==
+                   "-s\nemulator-5554\nexec-out\ntcpdump\n-i\nany\n-U\n-s\n0\n-w\n-\nudp port 53\n",
+               "adb capture", "arguments '" + read_file(dir + "/args") + "'");
+    }
+
+    // 未指定设备与过滤表达式
+    {
+        AdbCapture adb("", "");
+        CaptureResult result = capture(adb);
+        expect(result.ok && result.packets.size() == records.size(), "adb capture default device", result.error);
+        expect(read_file(dir + "/args") == "exec-out\ntcpdump\n-i\nany\n-U\n-s\n0\n-w\n-\n",
+               "adb capture default device", "arguments '" + read_file(dir + "/args") + "'");
+    }
+
+    // 设备离线：adb 没写出 pcap 文件头就退出
+    {
+        expect(write_fake_adb(dir, "echo 'error: device offline' >&2\nexit 1"), "adb offline", "cannot write fake adb");
+        AdbCapture adb("emulator-5554", "");
+        CaptureResult result = capture(adb);
+        expect(!result.ok && result.packets.empty(), "adb offline", "run succeeded");
+        expect(result.error.find("pcap header") != std::string::npos, "adb offline", "error '" + result.error + "'");
+    }
+
+    // 输出不是 pcap（设备端 tcpdump 写出 pcapng）
+    {
+        std::string pcapng = pcap;
+        pcapng[0] = 0x0A; pcapng[1] = 0x0D; pcapng[2] = 0x0D; pcapng[3] = 0x0A;
+        expect(write_file(dir + "/capture.pcapng", pcapng), "adb pcapng", "cannot write pcapng");
+        expect(write_fake_adb(dir, "exec cat '" + dir + "/capture.pcapng'"), "adb pcapng", "cannot write fake adb");
+        AdbCapture adb("emulator-5554", "");
+        CaptureResult result = capture(adb);
+        expect(!result.ok && result.packets.empty(), "adb pcapng", "run succeeded");
+    }
+
+    // 持续抓包：写完已有报文后不退出，stop() 结束子进程，run 正常返回
+    {
+        expect(write_fake_adb(dir, "cat '" + dir + "/capture.pcap'\nexec sleep 30"), "adb stop", "cannot write fake adb");
+        AdbCapture adb("emulator-5554", "");
+        CaptureResult result;
+        auto begin = std::chrono::steady_clock::now();
+        std::thread runner([&] { result = capture(adb); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        adb.stop();
+        runner.join();
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        expect(result.ok, "adb stop", "run failed: " + result.error);
+        expect(result.packets.size() == records.size(), "adb stop", "packets before stop");
+        expect(elapsed < std::chrono::seconds(10), "adb stop", "stop did not end the capture");
+    }
+
+    for (const char* name : {"adb", "args", "capture.pcap", "capture.pcapng"})
+        unlink((dir + "/" + name).c_str());
+    rmdir(dir.c_str());
+}
+
+} // namespace
+
+int main()
+{
+    check_stream_reader();
+    check_adb_capture();
+    if (g_failures == 0) std::printf("adb_capture: all checks passed\n");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,394 @@
+// 列式段与列式存储的检查：ColumnSegment 编码/SegmentView 解码往返（含 NULL 的 DELTA 列、行数一半处的
+// DICT/PLAIN 切换、全 NULL 列、混合类型、截断与损坏的段），ColumnStore 的过滤、时间范围、投影、分组聚合，
+// 以及缓冲行、已写出的段和重新打开后的结果一致。不依赖测试框架，全部通过返回 0。
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ColumnSegment.h"
+#include "ColumnStore.h"
+
+using namespace column_segment;
+using nlohmann::json;
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+// 编码后立即解析，segment 须在 view 使用期间存活
+bool round_trip(const std::vector<std::string>& columns, const std::vector<SqlRow>& rows,
+                std::string& segment, SegmentView& view, const std::string& name)
+{
+    segment = encode(columns, rows);
+    std::string error;
+    bool ok = view.parse(segment.data(), segment.size(), error);
+    expect(ok, name, "parse: " + error);
+    expect(!ok || view.rows() == rows.size(), name, "rows " + std::to_string(view.rows()));
+    return ok && view.rows() == rows.size();
+}
+
+bool decode_column(const SegmentView& view, const std::string& column, ColumnVector& out, const std::string& name)
+{
+    std::string error;
+    int index = view.find(column);
+    bool ok = index >= 0 && view.decode(index, out, error);
+    expect(ok, name, "decode " + column + ": " + error);
+    return ok;
+}
+
+void check_delta_with_nulls()
+{
+    const std::string name = "segment delta with nulls";
+    const int64_t lo = std::numeric_limits<int64_t>::min();
+    const int64_t hi = std::numeric_limits<int64_t>::max();
+    std::vector<SqlRow> rows = {
+        {SqlValue::datetime_us(1704067200000000), SqlValue::integer(100)},
+        {SqlValue::datetime_us(1704067200500000), SqlValue::null()},
+        {SqlValue::datetime_us(1704067201000000), SqlValue::integer(105)},
+        {SqlValue::datetime_us(1704067199000000), SqlValue::integer(-3)},
+        {SqlValue::datetime_us(1704067202000000), SqlValue::integer(lo)},
+        {SqlValue::datetime_us(1704067203000000), SqlValue::uinteger(static_cast<uint64_t>(hi))},
+        {SqlValue::datetime_us(1704067204000000)},          // 行比列短，缺的列为 NULL
+    };
+    std::string segment;
+    SegmentView view;
+    if (!round_trip({"timestamp", "bytes"}, rows, segment, view, name)) return;
+
+    const ColumnMeta& time = view.columns()[0];
+    expect(time.type == ColumnType::DATETIME && time.encoding == Encoding::DELTA && !time.has_nulls, name,
+           "timestamp meta");
+    expect(time.has_minmax && time.min_int == 1704067199000000 && time.max_int == 1704067204000000, name,
+           "timestamp min/max");
+
+    const ColumnMeta& bytes = view.columns()[1];
+    expect(bytes.type == ColumnType::INT && bytes.encoding == Encoding::DELTA && bytes.has_nulls, name, "bytes meta");
+    expect(bytes.has_minmax && bytes.min_int == lo && bytes.max_int == hi, name, "bytes min/max");
+
+    ColumnVector column;
+    if (!decode_column(view, "timestamp", column, name)) return;
+    for (size_t r = 0; r < rows.size(); ++r)
+        expect(!column.is_null(r) && column.ints[r] == rows[r][0].i, name, "timestamp row " + std::to_string(r));
+
+    if (!decode_column(view, "bytes", column, name)) return;
+    const std::vector<bool> nulls = {false, true, false, false, false, false, true};
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+        expect(column.is_null(r) == nulls[r], name, "null flag row " + std::to_string(r));
+        if (nulls[r]) continue;
+        int64_t want = rows[r][1].type == SqlValue::Type::UINT ? static_cast<int64_t>(rows[r][1].u) : rows[r][1].i;
+        expect(column.ints[r] == want, name, "bytes row " + std::to_string(r));
+    }
+}
+
+// rows 行中取 distinct 个不同值（可带 NULL 行），检查编码方式与解码结果
+void check_string_encoding(size_t rows_count, size_t distinct, size_t null_rows, Encoding want)
+{
+    const std::string name = "segment strings " + std::to_string(distinct) + "/" + std::to_string(rows_count) +
+                             " nulls " + std::to_string(null_rows);
+    std::vector<SqlRow> rows;
+    for (size_t r = 0; r < rows_count; ++r)
+    {
+        if (r < null_rows) rows.push_back({SqlValue::null()});
+        else rows.push_back({SqlValue::text("app-" + std::to_string((r - null_rows) % distinct))});
+    }
+    std::string segment;
+    SegmentView view;
+    if (!round_trip({"app"}, rows, segment, view, name)) return;
+
+    const ColumnMeta& meta = view.columns()[0];
+    expect(meta.type == ColumnType::STRING && meta.encoding == want, name,
+           "encoding " + std::to_string(static_cast<int>(meta.encoding)));
+    expect(meta.has_nulls == (null_rows > 0) && meta.has_minmax && meta.min_text == "app-0" &&
+           meta.max_text == "app-" + std::to_string(distinct - 1), name, "meta");
+
+    ColumnVector column;
+    if (!decode_column(view, "app", column, name)) return;
+    expect(column.is_dict() == (want == Encoding::DICT), name, "decoded representation");
+    for (size_t r = 0; r < rows_count; ++r)
+    {
+        bool null = r < null_rows;
+        expect(column.is_null(r) == null, name, "null flag row " + std::to_string(r));
+        if (!null) expect(column.text(r) == rows[r][0].s, name, "row " + std::to_string(r));
+    }
+}
+
+void check_all_null_and_mixed()
+{
+    const std::string name = "segment all-null and mixed";
+    std::vector<SqlRow> rows = {
+        {SqlValue::null(), SqlValue::integer(7)},
+        {SqlValue::null(), SqlValue::text("x")},
+        {SqlValue::null(), SqlValue::uinteger(18446744073709551615ull)},
+        {SqlValue::null(), SqlValue::null()},
+    };
+    std::string segment;
+    SegmentView view;
+    if (!round_trip({"empty", "mixed"}, rows, segment, view, name)) return;
+
+    // 全 NULL 的列没有可推断的类型与 min/max，解码后每行都是 NULL
+    const ColumnMeta& empty = view.columns()[0];
+    expect(empty.type == ColumnType::INT && empty.has_nulls && !empty.has_minmax, name, "all-null meta");
+    ColumnVector column;
+    if (decode_column(view, "empty", column, name))
+    {
+        for (size_t r = 0; r < rows.size(); ++r) expect(column.is_null(r), name, "all-null row " + std::to_string(r));
+    }
+
+    // 有字符串即为 STRING，数值转为文本
+    const ColumnMeta& mixed = view.columns()[1];
+    expect(mixed.type == ColumnType::STRING && mixed.has_nulls, name, "mixed meta");
+    if (decode_column(view, "mixed", column, name))
+    {
+        expect(column.text(0) == "7" && column.text(1) == "x" && column.text(2) == "18446744073709551615" &&
+               column.is_null(3), name, "mixed values");
+    }
+
+    // 全 NULL 的字符串列（无字典项）同样可解码
+    std::vector<SqlRow> strings = {{SqlValue::null()}, {SqlValue::null()}};
+    SegmentView strings_view;
+    if (round_trip({"s"}, strings, segment, strings_view, name) && decode_column(strings_view, "s", column, name))
+        expect(column.is_null(0) && column.is_null(1), name, "all-null string rows");
+}
+
+void check_corrupt_segments()
+{
+    const std::string name = "segment truncated";
+    std::vector<SqlRow> rows;
+    for (int r = 0; r < 50; ++r)
+    {
+        rows.push_back({SqlValue::datetime_us(1704067200000000 + r * 1000), SqlValue::integer(r * r),
+                        SqlValue::text(r % 3 ? "chrome" : "wechat"), SqlValue::text("path-" + std::to_string(r))});
+    }
+    std::string segment = encode({"timestamp", "bytes", "app", "path"}, rows);
+
+    // 任何截断都不能通过解析（列数据的长度越界在解析头部时即可发现）
+    std::string error;
+    for (size_t size = 0; size < segment.size(); ++size)
+    {
+        std::string truncated = segment.substr(0, size);
+        SegmentView view;
+        if (view.parse(truncated.data(), truncated.size(), error))
+        {
+            expect(false, name, "parsed at " + std::to_string(size) + " of " + std::to_string(segment.size()) + " bytes");
+            break;
+        }
+    }
+
+    std::string bad = segment;
+    bad[0] ^= 0x01;
+    SegmentView view;
+    expect(!view.parse(bad.data(), bad.size(), error), "segment bad magic", "accepted");
+    bad = segment;
+    bad[4] = 9;
+    expect(!view.parse(bad.data(), bad.size(), error), "segment bad version", "accepted");
+
+    // 列数据中截断的 varint：头部完好，解码失败而不是越界读取
+    bad = segment;
+    SegmentView good;
+    if (!good.parse(bad.data(), bad.size(), error)) return;
+    const ColumnMeta& bytes = good.columns()[1];
+    for (uint64_t i = 0; i < bytes.length; ++i) bad[bytes.offset + i] = static_cast<char>(0xFF);
+    SegmentView corrupt;
+    ColumnVector column;
+    expect(corrupt.parse(bad.data(), bad.size(), error) && !corrupt.decode(1, column, error), "segment bad varint",
+           "decoded");
+}
+
+// ------------------------------------------------------------------ ColumnStore
+
+const int64_t BASE_US = 1704067200000000;   // 各行时间 BASE + i 秒
+
+void remove_tree(const std::string& path)
+{
+    if (DIR* d = ::opendir(path.c_str()))
+    {
+        while (dirent* entry = ::readdir(d))
+        {
+            std::string child = entry->d_name;
+            if (child == "." || child == "..") continue;
+            struct stat st;
+            std::string full = path + "/" + child;
+            if (::lstat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) remove_tree(full);
+            else ::unlink(full.c_str());
+        }
+        ::closedir(d);
+    }
+    ::rmdir(path.c_str());
+}
+
+std::vector<SqlRow> packet_rows()
+{
+    const char* apps[] = {"chrome", "chrome", "wechat", "chrome", "qq", "wechat", "chrome", "qq", "wechat", "chrome"};
+    const int bytes[] = {100, 200, 50, 300, -1, 150, 400, 75, 25, 500};
+    std::vector<SqlRow> rows;
+    for (int i = 0; i < 10; ++i)
+    {
+        rows.push_back({SqlValue::datetime_us(BASE_US + i * 1000000LL), SqlValue::text(apps[i]),
+                        bytes[i] < 0 ? SqlValue::null() : SqlValue::integer(bytes[i])});
+    }
+    return rows;
+}
+
+// 按行输出 bytes 列（NULL 记为 -1）
+std::vector<int64_t> scan_bytes(ColumnStore& store, const ColumnQuery& query, const std::string& name)
+{
+    std::vector<int64_t> out;
+    std::string error;
+    int64_t count = store.scan(query, [&out](const std::vector<std::string>& columns, const SqlRow& row) {
+        for (size_t c = 0; c < columns.size(); ++c)
+            if (columns[c] == "bytes") out.push_back(row[c].type == SqlValue::Type::NUL ? -1 : row[c].i);
+        return true;
+    }, error);
+    expect(count == static_cast<int64_t>(out.size()), name, "scan: " + error);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+ColumnQuery make_query(std::vector<ColumnFilter> filters)
+{
+    ColumnQuery query;
+    query.table = "packets";
+    query.filters = std::move(filters);
+    return query;
+}
+
+void check_store_queries(ColumnStore& store, const std::string& stage)
+{
+    using Op = ColumnFilter::Op;
+    const std::string name = "store " + stage;
+
+    std::vector<int64_t> all = scan_bytes(store, make_query({}), name);
+    expect(all == std::vector<int64_t>({-1, 25, 50, 75, 100, 150, 200, 300, 400, 500}), name, "full scan");
+
+    expect(scan_bytes(store, make_query({{"bytes", Op::GT, SqlValue::integer(100)}}), name) ==
+           std::vector<int64_t>({150, 200, 300, 400, 500}), name, "bytes > 100");
+    expect(scan_bytes(store, make_query({{"app", Op::EQ, SqlValue::text("chrome")},
+                                         {"bytes", Op::GE, SqlValue::integer(300)}}), name) ==
+           std::vector<int64_t>({300, 400, 500}), name, "chrome and bytes >= 300");
+    expect(scan_bytes(store, make_query({{"app", Op::NE, SqlValue::text("chrome")}}), name) ==
+           std::vector<int64_t>({-1, 25, 50, 75, 150}), name, "app != chrome");
+    expect(scan_bytes(store, make_query({{"app", Op::EQ, SqlValue::text("firefox")}}), name).empty(), name,
+           "absent value");
+    // 与 INT 列比较的文本值按整数转换
+    expect(scan_bytes(store, make_query({{"bytes", Op::LT, SqlValue::text("60")}}), name) ==
+           std::vector<int64_t>({25, 50}), name, "bytes < '60'");
+
+    ColumnQuery range = make_query({});
+    range.from_us = BASE_US + 2000000;
+    range.to_us = BASE_US + 5000000;
+    expect(scan_bytes(store, range, name) == std::vector<int64_t>({-1, 50, 300}), name, "time range");
+
+    ColumnQuery limited = make_query({});
+    limited.limit = 2;
+    expect(scan_bytes(store, limited, name).size() == 2, name, "limit");
+
+    // 投影：只输出请求的列，段内不存在的列为 NULL
+    ColumnQuery projected = make_query({{"app", Op::EQ, SqlValue::text("qq")}});
+    projected.columns = {"app", "missing"};
+    std::string error;
+    int64_t count = store.scan(projected, [&](const std::vector<std::string>& columns, const SqlRow& row) {
+        expect(columns == std::vector<std::string>({"app", "missing"}) && row[0].s == "qq" &&
+               row[1].type == SqlValue::Type::NUL, name, "projected row");
+        return true;
+    }, error);
+    expect(count == 2, name, "projected count " + std::to_string(count));
+
+    ColumnQuery bad = make_query({{"bytes", Op::EQ, SqlValue::text("many")}});
+    expect(store.scan(bad, [](const std::vector<std::string>&, const SqlRow&) { return true; }, error) < 0, name,
+           "non-numeric filter on INT column accepted");
+
+    // 分组聚合：COUNT 计行数，其余聚合跳过 NULL
+    ColumnQuery grouped = make_query({});
+    grouped.group_by = {"app"};
+    grouped.aggregates = {{ColumnAggregate::Op::COUNT, ""}, {ColumnAggregate::Op::SUM, "bytes"},
+                          {ColumnAggregate::Op::MIN, "bytes"}, {ColumnAggregate::Op::MAX, "bytes"},
+                          {ColumnAggregate::Op::AVG, "bytes"}};
+    grouped.order_by = "sum(bytes)";
+    json rows = store.aggregate(grouped, error);
+    json want = json::parse(R"json([
+        {"app": "chrome", "count": 5, "sum(bytes)": 1500, "min(bytes)": 100, "max(bytes)": 500, "avg(bytes)": 300.0},
+        {"app": "wechat", "count": 3, "sum(bytes)": 225, "min(bytes)": 25, "max(bytes)": 150, "avg(bytes)": 75.0},
+        {"app": "qq", "count": 2, "sum(bytes)": 75, "min(bytes)": 75, "max(bytes)": 75, "avg(bytes)": 75.0}])json");
+    expect(rows == want, name, "group by app: " + rows.dump());
+
+    // 整体聚合与过滤、时间范围叠加
+    ColumnQuery total = make_query({{"app", Op::NE, SqlValue::text("qq")}});
+    total.from_us = BASE_US + 1000000;
+    total.aggregates = {{ColumnAggregate::Op::COUNT, ""}, {ColumnAggregate::Op::MAX, "timestamp"}};
+    rows = store.aggregate(total, error);
+    expect(rows.size() == 1 && rows[0]["count"] == 7, name, "filtered total: " + rows.dump());
+
+    ColumnQuery strings = make_query({});
+    strings.aggregates = {{ColumnAggregate::Op::SUM, "app"}};
+    expect(store.aggregate(strings, error).is_null(), name, "aggregate over string column accepted");
+
+    // JSON 请求入口
+    json result = store.query(json::parse(R"({"table": "packets", "filters": [{"column": "app", "op": "=",
+        "value": "wechat"}], "aggregates": [{"op": "sum", "column": "bytes"}]})"));
+    expect(result["error"] == 0 && result["rows"].size() == 1 && result["rows"][0]["sum(bytes)"] == 225, name,
+           "json aggregate: " + result.dump());
+    result = store.query(json::parse(R"({"table": "../etc"})"));
+    expect(result["error"] == 1, name, "invalid table name accepted");
+}
+
+void check_store()
+{
+    char tmpl[] = "/tmp/column_store_XXXXXX";
+    if (!::mkdtemp(tmpl))
+    {
+        expect(false, "store", "mkdtemp failed");
+        return;
+    }
+    std::string dir = tmpl;
+
+    ColumnStoreConfig config;
+    config.segment_rows = 4;                // 10 行：两个段写出，2 行留在缓冲
+    config.flush_delay_ms = 3600 * 1000;
+    {
+        ColumnStore store(dir, config);
+        expect(store.append("packets", {"timestamp", "app", "bytes"}, packet_rows()), "store", "append failed");
+        expect(store.status()["segments_written"] == 2 && store.status()["buffered_rows"] == 2, "store",
+               "status " + store.status().dump());
+        check_store_queries(store, "buffered");
+        store.flush();
+        expect(store.status()["segments_written"] == 3 && store.status()["buffered_rows"] == 0, "store",
+               "status after flush " + store.status().dump());
+        check_store_queries(store, "flushed");
+    }
+    {
+        ColumnStore store(dir, config);
+        check_store_queries(store, "reopened");
+    }
+    remove_tree(dir);
+}
+
+} // namespace
+
+int main()
+{
+    check_delta_with_nulls();
+    check_string_encoding(10, 5, 0, Encoding::DICT);    // 不同值恰为行数一半
+    check_string_encoding(10, 6, 0, Encoding::PLAIN);
+    check_string_encoding(11, 5, 0, Encoding::DICT);
+    check_string_encoding(11, 6, 0, Encoding::PLAIN);
+    check_string_encoding(12, 6, 3, Encoding::DICT);    // NULL 行不计入不同值
+    check_string_encoding(1, 1, 0, Encoding::PLAIN);
+    check_all_null_and_mixed();
+    check_corrupt_segments();
+    check_store();
+    if (g_failures == 0) std::printf("column_store: all checks passed\n");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
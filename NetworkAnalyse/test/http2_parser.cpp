@@ -0,0 +1,296 @@
+// HTTP/2 解析的检查：HpackDecoder 对 RFC 7541 附录 C 全部示例（含动态表淘汰与 Huffman）的解码结果与动态表大小，
+// Http2Connection 的帧长度上限（SETTINGS_MAX_FRAME_SIZE）、流数上限与一次完整的请求/响应。
+// 不依赖测试框架，全部通过返回 0。
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "CryptoUtil.h"
+#include "HpackDecoder.h"
+#include "Http2Parser.h"
+
+namespace {
+
+using Headers = std::vector<HpackDecoder::Header>;
+
+// 同一解码器依次解码的一个头部块
+struct HpackStep
+{
+    const char*     hex;
+    Headers         headers;
+    size_t          table_size;     // 解码后的动态表大小
+};
+
+struct HpackExample
+{
+    const char*             name;
+    size_t                  max_table_size;
+    std::vector<HpackStep>  steps;
+};
+
+const char* const DATE_21 = "Mon, 21 Oct 2013 20:13:21 GMT";
+const char* const DATE_22 = "Mon, 21 Oct 2013 20:13:22 GMT";
+const char* const COOKIE = "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1";
+
+// RFC 7541 附录 C
+std::vector<HpackExample> hpack_examples()
+{
+    Headers request1 = {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}};
+    Headers request2 = request1;
+    request2.push_back({"cache-control", "no-cache"});
+    Headers request3 = {{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"},
+                        {":authority", "www.example.com"}, {"custom-key", "custom-value"}};
+    Headers response1 = {{":status", "302"}, {"cache-control", "private"}, {"date", DATE_21},
+                         {"location", "https://www.example.com"}};
+    Headers response2 = {{":status", "307"}, {"cache-control", "private"}, {"date", DATE_21},
+                         {"location", "https://www.example.com"}};
+    Headers response3 = {{":status", "200"}, {"cache-control", "private"}, {"date", DATE_22},
+                         {"location", "https://www.example.com"}, {"content-encoding", "gzip"},
+                         {"set-cookie", COOKIE}};
+
+    return {
+        {"C.2.1 literal with indexing", 4096,
+         {{"400a637573746f6d2d6b65790d637573746f6d2d686561646572", {{"custom-key", "custom-header"}}, 55}}},
+        {"C.2.2 literal without indexing", 4096,
+         {{"040c2f73616d706c652f70617468", {{":path", "/sample/path"}}, 0}}},
+        {"C.2.3 literal never indexed", 4096,
+         {{"100870617373776f726406736563726574", {{"password", "secret"}}, 0}}},
+        {"C.2.4 indexed", 4096,
+         {{"82", {{":method", "GET"}}, 0}}},
+        {"C.3 requests without Huffman", 4096,
+         {{"828684410f7777772e6578616d706c652e636f6d", request1, 57},
+          {"828684be58086e6f2d6361636865", request2, 110},
+          {"828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565", request3, 164}}},
+        {"C.4 requests with Huffman", 4096,
+         {{"828684418cf1e3c2e5f23a6ba0ab90f4ff", request1, 57},
+          {"828684be5886a8eb10649cbf", request2, 110},
+          {"828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf", request3, 164}}},
+        {"C.5 responses without Huffman", 256,
+         {{"4803333032580770726976617465611d4d6f6e2c203231204f637420323031332032303a31333a323120474d54"
+           "6e1768747470733a2f2f7777772e6578616d706c652e636f6d", response1, 222},
+          {"4803333037c1c0bf", response2, 222},
+          {"88c1611d4d6f6e2c203231204f637420323031332032303a31333a323220474d54c05a04677a69707738666f6f"
+           "3d4153444a4b48514b425a584f5157454f50495541585157454f49553b206d61782d6167653d333630303b2076"
+           "657273696f6e3d31", response3, 215}}},
+        {"C.6 responses with Huffman", 256,
+         {{"488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f"
+           "0b97c8e9ae82ae43d3", response1, 222},
+          {"4883640effc1c0bf", response2, 222},
+          {"88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335df"
+           "dfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007", response3, 215}}},
+    };
+}
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+std::string dump(const Headers& headers)
+{
+    std::string out;
+    for (const auto& h : headers) out += h.first + ": " + h.second + "; ";
+    return out;
+}
+
+void check_hpack()
+{
+    for (const auto& example : hpack_examples())
+    {
+        HpackDecoder decoder(example.max_table_size);
+        for (size_t i = 0; i < example.steps.size(); ++i)
+        {
+            const HpackStep& step = example.steps[i];
+            std::string name = std::string(example.name) + " #" + std::to_string(i + 1);
+            crypto_util::Bytes block = crypto_util::from_hex(step.hex);
+            Headers headers;
+            expect(decoder.decode(block.data(), block.size(), headers), name, "decode failed");
+            expect(headers == step.headers, name, "headers '" + dump(headers) + "'");
+            expect(decoder.table_size() == step.table_size, name,
+                   "table size " + std::to_string(decoder.table_size()) + ", want " + std::to_string(step.table_size));
+        }
+    }
+
+    // 截断的头部块（字符串长度超出数据）
+    HpackDecoder decoder;
+    crypto_util::Bytes truncated = crypto_util::from_hex("400a637573746f6d2d6b6579");
+    Headers headers;
+    expect(!decoder.decode(truncated.data(), truncated.size(), headers), "HPACK truncated block", "accepted");
+}
+
+// 帧：长度(3) 类型(1) 标志(1) 流 ID(4) + 负载
+std::string frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+{
+    std::string out;
+    size_t len = payload.size();
+    out += static_cast<char>(len >> 16);
+    out += static_cast<char>(len >> 8);
+    out += static_cast<char>(len);
+    out += static_cast<char>(type);
+    out += static_cast<char>(flags);
+    for (int shift = 24; shift >= 0; shift -= 8) out += static_cast<char>(stream_id >> shift);
+    return out + payload;
+}
+
+std::string settings(const std::vector<std::pair<uint16_t, uint32_t>>& values)
+{
+    std::string payload;
+    for (const auto& v : values)
+    {
+        payload += static_cast<char>(v.first >> 8);
+        payload += static_cast<char>(v.first);
+        for (int shift = 24; shift >= 0; shift -= 8) payload += static_cast<char>(v.second >> shift);
+    }
+    return frame(0x4, 0, 0, payload);
+}
+
+std::string hex_bytes(const char* hex)
+{
+    crypto_util::Bytes bytes = crypto_util::from_hex(hex);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+const uint8_t DATA = 0x0, HEADERS = 0x1;
+const uint8_t END_STREAM = 0x1, END_HEADERS = 0x4;
+const uint16_t MAX_CONCURRENT_STREAMS = 0x3, MAX_FRAME_SIZE = 0x5;
+const char* const PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+// 一条连接：两端发出 SETTINGS 后按需投递帧，记录输出的流
+struct Connection
+{
+    std::vector<Http2Stream>    done;
+    Http2Connection             h2;
+    timeval                     ts{1700000000, 0};
+
+    Connection()
+        : h2(base(), [this](Http2Stream& stream) { done.push_back(stream); })
+    {
+    }
+
+    static HttpFlowInfo base()
+    {
+        HttpFlowInfo info{};
+        info.flow_id = "test";
+        return info;
+    }
+
+    bool client(const std::string& bytes)
+    {
+        ts.tv_usec += 1000;
+        return h2.feed(Http2Connection::CLIENT_TO_SERVER, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), ts);
+    }
+
+    bool server(const std::string& bytes)
+    {
+        ts.tv_usec += 1000;
+        return h2.feed(Http2Connection::SERVER_TO_CLIENT, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), ts);
+    }
+
+    bool open(const std::vector<std::pair<uint16_t, uint32_t>>& client_settings,
+              const std::vector<std::pair<uint16_t, uint32_t>>& server_settings)
+    {
+        return client(PREFACE + settings(client_settings)) && server(settings(server_settings));
+    }
+};
+
+// 不带 Huffman 的最小请求头部块：GET http://www.example.com/（静态表索引），不进动态表
+std::string request_block()
+{
+    return hex_bytes("828684") + hex_bytes("010f") + "www.example.com";
+}
+
+void check_exchange()
+{
+    const std::string name = "HTTP/2 exchange";
+    Connection conn;
+    expect(conn.open({}, {}), name, "settings rejected");
+    expect(conn.client(frame(HEADERS, END_HEADERS | END_STREAM, 1, request_block())), name, "request rejected");
+    expect(conn.server(frame(HEADERS, END_HEADERS, 1, hex_bytes("88"))), name, "response headers rejected");
+    expect(conn.server(frame(DATA, END_STREAM, 1, "hello")), name, "response body rejected");
+    expect(conn.done.size() == 1 && conn.h2.active_streams() == 0, name, "stream not finished");
+    if (conn.done.size() != 1) return;
+    const Http2Stream& stream = conn.done[0];
+    expect(stream.flow.method == "GET" && stream.flow.url == "http://www.example.com/", name,
+           "request '" + stream.flow.method + " " + stream.flow.url + "'");
+    expect(stream.flow.status_code == 200 && stream.response.body == "hello" && stream.response.length == 5, name,
+           "response");
+}
+
+void check_frame_size()
+{
+    const std::string request = frame(HEADERS, END_HEADERS, 1, request_block());
+    const std::string big_body(Http2Connection::DEFAULT_MAX_FRAME_SIZE + 1, 'x');
+
+    // 默认 16384：超出即协议错误
+    {
+        Connection conn;
+        expect(conn.open({}, {}) && conn.client(request), "frame size default", "setup failed");
+        expect(!conn.client(frame(DATA, END_STREAM, 1, big_body)), "frame size default", "oversized frame accepted");
+    }
+    // 服务端声明更大的上限后，客户端可发送更大的帧；服务端发往客户端的仍按客户端的声明（默认）
+    {
+        Connection conn;
+        expect(conn.open({}, {{MAX_FRAME_SIZE, 32768}}) && conn.client(request), "frame size raised", "setup failed");
+        expect(conn.client(frame(DATA, END_STREAM, 1, big_body)), "frame size raised", "frame within limit rejected");
+        expect(!conn.server(frame(DATA, END_STREAM, 1, big_body)), "frame size raised",
+               "server frame over the client's limit accepted");
+    }
+    // 恰好等于上限的帧合法
+    {
+        Connection conn;
+        expect(conn.open({}, {}) && conn.client(request), "frame size exact", "setup failed");
+        expect(conn.client(frame(DATA, END_STREAM, 1, std::string(Http2Connection::DEFAULT_MAX_FRAME_SIZE, 'x'))),
+               "frame size exact", "frame at limit rejected");
+    }
+    // 声明值超出合法范围 [16384, 2^24-1]
+    {
+        Connection conn;
+        expect(!conn.open({}, {{MAX_FRAME_SIZE, 1024}}), "frame size invalid setting", "accepted");
+    }
+}
+
+void check_stream_limit()
+{
+    // 服务端允许 2 个并发请求，客户端禁止推送：第 3 个流打开时最早的流提前输出
+    {
+        const std::string name = "stream limit from settings";
+        Connection conn;
+        expect(conn.open({{MAX_CONCURRENT_STREAMS, 0}}, {{MAX_CONCURRENT_STREAMS, 2}}), name, "settings rejected");
+        for (uint32_t id : {1u, 3u, 5u})
+            expect(conn.client(frame(HEADERS, END_HEADERS | END_STREAM, id, request_block())), name, "request rejected");
+        expect(conn.h2.active_streams() == 2, name, "active streams " + std::to_string(conn.h2.active_streams()));
+        expect(conn.done.size() == 1 && conn.done[0].stream_id == 1 && !conn.done[0].response_done, name,
+               "oldest stream not flushed");
+    }
+    // 未声明时按固定上限
+    {
+        const std::string name = "stream limit default";
+        Connection conn;
+        expect(conn.open({}, {}), name, "settings rejected");
+        const size_t opened = Http2Connection::MAX_STREAMS + 44;
+        for (uint32_t i = 0; i < opened; ++i)
+            conn.client(frame(HEADERS, END_HEADERS | END_STREAM, 2 * i + 1, request_block()));
+        expect(conn.h2.active_streams() == Http2Connection::MAX_STREAMS, name,
+               "active streams " + std::to_string(conn.h2.active_streams()));
+        expect(conn.done.size() == 44 && conn.done.front().stream_id == 1 && conn.done.back().stream_id == 87, name,
+               "flushed " + std::to_string(conn.done.size()) + " streams");
+        conn.h2.close(conn.ts);
+        expect(conn.done.size() == opened, name, "close did not flush the rest");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    check_hpack();
+    check_exchange();
+    check_frame_size();
+    check_stream_limit();
+    if (g_failures == 0) std::printf("http2_parser: all checks passed\n");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+// QUIC 客户端 Initial 的已知答案检查（RFC 9001 附录 A.1/A.2）：由 DCID 推导的密钥、头部保护的采样与掩码、
+// 受保护包解密后的 CRYPTO 帧，以及 QuicTracker 从该包中取出 SNI/ALPN；篡改或截断的包不建立连接。
+// 不依赖测试框架，全部通过返回 0。
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "CryptoUtil.h"
+#include "QuicParser.h"
+
+namespace {
+
+using crypto_util::Bytes;
+
+const char* const DCID = "8394c8f03e515708";
+const char* const CLIENT_KEY = "1f369613dd76d5467730efcbe3b1a22d";
+const char* const CLIENT_IV = "fa044b2f42a3fd3b46fb255c";
+const char* const CLIENT_HP = "9f50449e04a0e810283a1e9933adedd2";
+const char* const SAMPLE = "d1b1c98dd7689fb8ec11d242b123dc9b";
+const char* const MASK = "437b9aec36";
+const char* const UNPROTECTED_HEADER = "c300000001088394c8f03e5157080000449e00000002";
+const size_t PN_OFFSET = 18;
+const size_t PAYLOAD_LEN = 1162;            // 填充后的明文长度
+
+// A.2 ClientHello 所在的 CRYPTO 帧，其后以 PADDING 补足 PAYLOAD_LEN
+const char* const CRYPTO_FRAME =
+    "060040f1010000ed0303ebf8fa56f12939b9584a3896472ec40bb863cfd3e86804fe3a47f06a2b69484c000004130113"
+    "02010000c000000010000e00000b6578616d706c652e636f6dff01000100000a00080006001d00170018001000070005"
+    "04616c706e000500050100000000003300260024001d00209370b2c9caa47fbabaf4559fedba753de171fa71f50f1ce1"
+    "5d43e994ec74d748002b0003020304000d0010000e0403050306030203080408050806002d00020101001c0002400100"
+    "3900320408ffffffffffffffff05048000ffff07048000ffff0801100104800075300901100f088394c8f03e51570806"
+    "048000ffff";
+
+// A.2 受保护的客户端 Initial（1200 字节）
+const char* const PROTECTED_PACKET =
+    "c000000001088394c8f03e5157080000449e7b9aec34d1b1c98dd7689fb8ec11d242b123dc9bd8bab936b47d92ec356c"
+    "0bab7df5976d27cd449f63300099f3991c260ec4c60d17b31f8429157bb35a1282a643a8d2262cad67500cadb8e7378c"
+    "8eb7539ec4d4905fed1bee1fc8aafba17c750e2c7ace01e6005f80fcb7df621230c83711b39343fa028cea7f7fb5ff89"
+    "eac2308249a02252155e2347b63d58c5457afd84d05dfffdb20392844ae812154682e9cf012f9021a6f0be17ddd0c208"
+    "4dce25ff9b06cde535d0f920a2db1bf362c23e596d11a4f5a6cf3948838a3aec4e15daf8500a6ef69ec4e3feb6b1d98e"
+    "610ac8b7ec3faf6ad760b7bad1db4ba3485e8a94dc250ae3fdb41ed15fb6a8e5eba0fc3dd60bc8e30c5c4287e53805db"
+    "059ae0648db2f64264ed5e39be2e20d82df566da8dd5998ccabdae053060ae6c7b4378e846d29f37ed7b4ea9ec5d82e7"
+    "961b7f25a9323851f681d582363aa5f89937f5a67258bf63ad6f1a0b1d96dbd4faddfcefc5266ba6611722395c906556"
+    "be52afe3f565636ad1b17d508b73d8743eeb524be22b3dcbc2c7468d54119c7468449a13d8e3b95811a198f3491de3e7"
+    "fe942b330407abf82a4ed7c1b311663ac69890f4157015853d91e923037c227a33cdd5ec281ca3f79c44546b9d90ca00"
+    "f064c99e3dd97911d39fe9c5d0b23a229a234cb36186c4819e8b9c5927726632291d6a418211cc2962e20fe47feb3edf"
+    "330f2c603a9d48c0fcb5699dbfe5896425c5bac4aee82e57a85aaf4e2513e4f05796b07ba2ee47d80506f8d2c25e50fd"
+    "14de71e6c418559302f939b0e1abd576f279c4b2e0feb85c1f28ff18f58891ffef132eef2fa09346aee33c28eb130ff2"
+    "8f5b766953334113211996d20011a198e3fc433f9f2541010ae17c1bf202580f6047472fb36857fe843b19f5984009dd"
+    "c324044e847a4f4a0ab34f719595de37252d6235365e9b84392b061085349d73203a4a13e96f5432ec0fd4a1ee65accd"
+    "d5e3904df54c1da510b0ff20dcc0c77fcb2c0e0eb605cb0504db87632cf3d8b4dae6e705769d1de354270123cb11450e"
+    "fc60ac47683d7b8d0f811365565fd98c4c8eb936bcab8d069fc33bd801b03adea2e1fbc5aa463d08ca19896d2bf59a07"
+    "1b851e6c239052172f296bfb5e72404790a2181014f3b94a4e97d117b438130368cc39dbb2d198065ae3986547926cd2"
+    "162f40a29f0c3c8745c0f50fba3852e566d44575c29d39a03f0cda721984b6f440591f355e12d439ff150aab7613499d"
+    "bd49adabc8676eef023b15b65bfc5ca06948109f23f350db82123535eb8a7433bdabcb909271a6ecbcb58b936a88cd4e"
+    "8f2e6ff5800175f113253d8fa9ca8885c2f552e657dc603f252e1a8e308f76f0be79e2fb8f5d5fbbe2e30ecadd220723"
+    "c8c0aea8078cdfcb3868263ff8f0940054da48781893a7e49ad5aff4af300cd804a6b6279ab3ff3afb64491c85194aab"
+    "760d58a606654f9f4400e8b38591356fbf6425aca26dc85244259ff2b19c41b9f96f3ca9ec1dde434da7d2d392b905dd"
+    "f3d1f9af93d1af5950bd493f5aa731b4056df31bd267b6b90a079831aaf579be0a39013137aac6d404f518cfd4684064"
+    "7e78bfe706ca4cf5e9c5453e9f7cfd2b8b4c8d169a44e55c88d4a9a7f9474241e221af44860018ab0856972e194cd934";
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+std::string dcid()
+{
+    Bytes bytes = crypto_util::from_hex(DCID);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+void check_keys(QuicInitialKeys& keys)
+{
+    const std::string name = "initial keys";
+    expect(QuicTracker::client_initial_keys(0x00000001, dcid(), keys), name, "derivation failed");
+    expect(keys.key == crypto_util::from_hex(CLIENT_KEY), name, "key");
+    expect(keys.iv == crypto_util::from_hex(CLIENT_IV), name, "iv");
+    expect(keys.hp == crypto_util::from_hex(CLIENT_HP), name, "hp");
+
+    QuicInitialKeys unknown;
+    expect(!QuicTracker::client_initial_keys(0x0a0a0a0a, dcid(), unknown), name, "unknown version accepted");
+}
+
+void check_protection(const QuicInitialKeys& keys, const Bytes& packet)
+{
+    const std::string name = "header protection";
+    if (packet.size() != 1200)
+    {
+        expect(false, name, "packet length " + std::to_string(packet.size()));
+        return;
+    }
+
+    // 采样取自包号起始 + 4
+    Bytes sample(packet.begin() + PN_OFFSET + 4, packet.begin() + PN_OFFSET + 4 + 16);
+    expect(sample == crypto_util::from_hex(SAMPLE), name, "sample");
+    uint8_t mask[16];
+    expect(crypto_util::aes_ecb_encrypt_block(keys.hp, sample.data(), mask), name, "mask failed");
+    expect(Bytes(mask, mask + 5) == crypto_util::from_hex(MASK), name, "mask");
+
+    Bytes header(packet.begin(), packet.begin() + PN_OFFSET + 4);
+    header[0] ^= mask[0] & 0x0F;
+    for (size_t i = 0; i < 4; ++i) header[PN_OFFSET + i] ^= mask[1 + i];
+    expect(header == crypto_util::from_hex(UNPROTECTED_HEADER), name, "unprotected header");
+
+    // 包号 2
+    uint8_t nonce[12];
+    std::memcpy(nonce, keys.iv.data(), sizeof(nonce));
+    nonce[11] ^= 2;
+    Bytes plain;
+    expect(crypto_util::aead_decrypt(crypto_util::Aead::AES_128_GCM, keys.key, nonce, sizeof(nonce),
+                                     header.data(), header.size(), packet.data() + header.size(),
+                                     packet.size() - header.size(), plain),
+           name, "payload decryption failed");
+    Bytes want = crypto_util::from_hex(CRYPTO_FRAME);
+    want.resize(PAYLOAD_LEN, 0);
+    expect(plain == want, name, "payload");
+}
+
+QuicConnection* feed(QuicTracker& tracker, const Bytes& packet, int& direction)
+{
+    // 非 443 端口，避免未解出 Initial 时按四元组建立连接
+    timeval ts{1700000000, 0};
+    return tracker.process("10.0.0.1", 50000, "10.0.0.2", 4433, packet.data(), packet.size(), ts, direction);
+}
+
+void check_tracker(const Bytes& packet)
+{
+    {
+        const std::string name = "tracker client hello";
+        QuicTracker tracker;
+        int direction = -1;
+        QuicConnection* conn = feed(tracker, packet, direction);
+        expect(conn != nullptr, name, "connection not created");
+        if (!conn) return;
+        expect(conn->id == DCID && conn->version == 1 && direction == 0, name, "id " + conn->id);
+        expect(conn->server_name == "example.com", name, "sni '" + conn->server_name + "'");
+        expect(conn->alpn == "alpn", name, "alpn '" + conn->alpn + "'");
+        expect(conn->client_ip == "10.0.0.1" && conn->server_port == 4433, name, "endpoints");
+    }
+    {
+        QuicTracker tracker;
+        Bytes tampered = packet;
+        tampered[600] ^= 0x01;
+        int direction = -1;
+        expect(feed(tracker, tampered, direction) == nullptr && tracker.size() == 0, "tracker tampered packet",
+               "connection created");
+    }
+    {
+        QuicTracker tracker;
+        Bytes truncated(packet.begin(), packet.begin() + 600);
+        int direction = -1;
+        expect(feed(tracker, truncated, direction) == nullptr && tracker.size() == 0, "tracker truncated packet",
+               "connection created");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    QuicInitialKeys keys;
+    check_keys(keys);
+    Bytes packet = crypto_util::from_hex(PROTECTED_PACKET);
+    check_protection(keys, packet);
+    check_tracker(packet);
+    if (g_failures == 0) std::printf("quic_initial: all checks passed\n");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+// 会话超时相关的检查：TimerWheel 逐 tick 推进与跳转推进的到期结果与逐个比对的参考实现一致，
+// 报文时间大幅跳变时不按秒空转；SessionTable 对超前墙钟的报文时间不推进会话时钟。
+// 不依赖测试框架，全部通过返回 0。
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+#include "SessionTable.h"
+#include "TimerWheel.h"
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+// 随机登记与推进，每次推进的到期集合必须等于 expire <= now 且尚未输出的定时器
+void check_wheel_random(uint32_t seed, uint64_t max_step)
+{
+    const std::string name = "wheel random seed " + std::to_string(seed) + " step " + std::to_string(max_step);
+    std::mt19937_64 rng(seed);
+    TimerWheel wheel;
+    uint64_t now = 1700000000;
+    wheel.start(now);
+
+    std::vector<uint64_t> pending;      // 下标为定时器 ID，值为到期 tick，0 表示已输出
+    for (int round = 0; round < 400; ++round)
+    {
+        int adds = static_cast<int>(rng() % 8);
+        for (int i = 0; i < adds; ++i)
+        {
+            // 覆盖最低层、高层与超出最高层范围的延迟
+            uint64_t delays[] = {rng() % 64, rng() % 5000, rng() % 400000, rng() % (uint64_t(1) << 26)};
+            uint64_t expire = now + 1 + delays[rng() % 4];
+            wheel.schedule(pending.size(), expire);
+            pending.push_back(expire);
+        }
+
+        now += rng() % max_step;
+        std::vector<TimerWheel::TimerId> expired;
+        wheel.advance(now, expired);
+
+        std::vector<TimerWheel::TimerId> want;
+        for (size_t id = 0; id < pending.size(); ++id)
+        {
+            if (pending[id] != 0 && pending[id] <= now)
+            {
+                want.push_back(id);
+                pending[id] = 0;
+            }
+        }
+        std::sort(expired.begin(), expired.end());
+        if (expired != want)
+        {
+            expect(false, name, "round " + std::to_string(round) + ": expired " + std::to_string(expired.size()) +
+                   " timers, want " + std::to_string(want.size()));
+            return;
+        }
+    }
+    size_t remaining = std::count_if(pending.begin(), pending.end(), [](uint64_t e) { return e != 0; });
+    expect(wheel.size() == remaining, name, "size " + std::to_string(wheel.size()));
+}
+
+void check_wheel_jump()
+{
+    const std::string name = "wheel far jump";
+    TimerWheel wheel;
+    wheel.start(1700000000);
+    wheel.schedule(1, 1700000300);
+    wheel.schedule(2, 1700000060);
+    wheel.schedule(3, 4000000000);
+
+    // 约 73 年的间隔：逐 tick 推进需要二十多亿次循环
+    std::vector<TimerWheel::TimerId> expired;
+    wheel.advance(4000000000 - 1, expired);
+    expect(expired == std::vector<TimerWheel::TimerId>({2, 1}), name, "first jump not in expiry order");
+    expect(wheel.size() == 1, name, "size " + std::to_string(wheel.size()));
+
+    expired.clear();
+    wheel.advance(4000000000, expired);
+    expect(expired == std::vector<TimerWheel::TimerId>({3}), name, "last timer not expired");
+
+    // 空轮直接跳转，之后登记的定时器按新的当前 tick 计算
+    expired.clear();
+    wheel.advance(9000000000, expired);
+    wheel.schedule(4, 9000000010);
+    wheel.advance(9000000009, expired);
+    expect(expired.empty(), name, "timer expired early after empty jump");
+    wheel.advance(9000000010, expired);
+    expect(expired == std::vector<TimerWheel::TimerId>({4}), name, "timer not expired after empty jump");
+}
+
+void check_session_clock()
+{
+    const std::string name = "session future timestamp";
+    SessionTableConfig config;
+    config.idle_timeout = 60;
+    SessionTable table(config);
+
+    std::time_t wall = std::time(nullptr);
+    bool created = false;
+    table.touch("a", "UDP", 0, 0, wall, created);
+    // 超前墙钟十年的报文：计入钳位，按当前会话时钟记账
+    table.touch("b", "UDP", 0, 0, wall + 10 * 365 * 86400, created);
+    table.touch("c", "UDP", 0, 0, wall + 30, created);
+    expect(table.stats().clamped_time == 1, name, "clamped " + std::to_string(table.stats().clamped_time));
+
+    // 会话时钟停在 wall + 30：a、b 的空闲时间从 wall 起算，c 从 wall + 30 起算
+    table.expire(wall + 59);
+    expect(table.size() == 3, name, "sessions expired early");
+    table.expire(wall + 60);
+    expect(table.size() == 1, name, "size " + std::to_string(table.size()) + " after a/b timeout");
+    table.expire(wall + 90);
+    expect(table.size() == 0 && table.stats().expired_idle == 3, name, "c not expired");
+}
+
+} // namespace
+
+int main()
+{
+    for (uint32_t seed = 1; seed <= 4; ++seed)
+    {
+        check_wheel_random(seed, 4);         // 逐 tick 推进
+        check_wheel_random(seed, 200000);    // 跳转推进
+    }
+    check_wheel_jump();
+    check_session_clock();
+    if (g_failures == 0) std::printf("session_timers: all checks passed\n");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,394 @@
+// TLS 解密的已知答案检查：固定的 TLS 1.2 / 1.3 会话（由 OpenSSL 生成的两个方向的字节流与客户端 key log），
+// 验证 TlsDecryptor 的握手跟踪、密钥派生（TLS 1.3 HKDF-Expand-Label 与 KeyUpdate、TLS 1.2 PRF，SHA-256 / SHA-384）
+// 与记录解密（AES-128/256-GCM、ChaCha20-Poly1305）。
+// 不依赖测试框架，全部通过返回 0。
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "CryptoUtil.h"
+#include "TlsDecryptor.h"
+#include "TlsKeyLog.h"
+
+namespace {
+
+const TlsDecryptor::Direction CLIENT = TlsDecryptor::CLIENT_TO_SERVER;
+const TlsDecryptor::Direction SERVER = TlsDecryptor::SERVER_TO_CLIENT;
+
+// 一次投递的 TCP 负载（按抓包顺序）
+struct Segment
+{
+    TlsDecryptor::Direction dir;
+    const char*             hex;
+};
+
+const char* const REQUEST = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+const char* const RESPONSE = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+// TLS 1.3 TLS_AES_128_GCM_SHA256：加密握手、应用数据，服务端发出 KeyUpdate 后再发 1 字节
+const char* const TLS13_AES_128_GCM_KEYLOG =
+    "SERVER_HANDSHAKE_TRAFFIC_SECRET be23714487df7272b23bf5bfadbc05df9e5260d0b79fe6fd0913a44937fa882f "
+    "dcc446cb64ad0d17ee12e4560f8fe58dd455adea27db8ba27427ea2207fb9ca2\n"
+    "SERVER_TRAFFIC_SECRET_0 be23714487df7272b23bf5bfadbc05df9e5260d0b79fe6fd0913a44937fa882f "
+    "e830fa28abe27f52f18a4c7572ed236f22bfd4435984477a677be7fa73c5f1b5\n"
+    "CLIENT_HANDSHAKE_TRAFFIC_SECRET be23714487df7272b23bf5bfadbc05df9e5260d0b79fe6fd0913a44937fa882f "
+    "483310c871340aaf80df71af0c6b9a9016611a162fe0d213cf35ffb0e17e3e7d\n"
+    "CLIENT_TRAFFIC_SECRET_0 be23714487df7272b23bf5bfadbc05df9e5260d0b79fe6fd0913a44937fa882f "
+    "2fcf0b5e347198d9f697e9ef0cbaeeb520f145cf172513aa73188fd0d354f699\n";
+const Segment TLS13_AES_128_GCM_SEGMENTS[] = {
+    {CLIENT,  // 256 字节
+        "16030100fb010000f70303be23714487df7272b23bf5bfadbc05df9e5260d0b79fe6fd0913a44937fa882f2023fc86ea"
+        "30978406777cb1ee4502a62ff0433649a749da90d8489208970757b60004130100ff010000aa00000010000e00000b65"
+        "78616d706c652e636f6d000b000403000102000a00160014001d0017001e001900180100010101020103010400230000"
+        "0010000b000908687474702f312e310016000000170000000d001e001c040305030603080708080809080a080b080408"
+        "050806040105010601002b0003020304002d00020101003300260024001d0020449e2846dd130e46a3016f1dfd680ffb"
+        "01f30e6159d43e7f3bc2728f9d6e6a0b"},
+    {SERVER,  // 758 字节
+        "160303007a0200007603031ceb0b8d41ae9010577027461ce260037155153e472e5b7a0dd221ad0bebf78f2023fc86ea"
+        "30978406777cb1ee4502a62ff0433649a749da90d8489208970757b6130100002e002b0002030400330024001d00204f"
+        "969fa13695d11910a5d687548ee770f37e02afb5715dae232b30a7d4908e4614030300010117030300261024ef61481b"
+        "a62cdfdd371c12db026852aa4ca91f2dc3bf7a0ee36c6e8d05b4f52797b4780317030301a38c1edd2eab620727fba26b"
+        "b328f48e16c02528ec89f18875b94ea11aead9a51a428dbb060c851cacad0fb891eec1ffcc105f769af97594992233c5"
+        "20e49b70740701c0d243662dce8445656cd445812adf15a517c7875b872ead04a837848898eccceb8f5e8c62838697a9"
+        "a2efa6179565caa8414aab19e64904dad325f82ebfb8af9cf365d51b8dfe6a3056ee88d1528897475cfca343074f04c3"
+        "817e282791ecda528eafe4abbed4ea73bdfbc01da57cc913d40dd1e58956cea8bc17fdbce3d6739bfb3e2eb7f0aee136"
+        "c41619f175b708ef69c4868f5c7d1d270db7f3585bf758275c708e4b8b2b0c8723ef3ada291fce5c6fdf59e6b21b27e2"
+        "94c4985dd3c8a95fd5e1b407e492eeea0e374eedfffc67e21a77abb3c8d02bbd5c00414b38a8fbc4933008fef9b20f50"
+        "706dbcfa4d26f534ffc2ce2dad22bdfaaec2516f932485624e466e178f9e2e5f3b08561fe172e02af8003f1c15a304b8"
+        "e4d5c068215d8e2be31bb16242dd0c289208e68d11e6c5fb245af10a0b99aeab795cd2bec03523957cc600cc9cf6c150"
+        "c26e35613e63fade4bd0f86693934ec333b6062855501cf9170303005f3c3c0bb4c4b1a8681b216ceb79c920af9b6c51"
+        "bd6fb1157b7b14019d0c553f93f6facab6edc1988ecba8aa20c6834d42b66c03ccf2fab6dd520ec395a17c53b05c26c0"
+        "85b5ea9d4696e81b6c53176cd6bfd4724b2780ea840984432620472d170303003585bc5ceedcabaabe9423256c880f01"
+        "91db442a4b9a67dcfd1dd33bd1310c955975ae2f486ef415ac2fd59b98bfd942fcc2d6519d3e"},
+    {CLIENT,  // 64 字节
+        "14030300010117030300358c256a9b28d5d2b4cf32b77e759ab3dfe55d6aaffe73a14cc32e587c37356680683fd97c66"
+        "ce06253453322ddd7a27d7e5ed0e9ec2"},
+    {CLIENT,  // 59 字节
+        "1703030036ea1662dd1dc83a73d9be51c5e79ec2c8a03da3f533c2fa7513e0e7553aaf0c0c134e75c823f00e7d689ed5"
+        "83c59b7587e15600c2d6f7"},
+    {SERVER,  // 112 字节
+        "1703030039e45802bf8a7e3c5127f5e11bbd4d09fd516288e35f90da322951949bfd287aecf4e529dcf6f02312ef6435"
+        "7e7e9a0ac9c1de339d5da7174b0d1703030016547f12f83dffd6ccf6fa57b964b34c611cf0caa2201a17030300127cac"
+        "c4ed8e878369c9109c4dee64c885b0a2"},
+};
+
+// TLS 1.2 ECDHE-ECDSA-AES128-GCM-SHA256：key expansion 由 PRF 从 master secret 派生，显式 nonce
+const char* const TLS12_ECDHE_ECDSA_AES128_GCM_KEYLOG =
+    "CLIENT_RANDOM cc57881003914fbb1fe67f1d8d1eb3bf8c6e3a5f3a838023433a95749882964f "
+    "6d6400c2fa547548c869fa228e6ca830c34339ce0c3f706da69f67bcbda1f92d683c6d0c308c46557c17fce484dfd833\n";
+const Segment TLS12_ECDHE_ECDSA_AES128_GCM_SEGMENTS[] = {
+    {CLIENT,  // 171 字节
+        "16030100a6010000a20303cc57881003914fbb1fe67f1d8d1eb3bf8c6e3a5f3a838023433a95749882964f000004c02b"
+        "00ff0100007500000010000e00000b6578616d706c652e636f6d000b000403000102000a000c000a001d0017001e0019"
+        "0018002300000010000b000908687474702f312e310016000000170000000d002a002804030503060308070808080908"
+        "0a080b080408050806040105010601030303010302040205020602"},
+    {SERVER,  // 645 字节
+        "160303006c020000680303ba39708b2d401e034925f56872749e75186502db0b5adbd5444f574e4752440120c93d7a7d"
+        "6528131328b466db9b7be20aa6f2dfccc44b0064a53881d7d59e5ae7c02b000020ff01000100000b0004030001020010"
+        "000b000908687474702f312e3100170000160303018f0b00018b0001880001853082018130820127a00302010202141a"
+        "4d4051373b5f2e27fe7b7fe2b6b0a488d7893c300a06082a8648ce3d04030230163114301206035504030c0b6578616d"
+        "706c652e636f6d301e170d3236313031393036353535365a170d3336313031363036353535365a301631143012060355"
+        "04030c0b6578616d706c652e636f6d3059301306072a8648ce3d020106082a8648ce3d030107034200044ab571619efe"
+        "17af64ffd24316f5eb5d7b2c7228d7ff5e8dd49068ac5dbf9513c5ae5be39f5ae81357bd980778016f68eaa82e6f8411"
+        "8b41a5888371fd9edd23a3533051301d0603551d0e04160414a7c378276b88ef7842663cea36ddc5e82dae94a0301f06"
+        "03551d23041830168014a7c378276b88ef7842663cea36ddc5e82dae94a0300f0603551d130101ff040530030101ff30"
+        "0a06082a8648ce3d04030203480030450220492f576a984825aee7dacbcfeecb7bc01013023553309fa4154739b6c3c5"
+        "7a600221009ec02e4ba301bcb72812cd8cc1a3e5eb36700eb55aa9ca30946db4fa672d27c016030300720c00006e0300"
+        "1d2090db14923cc496415ab56420cf7b6b5f61cca81af84380e84279a2f163fab96b04030046304402206aab6a375be0"
+        "be1fb0134436b54a264280ca95c468a4afa172040466b944817d0220095e6e59b9757acfed2a1849bc35728ff8177b54"
+        "30b7c84de4ba7b9ffad2a1a516030300040e000000"},
+    {CLIENT,  // 93 字节
+        "16030300251000002120bceea73ace0d0f25f9ee50534c437cb45746309774373465421e2fd71e75ba19140303000101"
+        "1603030028f68eeb25c278da59dfadf444741967714fa58d2854a48791a2ecc6586d0d3ac8da431aff8cab5ff8"},
+    {SERVER,  // 51 字节
+        "140303000101160303002822deb1e5f35e4bbddc8edc0b86c4eec36342486ccaac1375fc656cbac4c0ce5751de76b8ac"
+        "ba7804"},
+    {CLIENT,  // 66 字节
+        "170303003df68eeb25c278da5a36f14861fc46126b54b5d142a5eafc9a3a4da75a862ea116b4785de1074329ee200614"
+        "e4bde4531dfe8b45382873ca071467749021"},
+    {SERVER,  // 69 字节
+        "170303004022deb1e5f35e4bbefb345eea9da5afa15dd52f53d844cd7cbb9578e09672b68457f7b91cc212082a990ba1"
+        "f4f67e2f1d98cbeb2bce3c6409d13982c937e3b486"},
+};
+
+// TLS 1.3 TLS_CHACHA20_POLY1305_SHA256：nonce 为 12 字节 IV 异或序号（RFC 7905），同样带 KeyUpdate
+const char* const TLS13_CHACHA20_POLY1305_KEYLOG =
+    "SERVER_HANDSHAKE_TRAFFIC_SECRET 28dec50875ef034ed86d2d51c4b64d5699ea184c223af2b75e44be46e79f91a6 "
+    "2313c31021605e4f8bea0d12196efc55ef67d06000f0c862e74bcdd77610bbbb\n"
+    "SERVER_TRAFFIC_SECRET_0 28dec50875ef034ed86d2d51c4b64d5699ea184c223af2b75e44be46e79f91a6 "
+    "75fae40c126ff8c8cde3e7ad03952d60e6b320df4cd9963b8fd586ee2a0580a5\n"
+    "CLIENT_HANDSHAKE_TRAFFIC_SECRET 28dec50875ef034ed86d2d51c4b64d5699ea184c223af2b75e44be46e79f91a6 "
+    "ca67b645aa12d6f3c7a270d1fcca37d47df78021ecf4593b7a5e74d88c0a4769\n"
+    "CLIENT_TRAFFIC_SECRET_0 28dec50875ef034ed86d2d51c4b64d5699ea184c223af2b75e44be46e79f91a6 "
+    "e6fe8893de4d0580b4ec4d77fc3fdc014c06f0dc0d34de72c5ee8c0f2d16fa83\n";
+const Segment TLS13_CHACHA20_POLY1305_SEGMENTS[] = {
+    {CLIENT,  // 256 字节
+        "16030100fb010000f7030328dec50875ef034ed86d2d51c4b64d5699ea184c223af2b75e44be46e79f91a620141dbbfa"
+        "15fef1044aac287f52da7343677c5b46847017c83964a8cb8069f2790004130300ff010000aa00000010000e00000b65"
+        "78616d706c652e636f6d000b000403000102000a00160014001d0017001e001900180100010101020103010400230000"
+        "0010000b000908687474702f312e310016000000170000000d001e001c040305030603080708080809080a080b080408"
+        "050806040105010601002b0003020304002d00020101003300260024001d002007e70b2eecae9e27b2c9af67007efda6"
+        "609f3ad5e62bdffd7362c5e9768c4771"},
+    {SERVER,  // 760 字节
+        "160303007a02000076030311e55b822ba41e6932d95b4d26a0f02bbfd038e25270cf3cd9fc860ac9e189ae20141dbbfa"
+        "15fef1044aac287f52da7343677c5b46847017c83964a8cb8069f279130300002e002b0002030400330024001d002028"
+        "d2e65bd7e5d4c363fe07e748020996dbde10f1da997a6371499efda862a7141403030001011703030026c983106839e9"
+        "5d0732e42542dd1175092441b458eccbb0c251028f182f0e2e99c4dbb500741b17030301a3c75dcfcfaea7100be8cec6"
+        "3eb8f02dfa019b46ce34d5cc80332f603417900248322112d63d57dc891d6d36238b79de5945daadaec582a31173cbb0"
+        "3959104d43094f495d87d2aad3c33635df8068740316a297502942e9cab5d9bf6d7ecd84427b0df8c5d7b80b22fdddaf"
+        "095b93fff17418dcbf76abcfd6dae6cd99d128075abc749780fae8aa19d63201761bb61b1e1a65e20f31b3d0963fdc17"
+        "23347d9f770bfc882eac54e57dadeb3422472f749c63e15326f54587dd5f2e70cd0d3a4d9f81f1a949a7cf3ed805cd52"
+        "54596e4e3da206a0639f8f7af1d4658a8c90b8e670327b763352bd4309d3f6e7cff455c32215bb8ca865dd167d6333a5"
+        "49f6140d55345f88d0bb8b184c6455762c33fce75b9e270b46b5f22cadf53152314391bf9c7aad8a1bd170280e5fc800"
+        "1df4032e2d2bd557576fd6e0f1849ba8abeb401d35b359beca71796b027e7f32de3988a53a8439579b9a8c8447d7fb47"
+        "f3246c8bde1cb2f6e4d350cd822dd3a14e405c915c55ccdbcd960c197a4a91097e9886d1e9080570dd2abef91dcd9ec5"
+        "6167fa4b0187b1879abb5a606cecb75a10e6287018fd75361703030061deff7305a18d81b2f724dce800b02d99d3ffd8"
+        "65f111b76ada9e2371971aa60a46a011c25d95ec78cb907c9a423ef8c72bdd968815f23ae822cded2b0e456c01a222ba"
+        "fe1f626225831b1619c96a8d211f4918fb3573f0804d43218ea29c3ab20e170303003596545f41cf833cc38ef1ccaa61"
+        "4542242f7c2f5663bafdf2c156bd7d8a9b114f3faca1b7947087f1c93f03db5897badc2bb5ae6533"},
+    {CLIENT,  // 64 字节
+        "1403030001011703030035f7127e125cb998d1613529808b63aa596c9b9a4ee5a10f1702295898bf0fb7f5455a4d3dbb"
+        "fb02737c9d5105df92320610eb560f44"},
+    {CLIENT,  // 59 字节
+        "17030300361eb8d9bf1d3c05c281dc901929f3f1e27654c2f63417d7f18c8eafb5df086d8e6ae0555eab9958aa4d4551"
+        "95f54a5effc5c44762416b"},
+    {SERVER,  // 112 字节
+        "1703030039ed413a635339e10e10013b677a31820668abc144f236349c021d305eaaacf3d57ca057badbd6b5048604a1"
+        "3bc64ddd91863688c92202929f5b1703030016cab44ef6639c463ffcdac4a03ea84462a5e4c9acc71e170303001204ee"
+        "1aae0ccc679cb9e589a1dce40eb1a738"},
+};
+
+// TLS 1.3 TLS_AES_256_GCM_SHA384：HKDF 用 SHA-384（48 字节的流量密钥），AES-256 密钥 32 字节
+const char* const TLS13_AES_256_GCM_KEYLOG =
+    "SERVER_HANDSHAKE_TRAFFIC_SECRET 7a96611fd8d86dbab6e536bfda22371b74a86a905b599442827eeaa77cbb5571 "
+    "f3284aa61b87aec570a6e498b5436603a12d329d624d87241b13f513bc9f3f83ac246eb29ffc7f0afc507ddbd5252182\n"
+    "SERVER_TRAFFIC_SECRET_0 7a96611fd8d86dbab6e536bfda22371b74a86a905b599442827eeaa77cbb5571 "
+    "db7429ed649351c3a696fa45276522ed0da5f78d4f5625f844dc87149bc9307b3b81bad0eaef4c42cc9ad174624a8f17\n"
+    "CLIENT_HANDSHAKE_TRAFFIC_SECRET 7a96611fd8d86dbab6e536bfda22371b74a86a905b599442827eeaa77cbb5571 "
+    "690080fa58a8dac55047df70f9b3985bf82b50ec827e2dc07bbc003165d26a3bf5f31ea1b415e6c524589ba341f3b021\n"
+    "CLIENT_TRAFFIC_SECRET_0 7a96611fd8d86dbab6e536bfda22371b74a86a905b599442827eeaa77cbb5571 "
+    "7cf7e1c383e2d257242ebf34dc5ae06c59d0ebf67415499cd56a54d2e0cef6cf22b5345fa1e5fc53414c961f21b23962\n";
+const Segment TLS13_AES_256_GCM_SEGMENTS[] = {
+    {CLIENT,  // 256 字节
+        "16030100fb010000f703037a96611fd8d86dbab6e536bfda22371b74a86a905b599442827eeaa77cbb557120862c010b"
+        "700163aafaf7a70e72b49321b826192c89244ca2ab24dd97812225290004130200ff010000aa00000010000e00000b65"
+        "78616d706c652e636f6d000b000403000102000a00160014001d0017001e001900180100010101020103010400230000"
+        "0010000b000908687474702f312e310016000000170000000d001e001c040305030603080708080809080a080b080408"
+        "050806040105010601002b0003020304002d00020101003300260024001d002082ec9b978e6d69545e17946284756204"
+        "ce9d6f0135ef6f1ba0ffbe81d992e951"},
+    {SERVER,  // 776 字节
+        "160303007a0200007603030f41da9f338e1ace91079c1b2a2a5cf3f9913b83c070a2c642566143f534d4c320862c010b"
+        "700163aafaf7a70e72b49321b826192c89244ca2ab24dd9781222529130200002e002b0002030400330024001d0020a6"
+        "2631d48f47b1853423db150354c0f11bfc4c1181c08d2017a98f236ab1065014030300010117030300262b2a9c900e12"
+        "fdad4dd791033fc82b400494fab4b230d1fd806f38d7fd4b32b059d26045445917030301a3d2f8dced3644f99e6d1b0c"
+        "4c13176f16294bc526e319f9e9506d7a50e7d67b6f80dbaaaa4f4dd9626763eb13f2d20c8c780ed0e5b6985ac907c155"
+        "62a8245b85a335b0dc9fb239ed10f596ce1e58dbe3276f406d3bb8937720d711a84b1196d31f615286efcd11d5432903"
+        "048c3b44b3a957b940a652bc3b8bde0f6ff5bcea90c22a7220c5cbe1a5e90ffd27f512ebb33fc0c76f0809f941a41b06"
+        "0686c2f9522b7704c35fba452cd4219800ded42fadb2b854d4a2a86d5a6ddb588316d99c0f348f20dccc5d1b85bd0b6d"
+        "dbc2af7d7372411549004ff06192ae0479bbe0815d3b4e79fa79f9a27e540edc46c66a473e6ddf2d21542f877e990ea9"
+        "10691fed890f22ccbcfefe4c1c7312afeef1b9511354b589bae6beae909d1c709e264127ae7054c72afd09865d1ed1f8"
+        "5134bd35c7a2034b038d7326c16eaca2abf193fa82966f049f4c7dc3117060e598d56e72af7e4cb41da8d4e249e3f3a5"
+        "01b35eb2d1bd66dc21245200fb34aae27278579f88a3bad163ea22ec7bbabab9fbcad47f63ed034c87c6761ababe1d97"
+        "e3167b3a754e2bc05d98133bab96d8dc81b8f996f451697c1703030061f390b188dd1c0cebdd4e8bf5a0909b70ae0a5a"
+        "0b88818b41e8a12e2f6f40e75fb4b4fd2c69577d13aec552ead61ad4651c4950afeef24866a8ad0a6d6a6ebc93157bfe"
+        "2e71f5787e21b2346c7649267fedb53b93de46e8f09fc905e0bc73bb45d117030300450111e36bb5fcae1e312c80050d"
+        "ac7818d0963cda202591383eacf61ff63ff08e6d3dadf4ad34b868756f1002cb1dc6475ef0e713977c5f19ab28453463"
+        "eea8247eef4711bc"},
+    {CLIENT,  // 80 字节
+        "140303000101170303004598dc2701ff65592acf8aa036cd2e5961f42b89a965ac73e119882a92d40699892b0750492d"
+        "69f13549d4088a97087d1dbefbd118701e1c71d370583c752e32b4e2f518f7d6"},
+    {CLIENT,  // 59 字节
+        "1703030036e455807cc17151fbdb9c34cec7ddd220ea0cc0b5e7d8d673ac386964244b6f5f45ce3bf1df3f6f0c027cbb"
+        "0937ca46733e7184401fe7"},
+    {SERVER,  // 112 字节
+        "1703030039ce164a2f543584dedf2bcdceb8cebfadc22a595454729387919dfed0392205bf22d30a0b3290e1461c77fa"
+        "3bad1b0a251984c07b58e473f6f817030300166e6e5536a7f964aaeb0e4dc7f1722fc6d3f054820215170303001281d5"
+        "ad8100b08e0335c0135b2e9ecd62e1c9"},
+};
+
+// TLS 1.2 ECDHE-RSA-CHACHA20-POLY1305（0xCCA8）：无显式 nonce，12 字节 IV 异或序号（RFC 7905）
+const char* const TLS12_ECDHE_RSA_CHACHA20_POLY1305_KEYLOG =
+    "CLIENT_RANDOM ede3e2358c78f3a8d62636e80472e4a6cbff319fc49d98da65d7d3474c2323d4 "
+    "0142aeca16389704f74fe1184cac633e46a4ad0fde0acfeaeda58d92793b662fcc3e40d0743a64476b184db2265edd2b\n";
+const Segment TLS12_ECDHE_RSA_CHACHA20_POLY1305_SEGMENTS[] = {
+    {CLIENT,  // 171 字节
+        "16030100a6010000a20303ede3e2358c78f3a8d62636e80472e4a6cbff319fc49d98da65d7d3474c2323d4000004cca8"
+        "00ff0100007500000010000e00000b6578616d706c652e636f6d000b000403000102000a000c000a001d0017001e0019"
+        "0018002300000010000b000908687474702f312e310016000000170000000d002a002804030503060308070808080908"
+        "0a080b080408050806040105010601030303010302040205020602"},
+    {SERVER,  // 1207 字节
+        "160303006c02000068030328e016e3b750cb0c815d0fc163df2a8c58ce0cb0f2a7a9a3444f574e4752440120e3716ba6"
+        "f51ccc9547ce3bac6c2a5d16a1260f81550ec6e1cf594298a2e3d896cca8000020ff01000100000b0004030001020010"
+        "000b000908687474702f312e310017000016030303070b0003030003000002fd308202f9308201e1a003020102021461"
+        "7b9d9e5af73dea2bf2076223a7f7df2cc9122d300d06092a864886f70d01010b0500300c310a300806035504030c0178"
+        "301e170d3236313031393034313933315a170d3236313032303034313933315a300c310a300806035504030c01783082"
+        "0122300d06092a864886f70d01010105000382010f003082010a0282010100b89e5ad81c17bd4e89f34bf3bfbb23402e"
+        "a1712a2742e4b83a119af875621cea077539ac861a533cde88f017e7f868afb38a6a011c877a235faf6255b19cc10b3c"
+        "094a904e32157b1fec06b479e3d5a489b03db1a690812a9239bbdef045c55e03ca47a5c16d71ec586043c2e68e975e10"
+        "086732e89cd7c6b0fb82dab79ad28e51fe7d31798a209f350228320fcaff01cd4e4302d63b2a9b749013fe04a9525538"
+        "d3b2102488713b6b5c21e11972785e3c145411c92185aa590ac2f2fa14d71a50071cf7998677f613e5d97556c79df8c5"
+        "137db31dbafcd9d3767f4f4592d7a68e60e58ac6882318a0aea6a831362a695817f9cb6e0e56c218a3a44379c5e17b02"
+        "03010001a3533051301d0603551d0e04160414e91824674f99d77bc8bdfa26c79b897f8237eed7301f0603551d230418"
+        "30168014e91824674f99d77bc8bdfa26c79b897f8237eed7300f0603551d130101ff040530030101ff300d06092a8648"
+        "86f70d01010b0500038201010073b4321e17dd66fe61298f58e1241be0631a8a4b987f86548a2ee1767ea1bf4c6bbed8"
+        "e4f974497734f432a2316f6a51e7238f8d0b5b68d909485e629abd5ec1b744b9682b0f7b366c586743cdc1547a268808"
+        "5cc4208661f20a08bbd240dcd760db16e2c58f0e82a450d8fe76d92ac1254758bf8f8dfbffce2afc019ef7c061f3b735"
+        "801c954911424ce8ca67593bb272dd1d840c5b65c0e420053b3557bc4a61e92622f77838c9b784ceb42df9d4a4c8f5c8"
+        "f55b4965bc9370ee98a6d9ba9c4ba78425de57a5042fe6c04c6a64a6466c32f78c9112ad651112d7e132d22bd04d3241"
+        "81cfb073bc52c0306bb2816e1e9f6e520a1a62b38b505245c4fd0836de160303012c0c00012803001d2031f1b37b9e9b"
+        "4e1a99b484c71c648b8a3dd1273b3d6286ecdfef818e1563dc450804010002967516867cf7145052b4342eefd3ac893a"
+        "df69f29c735c46da31227551ee032c9123679314101efba3a4ec4d7b42e8317c79dadf15e2a7411af2bab13e54965a92"
+        "fadca2e1effec45e5b91ab64ca3d4213331843385cfbb51270f52bc861591dc36ed93edd795fb63ebb14e3998d83954c"
+        "49fc218f8d819d51b288f50d7df64bfce2b0aa0790fc35ed411a311ce4cd61c061df4c513f9c767c71559a6269439d16"
+        "96cf6ad3c55b4bc206068bc7d55c0df67f6add7ad268fa29c64a0f8b65fcee92fcc9b9322c64259204b502a02d9ac9a8"
+        "ae2b79bc8eb490fc7693760b8a2f91dad66e20f6433b833a9605ae15a9ed805e266c6d4699af683f3a473b37e6211603"
+        "0300040e000000"},
+    {CLIENT,  // 85 字节
+        "1603030025100000212043d7d63ff6516d05616a954f024f0ff0ba3901a2c675ecc9d1b36da02036c967140303000101"
+        "160303002044da1554bbeb6beaed411b702c43ef3d29801b8a0246524f1b34d7529fe93436"},
+    {SERVER,  // 43 字节
+        "1403030001011603030020ba76e9717725747bbe9f3abe5423b2b6a4626650dc1392c11b44dd8c5fef7ea2"},
+    {CLIENT,  // 58 字节
+        "1703030035ddfdc4216480ae9ff0db5794f45eaf99ba2b63d6823582e4619498fdcd82ee62275ba653a87f8ac6a5a200"
+        "e963cd9ac9b27bedc7e3"},
+    {SERVER,  // 61 字节
+        "1703030038dc344229af69ace89d23d9d4142e168f22c1871b02966de2dab1c9fb25ca602607dfe493efa4d477278fd4"
+        "de8197b23e62d45e51b30f4cdf"},
+};
+
+// TLS 1.2 ECDHE-ECDSA-AES256-GCM-SHA384：PRF 用 SHA-384
+const char* const TLS12_ECDHE_ECDSA_AES256_GCM_KEYLOG =
+    "CLIENT_RANDOM 2cb28cae776733f327a295b54dcf25b4f80f4e10ba7c21a8438649cf73becf43 "
+    "e6f6f44d1fc4fe70c5a9714f5ad8dc3ecb1c13a046ef41f4f59d347273244015a33519735d807d9d6ee6400133bb40cf\n";
+const Segment TLS12_ECDHE_ECDSA_AES256_GCM_SEGMENTS[] = {
+    {CLIENT,  // 171 字节
+        "16030100a6010000a203032cb28cae776733f327a295b54dcf25b4f80f4e10ba7c21a8438649cf73becf43000004c02c"
+        "00ff0100007500000010000e00000b6578616d706c652e636f6d000b000403000102000a000c000a001d0017001e0019"
+        "0018002300000010000b000908687474702f312e310016000000170000000d002a002804030503060308070808080908"
+        "0a080b080408050806040105010601030303010302040205020602"},
+    {SERVER,  // 645 字节
+        "160303006c0200006803035155b13b139281950b7fe3c0169b752bf35b2f06cd27b583444f574e47524401207ce50d9d"
+        "75495b6f24dbb4fb5283cb7cb341230be21e93ca01c53502163f3725c02c000020ff01000100000b0004030001020010"
+        "000b000908687474702f312e3100170000160303018f0b00018b0001880001853082018130820127a00302010202141a"
+        "4d4051373b5f2e27fe7b7fe2b6b0a488d7893c300a06082a8648ce3d04030230163114301206035504030c0b6578616d"
+        "706c652e636f6d301e170d3236313031393036353535365a170d3336313031363036353535365a301631143012060355"
+        "04030c0b6578616d706c652e636f6d3059301306072a8648ce3d020106082a8648ce3d030107034200044ab571619efe"
+        "17af64ffd24316f5eb5d7b2c7228d7ff5e8dd49068ac5dbf9513c5ae5be39f5ae81357bd980778016f68eaa82e6f8411"
+        "8b41a5888371fd9edd23a3533051301d0603551d0e04160414a7c378276b88ef7842663cea36ddc5e82dae94a0301f06"
+        "03551d23041830168014a7c378276b88ef7842663cea36ddc5e82dae94a0300f0603551d130101ff040530030101ff30"
+        "0a06082a8648ce3d04030203480030450220492f576a984825aee7dacbcfeecb7bc01013023553309fa4154739b6c3c5"
+        "7a600221009ec02e4ba301bcb72812cd8cc1a3e5eb36700eb55aa9ca30946db4fa672d27c016030300720c00006e0300"
+        "1d20f6a8d5f7611650f08146d89218e1b557b8579eb2be1219916f1c363d72840a68040300463044022028de8935cc81"
+        "cf3c6983ba974dcecdfbad9c9e5872e89de49428f3b7cf73e17102205baf6f177ddeeb48ec75f2ce0267f354ec4c4890"
+        "a0d871ab47ba43067bef12be16030300040e000000"},
+    {CLIENT,  // 93 字节
+        "16030300251000002120e5b16036977e1204c451f858a5463eae6bd9c37ef83a5d86c511b70e3b3f327e140303000101"
+        "16030300288bb06cc9b43ee57d57ddbb691cea6674e4cfb9e45a018a3aaf41309b43c23299ec9d6f9a53fa3cf4"},
+    {SERVER,  // 51 字节
+        "1403030001011603030028dfc8cdbabb651f7e5b220ba3f950288668d4a5122099ebc9f8f21474a18042ce4e3df7699d"
+        "37fff5"},
+    {CLIENT,  // 66 字节
+        "170303003d8bb06cc9b43ee57e671231739b5cb3a3a6e5b595472f9c07a7388d831207f747b5d8d47f5b9544631d39a2"
+        "7346d6c0bfe089abe58bfaa0708419769477"},
+    {SERVER,  // 69 字节
+        "1703030040dfc8cdbabb651f7f024d7be5056ce0887580f1483658b871f17468f0c91afcb2ec7ce586f81e60a903938d"
+        "b1d57b473b87deae694565f5d5574ec0c02ad6f260"},
+};
+
+struct KnownAnswer
+{
+    const char*     name;
+    const char*     keylog;
+    const Segment*  segments;
+    size_t          count;
+    uint16_t        version;
+    uint16_t        suite;
+    std::string     server_plaintext;
+};
+
+int g_failures = 0;
+
+void expect(bool ok, const std::string& name, const std::string& what)
+{
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s: %s\n", name.c_str(), what.c_str());
+    ++g_failures;
+}
+
+// key log 只能从文件读入，写到临时文件
+bool open_keylog(TlsKeyLog& keylog, const char* text)
+{
+    char path[] = "/tmp/tls_known_answer.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return false;
+    std::string data = text;
+    bool written = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    ::close(fd);
+    std::string error;
+    bool ok = written && keylog.open(path, error);
+    unlink(path);
+    return ok;
+}
+
+// corrupt_last 为 true 时翻转最后一段的最后一字节（AEAD tag），解密应失败
+void run(const KnownAnswer& vector, bool corrupt_last)
+{
+    std::string name = std::string(vector.name) + (corrupt_last ? " (corrupted)" : "");
+    TlsKeyLog keylog;
+    if (!open_keylog(keylog, vector.keylog))
+    {
+        expect(false, name, "cannot load key log");
+        return;
+    }
+
+    TlsDecryptor decryptor(keylog);
+    std::string plaintext[2];
+    bool ok = true;
+    for (size_t i = 0; i < vector.count && ok; ++i)
+    {
+        crypto_util::Bytes data = crypto_util::from_hex(vector.segments[i].hex);
+        if (corrupt_last && i + 1 == vector.count) data.back() ^= 0x01;
+        ok = decryptor.feed(vector.segments[i].dir, data.data(), data.size(), plaintext[vector.segments[i].dir]);
+    }
+
+    if (corrupt_last)
+    {
+        expect(!ok, name, "tampered record was accepted");
+        return;
+    }
+    expect(ok, name, "feed failed");
+    expect(decryptor.version() == vector.version, name, "version");
+    expect(decryptor.cipher_suite() == vector.suite, name, "cipher suite");
+    expect(decryptor.server_name() == "example.com", name, "server name '" + decryptor.server_name() + "'");
+    expect(decryptor.alpn() == "http/1.1", name, "alpn '" + decryptor.alpn() + "'");
+    expect(plaintext[CLIENT] == REQUEST, name, "client plaintext '" + plaintext[CLIENT] + "'");
+    expect(plaintext[SERVER] == vector.server_plaintext, name, "server plaintext '" + plaintext[SERVER] + "'");
+}
+
+} // namespace
+
+int main()
+{
+    const KnownAnswer vectors[] = {
+        {"TLS 1.3 AES-128-GCM", TLS13_AES_128_GCM_KEYLOG, TLS13_AES_128_GCM_SEGMENTS,
+         sizeof(TLS13_AES_128_GCM_SEGMENTS) / sizeof(Segment), 0x0304, 0x1301, std::string(RESPONSE) + "!"},
+        {"TLS 1.2 ECDHE-ECDSA-AES128-GCM", TLS12_ECDHE_ECDSA_AES128_GCM_KEYLOG, TLS12_ECDHE_ECDSA_AES128_GCM_SEGMENTS,
+         sizeof(TLS12_ECDHE_ECDSA_AES128_GCM_SEGMENTS) / sizeof(Segment), 0x0303, 0xC02B, RESPONSE},
+        {"TLS 1.3 CHACHA20-POLY1305", TLS13_CHACHA20_POLY1305_KEYLOG, TLS13_CHACHA20_POLY1305_SEGMENTS,
+         sizeof(TLS13_CHACHA20_POLY1305_SEGMENTS) / sizeof(Segment), 0x0304, 0x1303, std::string(RESPONSE) + "!"},
+        {"TLS 1.3 AES-256-GCM", TLS13_AES_256_GCM_KEYLOG, TLS13_AES_256_GCM_SEGMENTS,
+         sizeof(TLS13_AES_256_GCM_SEGMENTS) / sizeof(Segment), 0x0304, 0x1302, std::string(RESPONSE) + "!"},
+        {"TLS 1.2 ECDHE-RSA-CHACHA20-POLY1305", TLS12_ECDHE_RSA_CHACHA20_POLY1305_KEYLOG,
+         TLS12_ECDHE_RSA_CHACHA20_POLY1305_SEGMENTS,
+         sizeof(TLS12_ECDHE_RSA_CHACHA20_POLY1305_SEGMENTS) / sizeof(Segment), 0x0303, 0xCCA8, RESPONSE},
+        {"TLS 1.2 ECDHE-ECDSA-AES256-GCM", TLS12_ECDHE_ECDSA_AES256_GCM_KEYLOG, TLS12_ECDHE_ECDSA_AES256_GCM_SEGMENTS,
+         sizeof(TLS12_ECDHE_ECDSA_AES256_GCM_SEGMENTS) / sizeof(Segment), 0x0303, 0xC02C, RESPONSE},
+    };
+    for (const auto& vector : vectors)
+    {
+        run(vector, false);
+        run(vector, true);
+    }
+    if (g_failures == 0) std::printf("tls_known_answer: %zu vectors passed\n", sizeof(vectors) / sizeof(vectors[0]));
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
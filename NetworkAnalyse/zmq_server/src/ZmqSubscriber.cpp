@@ -9,11 +9,20 @@ const int PACKET_THRESHOLD = 10;       // 报文数量阈值
 const int TIME_THRESHOLD_SEC = 5;       // 时间间隔阈值（秒）
 const size_t MAX_CACHE_SIZE = 1000;     // 最大缓存大小
 const size_t DB_WORKER_THREADS = 2;     // 数据库工作线程数量
-const int MAX_DB_RETRIES = 3;           // 数据库操作最大重试次数
 
-// 辅助函数声明：将ISO时间转换为MySQL datetime格式
-// 定义已移至 MySQLDAO.cpp，避免多重定义
-std::string format_mysql_datetime(const std::string& iso_time);
+// mitmproxy 的 ISO 8601 时间（UTC）转为 epoch 微秒，缺失或无法解析时取当前时间
+static int64_t message_time_us(const nlohmann::json& j)
+{
+    int64_t epoch_us = 0;
+    std::string text = j.value("timestamp", "");
+    if (text.empty()) {
+        spdlog::warn("Message has empty timestamp, using current time");
+    } else if (!parse_datetime_us(text, epoch_us)) {
+        spdlog::warn("Unrecognized timestamp '{}', using current time", text);
+        epoch_us = 0;
+    }
+    return epoch_us ? epoch_us : now_us();
+}
 
 ZMQSubscriber::ZMQSubscriber(const std::string& address)
   : m_ctx(1),
@@ -197,15 +206,7 @@ void ZMQSubscriber::parse_and_cache_http(const nlohmann::json& j) {
         flow.method = j.value("method", "");
         flow.status_code = j.value("status", 0);
         flow.content_type = j.value("content_type", "");
-        flow.start_time = j.value("timestamp", "");
-        
-        // 验证时间戳格式
-        if (!flow.start_time.empty()) {
-            flow.start_time = format_mysql_datetime(flow.start_time);
-        } else {
-            spdlog::warn("flow_info has empty timestamp, using current time");
-            flow.start_time = format_mysql_datetime("");
-        }
+        flow.start_time_us = message_time_us(j);
         
         // 保存flow_info
         {
@@ -246,27 +247,11 @@ void ZMQSubscriber::parse_and_cache_http(const nlohmann::json& j) {
         // 解析其他字段
         pkt.headers = j.value("headers", nlohmann::json{});
         pkt.body = j.value("info", "");
-        pkt.timestamp = j.value("timestamp", "");
+        pkt.timestamp_us = message_time_us(j);
         pkt.top_protocol = j.value("top_protocol", "HTTP");
         pkt.content_type = j.value("content_type", "");
         pkt.length = j.value("length", 0);
         
-        // 验证并格式化时间戳
-        if (!pkt.timestamp.empty()) {
-            // 保存原始时间戳
-            std::string original_ts = pkt.timestamp;
-            // 转换为MySQL格式
-            pkt.timestamp = format_mysql_datetime(pkt.timestamp);
-            
-            // 记录时间戳转换前后的对比（调试用）
-            if (original_ts != pkt.timestamp) {
-                spdlog::trace("Timestamp converted from '{}' to '{}'", original_ts, pkt.timestamp);
-            }
-        } else {
-            spdlog::warn("Packet has empty timestamp, using current time");
-            pkt.timestamp = format_mysql_datetime("");
-        }
-        
         spdlog::trace("Processing packet: flow_id={}, type={}, top_protocol={}",
                  pkt.flow_id, pkt.type, pkt.top_protocol);
         
@@ -294,7 +279,7 @@ void ZMQSubscriber::parse_and_cache_http(const nlohmann::json& j) {
                 flow.http_version = j.value("http_version", "1.1");
                 flow.host = j.value("host", "");
                 flow.url = j.value("url", "");
-                flow.start_time = pkt.timestamp;
+                flow.start_time_us = pkt.timestamp_us;
                 
                 // 根据packet类型设置method或status_code
                 if (pkt.type == "request") {
@@ -385,60 +370,17 @@ void ZMQSubscriber::flush_cache() {
         {
             std::lock_guard<std::mutex> lk(m_dbMutex);
             m_dbTasks.push([this, flow_copy, pkt_copy]() {
-                size_t flows_inserted = 0;
-                size_t packets_inserted = 0;
-                
-                // 插入 flow_info
-                for (const auto& flow : flow_copy) {
-                    int retries = 0;
-                    bool success = false;
-                    
-                    while (retries < MAX_DB_RETRIES && !success) {
-                        if (m_dao.insert_http_flow_info(flow)) {
-                            success = true;
-                            spdlog::info("Inserted http_flow_info: {}", flow.flow_id);
-                            flows_inserted++;
-                        } else {
-                            retries++;
-                            spdlog::error("Failed to insert http_flow_info (attempt {}): {}", 
-                                        retries, flow.flow_id);
-                            std::this_thread::sleep_for(std::chrono::milliseconds(100 * retries));
-                        }
-                    }
-                    
-                    if (!success) {
-                        spdlog::error("Giving up on http_flow_info after {} retries: {}", 
-                                    MAX_DB_RETRIES, flow.flow_id);
-                    }
+                // 一个事务写入；库暂时不可用时转存本地暂存区由后台回放，不在这里重试阻塞工作线程，
+                // 被拒的单条记录逐条剔除，不连累同批的其他记录
+                int stored = m_dao.store_http_exchanges(flow_copy, pkt_copy);
+                if (stored < 0) {
+                    spdlog::error("Dropped {} flow_infos, {} packets: database and spool both unavailable",
+                                  flow_copy.size(), pkt_copy.size());
+                    return;
                 }
-
-                // 插入 packet
-                for (const auto& pkt : pkt_copy) {
-                    int retries = 0;
-                    bool success = false;
-                    
-                    while (retries < MAX_DB_RETRIES && !success) {
-                        if (m_dao.insert_http_packet(pkt)) {
-                            success = true;
-                            spdlog::info("Inserted http_packet: {}", pkt.flow_id);
-                            packets_inserted++;
-                        } else {
-                            retries++;
-                            spdlog::error("Failed to insert http_packet (attempt {}): {}", 
-                                        retries, pkt.flow_id);
-                            std::this_thread::sleep_for(std::chrono::milliseconds(100 * retries));
-                        }
-                    }
-                    
-                    if (!success) {
-                        spdlog::error("Giving up on http_packet after {} retries: {}", 
-                                    MAX_DB_RETRIES, pkt.flow_id);
-                    }
-                }
-
-                m_totalPacketsStored += packets_inserted;
-                spdlog::info("Flushed to database: {} flow_infos, {} packets", 
-                             flows_inserted, packets_inserted);
+                if (stored > 0) m_totalPacketsStored += pkt_copy.size();
+                spdlog::info("{} {} flow_infos, {} packets", stored > 0 ? "Flushed to database:" : "Spooled for replay:",
+                             flow_copy.size(), pkt_copy.size());
             });
         }
         m_dbCv.notify_one();